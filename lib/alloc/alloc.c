@@ -1,11 +1,16 @@
 #include <string.h>
 
 #include "alloc/alloc.h"
+#include "alloc/tracking.h"
 #include "diagnostics/errno.h"
 
 Errno try_malloc(usize size, void** dst) {
     errno = 0;
+#ifdef COUGH_ALLOC_TRACKING
+    void* ptr = tracked_malloc(size);
+#else
     void* ptr = malloc(size);
+#endif
     if (ptr == NULL) {
         return errno ? errno : DUMMY_ERRNO;
     }
@@ -21,7 +26,11 @@ void* malloc_or_exit(usize size) {
 
 Errno try_realloc(void** ptr, usize new_size) {
     errno = 0;
+#ifdef COUGH_ALLOC_TRACKING
+    void* new_ptr = tracked_realloc(*ptr, new_size);
+#else
     void* new_ptr = realloc(*ptr, new_size);
+#endif
     if (new_ptr == NULL) {
         return errno ? errno : DUMMY_ERRNO;
     }
@@ -33,3 +42,11 @@ void* realloc_or_exit(void* ptr, usize size) {
     exit_on_errno_or(try_realloc(&ptr, size), "memory allocation failed");
     return ptr;
 }
+
+void free_allocation(void* ptr) {
+#ifdef COUGH_ALLOC_TRACKING
+    tracked_free(ptr);
+#else
+    free(ptr);
+#endif
+}
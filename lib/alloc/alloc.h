@@ -10,3 +10,7 @@ void* malloc_or_exit(usize size);
 
 Errno try_realloc(void** ptr, usize size);
 void* realloc_or_exit(void* ptr, usize size);
+
+/// @brief Frees memory from the functions above. Unlike `free`, it is seen by
+/// allocation tracking.
+void free_allocation(void* ptr);
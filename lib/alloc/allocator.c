@@ -0,0 +1,87 @@
+#include "alloc/alloc.h"
+#include "alloc/allocator.h"
+#include "diagnostics/errno.h"
+
+static void* heap_alloc(Allocator* self, usize size, usize alignment) {
+    void* ptr;
+    return try_malloc(size, &ptr) == 0 ? ptr : NULL;
+}
+
+static void* heap_realloc(
+    Allocator* self,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+) {
+    return try_realloc(&ptr, new_size) == 0 ? ptr : NULL;
+}
+
+static void heap_free(Allocator* self, void* ptr, usize size) {
+    free_allocation(ptr);
+}
+
+static const AllocatorVTable heap_allocator_vtable = {
+    .alloc = heap_alloc,
+    .realloc = heap_realloc,
+    .free = heap_free,
+};
+
+Allocator heap_allocator = { .vtable = &heap_allocator_vtable };
+
+void* allocator_try_alloc(Allocator* allocator, usize size, usize alignment) {
+    if (allocator == NULL) {
+        allocator = &heap_allocator;
+    }
+    return allocator->vtable->alloc(allocator, size, alignment);
+}
+
+void* allocator_try_realloc(
+    Allocator* allocator,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+) {
+    if (allocator == NULL) {
+        allocator = &heap_allocator;
+    }
+    return allocator->vtable->realloc(allocator, ptr, old_size, new_size, alignment);
+}
+
+void* allocator_alloc(Allocator* allocator, usize size, usize alignment) {
+    if (allocator == NULL) {
+        return malloc_or_exit(size);
+    }
+    void* ptr = allocator_try_alloc(allocator, size, alignment);
+    if (ptr == NULL && size != 0) {
+        exit_on_errno_or(DUMMY_ERRNO, "memory allocation failed");
+    }
+    return ptr;
+}
+
+void* allocator_realloc(
+    Allocator* allocator,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+) {
+    if (allocator == NULL) {
+        return realloc_or_exit(ptr, new_size);
+    }
+    void* new_ptr =
+        allocator_try_realloc(allocator, ptr, old_size, new_size, alignment);
+    if (new_ptr == NULL && new_size != 0) {
+        exit_on_errno_or(DUMMY_ERRNO, "memory allocation failed");
+    }
+    return new_ptr;
+}
+
+void allocator_free(Allocator* allocator, void* ptr, usize size) {
+    if (allocator == NULL) {
+        free_allocation(ptr);
+    } else {
+        allocator->vtable->free(allocator, ptr, size);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "primitives/primitives.h"
+
+/// @brief Where collections get their memory from.
+///
+/// Allocators are embedded in the structure that implements them, which is
+/// the context their functions get as `self`. Collections given `NULL` use
+/// `heap_allocator`.
+typedef struct Allocator {
+    struct AllocatorVTable const* vtable;
+} Allocator;
+
+typedef struct AllocatorVTable {
+    /// @return `NULL` when out of memory.
+    void*(*alloc)(Allocator* self, usize size, usize alignment);
+    /// @brief Resizes an allocation of `old_size` bytes, or allocates when
+    /// `ptr` is `NULL`. The allocation is left alone on failure.
+    ///
+    /// @return `NULL` when out of memory.
+    void*(*realloc)(
+        Allocator* self,
+        void* ptr,
+        usize old_size,
+        usize new_size,
+        usize alignment
+    );
+    void(*free)(Allocator* self, void* ptr, usize size);
+} AllocatorVTable;
+
+/// @brief `malloc`, `realloc` and `free`, that align to
+/// `alignof(max_align_t)` at most.
+extern Allocator heap_allocator;
+
+/// @brief Allocates from `allocator`, or the heap if it is `NULL`.
+///
+/// @return `NULL` when out of memory, or when the allocator refuses.
+void* allocator_try_alloc(Allocator* allocator, usize size, usize alignment);
+
+/// @brief Resizes like `allocator_try_alloc`. The allocation is left alone
+/// on failure.
+void* allocator_try_realloc(
+    Allocator* allocator,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+);
+
+/// @brief Like `allocator_try_alloc`, but exits when out of memory, for
+/// callers that cannot fail.
+void* allocator_alloc(Allocator* allocator, usize size, usize alignment);
+
+/// @brief Resizes like `allocator_alloc`.
+void* allocator_realloc(
+    Allocator* allocator,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+);
+
+void allocator_free(Allocator* allocator, void* ptr, usize size);
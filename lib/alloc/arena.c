@@ -0,0 +1,125 @@
+#include <stdalign.h>
+#include <string.h>
+
+#include "alloc/alloc.h"
+#include "alloc/arena.h"
+#include "ops/ptr.h"
+
+#define ARENA_DEFAULT_CHUNK_SIZE ((usize)64 << 10)
+#define ARENA_MAX_CHUNK_SIZE ((usize)4 << 20)
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* previous;
+    alignas(max_align_t) char data[];
+} ArenaChunk;
+
+static void arena_push_chunk(Arena* arena, usize min_size) {
+    usize size = arena->_chunk_size;
+    // allocations larger than chunks get a chunk of their own, that leaves
+    // the size of the next ones alone.
+    if (min_size > size) {
+        size = min_size;
+    } else if (arena->_chunk_size < ARENA_MAX_CHUNK_SIZE) {
+        arena->_chunk_size *= 2;
+    }
+    ArenaChunk* chunk = malloc_or_exit(sizeof(ArenaChunk) + size);
+    chunk->previous = arena->_chunk;
+    arena->_chunk = chunk;
+    arena->_next = chunk->data;
+    arena->_end = chunk->data + size;
+}
+
+static void* arena_allocator_alloc(Allocator* self, usize size, usize alignment) {
+    return arena_alloc((Arena*)self, size, alignment);
+}
+
+static void* arena_allocator_realloc(
+    Allocator* self,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+) {
+    return arena_realloc((Arena*)self, ptr, old_size, new_size, alignment);
+}
+
+static void arena_allocator_free(Allocator* self, void* ptr, usize size) {
+    // reclaimed with the arena.
+}
+
+static const AllocatorVTable arena_allocator_vtable = {
+    .alloc = arena_allocator_alloc,
+    .realloc = arena_allocator_realloc,
+    .free = arena_allocator_free,
+};
+
+Arena* arena_new(usize chunk_size) {
+    if (chunk_size == 0) {
+        chunk_size = ARENA_DEFAULT_CHUNK_SIZE;
+    }
+    // the first chunk holds the arena itself.
+    usize header = align_up_size(sizeof(Arena), alignof(max_align_t));
+    if (chunk_size < header) {
+        chunk_size = header;
+    }
+    Arena bootstrap = {
+        .base.vtable = &arena_allocator_vtable,
+        ._chunk = NULL,
+        ._chunk_size = chunk_size,
+        .allocated = 0,
+    };
+    arena_push_chunk(&bootstrap, chunk_size);
+    Arena* arena = (Arena*)bootstrap._next;
+    *arena = bootstrap;
+    arena->_next += header;
+    return arena;
+}
+
+void arena_free(Arena* arena) {
+    // the arena itself is in the first chunk, so it is read before the chunks
+    // are freed.
+    ArenaChunk* chunk = arena->_chunk;
+    while (chunk) {
+        ArenaChunk* previous = chunk->previous;
+        free_allocation(chunk);
+        chunk = previous;
+    }
+}
+
+void* arena_alloc(Arena* arena, usize size, usize alignment) {
+    char* ptr = align_up_mut(arena->_next, alignment);
+    if (ptr > arena->_end || size > (usize)(arena->_end - ptr)) {
+        arena_push_chunk(arena, size + alignment);
+        ptr = align_up_mut(arena->_next, alignment);
+    }
+    arena->_next = ptr + size;
+    arena->allocated += size;
+    return ptr;
+}
+
+void* arena_realloc(
+    Arena* arena,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+) {
+    if (ptr == NULL) {
+        return arena_alloc(arena, new_size, alignment);
+    }
+    char* start = ptr;
+    if (
+        start + old_size == arena->_next
+        && new_size <= (usize)(arena->_end - start)
+    ) {
+        arena->_next = start + new_size;
+        arena->allocated += new_size - old_size;
+        return ptr;
+    }
+    if (new_size <= old_size) {
+        return ptr;
+    }
+    void* new_ptr = arena_alloc(arena, new_size, alignment);
+    memcpy(new_ptr, ptr, old_size);
+    return new_ptr;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "primitives/primitives.h"
+#include "alloc/allocator.h"
+
+/// @brief A region that memory is bumped from, in chunks that are all freed
+/// at once.
+///
+/// The arena lives at the start of its first chunk, so that pointers to it
+/// stay valid while the structures allocated from it are moved around. It is
+/// an allocator whose `free` does nothing, so collections take `&arena->base`.
+typedef struct Arena {
+    Allocator base;
+    struct ArenaChunk* _chunk;  // the current one, linked to the previous ones
+    char* _next;
+    char* _end;
+    usize _chunk_size;          // of the next chunk
+    usize allocated;            // bytes handed out, for statistics
+} Arena;
+
+/// @brief Creates an arena whose chunks start at `chunk_size` bytes, or a
+/// default size if it is 0. Chunks are never smaller than the arena, which
+/// lives in the first one.
+Arena* arena_new(usize chunk_size);
+
+/// @brief Frees the arena and everything allocated from it.
+void arena_free(Arena* arena);
+
+/// @brief Bumps `size` bytes aligned to `alignment`, a power of two.
+void* arena_alloc(Arena* arena, usize size, usize alignment);
+
+/// @brief Resizes an allocation of `old_size` bytes. The last allocation is
+/// resized in place when its chunk has room, others are copied and their
+/// memory is only reclaimed with the arena.
+void* arena_realloc(
+    Arena* arena,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+);
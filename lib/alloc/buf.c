@@ -1,3 +1,4 @@
+#include <stdalign.h>
 #include <string.h>
 
 #include "alloc/alloc.h"
@@ -13,7 +14,7 @@ Buf buf_new(usize capacity) {
 }
 
 void buf_free(Buf* buf) {
-    free(buf->data);
+    allocator_free(buf->allocator, buf->data, buf->capacity);
 }
 
 bool buf_has_capacity_for(Buf* buf, usize additional) {
@@ -24,7 +25,13 @@ static void buf_reserve_for(Buf* buf, usize min_capacity) {
     if (min_capacity <= buf->capacity) return;
     usize next_capacity = (buf->capacity <= 5) ? 8 : buf->capacity * 1.5;
     usize new_capacity = (min_capacity >= next_capacity) ? min_capacity : next_capacity;
-    buf->data = realloc_or_exit(buf->data, new_capacity);
+    buf->data = allocator_realloc(
+        buf->allocator,
+        buf->data,
+        buf->capacity,
+        new_capacity,
+        alignof(max_align_t)
+    );
     buf->capacity = new_capacity;
 }
 
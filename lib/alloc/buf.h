@@ -1,11 +1,13 @@
 #pragma once
 
 #include "primitives/primitives.h"
+#include "alloc/allocator.h"
 
 typedef struct Buf {
     void* data;
     usize size;
     usize capacity;
+    Allocator* allocator;   // of the data, or NULL for the heap
 } Buf;
 
 Buf buf_new(usize capacity);
@@ -0,0 +1,236 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "alloc/tracking.h"
+
+char const* const alloc_stage_names[ALLOC_STAGES_LEN] = {
+#define X(stage, name) [stage] = name,
+    ALLOC_STAGES(X)
+#undef X
+};
+
+#ifdef COUGH_ALLOC_TRACKING
+
+#include "alloc/allocator.h"
+#include "collections/hash_map.h"
+
+typedef struct AllocRecord {
+    usize size;
+    AllocStage stage;
+} AllocRecord;
+
+DECL_HASH_MAP(uptr, AllocRecord)
+IMPL_HASH_MAP(uptr, AllocRecord)
+
+// the table of live allocations must not be tracked itself.
+static void* untracked_alloc(Allocator* self, usize size, usize alignment) {
+    return malloc(size);
+}
+
+static void* untracked_realloc(
+    Allocator* self,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+) {
+    return realloc(ptr, new_size);
+}
+
+static void untracked_free(Allocator* self, void* ptr, usize size) {
+    free(ptr);
+}
+
+static const AllocatorVTable untracked_allocator_vtable = {
+    .alloc = untracked_alloc,
+    .realloc = untracked_realloc,
+    .free = untracked_free,
+};
+
+static Allocator untracked_allocator = { .vtable = &untracked_allocator_vtable };
+
+static _Thread_local AllocStage current_stage = ALLOC_STAGE_OTHER;
+
+// guards everything below, allocations are made by several threads.
+static atomic_flag lock = ATOMIC_FLAG_INIT;
+static bool initialized;
+static HashMap(uptr, AllocRecord) live_allocations;
+static AllocStats stats[ALLOC_STAGES_LEN + 1];  // and the total
+
+static void report_at_exit(void) {
+    alloc_report(stderr);
+}
+
+static void tracker_lock(void) {
+    while (atomic_flag_test_and_set_explicit(&lock, memory_order_acquire));
+    if (!initialized) {
+        live_allocations = hash_map_new_in(uptr, AllocRecord)(&untracked_allocator);
+        if (getenv("COUGH_ALLOC_REPORT")) {
+            atexit(report_at_exit);
+        }
+        initialized = true;
+    }
+}
+
+static void tracker_unlock(void) {
+    atomic_flag_clear_explicit(&lock, memory_order_release);
+}
+
+// moves bytes in and out of the live memory of a stage, or of the total.
+static void charge(AllocStats* stats, usize freed, usize allocated) {
+    stats->live = stats->live - freed + allocated;
+    if (stats->live > stats->peak) {
+        stats->peak = stats->live;
+    }
+}
+
+static AllocStats* total_stats(void) {
+    return &stats[ALLOC_STAGES_LEN];
+}
+
+void* tracked_malloc(usize size) {
+    tracker_lock();
+    void* ptr = malloc(size);
+    if (ptr != NULL) {
+        AllocStats* stage_stats = &stats[current_stage];
+        AllocStats* totals = total_stats();
+        stage_stats->allocations++;
+        totals->allocations++;
+        stage_stats->bytes += size;
+        totals->bytes += size;
+        charge(stage_stats, 0, size);
+        charge(totals, 0, size);
+        hash_map_insert(uptr, AllocRecord)(
+            &live_allocations,
+            (uptr)ptr,
+            (AllocRecord){ .size = size, .stage = current_stage }
+        );
+    }
+    tracker_unlock();
+    return ptr;
+}
+
+void* tracked_realloc(void* ptr, usize size) {
+    if (ptr == NULL) {
+        return tracked_malloc(size);
+    }
+    tracker_lock();
+    // memory that was allocated before tracking started, or by another
+    // allocator, counts as new.
+    AllocRecord old = { .size = 0, .stage = current_stage };
+    AllocRecord const* record =
+        hash_map_get(uptr, AllocRecord)(live_allocations, (uptr)ptr);
+    if (record != NULL) {
+        old = *record;
+    }
+    void* new_ptr = realloc(ptr, size);
+    if (new_ptr != NULL) {
+        AllocStats* stage_stats = &stats[current_stage];
+        AllocStats* totals = total_stats();
+        stage_stats->reallocations++;
+        totals->reallocations++;
+        if (size > old.size) {
+            stage_stats->bytes += size - old.size;
+            totals->bytes += size - old.size;
+        }
+        if (new_ptr != ptr) {
+            usize copied = (old.size < size) ? old.size : size;
+            stage_stats->copied += copied;
+            totals->copied += copied;
+        }
+        // the memory moves to the stage that resized it.
+        charge(&stats[old.stage], old.size, 0);
+        charge(stage_stats, 0, size);
+        charge(totals, old.size, size);
+        hash_map_remove(uptr, AllocRecord)(&live_allocations, (uptr)ptr);
+        hash_map_insert(uptr, AllocRecord)(
+            &live_allocations,
+            (uptr)new_ptr,
+            (AllocRecord){ .size = size, .stage = current_stage }
+        );
+    }
+    tracker_unlock();
+    return new_ptr;
+}
+
+void tracked_free(void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    tracker_lock();
+    AllocRecord const* record =
+        hash_map_get(uptr, AllocRecord)(live_allocations, (uptr)ptr);
+    if (record != NULL) {
+        // memory is given back to the stage that allocated it, whoever frees
+        // it.
+        AllocStats* stage_stats = &stats[record->stage];
+        AllocStats* totals = total_stats();
+        stage_stats->frees++;
+        totals->frees++;
+        charge(stage_stats, record->size, 0);
+        charge(totals, record->size, 0);
+        hash_map_remove(uptr, AllocRecord)(&live_allocations, (uptr)ptr);
+    }
+    free(ptr);
+    tracker_unlock();
+}
+
+AllocStage alloc_stage_enter(AllocStage stage) {
+    AllocStage previous = current_stage;
+    current_stage = stage;
+    return previous;
+}
+
+void alloc_stage_leave(AllocStage previous) {
+    current_stage = previous;
+}
+
+AllocStats alloc_stats(AllocStage stage) {
+    tracker_lock();
+    AllocStats result = stats[stage];
+    tracker_unlock();
+    return result;
+}
+
+void alloc_stats_reset(void) {
+    tracker_lock();
+    for (usize i = 0; i <= ALLOC_STAGES_LEN; i++) {
+        // live memory is still freed later, and must be accounted for.
+        stats[i] = (AllocStats){ .live = stats[i].live, .peak = stats[i].live };
+    }
+    tracker_unlock();
+}
+
+#else
+
+AllocStage alloc_stage_enter(AllocStage stage) {
+    return ALLOC_STAGE_OTHER;
+}
+
+void alloc_stage_leave(AllocStage previous) {}
+
+AllocStats alloc_stats(AllocStage stage) {
+    return (AllocStats){ 0 };
+}
+
+void alloc_stats_reset(void) {}
+
+#endif
+
+void alloc_report(FILE* file) {
+    fprintf(
+        file,
+        "%-10s %10s %10s %10s %12s %12s %12s %12s\n",
+        "stage", "allocs", "reallocs", "frees", "bytes", "copied", "live", "peak"
+    );
+    for (usize i = 0; i <= ALLOC_STAGES_LEN; i++) {
+        AllocStats s = alloc_stats(i);
+        fprintf(
+            file,
+            "%-10s %10zu %10zu %10zu %12zu %12zu %12zu %12zu\n",
+            i < ALLOC_STAGES_LEN ? alloc_stage_names[i] : "total",
+            s.allocations, s.reallocations, s.frees,
+            s.bytes, s.copied, s.live, s.peak
+        );
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "primitives/primitives.h"
+
+/// @brief The parts of the pipeline that allocations are charged to.
+#define ALLOC_STAGES(X)                                                         \
+    X(ALLOC_STAGE_OTHER,        "other")                                        \
+    X(ALLOC_STAGE_TOKENIZER,    "tokenizer")                                    \
+    X(ALLOC_STAGE_PARSER,       "parser")                                       \
+    X(ALLOC_STAGE_ANALYZER,     "analyzer")                                     \
+    X(ALLOC_STAGE_EMITTER,      "emitter")                                      \
+    X(ALLOC_STAGE_VM,           "vm")                                           \
+
+typedef enum AllocStage {
+#define X(stage, name) stage,
+    ALLOC_STAGES(X)
+#undef X
+    ALLOC_STAGES_LEN,
+} AllocStage;
+
+extern char const* const alloc_stage_names[ALLOC_STAGES_LEN];
+
+/// @brief What was allocated while a stage ran, through `try_malloc` and
+/// `try_realloc`. Memory stays charged to the stage that last resized it
+/// until it is freed with `free_allocation`. Memory bumped from an arena is
+/// only seen as the chunks of the arena.
+typedef struct AllocStats {
+    usize allocations;
+    usize reallocations;
+    usize frees;
+    usize bytes;            // allocated, counting only the growth of reallocations
+    usize copied;           // moved by reallocations that could not grow in place
+    usize live;
+    usize peak;             // of `live`
+} AllocStats;
+
+/// @brief Makes allocations of the calling thread charged to `stage`.
+///
+/// @return the previous stage, to give back to `alloc_stage_leave`.
+AllocStage alloc_stage_enter(AllocStage stage);
+void alloc_stage_leave(AllocStage previous);
+
+/// @brief The statistics of a stage, or of all of them with
+/// `ALLOC_STAGES_LEN`. They are all zero unless built with
+/// `COUGH_ALLOC_TRACKING`.
+AllocStats alloc_stats(AllocStage stage);
+
+/// @brief Forgets the statistics, but not the live allocations.
+void alloc_stats_reset(void);
+
+/// @brief Prints a table of the statistics of each stage.
+///
+/// Tracking builds also print it to `stderr` at exit when the
+/// `COUGH_ALLOC_REPORT` environment variable is set.
+void alloc_report(FILE* file);
+
+#ifdef COUGH_ALLOC_TRACKING
+/// @brief `malloc`, `realloc` and `free` that record what they do, for
+/// `try_malloc`, `try_realloc` and `free_allocation`.
+void* tracked_malloc(usize size);
+void* tracked_realloc(void* ptr, usize size);
+void tracked_free(void* ptr);
+#endif
@@ -1,4 +1,5 @@
 #include "analyzer/analyzer.h"
+#include "alloc/tracking.h"
 #include "diagnostics/result.h"
 
 typedef struct Analyzer {
@@ -10,7 +11,8 @@ typedef struct Analyzer {
     Expression* expressions;
     usize* function_variable_space;
     usize function_id;
-    AstStorage* storage;
+    Arena* arena;
+    WorkerPool* workers;
 } Analyzer;
 
 static Analyzer with_scope_location(Analyzer analyzer, ScopeLocation scope_location) {
@@ -23,11 +25,13 @@ static Analyzer with_scope_location(Analyzer analyzer, ScopeLocation scope_locat
         .expressions = analyzer.expressions,
         .function_variable_space = analyzer.function_variable_space,
         .function_id = analyzer.function_id,
-        .storage = analyzer.storage,
+        .arena = analyzer.arena,
+        .workers = analyzer.workers,
     };
 }
 
 static void analyze_module(Analyzer* analyzer, Module* module);
+static void analyze_bodies_parallel(Analyzer* analyzer, Module* module);
 static void register_constant_def(Analyzer* analyzer, ConstantDef* constant_def);
 static void type_constant_def(Analyzer* analyzer, ConstantDef* constant_def);
 static void analyze_constant_def(Analyzer* analyzer, ConstantDef* constant_def);
@@ -38,11 +42,21 @@ static void analyze_expression(Analyzer* analyzer, Expression* expression);
 static void analyze_binary_operation(Analyzer* analyzer, BinaryOperation* binary_operation, TypeId* dst);
 static void analyze_variable_ref(Analyzer* analyzer, VariableRef* variable_ref);
 static void analyze_function_body(Analyzer* analyzer, Function* function);
+static void open_function_body(Analyzer* analyzer, Function* function);
+static void analyze_function_output(Analyzer* analyzer, Function* function);
 static void resolve_type(Analyzer* analyzer, TypeName name, TypeId* dst);
 
 bool analyze(Ast* ast, Reporter* reporter) {
+    WorkerPool workers = worker_pool_new(1);
+    bool ok = analyze_parallel(ast, reporter, &workers);
+    worker_pool_free(&workers);
+    return ok;
+}
+
+bool analyze_parallel(Ast* ast, Reporter* reporter, WorkerPool* workers) {
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_ANALYZER);
     TypeBinding bool_binding = {
-        .name = STRING_LITERAL("Bool"),
+        .name = intern(ast->interner, STRING_LITERAL("Bool")),
         .type = TYPE_BOOL,
     };
     insert_type_binding(&ast->bindings, ROOT_SCOPE_ID, bool_binding, NULL);
@@ -56,10 +70,12 @@ bool analyze(Ast* ast, Reporter* reporter) {
         .expressions = ast->expressions.data,
         .function_variable_space = NULL,
         .function_id = 0,
-        .storage = &ast->storage,
+        .arena = ast->arena,
+        .workers = workers,
     };
 
     analyze_module(&analyzer, &ast->root);
+    alloc_stage_leave(stage);
     return reporter_error_count(reporter) == 0;
 }
 
@@ -75,6 +91,10 @@ static void analyze_module(Analyzer* parent, Module* module) {
         ConstantDef* constant_def = &module->global_constants.data[i];
         type_constant_def(&analyzer, constant_def);
     }
+    if (analyzer.workers->threads > 1) {
+        analyze_bodies_parallel(&analyzer, module);
+        return;
+    }
     for (usize i = 0; i < module->global_constants.len; i++) {
         ConstantDef* constant_def = &module->global_constants.data[i];
         analyze_constant_def(&analyzer, constant_def);
@@ -82,9 +102,82 @@ static void analyze_module(Analyzer* parent, Module* module) {
     return;
 }
 
+static bool defines_functions(Expression const* expressions, Expression expression) {
+    switch (expression.kind) {
+    case EXPRESSION_FUNCTION:
+        return true;
+    case EXPRESSION_BINARY_OPERATION:;
+        BinaryOperation operation = expression.as.binary_operation;
+        return defines_functions(expressions, expressions[operation.operand_left])
+            || defines_functions(expressions, expressions[operation.operand_right]);
+    default:
+        return false;
+    }
+}
+
+typedef struct BodiesJob {
+    Analyzer const* analyzer;
+    ConstantDef const* constants;
+    usize const* bodies;    // indices of the constants
+    usize bodies_len;
+    usize chunks;
+} BodiesJob;
+
+static void analyze_bodies_chunk(void* context, usize chunk) {
+    BodiesJob const* job = context;
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_ANALYZER);
+    Analyzer analyzer = *job->analyzer;
+    usize start = worker_chunk_start(job->bodies_len, job->chunks, chunk);
+    usize end = worker_chunk_start(job->bodies_len, job->chunks, chunk + 1);
+    for (usize i = start; i < end; i++) {
+        ConstantDef const* constant_def = &job->constants[job->bodies[i]];
+        Function* function = &analyzer.expressions[constant_def->value].as.function;
+        analyze_function_output(&analyzer, function);
+    }
+    alloc_stage_leave(stage);
+}
+
+static void analyze_bodies_parallel(Analyzer* analyzer, Module* module) {
+    // the scopes of the bodies are opened here, so that the threads only read
+    // the registries and write the expressions of their own functions.
+    ArrayBuf(usize) bodies = array_buf_new(usize)();
+    ArrayBuf(usize) others = array_buf_new(usize)();
+    for (usize i = 0; i < module->global_constants.len; i++) {
+        Expression* value = &analyzer->expressions[module->global_constants.data[i].value];
+        if (
+            value->kind == EXPRESSION_FUNCTION
+            && !value->as.function.external
+            && !defines_functions(
+                analyzer->expressions,
+                analyzer->expressions[value->as.function.output]
+            )
+        ) {
+            open_function_body(analyzer, &value->as.function);
+            array_buf_push(usize)(&bodies, i);
+        } else {
+            array_buf_push(usize)(&others, i);
+        }
+    }
+
+    BodiesJob job = {
+        .analyzer = analyzer,
+        .constants = module->global_constants.data,
+        .bodies = bodies.data,
+        .bodies_len = bodies.len,
+        .chunks = worker_pool_chunks(analyzer->workers, bodies.len),
+    };
+    worker_pool_run(analyzer->workers, job.chunks, analyze_bodies_chunk, &job);
+
+    for (usize i = 0; i < others.len; i++) {
+        analyze_constant_def(analyzer, &module->global_constants.data[others.data[i]]);
+    }
+    array_buf_free(usize)(&bodies);
+    array_buf_free(usize)(&others);
+}
+
 static void register_constant_def(Analyzer* analyzer, ConstantDef* constant_def) {
     ValueBinding binding = {
-        .name = constant_def->name.string,
+        .name = constant_def->name.atom,
         .type = TYPE_INVALID,
         .store = {
             .kind = VALUE_STORE_CONSTANT,
@@ -148,7 +241,9 @@ static void analyze_constant_def(Analyzer* analyzer, ConstantDef* constant_def)
     Expression* expression = &analyzer->expressions[constant_def->value];
     if (expression->kind == EXPRESSION_FUNCTION) {
         // already analyzed the function signature.
-        analyze_function_body(analyzer, &expression->as.function);
+        if (!expression->as.function.external) {
+            analyze_function_body(analyzer, &expression->as.function);
+        }
         return;
     }
     analyze_expression(analyzer, expression);
@@ -207,7 +302,7 @@ static void analyze_variable_def(Analyzer* analyzer, VariableDef* variable_def)
     }
     resolve_type(analyzer, variable_def->type_name, &variable_def->type);
     ValueBinding binding = {
-        .name = variable_def->name.string,
+        .name = variable_def->name.atom,
         .type = variable_def->type,
         .store = {
             .kind = VALUE_STORE_VARIABLE,
@@ -235,7 +330,7 @@ static void analyze_expression(Analyzer* analyzer, Expression* expression) {
     case EXPRESSION_VARIABLE:
         analyze_variable_ref(analyzer, &expression->as.variable);
         expression->type =
-            get_binding(*analyzer->bindings, expression->as.variable.binding).as.value.type;
+            get_binding(*analyzer->bindings, expression->as.variable.binding).as.value->type;
         break;
     
     case EXPRESSION_FUNCTION:
@@ -288,7 +383,7 @@ static void analyze_variable_ref(Analyzer* analyzer, VariableRef* variable_ref)
     if (!find_binding(
         *analyzer->bindings,
         analyzer->scope_location,
-        variable_ref->name.string,
+        variable_ref->name.atom,
         &binding_id
     )) {
         // TODO: error handling
@@ -300,8 +395,8 @@ static void analyze_variable_ref(Analyzer* analyzer, VariableRef* variable_ref)
         // TODO: error handling
         return;
     }
-    if (binding.as.value.store.kind == VALUE_STORE_VARIABLE) {
-        if (binding.as.value.store.as.variable.function_id != analyzer->function_id) {
+    if (binding.as.value->store.kind == VALUE_STORE_VARIABLE) {
+        if (binding.as.value->store.as.variable.function_id != analyzer->function_id) {
             // TODO: error handling
             log_error("variable accessed outside of function");
             exit(-1);
@@ -310,12 +405,22 @@ static void analyze_variable_ref(Analyzer* analyzer, VariableRef* variable_ref)
     variable_ref->binding = binding_id;
 }
 
-static void analyze_function_body(Analyzer* parent, Function* function) {
+static void analyze_function_body(Analyzer* analyzer, Function* function) {
+    open_function_body(analyzer, function);
+    analyze_function_output(analyzer, function);
+}
+
+static void open_function_body(Analyzer* analyzer, Function* function) {
     ScopeLocation scope = scope_new(
-        parent->bindings,
-        scope_end_location(*parent->bindings, function->input.scope)
+        analyzer->bindings,
+        scope_end_location(*analyzer->bindings, function->input.scope)
     );
     function->output_scope = scope.scope_id;
+}
+
+static void analyze_function_output(Analyzer* parent, Function* function) {
+    ScopeLocation scope =
+        scope_end_location(*parent->bindings, function->output_scope);
     Analyzer analyzer = with_scope_location(*parent, scope);
     analyzer.function_variable_space = &function->variable_space;
     analyzer.function_id = function->function_id;
@@ -333,7 +438,7 @@ static void resolve_type(Analyzer* analyzer, TypeName name, TypeId* dst) {
         if (!find_binding(
             *analyzer->bindings,
             analyzer->scope_location,
-            name.as.identifier.string,
+            name.as.identifier.atom,
             &binding_id
         )) {
             // TODO: error handling
@@ -344,6 +449,6 @@ static void resolve_type(Analyzer* analyzer, TypeName name, TypeId* dst) {
             // TODO: error handling
             return;
         }
-        *dst = binding.as.type.type;
+        *dst = binding.as.type->type;
     }
 }
@@ -2,5 +2,14 @@
 
 #include "ast/ast.h"
 #include "diagnostics/report.h"
+#include "workers/workers.h"
 
 bool analyze(Ast* ast, Reporter* reporter);
+
+/// @brief Analyzes like `analyze`, with the bodies of the global functions
+/// analyzed by the threads of `workers` once every signature is known.
+///
+/// Bodies only read the bindings and types, except those that define
+/// functions of their own, which need new scopes and types. These are
+/// analyzed afterwards on the calling thread.
+bool analyze_parallel(Ast* ast, Reporter* reporter, WorkerPool* workers);
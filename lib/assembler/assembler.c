@@ -6,8 +6,6 @@
 
 DECL_HASH_MAP(Mnemonic, u8)
 IMPL_HASH_MAP(Mnemonic, u8)
-DECL_HASH_MAP(String, usize)
-IMPL_HASH_MAP(String, usize)
 
 typedef struct Assembler {
     String text;
@@ -450,7 +448,7 @@ static Result assembler_finish(Assembler* assembler, Bytecode* dst) {
 static void unexpected_eof(Assembler* assembler) {
     Reporter* reporter = assembler->reporter;
     report_start(reporter, SEVERITY_ERROR, 0);
-    report_message(reporter, format("unexpected end-of-file"));
+    report_format(reporter, "unexpected end-of-file");
     usize len = assembler->text.len;
     report_source_code(reporter, (Range){ len, len });
     report_end(reporter);
@@ -459,7 +457,7 @@ static void unexpected_eof(Assembler* assembler) {
 static void invalid_instruction(Assembler* assembler, Range source) {
     Reporter* reporter = assembler->reporter;
     report_start(reporter, SEVERITY_ERROR, 1);
-    report_message(reporter, format("invalid instruction"));
+    report_format(reporter, "invalid instruction");
     report_source_code(reporter, source);
     report_end(reporter);
 }
@@ -467,7 +465,7 @@ static void invalid_instruction(Assembler* assembler, Range source) {
 static void invalid_syscall(Assembler* assembler, Range source) {
     Reporter* reporter = assembler->reporter;
     report_start(reporter, SEVERITY_ERROR, 2);
-    report_message(reporter, format("invalid syscall"));
+    report_format(reporter, "invalid syscall");
     report_source_code(reporter, source);
     report_end(reporter);
 }
@@ -475,7 +473,7 @@ static void invalid_syscall(Assembler* assembler, Range source) {
 static void invalid_arg(Assembler* assembler, Range source) {
     Reporter* reporter = assembler->reporter;
     report_start(reporter, SEVERITY_ERROR, 3);
-    report_message(reporter, format("invalid argument"));
+    report_format(reporter, "invalid argument");
     report_source_code(reporter, source);
     report_end(reporter);
 }
@@ -483,7 +481,7 @@ static void invalid_arg(Assembler* assembler, Range source) {
 static void invalid_symbol(Assembler* assembler, Range source) {
     Reporter* reporter = assembler->reporter;
     report_start(reporter, SEVERITY_ERROR, 4);
-    report_message(reporter, format("invalid symbol"));
+    report_format(reporter, "invalid symbol");
     report_source_code(reporter, source);
     report_end(reporter);
 }
@@ -491,7 +489,7 @@ static void invalid_symbol(Assembler* assembler, Range source) {
 static void duplicate_symbol(Assembler* assembler, Range source) {
     Reporter* reporter = assembler->reporter;
     report_start(reporter, SEVERITY_ERROR, 5);
-    report_message(reporter, format("duplicate symbol"));
+    report_format(reporter, "duplicate symbol");
     report_source_code(reporter, source);
     report_end(reporter);
 }
@@ -499,6 +497,6 @@ static void duplicate_symbol(Assembler* assembler, Range source) {
 static void undefined_symbol(Assembler* assembler) {
     Reporter* reporter = assembler->reporter;
     report_start(reporter, SEVERITY_ERROR, 5);
-    report_message(reporter, format("undefined symbol"));
+    report_format(reporter, "undefined symbol");
     report_end(reporter);
 }
@@ -1,5 +1,5 @@
 #include "ast/ast.h"
 
 void ast_free(Ast* ast) {
-    ast_storage_free(&ast->storage);
+    arena_free(ast->arena);
 }
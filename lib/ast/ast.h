@@ -4,7 +4,7 @@
 #include "ast/type.h"
 #include "ast/binding.h"
 #include "ast/expression.h"
-#include "ast/memory.h"
+#include "alloc/arena.h"
 
 typedef struct Module {
     ScopeId global_scope;
@@ -18,7 +18,10 @@ typedef struct Ast {
     ArrayBuf(Expression) expressions;
     ArrayBuf(usize) functions;  // expression IDs
     Module root;
-    AstStorage storage;
+    Interner* interner;     // of the names of identifiers and bindings
+    /// @brief Where the expressions, bindings and types are allocated, so
+    /// that the whole AST is freed at once.
+    Arena* arena;
 } Ast;
 
 void ast_free(Ast* ast);
@@ -4,88 +4,92 @@ IMPL_ARRAY_BUF(BindingId);
 IMPL_ARRAY_BUF(TypeBindingEntry);
 IMPL_ARRAY_BUF(ValueBindingEntry);
 IMPL_ARRAY_BUF(Scope);
+IMPL_ARRAY_BUF(SequentialBinding);
+IMPL_HASH_MAP(Atom, BindingId)
+IMPL_HASH_MAP(Atom, usize)
 
 #define BINDING_ID_INDEX_MASK (usize)((usize)(-1) >> 1)
 // 1 for values, 0 for types
 #define BINDING_ID_KIND_MASK (usize)(~BINDING_ID_INDEX_MASK)
 
 BindingRegistry binding_registry_new(void) {
-    Scope root = {
-        ._parent = -1,
-        ._unordered_bindings = array_buf_new(BindingId)(),
-        ._sequential_bindings = array_buf_new(BindingId)(),
+    return binding_registry_new_in(NULL);
+}
+
+static Scope scope_new_in(Allocator* allocator, ScopeLocation parent) {
+    return (Scope){
+        ._parent = parent,
+        ._unordered_bindings = hash_map_new_in(Atom, BindingId)(allocator),
+        ._sequential_bindings = array_buf_new_in(SequentialBinding)(allocator),
+        ._last_sequential_bindings = hash_map_new_in(Atom, usize)(allocator),
     };
-    ArrayBuf(Scope) scopes = array_buf_new(Scope)();
-    array_buf_push(Scope)(&scopes, root);
+}
+
+BindingRegistry binding_registry_new_in(Allocator* allocator) {
+    ScopeLocation no_parent = { .scope_id = -1, ._pos = -1 };
+    ArrayBuf(Scope) scopes = array_buf_new_in(Scope)(allocator);
+    array_buf_push(Scope)(&scopes, scope_new_in(allocator, no_parent));
     return (BindingRegistry){
         ._scopes = scopes,
-        ._type_bindings = array_buf_new(TypeBindingEntry)(),
-        ._value_bindings = array_buf_new(ValueBindingEntry)(),
+        ._type_bindings = array_buf_new_in(TypeBindingEntry)(allocator),
+        ._value_bindings = array_buf_new_in(ValueBindingEntry)(allocator),
+        ._allocator = allocator,
     };
 }
 
 void binding_registry_free(BindingRegistry* registry) {
     for (usize i = 0; i < registry->_scopes.len; i++) {
         Scope* scope = &registry->_scopes.data[i];
-        array_buf_free(BindingId)(&scope->_unordered_bindings);
-        array_buf_free(BindingId)(&scope->_sequential_bindings);
+        hash_map_free(Atom, BindingId)(&scope->_unordered_bindings);
+        array_buf_free(SequentialBinding)(&scope->_sequential_bindings);
+        hash_map_free(Atom, usize)(&scope->_last_sequential_bindings);
     }
     array_buf_free(TypeBindingEntry)(&registry->_type_bindings);
     array_buf_free(ValueBindingEntry)(&registry->_value_bindings);
+    array_buf_free(Scope)(&registry->_scopes);
 }
 
 static bool find_binding_in_scope(
     BindingRegistry registry,
     ScopeLocation location,
-    String name,
+    Atom name,
     BindingId* dst
 ) {
-    Scope scope = registry._scopes.data[location.scope_id];
-    for (usize i = 0; i < scope._unordered_bindings.len; i++) {
-        BindingId id = scope._unordered_bindings.data[i];
-        Binding binding = get_binding(registry, id);
-        String binding_name;
-        switch (binding.kind) {
-        case BINDING_TYPE: binding_name = binding.as.type.name; break;
-        case BINDING_VALUE: binding_name = binding.as.value.name; break;
-        }
-        if (eq(String)(name, binding_name)) {
-            *dst = id;
-            return true;
-        }
+    Scope const* scope = &registry._scopes.data[location.scope_id];
+    BindingId const* id =
+        hash_map_get(Atom, BindingId)(scope->_unordered_bindings, name);
+    if (id) {
+        *dst = *id;
+        return true;
     }
 
-    if (location._pos > scope._sequential_bindings.len) {
-        location._pos = scope._sequential_bindings.len;
+    usize const* last =
+        hash_map_get(Atom, usize)(scope->_last_sequential_bindings, name);
+    if (!last) {
+        return false;
     }
-    for (isize i = location._pos - 1; i >= 0; i--) {
-        BindingId id = scope._sequential_bindings.data[i];
-        Binding binding = get_binding(registry, id);
-        String binding_name;
-        switch (binding.kind) {
-        case BINDING_TYPE: binding_name = binding.as.type.name; break;
-        case BINDING_VALUE: binding_name = binding.as.value.name; break;
-        }
-        if (eq(String)(name, binding_name)) {
-            *dst = id;
-            return true;
-        }
+    usize pos = *last;
+    while (pos != (usize)-1 && pos >= location._pos) {
+        pos = scope->_sequential_bindings.data[pos]._shadowed;
     }
-    return false;
+    if (pos == (usize)-1) {
+        return false;
+    }
+    *dst = scope->_sequential_bindings.data[pos].id;
+    return true;
 }
 
 bool find_binding(
     BindingRegistry registry,
     ScopeLocation location,
-    String name,
+    Atom name,
     BindingId* dst
 ) {
     while (location.scope_id != -1) {
-        Scope scope = registry._scopes.data[location.scope_id];
         if (find_binding_in_scope(registry, location, name, dst)) {
             return true;
         }
-        location = scope._parent;
+        location = registry._scopes.data[location.scope_id]._parent;
     }
     return false;
 }
@@ -93,20 +97,20 @@ bool find_binding(
 Binding get_binding(BindingRegistry registry, BindingId id) {
     usize index = id & BINDING_ID_INDEX_MASK;
     if (id & BINDING_ID_KIND_MASK) {
-        ValueBindingEntry entry = registry._value_bindings.data[index];
+        ValueBindingEntry const* entry = registry._value_bindings.data + index;
         return (Binding){
             .id = id,
-            .location = entry._location,
+            .location = entry->_location,
             .kind = BINDING_VALUE,
-            .as.value = entry._data,
+            .as.value = &entry->_data,
         };
     } else {
-        TypeBindingEntry entry = registry._type_bindings.data[index];
+        TypeBindingEntry const* entry = registry._type_bindings.data + index;
         return (Binding){
             .id = id,
-            .location = entry._location,
+            .location = entry->_location,
             .kind = BINDING_TYPE,
-            .as.type = entry._data,
+            .as.type = &entry->_data,
         };
     }
 }
@@ -133,16 +137,14 @@ BindingMut get_binding_mut(BindingRegistry* registry, BindingId id) {
 }
 
 ScopeLocation scope_new(BindingRegistry* registry, ScopeLocation parent) {
-    Scope scope = {
-        ._parent = parent,
-        ._unordered_bindings = array_buf_new(BindingId)(),
-        ._sequential_bindings = array_buf_new(BindingId)(),
-    };
     ScopeLocation location = {
         .scope_id = registry->_scopes.len,
         ._pos = 0,
     };
-    array_buf_push(Scope)(&registry->_scopes, scope);
+    array_buf_push(Scope)(
+        &registry->_scopes,
+        scope_new_in(registry->_allocator, parent)
+    );
     return location;
 }
 
@@ -154,7 +156,7 @@ ScopeLocation scope_end_location(BindingRegistry registry, ScopeId scope) {
 static bool alloc_binding_entry(
     BindingRegistry* registry,
     ScopeLocation location,
-    String name,
+    Atom name,
     bool sequential,
     BindingKind kind,
     BindingMut* dst
@@ -191,12 +193,32 @@ static bool alloc_binding_entry(
     }
 
     if (sequential) {
-        array_buf_push(BindingId)(&scope->_sequential_bindings, id);
-        dst->location = (ScopeLocation){ .scope_id = location.scope_id, ._pos = idx };
+        usize pos = scope->_sequential_bindings.len;
+        HashMapEntry(Atom, usize) last =
+            hash_map_entry(Atom, usize)(&scope->_last_sequential_bindings, name);
+        usize* shadowed = hash_map_entry_get(Atom, usize)(last);
+        SequentialBinding binding = {
+            .id = id,
+            ._shadowed = shadowed ? *shadowed : (usize)-1,
+        };
+        array_buf_push(SequentialBinding)(&scope->_sequential_bindings, binding);
+        if (shadowed) {
+            *shadowed = pos;
+        } else {
+            hash_map_entry_insert(Atom, usize)(&last, pos);
+        }
+        dst->location = (ScopeLocation){ .scope_id = location.scope_id, ._pos = pos };
     } else {
-        array_buf_push(BindingId)(&scope->_unordered_bindings, id);
+        hash_map_insert(Atom, BindingId)(&scope->_unordered_bindings, name, id);
         dst->location = (ScopeLocation){ .scope_id = location.scope_id, ._pos = 0 };
     }
+    switch (kind) {
+    case BINDING_TYPE:
+        registry->_type_bindings.data[idx]._location = dst->location;
+        break;
+    case BINDING_VALUE:
+        registry->_value_bindings.data[idx]._location = dst->location;
+    }
     return true;
 }
 
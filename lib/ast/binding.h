@@ -1,11 +1,12 @@
 #pragma once
 
+#include "collections/hash_map.h"
 #include "ast/binding_id.h"
 #include "ast/type.h"
 #include "ast/expression.h"
 
 typedef struct TypeBinding {
-    String name;
+    Atom name;
     TypeId type;
 } TypeBinding;
 
@@ -28,7 +29,7 @@ typedef struct ValueStore {
 } ValueStore;
 
 typedef struct ValueBinding {
-    String name;
+    Atom name;
     TypeId type;
     ValueStore store;
 } ValueBinding;
@@ -43,13 +44,15 @@ typedef enum BindingKind {
     BINDING_VALUE
 } BindingKind;
 
+/// @brief A view of a binding, that points into the registry until more
+/// bindings are inserted.
 typedef struct Binding {
     BindingId id;
     ScopeLocation location;
     BindingKind kind;
     union {
-        TypeBinding type;
-        ValueBinding value;
+        TypeBinding const* type;
+        ValueBinding const* value;
     } as;
 } Binding;
 
@@ -63,10 +66,25 @@ typedef struct BindingMut {
     } as;
 } BindingMut;
 
+DECL_HASH_MAP(Atom, BindingId)
+DECL_HASH_MAP(Atom, usize)
+
+typedef struct SequentialBinding {
+    BindingId id;
+    usize _shadowed;    // position of the previous one with the name, or -1
+} SequentialBinding;
+DECL_ARRAY_BUF(SequentialBinding)
+
+/// @brief The bindings of a scope, indexed by name.
+///
+/// Sequential bindings are only visible after their position, so each one
+/// links to the one it shadows, and lookups walk back from the last binding
+/// of the name until one comes before the position.
 typedef struct Scope {
     ScopeLocation _parent; // -1,-1 if no parent
-    ArrayBuf(BindingId) _unordered_bindings;
-    ArrayBuf(BindingId) _sequential_bindings;
+    HashMap(Atom, BindingId) _unordered_bindings;
+    ArrayBuf(SequentialBinding) _sequential_bindings;
+    HashMap(Atom, usize) _last_sequential_bindings;    // positions by name
 } Scope;
 DECL_ARRAY_BUF(Scope);
 
@@ -86,15 +104,19 @@ typedef struct BindingRegistry {
     ArrayBuf(TypeBindingEntry) _type_bindings;
     ArrayBuf(ValueBindingEntry) _value_bindings;
     ArrayBuf(Scope) _scopes;
+    Allocator* _allocator;
 } BindingRegistry;
 
 BindingRegistry binding_registry_new(void);
+/// @brief A registry whose bindings and scopes are allocated from
+/// `allocator`.
+BindingRegistry binding_registry_new_in(Allocator* allocator);
 void binding_registry_free(BindingRegistry* registry);
 
 bool find_binding(
     BindingRegistry registry,
     ScopeLocation location,
-    String name,
+    Atom name,
     BindingId* dst
 );
 
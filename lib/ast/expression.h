@@ -1,12 +1,13 @@
 #pragma once
 
 #include "collections/array.h"
+#include "collections/interner.h"
 #include "ast/type.h"
 #include "ast/binding_id.h"
 #include "emitter/emitter.h"
 
 typedef struct Identifier {
-    String string;
+    Atom atom;
     Range range;
 } Identifier;
 
@@ -65,6 +66,9 @@ typedef struct Function {
     TypeName output_type_name;
     TypeId output_type;
     ScopeId output_scope;
+    /// @brief Declared without a body, to call the function that another
+    /// module exports under the name of its constant. It has no `output`.
+    bool external;
     ExpressionId output;
     SymbolIndex symbol;
     usize function_id;
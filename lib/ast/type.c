@@ -14,13 +14,21 @@ IMPL_HASH_MAP(FunctionType, TypeId)
 IMPL_ARRAY_BUF(Type)
 
 TypeRegistry type_registry_new(void) {
-    ArrayBuf(Type) types = array_buf_new(Type)();
+    return type_registry_new_in(NULL);
+}
+
+TypeRegistry type_registry_new_in(Allocator* allocator) {
+    ArrayBuf(Type) types = array_buf_new_in(Type)(allocator);
     array_buf_push(Type)(&types, (Type){ .kind = TYPE_BOOL });
-    return (TypeRegistry){ ._types = types };
+    return (TypeRegistry){
+        ._types = types,
+        ._function_types = hash_map_new_in(FunctionType, TypeId)(allocator),
+    };
 }
 
 void type_registry_free(TypeRegistry* type_registry) {
     array_buf_free(Type)(&type_registry->_types);
+    hash_map_free(FunctionType, TypeId)(&type_registry->_function_types);
 }
 
 Type get_type(TypeRegistry registry, TypeId type) {
@@ -43,3 +51,25 @@ TypeId get_or_register_function_type(TypeRegistry* registry, FunctionType type)
     }
     return register_type(registry, (Type){ .kind = TYPE_FUNCTION, .as.function = type });
 }
+
+void write_type(TypeRegistry registry, TypeId type, StringBuf* dst) {
+    if (type == TYPE_INVALID) {
+        string_buf_push(dst, '?');
+        return;
+    }
+    Type resolved = get_type(registry, type);
+    switch (resolved.kind) {
+    case TYPE_BOOL:
+        string_buf_extend(dst, "Bool");
+        return;
+    case TYPE_FUNCTION:;
+        FunctionType function = resolved.as.function;
+        bool nested = function.input != TYPE_INVALID
+            && get_type(registry, function.input).kind == TYPE_FUNCTION;
+        string_buf_extend(dst, nested ? "fn (" : "fn ");
+        write_type(registry, function.input, dst);
+        string_buf_extend(dst, nested ? ") -> " : " -> ");
+        write_type(registry, function.output, dst);
+        return;
+    }
+}
@@ -2,6 +2,7 @@
 
 #include "collections/array.h"
 #include "collections/hash_map.h"
+#include "collections/string.h"
 
 typedef usize TypeId;
 #define TYPE_INVALID ((TypeId)(-1))
@@ -35,8 +36,14 @@ typedef struct TypeRegistry {
 } TypeRegistry;
 
 TypeRegistry type_registry_new(void);
+/// @brief A registry whose types are allocated from `allocator`.
+TypeRegistry type_registry_new_in(Allocator* allocator);
 void type_registry_free(TypeRegistry* type_registry);
 
 Type get_type(TypeRegistry registry, TypeId type);
 TypeId register_type(TypeRegistry* registry, Type type);
 TypeId get_or_register_function_type(TypeRegistry* registry, FunctionType type);
+
+/// @brief Appends the type to `dst` the way it is written in the source, like
+/// `fn (fn Bool -> Bool) -> Bool`. Types that did not resolve are written `?`.
+void write_type(TypeRegistry registry, TypeId type, StringBuf* dst);
@@ -79,12 +79,156 @@ void bytecode_write_variable_index(Bytecode* bytecode, usize index) {
     bytecode_write_byteword(bytecode, (Byteword)index);
 }
 
+static DecodeError decode_byteword(
+    Byteword const** ip,
+    Byteword const* end,
+    Byteword* dst
+) {
+    if (*ip >= end) {
+        *ip = end;
+        return DECODE_TRUNCATED;
+    }
+    *dst = bytecode_read_byteword(ip);
+    return DECODE_OK;
+}
+
+static DecodeError decode_word(Byteword const** ip, Byteword const* end, Word* dst) {
+    usize padding =
+        (alignof(Word) - (uptr)*ip % alignof(Word)) % alignof(Word) / sizeof(Byteword);
+    if ((usize)(end - *ip) < padding + sizeof(Word) / sizeof(Byteword)) {
+        *ip = end;
+        return DECODE_TRUNCATED;
+    }
+    for (usize i = 0; i < padding; i++) {
+        if (*((*ip)++) != 0) {
+            return DECODE_MISALIGNED_IMMEDIATE;
+        }
+    }
+    *dst = bytecode_read_word(ip);
+    return DECODE_OK;
+}
+
+static DecodeError decode_operand(
+    Byteword const** ip,
+    Byteword const* end,
+    BytecodeOperandKind kind,
+    BytecodeOperand* dst
+) {
+    DecodeError error;
+    Byteword byteword;
+    Word word;
+    switch (kind) {
+    case OPERAND_IMB:
+        return decode_byteword(ip, end, &dst->imb);
+    case OPERAND_IMW:
+        return decode_word(ip, end, &dst->imw);
+    case OPERAND_LOC:
+        error = decode_word(ip, end, &word);
+        dst->loc = word.as_uint;
+        return error;
+    case OPERAND_VAR:
+        error = decode_byteword(ip, end, &byteword);
+        dst->var = byteword;
+        return error;
+    }
+    return DECODE_OK;
+}
+
+#define OPERAND_KIND_imb OPERAND_IMB
+#define OPERAND_KIND_imw OPERAND_IMW
+#define OPERAND_KIND_loc OPERAND_LOC
+#define OPERAND_KIND_var OPERAND_VAR
+#define DECODE_ARG(idx, kind, ...)                                              \
+    dst->kinds[idx] = OPERAND_KIND_##kind;                                      \
+    dst->operands_len = idx + 1;                                                \
+    error = decode_operand(ip, end, OPERAND_KIND_##kind, &dst->operands[idx]);  \
+    if (error != DECODE_OK) {                                                   \
+        return error;                                                           \
+    }
+#define DECODE_CASE(code, mnemo, ...)                                           \
+    case code:                                                                  \
+        FOR_ALL(DECODE_ARG __VA_OPT__(, __VA_ARGS__))                           \
+        return DECODE_OK;
+
+DecodeError bytecode_decode(
+    Byteword const** ip,
+    Byteword const* end,
+    BytecodeInstruction* dst
+) {
+    DecodeError error;
+    Byteword byteword;
+    *dst = (BytecodeInstruction){ .opcode = OP_NOP };
+    error = decode_byteword(ip, end, &byteword);
+    if (error != DECODE_OK) {
+        return error;
+    }
+    dst->opcode = (Opcode)byteword;
+    switch (dst->opcode) {
+    FOR_OPERATIONS(DECODE_CASE)
+
+    case OP_SYS:
+        error = decode_byteword(ip, end, &byteword);
+        if (error != DECODE_OK) {
+            return error;
+        }
+        dst->syscall = (Syscall)byteword;
+        switch (dst->syscall) {
+        FOR_SYSCALLS(DECODE_CASE)
+        default:
+            return DECODE_INVALID_SYSCALL;
+        }
+
+    default:
+        return DECODE_INVALID_OPCODE;
+    }
+}
+
+#define WRITE_ARG_imb(idx)                                                      \
+    bytecode_write_byteword(bytecode, instruction->operands[idx].imb);
+#define WRITE_ARG_imw(idx)                                                      \
+    bytecode_write_word(bytecode, instruction->operands[idx].imw);
+#define WRITE_ARG_loc(idx)                                                      \
+    if (locations) {                                                            \
+        array_buf_push(usize)(locations, bytecode->instructions.len);           \
+    }                                                                           \
+    bytecode_write_location(bytecode, instruction->operands[idx].loc);
+#define WRITE_ARG_var(idx)                                                      \
+    bytecode_write_variable_index(bytecode, instruction->operands[idx].var);
+#define WRITE_ARG(idx, kind, ...) WRITE_ARG_##kind(idx)
+#define WRITE_CASE(code, mnemo, ...)                                            \
+    case code:                                                                  \
+        FOR_ALL(WRITE_ARG __VA_OPT__(, __VA_ARGS__))                            \
+        break;
+
+void bytecode_write_instruction(
+    Bytecode* bytecode,
+    BytecodeInstruction const* instruction,
+    ArrayBuf(usize)* locations
+) {
+    bytecode_write_opcode(bytecode, instruction->opcode);
+    switch (instruction->opcode) {
+    FOR_OPERATIONS(WRITE_CASE)
+
+    case OP_SYS:
+        bytecode_write_syscall(bytecode, instruction->syscall);
+        switch (instruction->syscall) {
+        FOR_SYSCALLS(WRITE_CASE)
+        default:
+            break;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
 bool eq(Mnemonic)(Mnemonic a, Mnemonic b) {
     return *(const u64*)&a == *(const u64*)&b;
 }
 
 void hash(Mnemonic)(Hasher* hasher, Mnemonic mnemo) {
-    hash(u64)(hasher, *(const u64*)&mnemo);
+    hash_bytes(hasher, mnemo.chars, sizeof(mnemo.chars));
 }
 
 #define OPERATION_MNEMONIC(opcode, mnemo, ...) [opcode] = { #mnemo },
@@ -102,6 +102,66 @@ typedef enum Opcode {
     /// top of the stack and pushes their sum.
     OP_ADU,
 
+    // Superinstructions. The fuser rewrites common sequences of the
+    // instructions above into these.
+
+    /// @brief `adl` -- add two `UInt` local variables together and store the
+    /// sum in a third one. Fused form of `var %a; var %b; adu; set %c`.
+    ///
+    /// @param a the index of the first operand.
+    /// @param b the index of the second operand.
+    /// @param c the index of the variable to be written.
+    OP_ADL,
+
+    /// @brief `adi` -- add a constant to the `UInt` at the top of the stack.
+    /// Fused form of `sca n; adu`.
+    ///
+    /// @param n the constant (64-bit immediate).
+    OP_ADI,
+
+    /// @brief `inc` -- add a constant to a `UInt` local variable. Fused form
+    /// of `var %a; sca n; adu; set %a`.
+    ///
+    /// @param a the index of the variable.
+    /// @param n the constant (64-bit immediate).
+    OP_INC,
+
+    /// @brief `jeq` -- jump to the specified memory location if a `UInt` local
+    /// variable is equal to a constant. Fused form of
+    /// `var %a; sca n; equ; jnz :loc`.
+    ///
+    /// @param a the index of the variable.
+    /// @param n the constant (64-bit immediate).
+    /// @param loc the location of the instruction to jump to.
+    OP_JEQ,
+
+    /// @brief `jne` -- jump to the specified memory location if a `UInt` local
+    /// variable is different from a constant. Fused form of
+    /// `var %a; sca n; neu; jnz :loc`.
+    ///
+    /// @param a the index of the variable.
+    /// @param n the constant (64-bit immediate).
+    /// @param loc the location of the instruction to jump to.
+    OP_JNE,
+
+    /// @brief `jge` -- jump to the specified memory location if a `UInt` local
+    /// variable is greater than or equal to a constant. Fused form of
+    /// `var %a; sca n; geu; jnz :loc`.
+    ///
+    /// @param a the index of the variable.
+    /// @param n the constant (64-bit immediate).
+    /// @param loc the location of the instruction to jump to.
+    OP_JGE,
+
+    /// @brief `jgt` -- jump to the specified memory location if a `UInt` local
+    /// variable is greater than a constant. Fused form of
+    /// `var %a; sca n; gtu; jnz :loc`.
+    ///
+    /// @param a the index of the variable.
+    /// @param n the constant (64-bit immediate).
+    /// @param loc the location of the instruction to jump to.
+    OP_JGT,
+
     OPCODES_LEN,
 } Opcode;
 
@@ -159,23 +219,30 @@ void bytecode_write_location_at(Byteword** ip, usize symbol);
 #define bytecode_write_loc bytecode_write_location
 #define bytecode_write_var bytecode_write_variable_index
 
-#define FOR_OPERATIONS(proc)    \
-    proc(OP_NOP, nop)           \
-    proc(OP_CAL, cal)           \
-    proc(OP_RES, res, imb)      \
-    proc(OP_RET, ret)           \
-    proc(OP_SCA, sca, imw)      \
-    proc(OP_LOC, loc, loc)      \
-    proc(OP_VAR, var, var)      \
-    proc(OP_SET, set, var)      \
-    proc(OP_POP, pop)           \
-    proc(OP_JMP, jmp, loc)      \
-    proc(OP_JNZ, jnz, loc)      \
-    proc(OP_EQU, equ)           \
-    proc(OP_NEU, neu)           \
-    proc(OP_GEU, geu)           \
-    proc(OP_GTU, gtu)           \
-    proc(OP_ADU, adu)           \
+#define FOR_OPERATIONS(proc)            \
+    proc(OP_NOP, nop)                   \
+    proc(OP_CAL, cal)                   \
+    proc(OP_RES, res, imb)              \
+    proc(OP_RET, ret)                   \
+    proc(OP_SCA, sca, imw)              \
+    proc(OP_LOC, loc, loc)              \
+    proc(OP_VAR, var, var)              \
+    proc(OP_SET, set, var)              \
+    proc(OP_POP, pop)                   \
+    proc(OP_JMP, jmp, loc)              \
+    proc(OP_JNZ, jnz, loc)              \
+    proc(OP_EQU, equ)                   \
+    proc(OP_NEU, neu)                   \
+    proc(OP_GEU, geu)                   \
+    proc(OP_GTU, gtu)                   \
+    proc(OP_ADU, adu)                   \
+    proc(OP_ADL, adl, var, var, var)    \
+    proc(OP_ADI, adi, imw)              \
+    proc(OP_INC, inc, var, imw)         \
+    proc(OP_JEQ, jeq, var, imw, loc)    \
+    proc(OP_JNE, jne, var, imw, loc)    \
+    proc(OP_JGE, jge, var, imw, loc)    \
+    proc(OP_JGT, jgt, var, imw, loc)    \
 
 #define FOR_SYSCALLS(proc)      \
     proc(SYS_NOP, nop)          \
@@ -193,6 +260,66 @@ void bytecode_write_location_at(Byteword** ip, usize symbol);
 #define FOR_ALL3(proc, c, ...)  \
     proc(2, c)
 
+/// @brief The most operands an instruction has, see `FOR_ALL`.
+#define BYTECODE_MAX_OPERANDS 3
+
+typedef enum BytecodeOperandKind {
+    OPERAND_IMB,
+    OPERAND_IMW,
+    OPERAND_LOC,
+    OPERAND_VAR,
+} BytecodeOperandKind;
+
+typedef union BytecodeOperand {
+    Byteword imb;
+    Word imw;
+    usize loc;  // an offset in bytewords, or a symbol index until it is fixed up
+    usize var;
+} BytecodeOperand;
+
+/// @brief An instruction read by `bytecode_decode`, with its immediates
+/// widened.
+typedef struct BytecodeInstruction {
+    Opcode opcode;
+    Syscall syscall;    // if `opcode` is `OP_SYS`
+    u8 operands_len;
+    BytecodeOperandKind kinds[BYTECODE_MAX_OPERANDS];
+    BytecodeOperand operands[BYTECODE_MAX_OPERANDS];
+} BytecodeInstruction;
+
+typedef enum DecodeError {
+    DECODE_OK,
+    DECODE_INVALID_OPCODE,
+    DECODE_INVALID_SYSCALL,
+    DECODE_TRUNCATED,               // an immediate runs past the end
+    DECODE_MISALIGNED_IMMEDIATE,    // the padding before a word is not zeroed
+} DecodeError;
+
+/// @brief Reads the instruction at `*ip`, without reading at or past `end`.
+///
+/// Word immediates are aligned like a `Word` in memory, after padding
+/// bytewords that must be zero.
+///
+/// @return `DECODE_OK` with `*ip` past the instruction, or the problem found
+/// with `*ip` past the culprit byteword, or at `end` if the instruction is
+/// truncated.
+DecodeError bytecode_decode(
+    Byteword const** ip,
+    Byteword const* end,
+    BytecodeInstruction* dst
+);
+
+/// @brief Writes an instruction like `bytecode_decode` reads it back, with
+/// the operands its opcode and syscall take.
+///
+/// @param locations gets the offset each location operand is written at, it
+/// may be `NULL`.
+void bytecode_write_instruction(
+    Bytecode* bytecode,
+    BytecodeInstruction const* instruction,
+    ArrayBuf(usize)* locations
+);
+
 typedef struct Mnemonic {
     alignas(u64) char chars[8];
 } Mnemonic;
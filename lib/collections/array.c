@@ -1,5 +1,8 @@
 #include "collections/array.h"
 
+IMPL_ARRAY_BUF(u8)
+IMPL_ARRAY_BUF(u16)
+IMPL_ARRAY_BUF(u32)
 IMPL_ARRAY_BUF(i32)
 IMPL_ARRAY_BUF(usize)
 IMPL_ARRAY_BUF(char)
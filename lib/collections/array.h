@@ -1,6 +1,8 @@
 #pragma once
 
+#include <stdalign.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "primitives/primitives.h"
 #include "alloc/buf.h"
@@ -10,54 +12,145 @@ typedef struct Range {
     usize end;
 } Range;
 
+/// @brief The capacity an array of `capacity` elements grows to when it needs
+/// `min_capacity`, by half of what it has so that pushes are amortized.
+static inline usize array_buf_grown_capacity(usize capacity, usize min_capacity) {
+    usize next_capacity = (capacity < 4) ? 4 : capacity + capacity / 2;
+    return (min_capacity > next_capacity) ? min_capacity : next_capacity;
+}
+
 #define ArrayBuf(T) ArrayBuf_##T
 
-#define array_buf_new(T)        array_buf_new_##T
-#define array_buf_free(T)       array_buf_free_##T
-#define array_buf_reserve(T)    array_buf_reserve_##T
-#define array_buf_push(T)       array_buf_push_##T
-#define array_buf_extend(T)     array_buf_extend_##T
-#define array_buf_pop(T)        array_buf_pop_##T
+#define array_buf_new(T)            array_buf_new_##T
+#define array_buf_new_in(T)         array_buf_new_in_##T
+#define array_buf_free(T)           array_buf_free_##T
+#define array_buf_reserve(T)        array_buf_reserve_##T
+#define array_buf_reserve_exact(T)  array_buf_reserve_exact_##T
+#define array_buf_try_reserve(T)    array_buf_try_reserve_##T
+#define array_buf_shrink_to_fit(T)  array_buf_shrink_to_fit_##T
+#define array_buf_push(T)           array_buf_push_##T
+#define array_buf_try_push(T)       array_buf_try_push_##T
+#define array_buf_extend(T)         array_buf_extend_##T
+#define array_buf_extend_n(T)       array_buf_extend_n_##T
+#define array_buf_pop(T)            array_buf_pop_##T
 
+// Pushes are inlined, and only call out of line when the array is full.
 #define DECL_ARRAY_BUF(T)                                                       \
     typedef struct ArrayBuf(T) {                                                \
         T* data;                                                                \
         usize len;                                                              \
         usize capacity;                                                         \
+        Allocator* allocator;   /* NULL for the heap */                         \
     } ArrayBuf(T);                                                              \
                                                                                 \
     ArrayBuf(T)                                                                 \
     array_buf_new(T)(void);                                                     \
                                                                                 \
+    /* an array whose data is allocated from `allocator`. */                    \
+    ArrayBuf(T)                                                                 \
+    array_buf_new_in(T)(Allocator* allocator);                                  \
+                                                                                \
     void                                                                        \
     array_buf_free(T)(                                                          \
         ArrayBuf(T)* array                                                      \
     );                                                                          \
                                                                                 \
+    /* makes room for `additional` elements, growing geometrically. */          \
     void                                                                        \
     array_buf_reserve(T)(                                                       \
         ArrayBuf(T)* array,                                                     \
         usize additional                                                        \
     );                                                                          \
                                                                                 \
+    /* makes room for exactly `additional` elements, for arrays whose final     \
+    length is known. */                                                         \
     void                                                                        \
-    array_buf_push(T)(                                                          \
+    array_buf_reserve_exact(T)(                                                 \
         ArrayBuf(T)* array,                                                     \
-        T value                                                                 \
+        usize additional                                                        \
     );                                                                          \
                                                                                 \
+    /* like `array_buf_reserve`, but returns false when the allocator          \
+    refuses instead of exiting, and leaves the array as it was. */              \
+    bool                                                                        \
+    array_buf_try_reserve(T)(                                                   \
+        ArrayBuf(T)* array,                                                     \
+        usize additional                                                        \
+    );                                                                          \
+                                                                                \
+    /* gives back the capacity past the length. */                              \
     void                                                                        \
+    array_buf_shrink_to_fit(T)(                                                 \
+        ArrayBuf(T)* array                                                      \
+    );                                                                          \
+                                                                                \
+    static inline void                                                          \
+    array_buf_push(T)(                                                          \
+        ArrayBuf(T)* array,                                                     \
+        T value                                                                 \
+    ) {                                                                         \
+        if (array->len == array->capacity) {                                    \
+            array_buf_reserve(T)(array, 1);                                     \
+        }                                                                       \
+        array->data[array->len++] = value;                                      \
+    }                                                                           \
+                                                                                \
+    static inline bool                                                          \
+    array_buf_try_push(T)(                                                      \
+        ArrayBuf(T)* array,                                                     \
+        T value                                                                 \
+    ) {                                                                         \
+        if (                                                                    \
+            array->len == array->capacity                                       \
+            && !array_buf_try_reserve(T)(array, 1)                              \
+        ) {                                                                     \
+            return false;                                                       \
+        }                                                                       \
+        array->data[array->len++] = value;                                      \
+        return true;                                                            \
+    }                                                                           \
+                                                                                \
+    static inline void                                                          \
     array_buf_extend(T)(                                                        \
         ArrayBuf(T)* array,                                                     \
         T const* values,                                                        \
         usize len                                                               \
-    );                                                                          \
-    \
-    T   \
-    array_buf_pop(T)(       \
-        ArrayBuf(T)* array  \
-    );                      \
+    ) {                                                                         \
+        if (array->capacity - array->len < len) {                               \
+            array_buf_reserve(T)(array, len);                                   \
+        }                                                                       \
+        if (len != 0) {                                                         \
+            memcpy(array->data + array->len, values, len * sizeof(T));          \
+        }                                                                       \
+        array->len += len;                                                      \
+    }                                                                           \
+                                                                                \
+    /* appends `len` uninitialized elements, and returns the first one for      \
+    the caller to fill in. */                                                   \
+    static inline T*                                                            \
+    array_buf_extend_n(T)(                                                      \
+        ArrayBuf(T)* array,                                                     \
+        usize len                                                               \
+    ) {                                                                         \
+        if (array->capacity - array->len < len) {                               \
+            array_buf_reserve(T)(array, len);                                   \
+        }                                                                       \
+        T* first = array->data + array->len;                                    \
+        array->len += len;                                                      \
+        return first;                                                           \
+    }                                                                           \
+                                                                                \
+    static inline T                                                             \
+    array_buf_pop(T)(                                                           \
+        ArrayBuf(T)* array                                                      \
+    ) {                                                                         \
+        return array->data[--array->len];                                       \
+    }                                                                           \
 
+
+DECL_ARRAY_BUF(u8);
+DECL_ARRAY_BUF(u16);
+DECL_ARRAY_BUF(u32);
 DECL_ARRAY_BUF(i32);
 DECL_ARRAY_BUF(usize);
 DECL_ARRAY_BUF(char);
@@ -65,77 +158,112 @@ DECL_ARRAY_BUF(char);
 #define IMPL_ARRAY_BUF_NEW(T)                                                   \
     ArrayBuf(T)                                                                 \
     array_buf_new(T)(void) {                                                    \
+        return array_buf_new_in(T)(NULL);                                       \
+    }                                                                           \
+                                                                                \
+    ArrayBuf(T)                                                                 \
+    array_buf_new_in(T)(Allocator* allocator) {                                 \
         return (ArrayBuf(T)){                                                   \
             .data = NULL,                                                       \
             .len = 0,                                                           \
-            .capacity = 0                                                       \
+            .capacity = 0,                                                      \
+            .allocator = allocator,                                             \
         };                                                                      \
     }                                                                           \
 
+
 #define IMPL_ARRAY_BUF_FREE(T)                                                  \
     void                                                                        \
     array_buf_free(T)(                                                          \
         ArrayBuf(T)* array                                                      \
     ) {                                                                         \
-        free(array->data);                                                      \
+        allocator_free(                                                         \
+            array->allocator,                                                   \
+            array->data,                                                        \
+            array->capacity * sizeof(T)                                         \
+        );                                                                      \
     }                                                                           \
 
+
 #define IMPL_ARRAY_BUF_RESERVE(T)                                               \
     void                                                                        \
-    array_buf_reserve(T)(                                                       \
+    array_buf_reserve_exact(T)(                                                 \
         ArrayBuf(T)* array,                                                     \
         usize additional                                                        \
     ) {                                                                         \
-        Buf buf = {                                                             \
-            .data = (void*)array->data,                                         \
-            .size = array->len * sizeof(T),                                     \
-            .capacity = array->capacity * sizeof(T),                            \
-        };                                                                      \
-        buf_reserve(&buf, additional * sizeof(T));                              \
-        array->data = (T*)buf.data;                                             \
-        array->len = buf.size / sizeof(T);                                      \
-        array->capacity = buf.capacity / sizeof(T);                             \
+        usize new_capacity = array->len + additional;                           \
+        if (new_capacity <= array->capacity) return;                            \
+        /* sizes are whole elements, so that allocators get back the sizes      \
+        they handed out. */                                                     \
+        array->data = allocator_realloc(                                        \
+            array->allocator,                                                   \
+            array->data,                                                        \
+            array->capacity * sizeof(T),                                        \
+            new_capacity * sizeof(T),                                           \
+            alignof(T)                                                          \
+        );                                                                      \
+        array->capacity = new_capacity;                                         \
     }                                                                           \
-
-#define IMPL_ARRAY_BUF_PUSH(T)                                                  \
+                                                                                \
     void                                                                        \
-    array_buf_push(T)(                                                          \
+    array_buf_reserve(T)(                                                       \
         ArrayBuf(T)* array,                                                     \
-        T value                                                                 \
+        usize additional                                                        \
     ) {                                                                         \
-        array_buf_extend(T)(array, &value, 1);                                  \
+        usize min_capacity = array->len + additional;                           \
+        if (min_capacity <= array->capacity) return;                            \
+        usize new_capacity =                                                    \
+            array_buf_grown_capacity(array->capacity, min_capacity);            \
+        array_buf_reserve_exact(T)(array, new_capacity - array->len);           \
     }                                                                           \
-
-#define IMPL_ARRAY_BUF_EXTEND(T)                                                \
-    void                                                                        \
-    array_buf_extend(T)(                                                        \
+                                                                                \
+    bool                                                                        \
+    array_buf_try_reserve(T)(                                                   \
         ArrayBuf(T)* array,                                                     \
-        T const* values,                                                        \
-        usize len                                                               \
+        usize additional                                                        \
     ) {                                                                         \
-        Buf buf = {                                                             \
-            .data = (void*)array->data,                                         \
-            .size = array->len * sizeof(T),                                     \
-            .capacity = array->capacity * sizeof(T),                            \
-        };                                                                      \
-        buf_extend_or_grow(&buf, values, len * sizeof(T), 1);                   \
-        array->data = (T*)buf.data;                                             \
-        array->len = buf.size / sizeof(T);                                      \
-        array->capacity = buf.capacity / sizeof(T);                             \
+        usize min_capacity = array->len + additional;                           \
+        if (min_capacity <= array->capacity) return true;                       \
+        usize new_capacity =                                                    \
+            array_buf_grown_capacity(array->capacity, min_capacity);            \
+        T* data = allocator_try_realloc(                                        \
+            array->allocator,                                                   \
+            array->data,                                                        \
+            array->capacity * sizeof(T),                                        \
+            new_capacity * sizeof(T),                                           \
+            alignof(T)                                                          \
+        );                                                                      \
+        if (data == NULL) return false;                                         \
+        array->data = data;                                                     \
+        array->capacity = new_capacity;                                         \
+        return true;                                                            \
     }                                                                           \
 
-#define IMPL_ARRAY_BUF_POP(T)                                                   \
-    T                                                                           \
-    array_buf_pop(T)(                                                           \
+
+#define IMPL_ARRAY_BUF_SHRINK_TO_FIT(T)                                         \
+    void                                                                        \
+    array_buf_shrink_to_fit(T)(                                                 \
         ArrayBuf(T)* array                                                      \
     ) {                                                                         \
-        return array->data[--array->len];                                       \
-    }
+        if (array->len == array->capacity) return;                              \
+        if (array->len == 0) {                                                  \
+            array_buf_free(T)(array);                                           \
+            array->data = NULL;                                                 \
+        } else {                                                                \
+            array->data = allocator_realloc(                                    \
+                array->allocator,                                               \
+                array->data,                                                    \
+                array->capacity * sizeof(T),                                    \
+                array->len * sizeof(T),                                         \
+                alignof(T)                                                      \
+            );                                                                  \
+        }                                                                       \
+        array->capacity = array->len;                                           \
+    }                                                                           \
+
 
 #define IMPL_ARRAY_BUF(T)                                                       \
     IMPL_ARRAY_BUF_NEW(T)                                                       \
     IMPL_ARRAY_BUF_FREE(T)                                                      \
     IMPL_ARRAY_BUF_RESERVE(T)                                                   \
-    IMPL_ARRAY_BUF_PUSH(T)                                                      \
-    IMPL_ARRAY_BUF_EXTEND(T)    \
-    IMPL_ARRAY_BUF_POP(T)                                                \
+    IMPL_ARRAY_BUF_SHRINK_TO_FIT(T)                                             \
@@ -1,3 +1,4 @@
 #include "collections/hash_map.h"
 
 IMPL_HASH_MAP(usize, usize)
+IMPL_HASH_MAP(String, usize)
@@ -4,10 +4,16 @@
 #include <string.h>
 #include <stdalign.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "ops/eq.h"
 #include "ops/hash.h"
 #include "ops/ptr.h"
 #include "alloc/alloc.h"
+#include "alloc/allocator.h"
+#include "diagnostics/errno.h"
 
 #define HASH_MAP_NAME(name, KEY, VALUE) name##_##KEY##_##VALUE
 
@@ -15,31 +21,98 @@
 #define HashMapEntry(KEY, VALUE) HASH_MAP_NAME(HashMapEntry, KEY, VALUE)
 
 #define hash_map_new(KEY, VALUE) HASH_MAP_NAME(hash_map_new, KEY, VALUE)
+#define hash_map_new_in(KEY, VALUE) HASH_MAP_NAME(hash_map_new_in, KEY, VALUE)
 #define hash_map_free(KEY, VALUE) HASH_MAP_NAME(hash_map_free, KEY, VALUE)
 
 #define hash_map_get(KEY, VALUE) HASH_MAP_NAME(hash_map_get, KEY, VALUE)
 #define hash_map_get_mut(KEY, VALUE) HASH_MAP_NAME(hash_map_get_mut, KEY, VALUE)
 #define hash_map_insert(KEY, VALUE) HASH_MAP_NAME(hash_map_insert, KEY, VALUE)
+#define hash_map_try_insert(KEY, VALUE) HASH_MAP_NAME(hash_map_try_insert, KEY, VALUE)
 #define hash_map_remove(KEY, VALUE) HASH_MAP_NAME(hash_map_remove, KEY, VALUE)
 
 #define hash_map_entry(KEY, VALUE) HASH_MAP_NAME(hash_map_entry, KEY, VALUE)
 #define hash_map_entry_get(KEY, VALUE) HASH_MAP_NAME(hash_map_entry_get, KEY, VALUE)
 #define hash_map_entry_insert(KEY, VALUE) HASH_MAP_NAME(hash_map_entry_insert, KEY, VALUE)
+#define hash_map_entry_try_insert(KEY, VALUE) HASH_MAP_NAME(hash_map_entry_try_insert, KEY, VALUE)
 #define hash_map_entry_remove(KEY, VALUE) HASH_MAP_NAME(hash_map_entry_remove, KEY, VALUE)
 
-typedef enum HashMapSlotOccupancy {
-    HASH_MAP_SLOT_EMPTY,
-    HASH_MAP_SLOT_FULL,
-    HASH_MAP_SLOT_DELETED,
-} HashMapSlotOccupancy;
+/// @brief Hash maps are Swiss tables: every slot has a one-byte tag, and the
+/// slots are probed by groups whose tags are all compared at once, with SSE2
+/// when available.
+///
+/// Full slots are tagged with the top 7 bits of the hash of their key, so
+/// that keys are only compared when their tags match. Empty and deleted slots
+/// have the top bit set instead.
+typedef enum HashMapTag {
+    HASH_MAP_TAG_EMPTY = 0x80,
+    HASH_MAP_TAG_DELETED = 0xfe,
+} HashMapTag;
+
+#define HASH_MAP_GROUP_SIZE 16
+
+/// @brief Bit `i` stands for slot `i` of a group.
+typedef u32 HashMapGroupMask;
+
+static inline bool hash_map_tag_is_full(u8 tag) {
+    return (tag & 0x80) == 0;
+}
+
+static inline u8 hash_map_tag_of(u64 hash) {
+    return (u8)(hash >> 57);
+}
+
+/// @brief The group where probing starts. Its bits are mostly disjoint from
+/// the ones of the tag, so that keys of the same group rarely share a tag.
+static inline usize hash_map_first_group(u64 hash, usize capacity) {
+    return (usize)(hash ^ (hash >> 32)) & (capacity / HASH_MAP_GROUP_SIZE - 1);
+}
+
+static inline HashMapGroupMask hash_map_group_match(u8 const* tags, u8 tag) {
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((__m128i const*)tags);
+    __m128i matches = _mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag));
+    return (HashMapGroupMask)_mm_movemask_epi8(matches);
+#else
+    HashMapGroupMask mask = 0;
+    for (usize i = 0; i < HASH_MAP_GROUP_SIZE; i++) {
+        mask |= (HashMapGroupMask)(tags[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+/// @brief Matches the empty and deleted slots of a group.
+static inline HashMapGroupMask hash_map_group_match_free(u8 const* tags) {
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((__m128i const*)tags);
+    return (HashMapGroupMask)_mm_movemask_epi8(group);
+#else
+    HashMapGroupMask mask = 0;
+    for (usize i = 0; i < HASH_MAP_GROUP_SIZE; i++) {
+        mask |= (HashMapGroupMask)(tags[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline usize hash_map_group_first(HashMapGroupMask mask) {
+    return (usize)__builtin_ctz(mask);
+}
+
+/// @brief Tables are at most 7/8 full, counting deleted slots.
+static inline usize hash_map_max_used(usize capacity) {
+    return capacity - capacity / 8;
+}
 
 #define DECL_HASH_MAP(KEY, VALUE)                                               \
     typedef struct HashMap(KEY, VALUE) {                                        \
-        u8* occupancies;                                                        \
+        u8* tags;                                                               \
         KEY* keys;                                                              \
         VALUE* values;                                                          \
         usize len;                                                              \
-        usize capacity;                                                         \
+        usize capacity;     /* 0 or a power of two, at least a group */         \
+        usize growth_left;  /* empty slots that can be filled before growing */ \
+        Allocator* allocator;   /* NULL for the heap */                         \
     } HashMap(KEY, VALUE);                                                      \
                                                                                 \
     typedef struct HashMapEntry(KEY, VALUE) {                                   \
@@ -54,6 +127,10 @@ typedef enum HashMapSlotOccupancy {
     HashMap(KEY, VALUE)                                                         \
     hash_map_new(KEY, VALUE)(void);                                             \
                                                                                 \
+    /* a map whose table is allocated from `allocator`. */                      \
+    HashMap(KEY, VALUE)                                                         \
+    hash_map_new_in(KEY, VALUE)(Allocator* allocator);                          \
+                                                                                \
     void                                                                        \
     hash_map_free(KEY, VALUE)(                                                  \
         HashMap(KEY, VALUE)* hash_map                                           \
@@ -78,6 +155,15 @@ typedef enum HashMapSlotOccupancy {
         VALUE value                                                             \
     );                                                                          \
                                                                                 \
+    /* like `hash_map_insert`, but returns false when the allocator refuses     \
+    to grow the table instead of exiting, and leaves the map as it was. */      \
+    bool                                                                        \
+    hash_map_try_insert(KEY, VALUE)(                                            \
+        HashMap(KEY, VALUE)* hash_map,                                          \
+        KEY key,                                                                \
+        VALUE value                                                             \
+    );                                                                          \
+                                                                                \
     void                                                                        \
     hash_map_remove(KEY, VALUE)(                                                \
         HashMap(KEY, VALUE)* hash_map,                                          \
@@ -101,33 +187,188 @@ typedef enum HashMapSlotOccupancy {
         VALUE value                                                             \
     );                                                                          \
                                                                                 \
+    /* like `hash_map_try_insert`, for an entry. */                             \
+    bool                                                                        \
+    hash_map_entry_try_insert(KEY, VALUE)(                                      \
+        HashMapEntry(KEY, VALUE)* entry,                                        \
+        VALUE value                                                             \
+    );                                                                          \
+                                                                                \
     void                                                                        \
     hash_map_entry_remove(KEY, VALUE)(                                          \
         HashMapEntry(KEY, VALUE)* entry                                         \
     );                                                                          \
 
 
-#define HASH_MAP_MAX_LOAD_FACTOR (0.75)
-
 #define IMPL_HASH_MAP_NEW(KEY, VALUE)                                           \
     HashMap(KEY, VALUE)                                                         \
     hash_map_new(KEY, VALUE)(void) {                                            \
+        return hash_map_new_in(KEY, VALUE)(NULL);                               \
+    }                                                                           \
+                                                                                \
+    HashMap(KEY, VALUE)                                                         \
+    hash_map_new_in(KEY, VALUE)(Allocator* allocator) {                         \
         return (HashMap(KEY, VALUE)){                                           \
+            .tags = NULL,                                                       \
             .keys = NULL,                                                       \
             .values = NULL,                                                     \
             .len = 0,                                                           \
-            .capacity = 0                                                       \
+            .capacity = 0,                                                      \
+            .growth_left = 0,                                                   \
+            .allocator = allocator,                                             \
         };                                                                      \
     }                                                                           \
 
+
 #define IMPL_HASH_MAP_FREE(KEY, VALUE)                                          \
+    /* the tags start a single buffer, followed by the keys and the values. */  \
+    static usize                                                                \
+    HASH_MAP_NAME(hash_map_buf_size, KEY, VALUE)(                               \
+        usize capacity,                                                         \
+        usize* keys_offset,                                                     \
+        usize* values_offset                                                    \
+    ) {                                                                         \
+        *keys_offset = align_up_size(capacity, alignof(KEY));                   \
+        *values_offset = align_up_size(                                         \
+            *keys_offset + capacity * sizeof(KEY),                              \
+            alignof(VALUE)                                                      \
+        );                                                                      \
+        return *values_offset + capacity * sizeof(VALUE);                       \
+    }                                                                           \
+                                                                                \
     void                                                                        \
     hash_map_free(KEY, VALUE)(                                                  \
         HashMap(KEY, VALUE)* hash_map                                           \
     ) {                                                                         \
-        free(hash_map->values);                                                 \
+        if (hash_map->tags == NULL) return;                                     \
+        usize keys_offset, values_offset;                                       \
+        usize bufsz = HASH_MAP_NAME(hash_map_buf_size, KEY, VALUE)(             \
+            hash_map->capacity,                                                 \
+            &keys_offset,                                                       \
+            &values_offset                                                      \
+        );                                                                      \
+        allocator_free(hash_map->allocator, hash_map->tags, bufsz);             \
     }                                                                           \
 
+
+#define IMPL_HASH_MAP_PROBE(KEY, VALUE)                                         \
+    static u64                                                                  \
+    HASH_MAP_NAME(hash_map_key_hash, KEY, VALUE)(KEY key) {                     \
+        Hasher hasher = new_hasher();                                           \
+        hash(KEY)(&hasher, key);                                                \
+        return finish_hash(hasher);                                             \
+    }                                                                           \
+                                                                                \
+    /* looks the key up along its probe sequence, that visits every group       \
+    once. */                                                                    \
+    static bool                                                                 \
+    HASH_MAP_NAME(hash_map_find, KEY, VALUE)(                                   \
+        HashMap(KEY, VALUE) const* hash_map,                                    \
+        KEY key,                                                                \
+        u64 key_hash,                                                           \
+        usize* slot                                                             \
+    ) {                                                                         \
+        u8 tag = hash_map_tag_of(key_hash);                                     \
+        usize groups_mask = hash_map->capacity / HASH_MAP_GROUP_SIZE - 1;       \
+        usize group = hash_map_first_group(key_hash, hash_map->capacity);       \
+        for (usize stride = 1;; stride++) {                                     \
+            usize start = group * HASH_MAP_GROUP_SIZE;                          \
+            u8 const* tags = hash_map->tags + start;                            \
+            HashMapGroupMask matches = hash_map_group_match(tags, tag);         \
+            for (; matches; matches &= matches - 1) {                           \
+                usize i = start + hash_map_group_first(matches);                \
+                if (eq(KEY)(key, hash_map->keys[i])) {                          \
+                    *slot = i;                                                  \
+                    return true;                                                \
+                }                                                               \
+            }                                                                   \
+            /* keys are never placed past a group with an empty slot. */        \
+            if (hash_map_group_match(tags, HASH_MAP_TAG_EMPTY)) {               \
+                return false;                                                   \
+            }                                                                   \
+            /* triangular probing. */                                           \
+            group = (group + stride) & groups_mask;                             \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    /* the first empty or deleted slot along the probe sequence. */             \
+    static usize                                                                \
+    HASH_MAP_NAME(hash_map_find_free, KEY, VALUE)(                              \
+        HashMap(KEY, VALUE) const* hash_map,                                    \
+        u64 key_hash                                                            \
+    ) {                                                                         \
+        usize groups_mask = hash_map->capacity / HASH_MAP_GROUP_SIZE - 1;       \
+        usize group = hash_map_first_group(key_hash, hash_map->capacity);       \
+        for (usize stride = 1;; stride++) {                                     \
+            usize start = group * HASH_MAP_GROUP_SIZE;                          \
+            HashMapGroupMask free_slots =                                       \
+                hash_map_group_match_free(hash_map->tags + start);              \
+            if (free_slots) {                                                   \
+                return start + hash_map_group_first(free_slots);                \
+            }                                                                   \
+            group = (group + stride) & groups_mask;                             \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    /* reallocates the table for `min_len` keys. it only doubles when more      \
+    than half of the usable slots would be full, otherwise dropping the         \
+    deleted slots is enough. returns false when the allocator refuses, and      \
+    leaves the table as it was. */                                              \
+    static bool                                                                 \
+    HASH_MAP_NAME(hash_map_try_rehash, KEY, VALUE)(                             \
+        HashMap(KEY, VALUE)* hash_map,                                          \
+        usize min_len                                                           \
+    ) {                                                                         \
+        usize new_capacity = hash_map->capacity;                                \
+        if (new_capacity == 0) {                                                \
+            new_capacity = HASH_MAP_GROUP_SIZE;                                 \
+        } else if (min_len > hash_map_max_used(new_capacity) / 2) {             \
+            new_capacity *= 2;                                                  \
+        }                                                                       \
+                                                                                \
+        usize keys_offset, values_offset;                                       \
+        usize bufsz = HASH_MAP_NAME(hash_map_buf_size, KEY, VALUE)(             \
+            new_capacity,                                                       \
+            &keys_offset,                                                       \
+            &values_offset                                                      \
+        );                                                                      \
+        u8* new_buf = allocator_try_alloc(                                      \
+            hash_map->allocator,                                                \
+            bufsz,                                                              \
+            alignof(max_align_t)                                                \
+        );                                                                      \
+        if (new_buf == NULL) return false;                                      \
+        HashMap(KEY, VALUE) new_hash_map = {                                    \
+            .tags = new_buf,                                                    \
+            .keys = (KEY*)(new_buf + keys_offset),                              \
+            .values = (VALUE*)(new_buf + values_offset),                        \
+            .len = hash_map->len,                                               \
+            .capacity = new_capacity,                                           \
+            .growth_left = hash_map_max_used(new_capacity) - hash_map->len,     \
+            .allocator = hash_map->allocator,                                   \
+        };                                                                      \
+        memset(new_hash_map.tags, HASH_MAP_TAG_EMPTY, new_capacity);            \
+                                                                                \
+        for (usize i = 0; i < hash_map->capacity; i++) {                        \
+            if (!hash_map_tag_is_full(hash_map->tags[i])) continue;             \
+                                                                                \
+            KEY key = hash_map->keys[i];                                        \
+            u64 key_hash = HASH_MAP_NAME(hash_map_key_hash, KEY, VALUE)(key);   \
+            usize j = HASH_MAP_NAME(hash_map_find_free, KEY, VALUE)(            \
+                &new_hash_map,                                                  \
+                key_hash                                                        \
+            );                                                                  \
+            new_hash_map.tags[j] = hash_map_tag_of(key_hash);                   \
+            new_hash_map.keys[j] = key;                                         \
+            new_hash_map.values[j] = hash_map->values[i];                       \
+        }                                                                       \
+                                                                                \
+        hash_map_free(KEY, VALUE)(hash_map);                                    \
+        *hash_map = new_hash_map;                                               \
+        return true;                                                            \
+    }                                                                           \
+
+
 #define IMPL_HASH_MAP_GET(KEY, VALUE)                                           \
     const VALUE*                                                                \
     hash_map_get(KEY, VALUE)(                                                   \
@@ -138,109 +379,66 @@ typedef enum HashMapSlotOccupancy {
             return NULL;                                                        \
         }                                                                       \
                                                                                 \
-        Hasher hasher = new_hasher();                                           \
-        hash(KEY)(&hasher, key);                                                \
-        u64 hash = finish_hash(hasher);                                         \
-                                                                                \
-        usize start_i = hash % hash_map.capacity;                               \
-        usize i = start_i;                                                      \
-        do {                                                                    \
-            HashMapSlotOccupancy occupancy = hash_map.occupancies[i];           \
-            /* we use if statements instead of a switch to be able to break
-            out of the loop. */                                                 \
-            if (occupancy == HASH_MAP_SLOT_EMPTY) {                             \
-                break;                                                          \
-            } else if (occupancy == HASH_MAP_SLOT_DELETED) {                    \
-                continue;                                                       \
-            }                                                                   \
-                                                                                \
-            KEY key2 = hash_map.keys[i];                                        \
-            if (eq(KEY)(key, key2)) {                                           \
-                return hash_map.values + i;                                     \
-            }                                                                   \
-        } while (                                                               \
-            /* linear probing */                                                \
-            i = (i + 1 == hash_map.capacity) ? 0 : (i + 1), i != start_i        \
-        );                                                                      \
-                                                                                \
+        u64 key_hash = HASH_MAP_NAME(hash_map_key_hash, KEY, VALUE)(key);       \
+        usize slot;                                                             \
+        if (                                                                    \
+            HASH_MAP_NAME(hash_map_find, KEY, VALUE)(                           \
+                &hash_map,                                                      \
+                key,                                                            \
+                key_hash,                                                       \
+                &slot                                                           \
+            )                                                                   \
+        ) {                                                                     \
+            return hash_map.values + slot;                                      \
+        }                                                                       \
         return NULL;                                                            \
     }                                                                           \
 
+
 #define IMPL_HASH_MAP_ENTRY(KEY, VALUE)                                         \
     HashMapEntry(KEY, VALUE)                                                    \
     hash_map_entry(KEY, VALUE)(                                                 \
-        HashMap(KEY, VALUE)* p_hash_map,                                        \
+        HashMap(KEY, VALUE)* hash_map,                                          \
         KEY key                                                                 \
     ) {                                                                         \
-        HashMap(KEY, VALUE) hash_map = *p_hash_map;                             \
-                                                                                \
-        if (hash_map.capacity == 0) {                                           \
+        if (hash_map->capacity == 0) {                                          \
             return (HashMapEntry(KEY, VALUE)){                                  \
-                .hash_map = p_hash_map,                                         \
+                .hash_map = hash_map,                                           \
                 .key = key,                                                     \
                 .has_slot = false,                                              \
                 .has_key_hash = false,                                          \
             };                                                                  \
         }                                                                       \
                                                                                 \
-        Hasher hasher = new_hasher();                                           \
-        hash(KEY)(&hasher, key);                                                \
-        u64 hash = finish_hash(hasher);                                         \
-                                                                                \
-        usize start_i = hash % hash_map.capacity;                               \
-        usize i = start_i;                                                      \
-        usize slot_index = -1;                                                  \
-        do {                                                                    \
-            HashMapSlotOccupancy occupancy = hash_map.occupancies[i];           \
-            /* we use if statements instead of a switch to be able to break
-            out of the loop. */                                                 \
-            if (occupancy == HASH_MAP_SLOT_EMPTY) {                             \
-                if (slot_index == -1) slot_index = i;                           \
-                break;                                                          \
-            } else if (occupancy == HASH_MAP_SLOT_DELETED) {                    \
-                if (slot_index == -1) slot_index = i;                           \
-                continue;                                                       \
-            }                                                                   \
-                                                                                \
-            KEY key2 = hash_map.keys[i];                                        \
-            if (eq(KEY)(key, key2)) {                                           \
-                return (HashMapEntry(KEY, VALUE)) {                             \
-                    .hash_map = p_hash_map,                                     \
-                    .key = key,                                                 \
-                    .has_slot = true,                                           \
-                    .slot_index = i,                                            \
-                    .has_key_hash = true,                                       \
-                    .key_hash = hash,                                           \
-                };                                                              \
-            }                                                                   \
-        } while (                                                               \
-            /* linear probing. */                                               \
-            i = (i + 1 == hash_map.capacity) ? 0 : (i + 1), i != start_i        \
+        u64 key_hash = HASH_MAP_NAME(hash_map_key_hash, KEY, VALUE)(key);       \
+        usize slot;                                                             \
+        bool found = HASH_MAP_NAME(hash_map_find, KEY, VALUE)(                  \
+            hash_map,                                                           \
+            key,                                                                \
+            key_hash,                                                           \
+            &slot                                                               \
         );                                                                      \
-                                                                                \
-        if (                                                                    \
-            slot_index == -1                                                    \
-            || hash_map.len + 1 > HASH_MAP_MAX_LOAD_FACTOR * hash_map.capacity  \
-        ) {                                                                     \
-            return (HashMapEntry(KEY, VALUE)){                                  \
-                .hash_map = p_hash_map,                                         \
-                .key = key,                                                     \
-                .has_slot = false,                                              \
-                .has_key_hash = true,                                           \
-                .key_hash = hash,                                               \
-            };                                                                  \
+        if (!found) {                                                           \
+            slot = HASH_MAP_NAME(hash_map_find_free, KEY, VALUE)(               \
+                hash_map,                                                       \
+                key_hash                                                        \
+            );                                                                  \
         }                                                                       \
-                                                                                \
+        /* filling an empty slot of a full table needs a rehash instead. */     \
+        bool has_slot = found                                                   \
+            || hash_map->tags[slot] != HASH_MAP_TAG_EMPTY                       \
+            || hash_map->growth_left > 0;                                       \
         return (HashMapEntry(KEY, VALUE)){                                      \
-            .hash_map = p_hash_map,                                             \
+            .hash_map = hash_map,                                               \
             .key = key,                                                         \
-            .has_slot = true,                                                   \
-            .slot_index = slot_index,                                           \
+            .has_slot = has_slot,                                               \
+            .slot_index = slot,                                                 \
             .has_key_hash = true,                                               \
-            .key_hash = hash,                                                   \
+            .key_hash = key_hash,                                               \
         };                                                                      \
     }                                                                           \
 
+
 #define IMPL_HASH_MAP_ENTRY_GET(KEY, VALUE)                                     \
     VALUE*                                                                      \
     hash_map_entry_get(KEY, VALUE)(                                             \
@@ -249,12 +447,13 @@ typedef enum HashMapSlotOccupancy {
         if (!entry.has_slot) {                                                  \
             return NULL;                                                        \
         }                                                                       \
-        if (entry.hash_map->occupancies[entry.slot_index] != HASH_MAP_SLOT_FULL) {  \
+        if (!hash_map_tag_is_full(entry.hash_map->tags[entry.slot_index])) {    \
             return NULL;                                                        \
         }                                                                       \
         return entry.hash_map->values + entry.slot_index;                       \
     }                                                                           \
 
+
 #define IMPL_HASH_MAP_GET_MUT(KEY, VALUE)                                       \
     VALUE*                                                                      \
     hash_map_get_mut(KEY, VALUE)(                                               \
@@ -266,6 +465,7 @@ typedef enum HashMapSlotOccupancy {
         return hash_map_entry_get(KEY, VALUE)(entry);                           \
     }                                                                           \
 
+
 #define IMPL_HASH_MAP_INSERT(KEY, VALUE)                                        \
     void                                                                        \
     hash_map_insert(KEY, VALUE)(                                                \
@@ -277,6 +477,18 @@ typedef enum HashMapSlotOccupancy {
             hash_map_entry(KEY, VALUE)(hash_map, key);                          \
         hash_map_entry_insert(KEY, VALUE)(&entry, value);                       \
     }                                                                           \
+                                                                                \
+    bool                                                                        \
+    hash_map_try_insert(KEY, VALUE)(                                            \
+        HashMap(KEY, VALUE)* hash_map,                                          \
+        KEY key,                                                                \
+        VALUE value                                                             \
+    ) {                                                                         \
+        HashMapEntry(KEY, VALUE) entry =                                        \
+            hash_map_entry(KEY, VALUE)(hash_map, key);                          \
+        return hash_map_entry_try_insert(KEY, VALUE)(&entry, value);            \
+    }                                                                           \
+
 
 #define IMPL_HASH_MAP_REMOVE(KEY, VALUE)                                        \
     void                                                                        \
@@ -289,131 +501,86 @@ typedef enum HashMapSlotOccupancy {
         hash_map_entry_remove(KEY, VALUE)(&entry);                              \
     }                                                                           \
 
+
 #define IMPL_HASH_MAP_ENTRY_INSERT(KEY, VALUE)                                  \
-    static usize                                                                \
-    hash_map_insert_in_empty_slot##KEY##_##VALUE(                               \
-        HashMap(KEY, VALUE)* hash_map,                                          \
-        KEY key,                                                                \
-        u64 key_hash,                                                           \
+    void                                                                        \
+    hash_map_entry_insert(KEY, VALUE)(                                          \
+        HashMapEntry(KEY, VALUE)* entry,                                        \
         VALUE value                                                             \
     ) {                                                                         \
-        usize i = key_hash % hash_map->capacity;                                \
-        for (;; i = (i + 1 == hash_map->capacity) ? 0 : (i + 1)) {              \
-            HashMapSlotOccupancy occupancy = hash_map->occupancies[i];          \
-            if (occupancy == HASH_MAP_SLOT_FULL) continue;                      \
-                                                                                \
-            hash_map->occupancies[i] = HASH_MAP_SLOT_FULL;                      \
-            hash_map->keys[i] = key;                                            \
-            hash_map->values[i] = value;                                        \
-            break;                                                              \
+        if (!hash_map_entry_try_insert(KEY, VALUE)(entry, value)) {             \
+            exit_on_errno_or(DUMMY_ERRNO, "memory allocation failed");          \
         }                                                                       \
-        hash_map->len++;                                                        \
-        return i;                                                               \
     }                                                                           \
                                                                                 \
-    void                                                                        \
-    hash_map_entry_insert(KEY, VALUE)(                                          \
+    bool                                                                        \
+    hash_map_entry_try_insert(KEY, VALUE)(                                      \
         HashMapEntry(KEY, VALUE)* entry,                                        \
         VALUE value                                                             \
     ) {                                                                         \
-        if (entry->has_slot) {                                                  \
+        HashMap(KEY, VALUE)* hash_map = entry->hash_map;                        \
+        if (!entry->has_slot) {                                                 \
             if (                                                                \
-                entry->hash_map->occupancies[entry->slot_index]                 \
-                != HASH_MAP_SLOT_FULL                                           \
+                !HASH_MAP_NAME(hash_map_try_rehash, KEY, VALUE)(                \
+                    hash_map,                                                   \
+                    hash_map->len + 1                                           \
+                )                                                               \
             ) {                                                                 \
-                entry->hash_map->occupancies[entry->slot_index] = HASH_MAP_SLOT_FULL;   \
-                entry->hash_map->keys[entry->slot_index] = entry->key;          \
+                return false;                                                   \
             }                                                                   \
-                                                                                \
-            entry->hash_map->values[entry->slot_index] = value;                 \
-            entry->hash_map->len++;                                             \
-            return;                                                             \
-        }                                                                       \
-                                                                                \
-        /* reallocate. */                                                       \
-        usize old_capacity = entry->hash_map->capacity;                         \
-        usize new_capacity = (old_capacity <= 4) ? 8 : 2 * old_capacity;        \
-                                                                                \
-        usize values_bufsz = new_capacity * sizeof(VALUE);                      \
-        usize values_bufsz_aligned = align_up_size(values_bufsz, alignof(KEY)); \
-        usize keys_bufsz = new_capacity * sizeof(KEY);                          \
-        usize occupancies_bufsz = new_capacity * sizeof(u8);                    \
-        usize bufsz = values_bufsz_aligned + keys_bufsz + occupancies_bufsz;    \
-                                                                                \
-        void* new_buf = malloc(bufsz);                                          \
-        HashMap(KEY, VALUE) new_hash_map = {                                    \
-            .occupancies = (u8*)(new_buf + values_bufsz_aligned + keys_bufsz),  \
-            .keys = (KEY*)(new_buf + values_bufsz_aligned),                     \
-            .values = (VALUE*)new_buf,                                          \
-            .len = 0,                                                           \
-            .capacity = new_capacity,                                           \
-        };                                                                      \
-        memset(new_hash_map.occupancies, 0, occupancies_bufsz);                 \
-                                                                                \
-        /* copy over existing entries. */                                       \
-        for (usize i = 0; i < entry->hash_map->capacity; i++) {                 \
-            if (entry->hash_map->occupancies[i] != HASH_MAP_SLOT_FULL) continue;\
-                                                                                \
-            KEY key = entry->hash_map->keys[i];                                 \
-            VALUE value = entry->hash_map->values[i];                           \
-                                                                                \
-            Hasher hasher = new_hasher();                                       \
-            hash(KEY)(&hasher, key);                                            \
-            u64 key_hash = finish_hash(hasher);                                 \
-                                                                                \
-            hash_map_insert_in_empty_slot##KEY##_##VALUE(                       \
-                &new_hash_map,                                                  \
-                key,                                                            \
-                key_hash,                                                       \
-                value                                                           \
+            if (!entry->has_key_hash) {                                         \
+                entry->key_hash =                                               \
+                    HASH_MAP_NAME(hash_map_key_hash, KEY, VALUE)(entry->key);   \
+                entry->has_key_hash = true;                                     \
+            }                                                                   \
+            entry->has_slot = true;                                             \
+            entry->slot_index = HASH_MAP_NAME(hash_map_find_free, KEY, VALUE)(  \
+                hash_map,                                                       \
+                entry->key_hash                                                 \
             );                                                                  \
         }                                                                       \
                                                                                 \
-        /* replace hash map. */                                                 \
-        hash_map_free(KEY, VALUE)(entry->hash_map);                             \
-        *entry->hash_map = new_hash_map;                                        \
-                                                                                \
-        /* insert new entry. */                                                 \
-        u64 key_hash;                                                           \
-        if (entry->has_key_hash) {                                              \
-            key_hash = entry->key_hash;                                         \
-        } else {                                                                \
-            Hasher hasher = new_hasher();                                       \
-            hash(KEY)(&hasher, entry->key);                                     \
-            key_hash = finish_hash(hasher);                                     \
+        u8* tag = hash_map->tags + entry->slot_index;                           \
+        if (!hash_map_tag_is_full(*tag)) {                                      \
+            if (*tag == HASH_MAP_TAG_EMPTY) {                                   \
+                hash_map->growth_left--;                                        \
+            }                                                                   \
+            *tag = hash_map_tag_of(entry->key_hash);                            \
+            hash_map->keys[entry->slot_index] = entry->key;                     \
+            hash_map->len++;                                                    \
         }                                                                       \
-                                                                                \
-        usize i = hash_map_insert_in_empty_slot##KEY##_##VALUE(                 \
-            entry->hash_map,                                                    \
-            entry->key,                                                         \
-            key_hash,                                                           \
-            value                                                               \
-        );                                                                      \
-                                                                                \
-        entry->has_slot = true;                                                 \
-        entry->slot_index = i;                                                  \
-        entry->has_key_hash = true;                                             \
-        entry->key_hash = key_hash;                                             \
+        hash_map->values[entry->slot_index] = value;                            \
+        return true;                                                            \
     }                                                                           \
 
+
 #define IMPL_HASH_MAP_ENTRY_REMOVE(KEY, VALUE)                                  \
     void                                                                        \
     hash_map_entry_remove(KEY, VALUE)(                                          \
         HashMapEntry(KEY, VALUE)* entry                                         \
     ) {                                                                         \
         if (!entry->has_slot) return;                                           \
-        if (                                                                    \
-            entry->hash_map->occupancies[entry->slot_index]                     \
-            != HASH_MAP_SLOT_FULL                                               \
-        ) return;                                                               \
-        entry->hash_map->occupancies[entry->slot_index] = HASH_MAP_SLOT_DELETED;\
-        entry->hash_map->len--;                                                 \
+        HashMap(KEY, VALUE)* hash_map = entry->hash_map;                        \
+        u8* tag = hash_map->tags + entry->slot_index;                           \
+        if (!hash_map_tag_is_full(*tag)) return;                                \
+                                                                                \
+        /* probing stops at groups with an empty slot, so the slot can only be  \
+        emptied when its group has one already. */                              \
+        usize start = align_down_size(entry->slot_index, HASH_MAP_GROUP_SIZE);  \
+        if (hash_map_group_match(hash_map->tags + start, HASH_MAP_TAG_EMPTY)) { \
+            *tag = HASH_MAP_TAG_EMPTY;                                          \
+            hash_map->growth_left++;                                            \
+        } else {                                                                \
+            *tag = HASH_MAP_TAG_DELETED;                                        \
+        }                                                                       \
+        hash_map->len--;                                                        \
     }                                                                           \
 
 
 #define IMPL_HASH_MAP(KEY, VALUE)                                               \
     IMPL_HASH_MAP_NEW(KEY, VALUE)                                               \
     IMPL_HASH_MAP_FREE(KEY, VALUE)                                              \
+    IMPL_HASH_MAP_PROBE(KEY, VALUE)                                             \
                                                                                 \
     IMPL_HASH_MAP_GET(KEY, VALUE)                                               \
     IMPL_HASH_MAP_GET_MUT(KEY, VALUE)                                           \
@@ -425,4 +592,6 @@ typedef enum HashMapSlotOccupancy {
     IMPL_HASH_MAP_ENTRY_INSERT(KEY, VALUE)                                      \
     IMPL_HASH_MAP_ENTRY_REMOVE(KEY, VALUE)                                      \
 
+
 DECL_HASH_MAP(usize, usize)
+DECL_HASH_MAP(String, usize)
@@ -0,0 +1,66 @@
+#include <string.h>
+
+#include "collections/interner.h"
+
+void hash(Atom)(Hasher* hasher, Atom atom) {
+    hash(u32)(hasher, atom);
+}
+
+bool eq(Atom)(Atom a, Atom b) {
+    return a == b;
+}
+
+IMPL_ARRAY_BUF(Atom)
+IMPL_ARRAY_BUF(String)
+IMPL_HASH_MAP(String, Atom)
+
+Interner interner_new(void) {
+    return (Interner){
+        ._strings = array_buf_new(String)(),
+        ._atoms = hash_map_new(String, Atom)(),
+        ._copies = NULL,
+    };
+}
+
+void interner_free(Interner* interner) {
+    array_buf_free(String)(&interner->_strings);
+    hash_map_free(String, Atom)(&interner->_atoms);
+    if (interner->_copies) {
+        arena_free(interner->_copies);
+    }
+}
+
+static Atom intern_with(Interner* interner, String string, bool copy) {
+    HashMapEntry(String, Atom) entry =
+        hash_map_entry(String, Atom)(&interner->_atoms, string);
+    Atom* atom = hash_map_entry_get(String, Atom)(entry);
+    if (atom) {
+        return *atom;
+    }
+    if (copy) {
+        if (!interner->_copies) {
+            interner->_copies = arena_new(0);
+        }
+        char* data = arena_alloc(interner->_copies, string.len, 1);
+        memcpy(data, string.data, string.len);
+        string.data = data;
+        // the entry keeps the key it was looked up with
+        entry.key = string;
+    }
+    Atom new_atom = interner->_strings.len;
+    array_buf_push(String)(&interner->_strings, string);
+    hash_map_entry_insert(String, Atom)(&entry, new_atom);
+    return new_atom;
+}
+
+Atom intern(Interner* interner, String string) {
+    return intern_with(interner, string, false);
+}
+
+Atom intern_copy(Interner* interner, String string) {
+    return intern_with(interner, string, true);
+}
+
+String atom_string(Interner interner, Atom atom) {
+    return interner._strings.data[atom];
+}
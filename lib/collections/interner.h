@@ -0,0 +1,41 @@
+#pragma once
+
+#include "primitives/primitives.h"
+#include "collections/array.h"
+#include "collections/hash_map.h"
+#include "collections/string.h"
+#include "alloc/arena.h"
+
+/// @brief A string that was interned, so that equal strings have equal atoms.
+/// Atoms are dense, in the order the strings were first interned.
+typedef u32 Atom;
+
+void hash(Atom)(Hasher* hasher, Atom atom);
+bool eq(Atom)(Atom a, Atom b);
+
+DECL_ARRAY_BUF(Atom)
+DECL_ARRAY_BUF(String)
+DECL_HASH_MAP(String, Atom)
+
+/// @brief The table of the atoms of identifiers, shared by the tokenizer that
+/// fills it and by whoever compares names.
+typedef struct Interner {
+    ArrayBuf(String) _strings;  // by atom
+    HashMap(String, Atom) _atoms;
+    Arena* _copies;     // of the strings of `intern_copy`, NULL until then
+} Interner;
+
+Interner interner_new(void);
+void interner_free(Interner* interner);
+
+/// @brief Returns the atom of `string`, making a new one the first time.
+///
+/// Strings are not copied, so they must outlive the interner, like the source
+/// they are sliced from.
+Atom intern(Interner* interner, String string);
+
+/// @brief Like `intern`, but copies the string the first time, for strings
+/// that do not outlive the interner.
+Atom intern_copy(Interner* interner, String string);
+
+String atom_string(Interner interner, Atom atom);
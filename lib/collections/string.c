@@ -1,6 +1,5 @@
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
 #include <assert.h>
 
 #include "collections/array.h"
@@ -15,66 +14,130 @@ String string_slice(String string, Range range) {
 }
 
 StringBuf string_buf_new(void) {
-    return (StringBuf){ .data = NULL, .len = 0, .capacity = 0 };
+    return string_buf_new_in(NULL);
+}
+
+StringBuf string_buf_new_in(Allocator* allocator) {
+    return (StringBuf){
+        .data = NULL,
+        .len = 0,
+        .capacity = 0,
+        .allocator = allocator,
+    };
+}
+
+void small_string_buf_init(SmallStringBuf* small) {
+    small->_storage[0] = '\0';
+    small->buf = (StringBuf){
+        .data = small->_storage,
+        .len = 0,
+        .capacity = SMALL_STRING_BUF_CAPACITY,
+        .allocator = NULL,
+        ._borrowed = true,
+    };
 }
 
 StringBuf format(char const* fmt, ...) {
-    // FIXME: error handling
+    va_list args;
+    va_start(args, fmt);
+    StringBuf buf = string_buf_new();
+    vformat_into(&buf, fmt, args);
+    va_end(args);
+    return buf;
+}
 
-    va_list args, args2;
+void format_into(StringBuf* dst, char const* fmt, ...) {
+    va_list args;
     va_start(args, fmt);
-    va_copy(args2, args);
+    vformat_into(dst, fmt, args);
+    va_end(args);
+}
+
+void vformat_into(StringBuf* dst, char const* fmt, va_list args) {
+    // FIXME: error handling
 
+    va_list retry;
+    va_copy(retry, args);
+
+    // the room left includes the NUL terminator.
+    usize available = dst->data ? dst->capacity - dst->len : 0;
     errno = 0;
-    int len = vsnprintf(NULL, 0, fmt, args);
+    char* end = available ? dst->data + dst->len : NULL;
+    int len = vsnprintf(end, available, fmt, args);
     if (len < 0) {
         exit_on_errno(errno);
         exit(-1);
     }
-    va_end(args);
-
-    StringBuf buf = string_buf_new();
-    string_buf_reserve(&buf, len);
-    errno = 0;
-    if (vsnprintf(buf.data, buf.capacity, fmt, args2) < 0) {
-        exit_on_errno(errno);
-        exit(-1);
+    if ((usize)len >= available) {
+        string_buf_reserve(dst, len);
+        errno = 0;
+        if (vsnprintf(dst->data + dst->len, len + 1, fmt, retry) < 0) {
+            exit_on_errno(errno);
+            exit(-1);
+        }
     }
-    va_end(args2);
-    buf.len = len;
-
-    return buf;
+    va_end(retry);
+    dst->len += len;
 }
 
 void string_buf_free(StringBuf* string) {
-    free(string->data);
+    if (!string->_borrowed) {
+        allocator_free(string->allocator, string->data, string->capacity);
+    }
 }
 
 static ArrayBuf(char) to_array(StringBuf* string) {
     return (ArrayBuf(char)){
         .data = string->data,
         .len = string->data ? string->len + 1 : 0,
-        .capacity = string->capacity
+        .capacity = string->capacity,
+        .allocator = string->allocator,
     };
 }
 
-static StringBuf from_array(ArrayBuf(char)* array) {
+// the array only grows strings that own their data, so borrowed storage stays
+// borrowed.
+static StringBuf from_array(ArrayBuf(char)* array, bool borrowed) {
     return (StringBuf){
         .data = array->data,
         .len = array->len != 0 ? array->len - 1 : 0,
-        .capacity = array->capacity
+        .capacity = array->capacity,
+        .allocator = array->allocator,
+        ._borrowed = borrowed,
     };
 }
 
-void string_buf_reserve(StringBuf* string, usize additional) {
-    if (additional == 0) return;
+bool string_buf_try_reserve(StringBuf* string, usize additional) {
+    // strings without data still get their terminator.
+    if (additional == 0 && string->data) return true;
+    if (string->_borrowed) {
+        usize min_capacity = string->len + additional + 1;
+        if (min_capacity <= string->capacity) return true;
+        // leaves the storage for memory of its own, the rest is as usual.
+        usize new_capacity =
+            array_buf_grown_capacity(string->capacity, min_capacity);
+        char* data = allocator_try_alloc(string->allocator, new_capacity, 1);
+        if (data == NULL) return false;
+        memcpy(data, string->data, string->len + 1);
+        string->data = data;
+        string->capacity = new_capacity;
+        string->_borrowed = false;
+        return true;
+    }
     ArrayBuf(char) array = to_array(string);
     usize additional_bytes = (array.len == 0) ? additional + 1 : additional;
-    array_buf_reserve(char)(&array, additional_bytes);
+    if (!array_buf_try_reserve(char)(&array, additional_bytes)) return false;
     if (array.len == 0) {
         array_buf_push(char)(&array, '\0');
     }
-    *string = from_array(&array);
+    *string = from_array(&array, string->_borrowed);
+    return true;
+}
+
+void string_buf_reserve(StringBuf* string, usize additional) {
+    if (!string_buf_try_reserve(string, additional)) {
+        exit_on_errno_or(DUMMY_ERRNO, "memory allocation failed");
+    }
 }
 
 void string_buf_push(StringBuf* string, char c) {
@@ -95,7 +158,7 @@ void string_buf_extend_slice(StringBuf* string, String s) {
     array_buf_extend(char)(&array, s.data, s.len);
     array_buf_push(char)(&array, '\0');
     
-    *string = from_array(&array);
+    *string = from_array(&array, string->_borrowed);
 }
 
 Errno read_file(FILE* file, StringBuf* dst) {
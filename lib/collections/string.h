@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdarg.h>
 #include <stdio.h>
 
 #include "primitives/primitives.h"
@@ -19,13 +20,42 @@ typedef struct StringBuf {
     char* data;
     usize len;              // not including NUL terminator
     usize capacity;         // including NUL terminator
+    Allocator* allocator;   // NULL for the heap
+    bool _borrowed;         // `data` is storage that is not freed
 } StringBuf;
 
+/// @brief Bytes a `SmallStringBuf` holds before it allocates, including the
+/// NUL terminator.
+#define SMALL_STRING_BUF_CAPACITY 128
+
+/// @brief A `StringBuf` that starts in storage of its own, for short strings
+/// like diagnostics that would otherwise each take an allocation.
+///
+/// `buf` points into the storage until it outgrows it, so the structure must
+/// not be moved while `buf` is in use. Copies of `buf` itself are fine.
+typedef struct SmallStringBuf {
+    StringBuf buf;
+    char _storage[SMALL_STRING_BUF_CAPACITY];
+} SmallStringBuf;
+
 StringBuf string_buf_new(void);
+/// @brief A string whose characters are allocated from `allocator`.
+StringBuf string_buf_new_in(Allocator* allocator);
+void small_string_buf_init(SmallStringBuf* small);
 StringBuf format(char const* restrict fmt, ...);
 void string_buf_free(StringBuf* string);
 
+/// @brief Appends the string formatted like `printf` to `dst`. It is only
+/// formatted twice when it does not fit in the capacity left.
+void format_into(StringBuf* dst, char const* restrict fmt, ...);
+void vformat_into(StringBuf* dst, char const* restrict fmt, va_list args);
+
+/// @brief Makes room for `additional` more characters and the terminator, so
+/// that `data` is a valid string afterwards, even if empty.
 void string_buf_reserve(StringBuf* string, usize additional);
+/// @brief Like `string_buf_reserve`, but returns false when the allocator
+/// refuses instead of exiting, and leaves the string as it was.
+bool string_buf_try_reserve(StringBuf* string, usize additional);
 void string_buf_push(StringBuf* string, char c);
 void string_buf_extend(StringBuf* string, char const* s);
 void string_buf_extend_slice(StringBuf* string, String s);
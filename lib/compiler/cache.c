@@ -0,0 +1,223 @@
+#include <inttypes.h>
+
+#include "compiler/cache.h"
+#include "compiler/compiler.h"
+#include "ops/hash.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static void create_directory(char const* path) {
+    // fails harmlessly when the directory exists already.
+    mkdir(path, 0777);
+}
+
+// a file next to `path` that no other compilation opens.
+static FILE* open_temporary(char const* path, StringBuf* temporary) {
+    *temporary = format("%s.XXXXXX", path);
+    int fd = mkstemp(temporary->data);
+    if (fd < 0) {
+        return NULL;
+    }
+    FILE* file = fdopen(fd, "wb");
+    if (!file) {
+        close(fd);
+    }
+    return file;
+}
+#else
+#include <stdatomic.h>
+
+// elsewhere, the directory must exist already.
+static void create_directory(char const* path) {
+    (void)path;
+}
+
+// without `mkstemp`, the name is only unique within the process, so
+// processes should not share a cache.
+static FILE* open_temporary(char const* path, StringBuf* temporary) {
+    static atomic_size_t counter = 0;
+    *temporary = format("%s.%zu.tmp", path, atomic_fetch_add(&counter, 1));
+    return fopen(temporary->data, "wb");
+}
+#endif
+
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+
+#define CACHE_VERSION \
+    "cough " COUGH_VERSION ", image " STRINGIFY(BYTECODE_IMAGE_VERSION)
+
+typedef struct Fingerprint {
+    u64 high;
+    u64 low;
+} Fingerprint;
+
+// two independent 64-bit hashes, since the keys must not collide at all.
+static Fingerprint fingerprint(String version, String source) {
+    Hasher high = new_hasher();
+    Hasher low = new_hasher();
+    hash(u8)(&low, 1);
+    hash(String)(&high, version);
+    hash(String)(&low, version);
+    hash(String)(&high, source);
+    hash(String)(&low, source);
+    return (Fingerprint){ .high = finish_hash(high), .low = finish_hash(low) };
+}
+
+CompileCache compile_cache_new(char const* directory) {
+    create_directory(directory);
+    StringBuf path = string_buf_new();
+    string_buf_extend(&path, directory);
+    return (CompileCache){
+        .directory = path,
+        .version = STRING_LITERAL(CACHE_VERSION),
+        .stats = { 0 },
+    };
+}
+
+void compile_cache_free(CompileCache* cache) {
+    string_buf_free(&cache->directory);
+}
+
+StringBuf compile_cache_path(CompileCache const* cache, String source) {
+    Fingerprint key = fingerprint(cache->version, source);
+    return format(
+        "%s/%016" PRIx64 "%016" PRIx64 ".cbc",
+        cache->directory.data,
+        key.high,
+        key.low
+    );
+}
+
+static void store(CompileCache* cache, BytecodeImage const* image, char const* path) {
+    // written aside first, so that other compilations never load a partial
+    // image, nor write to the same file.
+    StringBuf temporary;
+    FILE* file = open_temporary(path, &temporary);
+    bool ok = file != NULL;
+    if (file) {
+        ok = bytecode_image_write(image, file) == IMAGE_OK;
+        ok = fclose(file) == 0 && ok;
+    }
+    ok = ok && rename(temporary.data, path) == 0;
+    if (ok) {
+        cache->stats.stores++;
+    } else {
+        cache->stats.store_failures++;
+        remove(temporary.data);
+    }
+    string_buf_free(&temporary);
+}
+
+static bool same_function(BytecodeFunction a, BytecodeFunction b) {
+    return a.offset == b.offset
+        && a.locals == b.locals
+        && a.args == b.args
+        && a.results == b.results
+        && a.returns == b.returns
+        && a.max_depth == b.max_depth;
+}
+
+// whether a loaded image could have been stored by `compile_cached`: it is
+// not an object, with references or imports, which runs only once linked, its bytecode decodes, and its
+// metadata is what the verifier finds, or the unbounded one of a module
+// without an entry point.
+static bool check_image(BytecodeImage const* image) {
+    if (image->references.len != 0) {
+        return false;
+    }
+    for (usize i = 0; i < image->symbols.len; i++) {
+        if (image->symbols.data[i].offset == BYTECODE_SYMBOL_UNDEFINED) {
+            return false;
+        }
+    }
+    BytecodeMetadata const* stored = &image->metadata;
+    BytecodeMetadata metadata;
+    VerifyError error;
+    if (!bytecode_analyze(image->bytecode, &metadata, &error)) {
+        // the errors before `VERIFY_FALLS_OFF_END` are about the encoding.
+        return error.kind >= VERIFY_FALLS_OFF_END
+            && stored->functions.len == 0
+            && stored->max_stack == BYTECODE_UNBOUNDED
+            && stored->max_locals == BYTECODE_UNBOUNDED
+            && stored->max_calls == BYTECODE_UNBOUNDED;
+    }
+    bool same = metadata.functions.len == stored->functions.len
+        && metadata.max_stack == stored->max_stack
+        && metadata.max_locals == stored->max_locals
+        && metadata.max_calls == stored->max_calls;
+    for (usize i = 0; same && i < metadata.functions.len; i++) {
+        same = same_function(metadata.functions.data[i], stored->functions.data[i]);
+    }
+    bytecode_metadata_free(&metadata);
+    return same;
+}
+
+bool compile_cached(
+    CompileCache* cache,
+    String source,
+    Reporter* reporter,
+    CachedBytecode* dst
+) {
+    StringBuf path = compile_cache_path(cache, source);
+    BytecodeImage image;
+    ImageError error = bytecode_image_load(path.data, &image);
+    if (error == IMAGE_OK && !check_image(&image)) {
+        bytecode_image_free(&image);
+        cache->stats.rejected++;
+        error = IMAGE_CORRUPT;
+    }
+    if (error == IMAGE_OK) {
+        cache->stats.hits++;
+        *dst = (CachedBytecode){ .image = image, .hit = true };
+        string_buf_free(&path);
+        return true;
+    }
+    cache->stats.misses++;
+    if (error == IMAGE_INCOMPATIBLE) {
+        cache->stats.stale++;
+    }
+
+    Bytecode bytecode;
+    if (!compile(source, reporter, &bytecode)) {
+        string_buf_free(&path);
+        return false;
+    }
+    image = (BytecodeImage){
+        .bytecode = bytecode,
+        .symbols = array_buf_new(BytecodeSymbol)(),
+        .references = array_buf_new(usize)(),
+    };
+    // modules without an entry point have no bounds, but can still be
+    // stored.
+    VerifyError verify_error;
+    if (!bytecode_analyze(bytecode, &image.metadata, &verify_error)) {
+        image.metadata = (BytecodeMetadata){
+            .functions = array_buf_new(BytecodeFunction)(),
+            .max_stack = BYTECODE_UNBOUNDED,
+            .max_locals = BYTECODE_UNBOUNDED,
+            .max_calls = BYTECODE_UNBOUNDED,
+        };
+    }
+    store(cache, &image, path.data);
+    string_buf_free(&path);
+
+    *dst = (CachedBytecode){ .image = image, .hit = false };
+    return true;
+}
+
+void cached_bytecode_free(CachedBytecode* bytecode) {
+    BytecodeImage* image = &bytecode->image;
+    if (bytecode->hit) {
+        bytecode_image_free(image);
+        return;
+    }
+    array_buf_free(Byteword)(&image->bytecode.instructions);
+    array_buf_free(Byteword)(&image->bytecode.rodata);
+    array_buf_free(BytecodeSymbol)(&image->symbols);
+    array_buf_free(usize)(&image->references);
+    bytecode_metadata_free(&image->metadata);
+}
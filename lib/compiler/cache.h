@@ -0,0 +1,59 @@
+#pragma once
+
+#include "collections/string.h"
+#include "diagnostics/report.h"
+#include "image/image.h"
+
+/// @brief Counts how compilations through a cache went.
+typedef struct CompileCacheStats {
+    usize hits;
+    usize misses;       // including entries that were stale or unreadable
+    usize stale;        // entries written by an incompatible compiler
+    usize rejected;     // entries that loaded but did not verify
+    usize stores;
+    usize store_failures;
+} CompileCacheStats;
+
+/// @brief A directory of bytecode images, keyed by a 128-bit fingerprint of
+/// the source text and of the version of the compiler.
+///
+/// Sources that did not change since they were last compiled are loaded from
+/// their image instead of going through the pipeline again. Upgrading the
+/// compiler changes every key, so older entries are never loaded.
+typedef struct CompileCache {
+    StringBuf directory;
+    String version;
+    CompileCacheStats stats;
+} CompileCache;
+
+/// @brief Bytecode compiled through a cache.
+typedef struct CachedBytecode {
+    /// @brief Loaded from the cache when `hit`, built in memory otherwise.
+    BytecodeImage image;
+    bool hit;
+} CachedBytecode;
+
+/// @brief Opens the cache stored in `directory`, that is created if it does
+/// not exist yet.
+CompileCache compile_cache_new(char const* directory);
+void compile_cache_free(CompileCache* cache);
+
+/// @brief The path of the entry of `source`, whether it exists or not.
+StringBuf compile_cache_path(CompileCache const* cache, String source);
+
+/// @brief Compiles `source` like `compile`, unless the cache has an entry
+/// for it. Entries are verified when loaded, and compiled again if their
+/// bytecode or metadata is not what the compiler would have stored. New
+/// entries are stored on a best-effort basis: a cache that cannot be written
+/// to only counts the failures.
+///
+/// @param reporter gets the problems found when compiling. Sources with
+/// errors are never stored.
+bool compile_cached(
+    CompileCache* cache,
+    String source,
+    Reporter* reporter,
+    CachedBytecode* dst
+);
+
+void cached_bytecode_free(CachedBytecode* bytecode);
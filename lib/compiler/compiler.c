@@ -0,0 +1,181 @@
+#include "compiler/compiler.h"
+#include "tokenizer/tokenizer.h"
+#include "parser/parser.h"
+#include "analyzer/analyzer.h"
+#include "generator/generator.h"
+
+typedef struct Compilation {
+    Interner interner;
+    TokenStream tokens;
+    Ast ast;
+    Emitter emitter;
+} Compilation;
+
+// frees everything but the emitter.
+static void compilation_free(Compilation* compilation) {
+    ast_free(&compilation->ast);
+    token_stream_free(&compilation->tokens);
+    interner_free(&compilation->interner);
+}
+
+// runs the pipeline up to the emitter, that the caller finishes or frees.
+static bool compilation_run(
+    Compilation* compilation,
+    String source,
+    WorkerPool* workers,
+    Reporter* reporter
+) {
+    compilation->interner = interner_new();
+    if (!tokenize(source, &compilation->interner, reporter, &compilation->tokens)) {
+        interner_free(&compilation->interner);
+        return false;
+    }
+    Ast* ast = &compilation->ast;
+    if (!parse(compilation->tokens, reporter, ast) || !analyze_parallel(ast, reporter, workers)) {
+        compilation_free(compilation);
+        return false;
+    }
+    compilation->emitter = emitter_new();
+    if (!generate_parallel(ast, &compilation->emitter, workers)) {
+        emitter_free(&compilation->emitter);
+        compilation_free(compilation);
+        return false;
+    }
+    return true;
+}
+
+// functions declared without a body can only be resolved by `link`.
+static bool check_no_imports(Compilation const* compilation, Reporter* reporter) {
+    Ast const* ast = &compilation->ast;
+    ArrayBuf(ConstantDef) constants = ast->root.global_constants;
+    bool ok = true;
+    for (usize i = 0; i < constants.len; i++) {
+        Identifier name = constants.data[i].name;
+        Expression value = ast->expressions.data[constants.data[i].value];
+        if (value.kind != EXPRESSION_FUNCTION || !value.as.function.external) {
+            continue;
+        }
+        String string = atom_string(*ast->interner, name.atom);
+        report_start(reporter, SEVERITY_ERROR, 0);
+        report_format(reporter, "undefined symbol `%.*s`", (int)string.len, string.data);
+        report_source_code(reporter, name.range);
+        report_end(reporter);
+        ok = false;
+    }
+    return ok;
+}
+
+bool compile(String source, Reporter* reporter, Bytecode* dst) {
+    WorkerPool workers = worker_pool_new(1);
+    bool ok = compile_parallel(source, &workers, reporter, dst);
+    worker_pool_free(&workers);
+    return ok;
+}
+
+bool compile_parallel(
+    String source,
+    WorkerPool* workers,
+    Reporter* reporter,
+    Bytecode* dst
+) {
+    Compilation compilation;
+    if (!compilation_run(&compilation, source, workers, reporter)) {
+        return false;
+    }
+    bool ok = check_no_imports(&compilation, reporter)
+        && emitter_finish(&compilation.emitter, dst);
+    if (!ok) {
+        emitter_free(&compilation.emitter);
+    }
+    compilation_free(&compilation);
+    return ok;
+}
+
+bool compile_object(
+    String source,
+    WorkerPool* workers,
+    Reporter* reporter,
+    CompiledObject* dst
+) {
+    Compilation compilation;
+    if (!compilation_run(&compilation, source, workers, reporter)) {
+        return false;
+    }
+    Bytecode bytecode;
+    ArrayBuf(usize) locations;
+    ArrayBuf(usize) references;
+    emitter_finish_relocatable(&compilation.emitter, &bytecode, &locations, &references);
+
+    // the names are copied out of the interner first, each followed by the
+    // signature of its constant, since the buffer moves while it grows.
+    Ast const* ast = &compilation.ast;
+    ArrayBuf(ConstantDef) constants = ast->root.global_constants;
+    StringBuf names = string_buf_new();
+    ArrayBuf(usize) name_starts = array_buf_new(usize)();
+    ArrayBuf(usize) signature_starts = array_buf_new(usize)();
+    for (usize i = 0; i < constants.len; i++) {
+        array_buf_push(usize)(&name_starts, names.len);
+        String name = atom_string(*ast->interner, constants.data[i].name.atom);
+        string_buf_extend_slice(&names, name);
+        array_buf_push(usize)(&signature_starts, names.len);
+        write_type(ast->types, constants.data[i].type, &names);
+    }
+
+    ArrayBuf(BytecodeSymbol) symbols = array_buf_new(BytecodeSymbol)();
+    for (usize i = 0; i < locations.len; i++) {
+        usize location = locations.data[i];
+        array_buf_push(BytecodeSymbol)(&symbols, (BytecodeSymbol){
+            .name = STRING_LITERAL(""),
+            .signature = STRING_LITERAL(""),
+            .offset = location == SYMBOL_UNSET_LOCATION
+                ? BYTECODE_SYMBOL_UNDEFINED
+                : location,
+        });
+    }
+    for (usize i = 0; i < constants.len; i++) {
+        Expression value = ast->expressions.data[constants.data[i].value];
+        if (value.kind != EXPRESSION_FUNCTION) {
+            continue;
+        }
+        usize name = name_starts.data[i];
+        usize signature = signature_starts.data[i];
+        usize end = i + 1 < constants.len ? name_starts.data[i + 1] : names.len;
+        BytecodeSymbol* symbol = &symbols.data[value.as.function.symbol];
+        symbol->name = (String){ .data = names.data + name, .len = signature - name };
+        symbol->signature = (String){
+            .data = names.data + signature,
+            .len = end - signature,
+        };
+    }
+    array_buf_free(usize)(&name_starts);
+    array_buf_free(usize)(&signature_starts);
+    array_buf_free(usize)(&locations);
+    compilation_free(&compilation);
+
+    *dst = (CompiledObject){
+        .image = {
+            .bytecode = bytecode,
+            .symbols = symbols,
+            .references = references,
+            // objects are only verified once linked.
+            .metadata = {
+                .functions = array_buf_new(BytecodeFunction)(),
+                .max_stack = BYTECODE_UNBOUNDED,
+                .max_locals = BYTECODE_UNBOUNDED,
+                .max_calls = BYTECODE_UNBOUNDED,
+            },
+        },
+        ._names = names,
+    };
+    return true;
+}
+
+void compiled_object_free(CompiledObject* object) {
+    BytecodeImage* image = &object->image;
+    array_buf_free(Byteword)(&image->bytecode.instructions);
+    array_buf_free(Byteword)(&image->bytecode.rodata);
+    array_buf_free(BytecodeSymbol)(&image->symbols);
+    array_buf_free(usize)(&image->references);
+    bytecode_metadata_free(&image->metadata);
+    string_buf_free(&object->_names);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "bytecode/bytecode.h"
+#include "collections/string.h"
+#include "diagnostics/report.h"
+#include "image/image.h"
+#include "workers/workers.h"
+
+/// @brief Tokenizes, parses, analyzes and generates the bytecode of a module.
+///
+/// @param reporter gets the problems found by every stage. Compilation stops
+/// after the first stage that reports errors. Functions declared without a
+/// body are reported as undefined, since only `link` resolves them.
+bool compile(String source, Reporter* reporter, Bytecode* dst);
+
+/// @brief Compiles like `compile`, with the bodies of the functions analyzed
+/// and generated by the threads of `workers`. The bytecode is the same with
+/// any number of threads.
+bool compile_parallel(
+    String source,
+    WorkerPool* workers,
+    Reporter* reporter,
+    Bytecode* dst
+);
+
+/// @brief A module compiled on its own, to be linked with others.
+typedef struct CompiledObject {
+    /// @brief A relocatable image, with a symbol for each function. Global
+    /// functions are named after their constant, and are imported when they
+    /// are external.
+    BytecodeImage image;
+    StringBuf _names;   // that the names of the symbols point into
+} CompiledObject;
+
+/// @brief Compiles a module like `compile_parallel`, into an object whose
+/// references are left for `link` to resolve.
+///
+/// Objects can be written and loaded like any other image, so that modules
+/// that did not change need not be compiled again.
+bool compile_object(
+    String source,
+    WorkerPool* workers,
+    Reporter* reporter,
+    CompiledObject* dst
+);
+
+void compiled_object_free(CompiledObject* object);
@@ -15,6 +15,17 @@ void report_message(Reporter* reporter, StringBuf message) {
     (reporter->vtable->message)(reporter, message);
 }
 
+void report_format(Reporter* reporter, char const* fmt, ...) {
+    SmallStringBuf message;
+    small_string_buf_init(&message);
+    va_list args;
+    va_start(args, fmt);
+    vformat_into(&message.buf, fmt, args);
+    va_end(args);
+    report_message(reporter, message.buf);
+    string_buf_free(&message.buf);
+}
+
 void report_source_code(Reporter* reporter, Range source_code) {
     (reporter->vtable->source_code)(reporter, source_code);
 }
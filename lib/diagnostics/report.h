@@ -21,6 +21,11 @@ typedef struct ReporterVTable {
 
 void report_start(Reporter* reporter, Severity severity, i32 code);
 void report_end(Reporter* reporter);
+/// @brief Adds the message of the diagnostic. Reporters copy what they keep
+/// of it, so it may live on the stack.
 void report_message(Reporter* reporter, StringBuf message);
+/// @brief Adds a message formatted like `printf`, which does not allocate
+/// when it is short.
+void report_format(Reporter* reporter, char const* restrict fmt, ...);
 void report_source_code(Reporter* reporter, Range source_code);
 usize reporter_error_count(const Reporter* reporter);
@@ -1,6 +1,8 @@
 #include <inttypes.h>
+#include <stdlib.h>
 
 #include "disassembler/disassembler.h"
+#include "verifier/verifier.h"
 
 typedef struct Disassembler {
     Bytecode bytecode;
@@ -9,6 +11,12 @@ typedef struct Disassembler {
     ArrayBuf(usize) symbol_locations;
 } Disassembler;
 
+static int compare_locations(void const* a, void const* b) {
+    usize lhs = *(usize const*)a;
+    usize rhs = *(usize const*)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
 static void register_symbols(Disassembler* disassembler) {
     #define REGISTER_LOC_ARG_imb bytecode_read_imb(&disassembler->ip);
     #define REGISTER_LOC_ARG_imw bytecode_read_imw(&disassembler->ip);
@@ -16,7 +24,7 @@ static void register_symbols(Disassembler* disassembler) {
     #define REGISTER_LOC_ARG_loc                                        \
         loc = bytecode_read_loc(&disassembler->ip);               \
         array_buf_push(usize)(&disassembler->symbol_locations, loc);
-    #define REGISTER_LOC_ARG(i, kind) REGISTER_LOC_ARG_##kind
+    #define REGISTER_LOC_ARG(i, kind, ...) REGISTER_LOC_ARG_##kind
 
     #define REGISTER_LOC_CASE(code, mnemo, ...)             \
         case code:                                          \
@@ -38,17 +46,28 @@ static void register_symbols(Disassembler* disassembler) {
             FOR_SYSCALLS(REGISTER_LOC_CASE)
 
             default:
-                exit(-1);
+                // unreachable, the encoding is verified by `disassemble`.
                 break;
             }
             break;
-        
+
         default:
-            // unreachable
-            exit(-1);
+            // unreachable, the encoding is verified by `disassemble`.
             break;
         }
     }
+
+    // jumps may point backwards and several may share a target, so the
+    // locations are put in emission order without duplicates
+    ArrayBuf(usize)* locations = &disassembler->symbol_locations;
+    qsort(locations->data, locations->len, sizeof(usize), compare_locations);
+    usize unique_len = 0;
+    for (usize i = 0; i < locations->len; i++) {
+        if (unique_len == 0 || locations->data[unique_len - 1] != locations->data[i]) {
+            locations->data[unique_len++] = locations->data[i];
+        }
+    }
+    locations->len = unique_len;
 }
 
 static void disassemble_arg_imb(Disassembler* disassembler) {
@@ -64,7 +83,7 @@ static void disassemble_arg_imb(Disassembler* disassembler) {
 static void disassemble_arg_imw(Disassembler* disassembler) {
     Word val = bytecode_read_imw(&disassembler->ip);
     char buf[64];
-    usize len = snprintf(buf, 64, " %"  PRIu64, val.as_uint);
+    usize len = snprintf(buf, 64, " %"  PRId64, val.as_int);
     string_buf_extend_slice(
         disassembler->dst,
         (String){ .data = buf, .len = len }
@@ -111,28 +130,30 @@ static void disassemble_one(Disassembler* disassembler) {
         
         switch (syscall) {
         FOR_SYSCALLS(DISASSEMBLE_ONE_CASE)
-        
+
         default:
-            // unreachable
-            exit(-1);
+            // unreachable, the encoding is verified by `disassemble`.
             break;
         }
+        break;
 
     default:
-        // unreachable
-        exit(-1);
+        // unreachable, the encoding is verified by `disassemble`.
         break;
     }
 
     string_buf_push(disassembler->dst, '\n');
 }
 
-StringBuf disassemble(Bytecode bytecode) {
-    StringBuf dst = string_buf_new();
+bool disassemble(Bytecode bytecode, Reporter* reporter, StringBuf* dst) {
+    if (!bytecode_verify_encoding(bytecode, reporter)) {
+        return false;
+    }
+    *dst = string_buf_new();
     Disassembler disassembler = {
         .bytecode = bytecode,
         .ip = bytecode.instructions.data,
-        .dst = &dst,
+        .dst = dst,
         .symbol_locations = array_buf_new_usize(),
     };
     register_symbols(&disassembler);
@@ -147,7 +168,7 @@ StringBuf disassemble(Bytecode bytecode) {
                 symbol_location_index++;
                 char buf[64];
                 usize len = snprintf(buf, 64, ":s%zu\n", next_symbol);
-                string_buf_extend_slice(&dst, (String){ .data = buf, .len = len });
+                string_buf_extend_slice(dst, (String){ .data = buf, .len = len });
             }
         }
 
@@ -156,5 +177,6 @@ StringBuf disassemble(Bytecode bytecode) {
         }
         disassemble_one(&disassembler);
     }
-    return dst;
+    array_buf_free(usize)(&disassembler.symbol_locations);
+    return true;
 }
@@ -2,5 +2,10 @@
 
 #include "collections/string.h"
 #include "bytecode/bytecode.h"
+#include "diagnostics/report.h"
 
-StringBuf disassemble(Bytecode bytecode);
+/// @brief Writes the assembly of the bytecode to `dst`.
+///
+/// @return false if the bytecode cannot be decoded, which is reported like
+/// in `bytecode_verify_encoding`.
+bool disassemble(Bytecode bytecode, Reporter* reporter, StringBuf* dst);
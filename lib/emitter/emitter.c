@@ -1,4 +1,7 @@
 #include "emitter/emitter.h"
+#include "alloc/alloc.h"
+
+#define WORD_BYTEWORDS (alignof(Word) / sizeof(Byteword))
 
 Emitter emitter_new(void) {
     return (Emitter){
@@ -57,7 +60,6 @@ void emitter_free(Emitter* emitter) {
     array_buf_free(Byteword)(&emitter->_bytecode.rodata);
 }
 
-#define UNSET_LOCATION ((usize)-1)
 bool emitter_finish(Emitter* p_emitter, Bytecode* dst) {
     Emitter emitter = *p_emitter;
 
@@ -82,14 +84,234 @@ bool emitter_finish(Emitter* p_emitter, Bytecode* dst) {
     return true;
 }
 
+void emitter_finish_relocatable(
+    Emitter* emitter,
+    Bytecode* dst,
+    ArrayBuf(usize)* symbol_locations,
+    ArrayBuf(usize)* references
+) {
+    *dst = emitter->_bytecode;
+    *symbol_locations = emitter->_symbol_locations;
+    *references = emitter->_symbol_ref_locations;
+}
+
+Emitter emitter_fragment(Emitter const* emitter) {
+    Emitter fragment = emitter_new();
+    usize symbols = emitter->_symbol_locations.len;
+    usize* locations =
+        array_buf_extend_n(usize)(&fragment._symbol_locations, symbols);
+    for (usize i = 0; i < symbols; i++) {
+        locations[i] = SYMBOL_UNSET_LOCATION;
+    }
+    fragment._next_symbol = emitter->_next_symbol;
+    return fragment;
+}
+
+// words are aligned in the instructions, so fragments that do not land on a
+// word boundary are emitted again one instruction at a time, to pad their
+// words for their new place. `moved` gets where each instruction went.
+static bool append_instructions(
+    Emitter* emitter,
+    ArrayBuf(Byteword) instructions,
+    usize* moved
+) {
+    Byteword const* start = instructions.data;
+    Byteword const* end = start + instructions.len;
+    Byteword const* reader = start;
+    while (reader < end) {
+        moved[reader - start] = emitter->_bytecode.instructions.len;
+        BytecodeInstruction instruction;
+        if (bytecode_decode(&reader, end, &instruction) != DECODE_OK) {
+            return false;
+        }
+        bytecode_write_instruction(
+            &emitter->_bytecode,
+            &instruction,
+            &emitter->_symbol_ref_locations
+        );
+    }
+    moved[instructions.len] = emitter->_bytecode.instructions.len;
+    return true;
+}
+
+bool emitter_append(Emitter* emitter, Emitter* fragment) {
+    usize base = emitter->_bytecode.instructions.len;
+    ArrayBuf(Byteword) instructions = fragment->_bytecode.instructions;
+    usize* moved = NULL;
+    bool ok = true;
+    if (base % WORD_BYTEWORDS == 0) {
+        for (usize i = 0; i < fragment->_symbol_ref_locations.len; i++) {
+            array_buf_push(usize)(
+                &emitter->_symbol_ref_locations,
+                base + fragment->_symbol_ref_locations.data[i]
+            );
+        }
+        array_buf_extend(Byteword)(
+            &emitter->_bytecode.instructions,
+            instructions.data,
+            instructions.len
+        );
+    } else {
+        // only the start of instructions can be the location of a symbol.
+        moved = malloc_or_exit((instructions.len + 1) * sizeof(usize));
+        for (usize i = 0; i <= instructions.len; i++) {
+            moved[i] = SYMBOL_UNSET_LOCATION;
+        }
+        ok = append_instructions(emitter, instructions, moved);
+    }
+
+    for (usize i = 0; ok && i < fragment->_symbol_locations.len; i++) {
+        usize location = fragment->_symbol_locations.data[i];
+        if (location == SYMBOL_UNSET_LOCATION) {
+            continue;
+        }
+        if (
+            emitter->_symbol_locations.data[i] != SYMBOL_UNSET_LOCATION
+            || location > instructions.len
+            || (moved && moved[location] == SYMBOL_UNSET_LOCATION)
+        ) {
+            ok = false;
+            break;
+        }
+        emitter->_symbol_locations.data[i] =
+            moved ? moved[location] : base + location;
+    }
+    free_allocation(moved);
+    emitter_free(fragment);
+    return ok;
+}
+
+// checks that the references of relocatable bytecode are exactly its location
+// operands, as `emitter_append` takes them when it emits the instructions
+// again, and that its symbols are at the start of instructions.
+static bool check_relocatable(
+    ArrayBuf(Byteword) instructions,
+    ArrayBuf(usize) references,
+    usize const* symbol_locations,
+    usize symbols_len
+) {
+    usize len = instructions.len;
+    bool* starts = malloc_or_exit((len + 1) * sizeof(bool));
+    bool* locations = malloc_or_exit((len + 1) * sizeof(bool));
+    for (usize i = 0; i <= len; i++) {
+        starts[i] = false;
+        locations[i] = false;
+    }
+
+    // decoded instructions are written back the same, so writing them again
+    // tells where their location operands start.
+    Bytecode written = {
+        .rodata = array_buf_new(Byteword)(),
+        .instructions = array_buf_new(Byteword)(),
+    };
+    ArrayBuf(usize) operands = array_buf_new(usize)();
+    Byteword const* const start = instructions.data;
+    Byteword const* const end = start + len;
+    Byteword const* reader = start;
+    bool ok = true;
+    while (ok && reader < end) {
+        starts[reader - start] = true;
+        BytecodeInstruction instruction;
+        ok = bytecode_decode(&reader, end, &instruction) == DECODE_OK;
+        if (ok) {
+            bytecode_write_instruction(&written, &instruction, &operands);
+        }
+    }
+    for (usize i = 0; ok && i < operands.len; i++) {
+        locations[operands.data[i]] = true;
+    }
+
+    ok = ok && references.len == operands.len;
+    for (usize i = 0; ok && i < references.len; i++) {
+        usize location = references.data[i];
+        ok = location < len && locations[location];
+        // each location is referenced once.
+        if (ok) {
+            locations[location] = false;
+        }
+    }
+    for (usize i = 0; ok && i < symbols_len; i++) {
+        usize location = symbol_locations[i];
+        ok = location == SYMBOL_UNSET_LOCATION
+            || (location < len && starts[location]);
+    }
+    array_buf_free(Byteword)(&written.rodata);
+    array_buf_free(Byteword)(&written.instructions);
+    array_buf_free(usize)(&operands);
+    free_allocation(starts);
+    free_allocation(locations);
+    return ok;
+}
+
+bool emit_relocatable(
+    Emitter* emitter,
+    Bytecode bytecode,
+    ArrayBuf(usize) references,
+    usize const* symbol_locations,
+    SymbolIndex const* symbols,
+    usize symbols_len
+) {
+    if (bytecode.rodata.len != 0) {
+        return false;
+    }
+    Emitter fragment = emitter_fragment(emitter);
+    ArrayBuf(Byteword)* instructions = &fragment._bytecode.instructions;
+    array_buf_extend(Byteword)(
+        instructions,
+        bytecode.instructions.data,
+        bytecode.instructions.len
+    );
+    // decoded from the copy, whose words are aligned like the ones of the
+    // emitter.
+    if (!check_relocatable(
+        *instructions,
+        references,
+        symbol_locations,
+        symbols_len
+    )) {
+        emitter_free(&fragment);
+        return false;
+    }
+
+    // the operands are symbol indices of the bytecode, that become symbols
+    // of the emitter.
+    for (usize i = 0; i < references.len; i++) {
+        usize location = references.data[i];
+        Byteword const* reader = instructions->data + location;
+        usize symbol = bytecode_read_location(&reader);
+        if (symbol >= symbols_len) {
+            emitter_free(&fragment);
+            return false;
+        }
+        Byteword* writer = instructions->data + location;
+        bytecode_write_location_at(&writer, symbols[symbol]);
+        array_buf_push(usize)(&fragment._symbol_ref_locations, location);
+    }
+    for (usize i = 0; i < symbols_len; i++) {
+        usize location = symbol_locations[i];
+        if (location == SYMBOL_UNSET_LOCATION) {
+            continue;
+        }
+        if (
+            symbols[i] >= fragment._symbol_locations.len
+            || fragment._symbol_locations.data[symbols[i]] != SYMBOL_UNSET_LOCATION
+        ) {
+            emitter_free(&fragment);
+            return false;
+        }
+        fragment._symbol_locations.data[symbols[i]] = location;
+    }
+    return emitter_append(emitter, &fragment);
+}
+
 SymbolIndex emit_new_symbol(Emitter* emitter) {
     SymbolIndex symbol_index = emitter->_next_symbol++;
-    array_buf_push(usize)(&emitter->_symbol_locations, UNSET_LOCATION);
+    array_buf_push(usize)(&emitter->_symbol_locations, SYMBOL_UNSET_LOCATION);
     return symbol_index;
 }
 
 bool emit_symbol_location(Emitter* emitter, SymbolIndex symbol_index) {
-    if (emitter->_symbol_locations.data[symbol_index] != UNSET_LOCATION) {
+    if (emitter->_symbol_locations.data[symbol_index] != SYMBOL_UNSET_LOCATION) {
         return false;
     }
     emitter->_symbol_locations.data[symbol_index] =
@@ -5,6 +5,9 @@
 
 typedef usize SymbolIndex;
 
+/// @brief The location of symbols that were not emitted.
+#define SYMBOL_UNSET_LOCATION ((usize)-1)
+
 typedef struct Emitter {
     Bytecode _bytecode;
     ArrayBuf(usize) _symbol_locations;
@@ -16,6 +19,55 @@ Emitter emitter_new(void);
 void emitter_free(Emitter* emitter);
 bool emitter_finish(Emitter* emitter, Bytecode* dst);
 
+/// @brief Finishes the bytecode without fixing up its references, whose
+/// operands keep the index of their symbol, so that a linker can relocate it
+/// with `emit_relocatable`.
+///
+/// @param symbol_locations gets the location of each symbol, or
+/// `SYMBOL_UNSET_LOCATION` for those that were never emitted.
+/// @param references gets the locations of the operands of the references.
+void emitter_finish_relocatable(
+    Emitter* emitter,
+    Bytecode* dst,
+    ArrayBuf(usize)* symbol_locations,
+    ArrayBuf(usize)* references
+);
+
+/// @brief Appends bytecode finished by `emitter_finish_relocatable`.
+///
+/// @param symbols the symbol of this emitter that each symbol of the
+/// bytecode stands for.
+/// @param symbol_locations the locations of the symbols in the bytecode, by
+/// index, or `SYMBOL_UNSET_LOCATION` for those it does not define.
+/// @return false if the bytecode does not decode, if the references are not
+/// exactly its location operands, if the symbol locations are not the start
+/// of instructions, if a symbol gets a second location, or if the bytecode
+/// has rodata, which cannot be relocated.
+bool emit_relocatable(
+    Emitter* emitter,
+    Bytecode bytecode,
+    ArrayBuf(usize) references,
+    usize const* symbol_locations,
+    SymbolIndex const* symbols,
+    usize symbols_len
+);
+
+/// @brief An empty emitter that knows the symbols of `emitter`, to emit a
+/// part of its bytecode separately, like on another thread.
+///
+/// Fragments can emit references to the symbols and set their locations, but
+/// not create new ones. They are appended back with `emitter_append`.
+Emitter emitter_fragment(Emitter const* emitter);
+
+/// @brief Moves the bytecode of `fragment` to the end of `emitter`, with the
+/// symbol locations and references it emitted, and frees the fragment.
+///
+/// References are fixed up by `emitter_finish` like any other.
+///
+/// @return false if the fragment sets the location of a symbol that already
+/// has one.
+bool emitter_append(Emitter* emitter, Emitter* fragment);
+
 SymbolIndex emit_new_symbol(Emitter* emitter);
 bool emit_symbol_location(Emitter* emitter, SymbolIndex symbol_index);
 
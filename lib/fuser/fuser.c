@@ -0,0 +1,212 @@
+#include <string.h>
+
+#include "alloc/alloc.h"
+#include "fuser/fuser.h"
+
+#define NO_OFFSET ((usize)-1)
+
+DECL_ARRAY_BUF(BytecodeInstruction)
+IMPL_ARRAY_BUF(BytecodeInstruction)
+
+typedef struct Fuser {
+    ArrayBuf(BytecodeInstruction) instructions;
+    ArrayBuf(usize) offsets;    // of each instruction in the source bytecode
+    // indexed by offset in the source bytecode, one past the end included.
+    bool* is_target;
+    Bytecode dst;
+    // offset in the fused bytecode of each source offset.
+    usize* new_offsets;
+    ArrayBuf(usize) ref_locations;
+} Fuser;
+
+static bool decode(Fuser* fuser, Bytecode bytecode) {
+    Byteword const* const start = bytecode.instructions.data;
+    usize const len = bytecode.instructions.len;
+    Byteword const* const end = start + len;
+    Byteword const* ip = start;
+    usize offset;
+    while ((offset = ip - start) < len) {
+        BytecodeInstruction instruction;
+        if (bytecode_decode(&ip, end, &instruction) != DECODE_OK) {
+            return false;
+        }
+        for (usize i = 0; i < instruction.operands_len; i++) {
+            if (instruction.kinds[i] != OPERAND_LOC) {
+                continue;
+            }
+            if (instruction.operands[i].loc > len) {
+                return false;
+            }
+            fuser->is_target[instruction.operands[i].loc] = true;
+        }
+        array_buf_push(BytecodeInstruction)(&fuser->instructions, instruction);
+        array_buf_push(usize)(&fuser->offsets, offset);
+    }
+    return true;
+}
+
+// locations are patched once all offsets are known, see `fuse`.
+static void write_instruction(Fuser* fuser, BytecodeInstruction const* instruction) {
+    bytecode_write_instruction(&fuser->dst, instruction, &fuser->ref_locations);
+}
+
+// returns whether the `len` instructions at `index` exist and none but the
+// first is jumped to.
+static bool window_fits(Fuser* fuser, usize index, usize len) {
+    if (index + len > fuser->instructions.len) {
+        return false;
+    }
+    for (usize i = index + 1; i < index + len; i++) {
+        if (fuser->is_target[fuser->offsets.data[i]]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static Opcode fused_jump(Opcode compare) {
+    // the immediate is the upper value: `sca n; geu` is `%a >= n`.
+    switch (compare) {
+    case OP_EQU: return OP_JEQ;
+    case OP_NEU: return OP_JNE;
+    case OP_GEU: return OP_JGE;
+    case OP_GTU: return OP_JGT;
+    default: return OP_NOP;
+    }
+}
+
+// tries to fuse the instructions at `index` into `fused`, returns the number
+// of instructions consumed or 0 if nothing matches.
+static usize match(Fuser* fuser, usize index, BytecodeInstruction* fused) {
+    BytecodeInstruction const* in = fuser->instructions.data + index;
+
+    if (
+        window_fits(fuser, index, 4)
+        && in[0].opcode == OP_VAR
+        && in[1].opcode == OP_VAR
+        && in[2].opcode == OP_ADU
+        && in[3].opcode == OP_SET
+    ) {
+        *fused = (BytecodeInstruction){
+            .opcode = OP_ADL,
+            .operands = { in[0].operands[0], in[1].operands[0], in[3].operands[0] },
+        };
+        return 4;
+    }
+
+    if (
+        window_fits(fuser, index, 4)
+        && in[0].opcode == OP_VAR
+        && in[1].opcode == OP_SCA
+        && in[2].opcode == OP_ADU
+        && in[3].opcode == OP_SET
+        && in[3].operands[0].var == in[0].operands[0].var
+    ) {
+        *fused = (BytecodeInstruction){
+            .opcode = OP_INC,
+            .operands = { in[0].operands[0], in[1].operands[0] },
+        };
+        return 4;
+    }
+
+    if (
+        window_fits(fuser, index, 4)
+        && in[0].opcode == OP_VAR
+        && in[1].opcode == OP_SCA
+        && fused_jump(in[2].opcode) != OP_NOP
+        && in[3].opcode == OP_JNZ
+    ) {
+        *fused = (BytecodeInstruction){
+            .opcode = fused_jump(in[2].opcode),
+            .operands = { in[0].operands[0], in[1].operands[0], in[3].operands[0] },
+        };
+        return 4;
+    }
+
+    if (
+        window_fits(fuser, index, 2)
+        && in[0].opcode == OP_SCA
+        && in[1].opcode == OP_ADU
+    ) {
+        *fused = (BytecodeInstruction){
+            .opcode = OP_ADI,
+            .operands = { in[0].operands[0] },
+        };
+        return 2;
+    }
+
+    return 0;
+}
+
+bool fuse(Bytecode bytecode, Bytecode* dst) {
+    usize const len = bytecode.instructions.len;
+    Fuser fuser = {
+        .instructions = array_buf_new(BytecodeInstruction)(),
+        .offsets = array_buf_new(usize)(),
+        .is_target = malloc_or_exit((len + 1) * sizeof(bool)),
+        .dst = {
+            .rodata = array_buf_new(Byteword)(),
+            .instructions = array_buf_new(Byteword)(),
+        },
+        .new_offsets = malloc_or_exit((len + 1) * sizeof(usize)),
+        .ref_locations = array_buf_new(usize)(),
+    };
+    memset(fuser.is_target, 0, (len + 1) * sizeof(bool));
+    for (usize i = 0; i <= len; i++) {
+        fuser.new_offsets[i] = NO_OFFSET;
+    }
+
+    bool ok = decode(&fuser, bytecode);
+    if (ok) {
+        for (usize i = 0; i < fuser.instructions.len;) {
+            BytecodeInstruction const* instruction = fuser.instructions.data + i;
+            fuser.new_offsets[fuser.offsets.data[i]] = fuser.dst.instructions.len;
+
+            BytecodeInstruction fused;
+            usize consumed = match(&fuser, i, &fused);
+            if (consumed != 0) {
+                write_instruction(&fuser, &fused);
+                i += consumed;
+            } else {
+                write_instruction(&fuser, instruction);
+                i++;
+            }
+        }
+        fuser.new_offsets[len] = fuser.dst.instructions.len;
+
+        for (usize i = 0; i < fuser.ref_locations.len; i++) {
+            Byteword* ref_ptr =
+                fuser.dst.instructions.data + fuser.ref_locations.data[i];
+            Byteword const* reader = ref_ptr;
+            usize location = fuser.new_offsets[bytecode_read_location(&reader)];
+            if (location == NO_OFFSET) {
+                // jumps into the middle of an instruction
+                ok = false;
+                break;
+            }
+            Byteword* writer = ref_ptr;
+            bytecode_write_location_at(&writer, location);
+        }
+    }
+
+    if (ok) {
+        if (bytecode.rodata.len != 0) {
+            array_buf_extend(Byteword)(
+                &fuser.dst.rodata,
+                bytecode.rodata.data,
+                bytecode.rodata.len
+            );
+        }
+        *dst = fuser.dst;
+    } else {
+        array_buf_free(Byteword)(&fuser.dst.instructions);
+        array_buf_free(Byteword)(&fuser.dst.rodata);
+    }
+
+    array_buf_free(BytecodeInstruction)(&fuser.instructions);
+    array_buf_free(usize)(&fuser.offsets);
+    array_buf_free(usize)(&fuser.ref_locations);
+    free_allocation(fuser.is_target);
+    free_allocation(fuser.new_offsets);
+    return ok;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "bytecode/bytecode.h"
+
+/// @brief Rewrites common instruction sequences of finished bytecode into
+/// fused superinstructions.
+///
+/// The fused sequences are:
+/// - `var %a; var %b; adu; set %c` into `adl %a %b %c`,
+/// - `var %a; sca n; adu; set %a` into `inc %a n`,
+/// - `var %a; sca n; equ|neu|geu|gtu; jnz :L` into `jeq|jne|jge|jgt %a n :L`,
+/// - `sca n; adu` into `adi n`.
+///
+/// A sequence is never fused across a jump target. Fusion is optional: the
+/// unfused bytecode has the same behavior and stays the reference.
+///
+/// @param bytecode the bytecode to fuse, left untouched.
+/// @param dst where the fused bytecode is written.
+/// @return false if the bytecode does not decode, see `bytecode_decode`.
+bool fuse(Bytecode bytecode, Bytecode* dst);
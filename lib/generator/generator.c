@@ -1,4 +1,6 @@
 #include "generator/generator.h"
+#include "alloc/alloc.h"
+#include "alloc/tracking.h"
 
 typedef struct Generator {
     Emitter* emitter;
@@ -12,7 +14,37 @@ static void generate_pattern_match(Generator gen, Pattern pattern);
 static void generate_expression(Generator gen, Expression expression);
 static void generate_binary_operation(Generator gen, BinaryOperation binary_operation);
 
-void generate(Ast* ast, Emitter* emitter) {
+bool generate(Ast* ast, Emitter* emitter) {
+    WorkerPool workers = worker_pool_new(1);
+    bool ok = generate_parallel(ast, emitter, &workers);
+    worker_pool_free(&workers);
+    return ok;
+}
+
+typedef struct GenerateJob {
+    Generator generator;
+    usize const* functions;
+    usize functions_len;
+    usize chunks;
+    Emitter* fragments;
+} GenerateJob;
+
+static void generate_chunk(void* context, usize chunk) {
+    GenerateJob const* job = context;
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_EMITTER);
+    Generator generator = job->generator;
+    generator.emitter = &job->fragments[chunk];
+    usize start = worker_chunk_start(job->functions_len, job->chunks, chunk);
+    usize end = worker_chunk_start(job->functions_len, job->chunks, chunk + 1);
+    for (usize i = start; i < end; i++) {
+        Function function = generator.expressions[job->functions[i]].as.function;
+        generate_function(generator, function);
+    }
+    alloc_stage_leave(stage);
+}
+
+bool generate_parallel(Ast* ast, Emitter* emitter, WorkerPool* workers) {
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_EMITTER);
     for (size_t i = 0; i < ast->functions.len; i++) {
         Function* function = &ast->expressions.data[ast->functions.data[i]].as.function;
         function->symbol = emit_new_symbol(emitter);
@@ -24,13 +56,48 @@ void generate(Ast* ast, Emitter* emitter) {
         .bindings = ast->bindings,
     };
 
-    for (size_t i = 0; i < ast->functions.len; i++) {
-        Function function = ast->expressions.data[ast->functions.data[i]].as.function;
-        generate_function(generator, function);
+    usize chunks = worker_pool_chunks(workers, ast->functions.len);
+    if (chunks <= 1) {
+        for (size_t i = 0; i < ast->functions.len; i++) {
+            Function function = ast->expressions.data[ast->functions.data[i]].as.function;
+            generate_function(generator, function);
+        }
+        alloc_stage_leave(stage);
+        return true;
+    }
+
+    // every symbol exists before the fragments are made, and the threads only
+    // read the AST.
+    GenerateJob job = {
+        .generator = generator,
+        .functions = ast->functions.data,
+        .functions_len = ast->functions.len,
+        .chunks = chunks,
+        .fragments = malloc_or_exit(chunks * sizeof(Emitter)),
+    };
+    for (usize i = 0; i < chunks; i++) {
+        job.fragments[i] = emitter_fragment(emitter);
+    }
+    worker_pool_run(workers, chunks, generate_chunk, &job);
+    // the fragments left after a failure are only freed.
+    bool ok = true;
+    for (usize i = 0; i < chunks; i++) {
+        if (ok) {
+            ok = emitter_append(emitter, &job.fragments[i]);
+        } else {
+            emitter_free(&job.fragments[i]);
+        }
     }
+    free_allocation(job.fragments);
+    alloc_stage_leave(stage);
+    return ok;
 }
 
 static void generate_function(Generator gen, Function function) {
+    // the symbols of external functions are left for a linker.
+    if (function.external) {
+        return;
+    }
     emit_symbol_location(gen.emitter, function.symbol);
     if (function.variable_space > 0) {
         emit(res)(gen.emitter, function.variable_space);
@@ -46,7 +113,7 @@ static void generate_pattern_match(Generator gen, Pattern pattern) {
         BindingId binding = pattern.as.variable.binding;
         // TODO: sanity check if it's a value binding & variable store
         usize variable_index = get_binding(gen.bindings, binding)
-            .as.value.store.as.variable.index;
+            .as.value->store.as.variable.index;
         emit(set)(gen.emitter, variable_index);
     }
 }
@@ -56,10 +123,10 @@ static void generate_expression(Generator gen, Expression expression) {
     case EXPRESSION_VARIABLE:;
         BindingId binding_id = expression.as.variable.binding;
         // FIXME: sanity check if it's a value binding?
-        ValueBinding binding = get_binding(gen.bindings, binding_id).as.value;
-        switch (binding.store.kind) {
+        ValueBinding const* binding = get_binding(gen.bindings, binding_id).as.value;
+        switch (binding->store.kind) {
         case VALUE_STORE_CONSTANT:;
-            Expression value = gen.expressions[binding.store.as.constant];
+            Expression value = gen.expressions[binding->store.as.constant];
             switch (value.kind) {
             case EXPRESSION_FUNCTION:
                 emit(loc)(gen.emitter, value.as.function.symbol);
@@ -72,7 +139,7 @@ static void generate_expression(Generator gen, Expression expression) {
             }
             break;
         case VALUE_STORE_VARIABLE:
-            emit(var)(gen.emitter, binding.store.as.variable.index);
+            emit(var)(gen.emitter, binding->store.as.variable.index);
             return;
         }
         break;
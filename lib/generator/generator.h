@@ -3,5 +3,15 @@
 #include "ast/ast.h"
 #include "emitter/emitter.h"
 #include "diagnostics/report.h"
+#include "workers/workers.h"
 
-void generate(Ast* ast, Emitter* emitter);
+/// @return false if the bytecode of a function cannot be appended, see
+/// `emitter_append`.
+bool generate(Ast* ast, Emitter* emitter);
+
+/// @brief Generates like `generate`, with the functions split into chunks
+/// that are emitted into fragments by the threads of `workers`.
+///
+/// The fragments are appended in the order of the functions, so the bytecode
+/// is the same with any number of threads.
+bool generate_parallel(Ast* ast, Emitter* emitter, WorkerPool* workers);
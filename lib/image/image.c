@@ -0,0 +1,428 @@
+#include <string.h>
+
+#include "alloc/alloc.h"
+#include "image/image.h"
+#include "ops/ptr.h"
+
+#ifdef BYTECODE_IMAGE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+IMPL_ARRAY_BUF(BytecodeSymbol)
+
+#define IMAGE_MAGIC "COUGHBC"
+#define IMAGE_BYTE_ORDER 0x01020304u
+
+// the flags of the header.
+#define IMAGE_OBJECT 0x1u   // symbols may be undefined, references resolved
+
+typedef enum ImageSectionKind {
+    SECTION_RODATA,
+    SECTION_INSTRUCTIONS,
+    SECTION_SYMBOLS,
+    SECTION_NAMES,
+    SECTION_FUNCTIONS,
+    SECTION_REFERENCES,
+    SECTIONS_LEN,
+} ImageSectionKind;
+
+// the on-disk layout, that only has fixed-width fields without padding.
+typedef struct ImageSection {
+    u64 offset;     // from the start of the file, aligned like a `Word`
+    u64 size;       // in bytes
+} ImageSection;
+
+typedef struct ImageHeader {
+    char magic[8];
+    u32 version;
+    u32 byte_order;
+    u32 word_size;
+    u32 flags;
+    u64 max_stack;
+    u64 max_locals;
+    u64 max_calls;
+    ImageSection sections[SECTIONS_LEN];
+} ImageHeader;
+
+typedef struct ImageSymbol {
+    u64 name_offset;    // in the names section
+    u64 name_len;
+    u64 signature_len;  // right after the name
+    u64 offset;
+} ImageSymbol;
+
+typedef struct ImageFunction {
+    u64 offset;
+    u32 args;
+    u32 results;
+    u32 max_depth;
+    u16 locals;
+    u8 returns;
+    u8 reserved;
+} ImageFunction;
+
+static bool write_bytes(FILE* file, void const* data, usize size, usize* position) {
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        return false;
+    }
+    *position += size;
+    return true;
+}
+
+static bool write_padding(FILE* file, usize offset, usize* position) {
+    static char const zeros[alignof(Word)] = { 0 };
+    return write_bytes(file, zeros, offset - *position, position);
+}
+
+ImageError bytecode_image_write(BytecodeImage const* image, FILE* file) {
+    Bytecode bytecode = image->bytecode;
+    BytecodeMetadata metadata = image->metadata;
+    usize names_size = 0;
+    bool object = image->references.len != 0;
+    for (usize i = 0; i < image->symbols.len; i++) {
+        BytecodeSymbol symbol = image->symbols.data[i];
+        names_size += symbol.name.len + symbol.signature.len;
+        object = object || symbol.offset == BYTECODE_SYMBOL_UNDEFINED;
+    }
+    usize sizes[SECTIONS_LEN] = {
+        [SECTION_RODATA] = bytecode.rodata.len * sizeof(Byteword),
+        [SECTION_INSTRUCTIONS] = bytecode.instructions.len * sizeof(Byteword),
+        [SECTION_SYMBOLS] = image->symbols.len * sizeof(ImageSymbol),
+        [SECTION_NAMES] = names_size,
+        [SECTION_FUNCTIONS] = metadata.functions.len * sizeof(ImageFunction),
+        [SECTION_REFERENCES] = image->references.len * sizeof(u64),
+    };
+
+    ImageHeader header = {
+        .magic = IMAGE_MAGIC,
+        .version = BYTECODE_IMAGE_VERSION,
+        .byte_order = IMAGE_BYTE_ORDER,
+        .word_size = sizeof(Word),
+        .flags = object ? IMAGE_OBJECT : 0,
+        .max_stack = metadata.max_stack,
+        .max_locals = metadata.max_locals,
+        .max_calls = metadata.max_calls,
+    };
+    usize end = sizeof(header);
+    for (usize i = 0; i < SECTIONS_LEN; i++) {
+        end = align_up_size(end, alignof(Word));
+        header.sections[i] = (ImageSection){ .offset = end, .size = sizes[i] };
+        end += sizes[i];
+    }
+
+    usize position = 0;
+    #define WRITE(data, size)                                                   \
+        if (!write_bytes(file, (data), (size), &position)) {                    \
+            return IMAGE_IO;                                                    \
+        }
+    #define START_SECTION(kind)                                                 \
+        if (!write_padding(file, header.sections[kind].offset, &position)) {   \
+            return IMAGE_IO;                                                    \
+        }
+
+    WRITE(&header, sizeof(header));
+
+    START_SECTION(SECTION_RODATA);
+    WRITE(bytecode.rodata.data, sizes[SECTION_RODATA]);
+
+    START_SECTION(SECTION_INSTRUCTIONS);
+    WRITE(bytecode.instructions.data, sizes[SECTION_INSTRUCTIONS]);
+
+    START_SECTION(SECTION_SYMBOLS);
+    usize name_offset = 0;
+    for (usize i = 0; i < image->symbols.len; i++) {
+        BytecodeSymbol symbol = image->symbols.data[i];
+        ImageSymbol record = {
+            .name_offset = name_offset,
+            .name_len = symbol.name.len,
+            .signature_len = symbol.signature.len,
+            .offset = symbol.offset,
+        };
+        WRITE(&record, sizeof(record));
+        name_offset += symbol.name.len + symbol.signature.len;
+    }
+
+    START_SECTION(SECTION_NAMES);
+    for (usize i = 0; i < image->symbols.len; i++) {
+        BytecodeSymbol symbol = image->symbols.data[i];
+        WRITE(symbol.name.data, symbol.name.len);
+        WRITE(symbol.signature.data, symbol.signature.len);
+    }
+
+    START_SECTION(SECTION_FUNCTIONS);
+    for (usize i = 0; i < metadata.functions.len; i++) {
+        BytecodeFunction function = metadata.functions.data[i];
+        ImageFunction record = {
+            .offset = function.offset,
+            .args = function.args,
+            .results = function.results,
+            .max_depth = function.max_depth,
+            .locals = function.locals,
+            .returns = function.returns,
+        };
+        WRITE(&record, sizeof(record));
+    }
+
+    START_SECTION(SECTION_REFERENCES);
+    for (usize i = 0; i < image->references.len; i++) {
+        u64 record = image->references.data[i];
+        WRITE(&record, sizeof(record));
+    }
+    #undef WRITE
+    #undef START_SECTION
+
+    return fflush(file) == 0 ? IMAGE_OK : IMAGE_IO;
+}
+
+#ifdef BYTECODE_IMAGE_MMAP
+
+static ImageError map_file(char const* path, void** mapping, usize* size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return IMAGE_IO;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return IMAGE_IO;
+    }
+    if ((usize)status.st_size < sizeof(ImageHeader)) {
+        close(fd);
+        return IMAGE_NOT_AN_IMAGE;
+    }
+    *size = status.st_size;
+    *mapping = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return (*mapping == MAP_FAILED) ? IMAGE_IO : IMAGE_OK;
+}
+
+static void unmap_file(void* mapping, usize size) {
+    munmap(mapping, size);
+}
+
+#else
+
+static ImageError map_file(char const* path, void** mapping, usize* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return IMAGE_IO;
+    }
+    StringBuf contents = string_buf_new();
+    Errno err = read_file(file, &contents);
+    fclose(file);
+    if (err) {
+        string_buf_free(&contents);
+        return IMAGE_IO;
+    }
+    if (contents.len < sizeof(ImageHeader)) {
+        string_buf_free(&contents);
+        return IMAGE_NOT_AN_IMAGE;
+    }
+    *mapping = contents.data;
+    *size = contents.len;
+    return IMAGE_OK;
+}
+
+static void unmap_file(void* mapping, usize size) {
+    free_allocation(mapping);
+}
+
+#endif
+
+static bool section_fits(ImageSection section, usize file_size, usize record_size) {
+    return section.offset % alignof(Word) == 0
+        && section.offset <= file_size
+        && section.size <= file_size - section.offset
+        && section.size % record_size == 0;
+}
+
+// whether the symbols and functions are at the start of instructions, as far
+// as they decode. Only objects have undefined symbols.
+static bool offsets_fit(u8 const* data, ImageHeader header) {
+    ImageSection instructions = header.sections[SECTION_INSTRUCTIONS];
+    usize len = instructions.size / sizeof(Byteword);
+    bool* starts = malloc_or_exit((len + 1) * sizeof(bool));
+    for (usize i = 0; i <= len; i++) {
+        starts[i] = false;
+    }
+    Byteword const* const start = (Byteword const*)(data + instructions.offset);
+    Byteword const* const end = start + len;
+    Byteword const* reader = start;
+    while (reader < end) {
+        starts[reader - start] = true;
+        BytecodeInstruction instruction;
+        if (bytecode_decode(&reader, end, &instruction) != DECODE_OK) {
+            break;
+        }
+    }
+
+    bool ok = true;
+    ImageSection symbols = header.sections[SECTION_SYMBOLS];
+    for (usize i = 0; ok && i < symbols.size / sizeof(ImageSymbol); i++) {
+        ImageSymbol record;
+        memcpy(&record, data + symbols.offset + i * sizeof(record), sizeof(record));
+        ok = record.offset == BYTECODE_SYMBOL_UNDEFINED
+            ? (header.flags & IMAGE_OBJECT) != 0
+            : record.offset < len && starts[record.offset];
+    }
+    ImageSection functions = header.sections[SECTION_FUNCTIONS];
+    for (usize i = 0; ok && i < functions.size / sizeof(ImageFunction); i++) {
+        ImageFunction record;
+        memcpy(&record, data + functions.offset + i * sizeof(record), sizeof(record));
+        ok = record.offset < len && starts[record.offset];
+    }
+    free_allocation(starts);
+    return ok;
+}
+
+static ImageError parse(u8 const* data, usize size, BytecodeImage* dst) {
+    ImageHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, IMAGE_MAGIC, sizeof(header.magic)) != 0) {
+        return IMAGE_NOT_AN_IMAGE;
+    }
+    if (
+        header.version != BYTECODE_IMAGE_VERSION
+        || header.byte_order != IMAGE_BYTE_ORDER
+        || header.word_size != sizeof(Word)
+    ) {
+        return IMAGE_INCOMPATIBLE;
+    }
+
+    usize const record_sizes[SECTIONS_LEN] = {
+        [SECTION_RODATA] = sizeof(Byteword),
+        [SECTION_INSTRUCTIONS] = sizeof(Byteword),
+        [SECTION_SYMBOLS] = sizeof(ImageSymbol),
+        [SECTION_NAMES] = 1,
+        [SECTION_FUNCTIONS] = sizeof(ImageFunction),
+        [SECTION_REFERENCES] = sizeof(u64),
+    };
+    for (usize i = 0; i < SECTIONS_LEN; i++) {
+        if (!section_fits(header.sections[i], size, record_sizes[i])) {
+            return IMAGE_CORRUPT;
+        }
+    }
+    ImageSection names = header.sections[SECTION_NAMES];
+    ImageSection symbols = header.sections[SECTION_SYMBOLS];
+    for (usize i = 0; i < symbols.size / sizeof(ImageSymbol); i++) {
+        ImageSymbol record;
+        memcpy(&record, data + symbols.offset + i * sizeof(record), sizeof(record));
+        if (
+            record.name_offset > names.size
+            || record.name_len > names.size - record.name_offset
+            || record.signature_len
+                > names.size - record.name_offset - record.name_len
+        ) {
+            return IMAGE_CORRUPT;
+        }
+    }
+    if (
+        (header.flags & ~IMAGE_OBJECT) != 0
+        || (header.sections[SECTION_REFERENCES].size != 0
+            && (header.flags & IMAGE_OBJECT) == 0)
+        || !offsets_fit(data, header)
+    ) {
+        return IMAGE_CORRUPT;
+    }
+
+    // the bytecode stays in the mapping.
+    ImageSection rodata = header.sections[SECTION_RODATA];
+    ImageSection instructions = header.sections[SECTION_INSTRUCTIONS];
+    BytecodeImage image = {
+        .bytecode = {
+            .rodata = {
+                .data = (Byteword*)(data + rodata.offset),
+                .len = rodata.size / sizeof(Byteword),
+                .capacity = rodata.size / sizeof(Byteword),
+            },
+            .instructions = {
+                .data = (Byteword*)(data + instructions.offset),
+                .len = instructions.size / sizeof(Byteword),
+                .capacity = instructions.size / sizeof(Byteword),
+            },
+        },
+        .symbols = array_buf_new(BytecodeSymbol)(),
+        .references = array_buf_new(usize)(),
+        .metadata = {
+            .functions = array_buf_new(BytecodeFunction)(),
+            .max_stack = header.max_stack,
+            .max_locals = header.max_locals,
+            .max_calls = header.max_calls,
+        },
+    };
+
+    for (usize i = 0; i < symbols.size / sizeof(ImageSymbol); i++) {
+        ImageSymbol record;
+        memcpy(&record, data + symbols.offset + i * sizeof(record), sizeof(record));
+        char const* name = (char const*)data + names.offset + record.name_offset;
+        array_buf_push(BytecodeSymbol)(
+            &image.symbols,
+            (BytecodeSymbol){
+                .name = { .data = name, .len = record.name_len },
+                .signature = {
+                    .data = name + record.name_len,
+                    .len = record.signature_len,
+                },
+                .offset = record.offset,
+            }
+        );
+    }
+
+    ImageSection functions = header.sections[SECTION_FUNCTIONS];
+    for (usize i = 0; i < functions.size / sizeof(ImageFunction); i++) {
+        ImageFunction record;
+        memcpy(&record, data + functions.offset + i * sizeof(record), sizeof(record));
+        array_buf_push(BytecodeFunction)(
+            &image.metadata.functions,
+            (BytecodeFunction){
+                .offset = record.offset,
+                .locals = record.locals,
+                .args = record.args,
+                .results = record.results,
+                .returns = record.returns,
+                .max_depth = record.max_depth,
+            }
+        );
+    }
+
+    ImageSection references = header.sections[SECTION_REFERENCES];
+    for (usize i = 0; i < references.size / sizeof(u64); i++) {
+        u64 record;
+        memcpy(&record, data + references.offset + i * sizeof(record), sizeof(record));
+        array_buf_push(usize)(&image.references, record);
+    }
+
+    *dst = image;
+    return IMAGE_OK;
+}
+
+ImageError bytecode_image_load(char const* path, BytecodeImage* dst) {
+    void* mapping;
+    usize size;
+    ImageError error = map_file(path, &mapping, &size);
+    if (error != IMAGE_OK) {
+        return error;
+    }
+    error = parse(mapping, size, dst);
+    if (error != IMAGE_OK) {
+        unmap_file(mapping, size);
+        return error;
+    }
+    dst->_mapping = mapping;
+    dst->_mapping_size = size;
+    return IMAGE_OK;
+}
+
+void bytecode_image_free(BytecodeImage* image) {
+    if (!image->_mapping) {
+        return;
+    }
+    array_buf_free(BytecodeSymbol)(&image->symbols);
+    array_buf_free(usize)(&image->references);
+    bytecode_metadata_free(&image->metadata);
+    unmap_file(image->_mapping, image->_mapping_size);
+    image->_mapping = NULL;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "bytecode/bytecode.h"
+#include "collections/array.h"
+#include "collections/string.h"
+#include "diagnostics/errno.h"
+#include "verifier/verifier.h"
+
+// Images are memory-mapped, which needs `mmap`. Elsewhere they are read.
+#if defined(__unix__) || defined(__APPLE__)
+#define BYTECODE_IMAGE_MMAP
+#endif
+
+/// @brief Bumped whenever the layout of images or the meaning of the bytecode
+/// changes, so that older images are refused rather than misread.
+#define BYTECODE_IMAGE_VERSION 3
+
+/// @brief A named location of the bytecode, like a function entry.
+///
+/// Symbols of objects can also be imported, with an undefined offset, or
+/// local, with an empty name. Named symbols carry the type of their function
+/// as it is written in the source, for the linker to check imports against.
+typedef struct BytecodeSymbol {
+    String name;
+    String signature;   // empty for local symbols
+    usize offset;       // in bytewords, or BYTECODE_SYMBOL_UNDEFINED
+} BytecodeSymbol;
+
+#define BYTECODE_SYMBOL_UNDEFINED ((usize)-1)
+
+DECL_ARRAY_BUF(BytecodeSymbol)
+
+/// @brief Bytecode with everything needed to run it without compiling it
+/// again.
+///
+/// Images are written as a header followed by sections for the rodata, the
+/// instructions, the symbols, their names and signatures, the functions and
+/// the references.
+/// Integers are in the byte order of the host, which is checked when loading,
+/// like the version and the size of words.
+///
+/// Images with references or undefined symbols are relocatable objects, that
+/// must be linked to run: the operands of their references are indices in
+/// `symbols` instead of locations.
+typedef struct BytecodeImage {
+    Bytecode bytecode;
+    ArrayBuf(BytecodeSymbol) symbols;
+    BytecodeMetadata metadata;
+    /// @brief The locations of the operands of the references of objects.
+    ArrayBuf(usize) references;
+    /// @brief The file a loaded image points into, `NULL` for images built in
+    /// memory.
+    void* _mapping;
+    usize _mapping_size;
+} BytecodeImage;
+
+typedef enum ImageError {
+    IMAGE_OK,
+    IMAGE_IO,               // see `errno`
+    IMAGE_NOT_AN_IMAGE,
+    IMAGE_INCOMPATIBLE,     // another version, byte order or word size
+    IMAGE_CORRUPT,          // sections do not fit in the file or each other
+} ImageError;
+
+/// @brief Writes the image to `file`, at its current position.
+///
+/// @return IMAGE_OK or IMAGE_IO.
+ImageError bytecode_image_write(BytecodeImage const* image, FILE* file);
+
+/// @brief Loads the image written to `path`.
+///
+/// The rodata, instructions and symbol names of the image point into a
+/// read-only mapping of the file, that processes loading the same file share.
+/// They must not be modified, and are freed with the image.
+///
+/// @return IMAGE_CORRUPT as well when symbols or functions are not at the
+/// start of an instruction, or when an image that is not an object has
+/// undefined symbols.
+ImageError bytecode_image_load(char const* path, BytecodeImage* dst);
+
+/// @brief Frees a loaded image. Images built in memory are owned by whoever
+/// built them.
+void bytecode_image_free(BytecodeImage* image);
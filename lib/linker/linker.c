@@ -0,0 +1,179 @@
+#include "linker/linker.h"
+#include "collections/hash_map.h"
+#include "collections/interner.h"
+#include "emitter/emitter.h"
+
+typedef struct Linker {
+    Emitter emitter;
+    HashMap(String, usize) exports;   // symbols of the emitter by name
+    ArrayBuf(String) signatures;      // by symbol of the emitter
+    /// @brief The symbol of the emitter that each symbol of the objects
+    /// stands for, one object after the other.
+    ArrayBuf(usize) symbols;
+    Reporter* reporter;
+} Linker;
+
+static void duplicate_symbol(Linker* linker, String name) {
+    Reporter* reporter = linker->reporter;
+    report_start(reporter, SEVERITY_ERROR, 0);
+    report_format(reporter, "duplicate symbol `%.*s`", (int)name.len, name.data);
+    report_end(reporter);
+}
+
+static void undefined_symbol(Linker* linker, String name) {
+    Reporter* reporter = linker->reporter;
+    report_start(reporter, SEVERITY_ERROR, 1);
+    report_format(reporter, "undefined symbol `%.*s`", (int)name.len, name.data);
+    report_end(reporter);
+}
+
+static void invalid_object(Linker* linker, usize index) {
+    Reporter* reporter = linker->reporter;
+    report_start(reporter, SEVERITY_ERROR, 2);
+    report_format(reporter, "object %zu does not fit its references", index);
+    report_end(reporter);
+}
+
+static void object_with_rodata(Linker* linker, usize index) {
+    Reporter* reporter = linker->reporter;
+    report_start(reporter, SEVERITY_ERROR, 3);
+    report_format(reporter, "object %zu has rodata, which cannot be linked", index);
+    report_end(reporter);
+}
+
+static void mismatched_symbol(Linker* linker, BytecodeSymbol import, String export) {
+    Reporter* reporter = linker->reporter;
+    report_start(reporter, SEVERITY_ERROR, 4);
+    report_format(
+        reporter,
+        "symbol `%.*s` is imported as `%.*s`, but exported as `%.*s`",
+        (int)import.name.len, import.name.data,
+        (int)import.signature.len, import.signature.data,
+        (int)export.len, export.data
+    );
+    report_end(reporter);
+}
+
+// gives a symbol of the emitter to every symbol that an object defines, and
+// exports the named ones.
+static bool define_symbols(Linker* linker, BytecodeImage const* object) {
+    bool ok = true;
+    for (usize i = 0; i < object->symbols.len; i++) {
+        BytecodeSymbol symbol = object->symbols.data[i];
+        if (symbol.offset == BYTECODE_SYMBOL_UNDEFINED) {
+            array_buf_push(usize)(&linker->symbols, SYMBOL_UNSET_LOCATION);
+            continue;
+        }
+        SymbolIndex index = emit_new_symbol(&linker->emitter);
+        array_buf_push(usize)(&linker->symbols, index);
+        array_buf_push(String)(&linker->signatures, symbol.signature);
+        if (symbol.name.len == 0) {
+            continue;
+        }
+        if (hash_map_get(String, usize)(linker->exports, symbol.name)) {
+            duplicate_symbol(linker, symbol.name);
+            ok = false;
+            continue;
+        }
+        hash_map_insert(String, usize)(&linker->exports, symbol.name, index);
+    }
+    return ok;
+}
+
+static bool import_symbols(Linker* linker, BytecodeImage const* object, usize* symbols) {
+    bool ok = true;
+    for (usize i = 0; i < object->symbols.len; i++) {
+        BytecodeSymbol symbol = object->symbols.data[i];
+        if (symbol.offset != BYTECODE_SYMBOL_UNDEFINED) {
+            continue;
+        }
+        usize const* index =
+            hash_map_get(String, usize)(linker->exports, symbol.name);
+        if (!index) {
+            undefined_symbol(linker, symbol.name);
+            ok = false;
+            continue;
+        }
+        String signature = linker->signatures.data[*index];
+        if (!eq(String)(symbol.signature, signature)) {
+            mismatched_symbol(linker, symbol, signature);
+            ok = false;
+            continue;
+        }
+        symbols[i] = *index;
+    }
+    return ok;
+}
+
+static bool emit_object(Linker* linker, BytecodeImage const* object, usize const* symbols) {
+    ArrayBuf(usize) locations = array_buf_new(usize)();
+    for (usize i = 0; i < object->symbols.len; i++) {
+        usize offset = object->symbols.data[i].offset;
+        array_buf_push(usize)(
+            &locations,
+            offset == BYTECODE_SYMBOL_UNDEFINED ? SYMBOL_UNSET_LOCATION : offset
+        );
+    }
+    bool ok = emit_relocatable(
+        &linker->emitter,
+        object->bytecode,
+        object->references,
+        locations.data,
+        symbols,
+        object->symbols.len
+    );
+    array_buf_free(usize)(&locations);
+    return ok;
+}
+
+bool link(
+    BytecodeImage const* objects,
+    usize objects_len,
+    Reporter* reporter,
+    Bytecode* dst
+) {
+    Linker linker = {
+        .emitter = emitter_new(),
+        .exports = hash_map_new(String, usize)(),
+        .symbols = array_buf_new(usize)(),
+        .signatures = array_buf_new(String)(),
+        .reporter = reporter,
+    };
+
+    // every object is defined before any is imported from, so that objects
+    // can call each other whatever their order.
+    bool ok = true;
+    for (usize i = 0; i < objects_len; i++) {
+        ok = define_symbols(&linker, &objects[i]) && ok;
+    }
+    usize first_symbol = 0;
+    for (usize i = 0; i < objects_len; i++) {
+        usize* symbols = linker.symbols.data + first_symbol;
+        ok = import_symbols(&linker, &objects[i], symbols) && ok;
+        first_symbol += objects[i].symbols.len;
+    }
+
+    first_symbol = 0;
+    for (usize i = 0; ok && i < objects_len; i++) {
+        usize const* symbols = linker.symbols.data + first_symbol;
+        // nothing refers to rodata, so it cannot be moved along the
+        // instructions.
+        if (objects[i].bytecode.rodata.len != 0) {
+            object_with_rodata(&linker, i);
+            ok = false;
+        } else if (!emit_object(&linker, &objects[i], symbols)) {
+            invalid_object(&linker, i);
+            ok = false;
+        }
+        first_symbol += objects[i].symbols.len;
+    }
+
+    ok = ok && emitter_finish(&linker.emitter, dst);
+    if (!ok) {
+        emitter_free(&linker.emitter);
+    }
+    hash_map_free(String, usize)(&linker.exports);
+    array_buf_free(usize)(&linker.symbols);
+    array_buf_free(String)(&linker.signatures);
+    return ok;
+}
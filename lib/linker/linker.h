@@ -0,0 +1,24 @@
+#pragma once
+
+#include "bytecode/bytecode.h"
+#include "diagnostics/report.h"
+#include "image/image.h"
+
+/// @brief Links relocatable objects into bytecode that can run.
+///
+/// The instructions of the objects are laid out in order, so the entry point
+/// of the first object is the entry point of the bytecode. Every named symbol
+/// that an object defines is exported to the others, and every symbol that
+/// it leaves undefined is imported from the object that exports its name.
+/// Symbols with empty names stay local to their object. Imports must have
+/// the signature of their export, like calls in a single module.
+///
+/// @param reporter gets the symbols that are exported twice or never, or
+/// imported with another signature, the objects whose references or symbols
+/// do not fit their instructions, and the objects with rodata.
+bool link(
+    BytecodeImage const* objects,
+    usize objects_len,
+    Reporter* reporter,
+    Bytecode* dst
+);
@@ -1,15 +1,116 @@
+#include <string.h>
+
 #include "ops/hash.h"
 
 Hasher new_hasher(void) {
     return (Hasher){ .state = 0 };
 }
 
+// the values are folded with a single multiplication each, which leaves the
+// low bits of the state depending on the low bits of the values only. the
+// high half is folded back into them.
 u64 finish_hash(Hasher hasher) {
-    return hasher.state;
+    u64 s = hasher.state;
+    s ^= s >> 32;
+    s *= 0xd6e8feb86659fd93ULL;
+    s ^= s >> 32;
+    return s;
 }
 
 #define PI ((u64)0x517cc1b727220a95ULL)
 
+static u64 const SECRET[4] = {
+    0xa0761d6478bd642fULL,
+    0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL,
+    0x589965cc75374cc3ULL,
+};
+
+// the full 128-bit product of `*a` and `*b`, low half in `*a`.
+static inline void multiply(u64* a, u64* b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t product = (__uint128_t)*a * *b;
+    *a = (u64)product;
+    *b = (u64)(product >> 64);
+#else
+    u64 a_high = *a >> 32, a_low = (u32)*a;
+    u64 b_high = *b >> 32, b_low = (u32)*b;
+    u64 high = a_high * b_high, middle0 = a_high * b_low;
+    u64 middle1 = a_low * b_high, low = a_low * b_low;
+    u64 t = low + (middle0 << 32);
+    u64 carry = t < low;
+    u64 result_low = t + (middle1 << 32);
+    carry += result_low < t;
+    *a = result_low;
+    *b = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+#endif
+}
+
+static inline u64 mix(u64 a, u64 b) {
+    multiply(&a, &b);
+    return a ^ b;
+}
+
+static inline u64 read_u64(u8 const* p) {
+    u64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline u64 read_u32(u8 const* p) {
+    u32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void hash_bytes(Hasher* hasher, void const* data, usize len) {
+    u8 const* p = data;
+    // the seed is mixed first, so that states differing in few bits do not
+    // start the lanes off alike.
+    u64 seed = hasher->state;
+    seed ^= mix(seed ^ SECRET[0], SECRET[1]);
+    u64 a, b;
+    if (len <= 16) {
+        // short inputs are read as two possibly overlapping halves.
+        if (len >= 4) {
+            usize middle = (len >> 3) << 2;
+            a = (read_u32(p) << 32) | read_u32(p + middle);
+            b = (read_u32(p + len - 4) << 32) | read_u32(p + len - 4 - middle);
+        } else if (len > 0) {
+            a = ((u64)p[0] << 16) | ((u64)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        usize left = len;
+        if (left > 48) {
+            // three independent lanes, so that the multiplications overlap.
+            u64 seed1 = seed, seed2 = seed;
+            do {
+                seed = mix(read_u64(p) ^ SECRET[1], read_u64(p + 8) ^ seed);
+                seed1 = mix(read_u64(p + 16) ^ SECRET[2], read_u64(p + 24) ^ seed1);
+                seed2 = mix(read_u64(p + 32) ^ SECRET[3], read_u64(p + 40) ^ seed2);
+                p += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (left > 16) {
+            seed = mix(read_u64(p) ^ SECRET[1], read_u64(p + 8) ^ seed);
+            p += 16;
+            left -= 16;
+        }
+        // the last 16 bytes, that may overlap with the ones already read.
+        a = read_u64(p + left - 16);
+        b = read_u64(p + left - 8);
+    }
+    a ^= SECRET[1];
+    b ^= seed;
+    multiply(&a, &b);
+    hasher->state = mix(a ^ SECRET[0] ^ len, b ^ SECRET[1]);
+}
+
 #define IMPL_HASH_INTEGRAL(T)                   \
     void hash(T)(Hasher* hasher, T val) {       \
         u64 s = hasher->state;                  \
@@ -38,10 +139,7 @@ IMPL_HASH_INTEGRAL(bool)
 IMPL_HASH_INTEGRAL(char)
 
 void hash(String)(Hasher* hasher, String val) {
-    hash_usize(hasher, val.len);
-    for (usize i = 0; i < val.len; i++) {
-        hash_char(hasher, val.data[i]);
-    }
+    hash_bytes(hasher, val.data, val.len);
 }
 
 void hash(StringBuf)(Hasher* hasher, StringBuf val) {
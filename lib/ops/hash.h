@@ -8,8 +8,16 @@ typedef struct Hasher {
 } Hasher;
 
 Hasher new_hasher(void);
+
+/// @brief Mixes the state into a hash whose bits all depend on every value
+/// that was hashed, so that both the low bits and the high bits can be used.
 u64 finish_hash(Hasher hasher);
 
+/// @brief Hashes `len` bytes at once, reading up to 48 bytes per step in the
+/// style of wyhash. The state is mixed into the seed of the hash, and the
+/// length is part of it.
+void hash_bytes(Hasher* hasher, void const* data, usize len);
+
 #define hash(T) hash_##T
 
 void hash(u8)(          Hasher* hasher, u8          val);
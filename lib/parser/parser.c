@@ -1,4 +1,5 @@
 #include "parser/parser.h"
+#include "alloc/tracking.h"
 
 typedef struct Parser {
     String source;
@@ -7,36 +8,36 @@ typedef struct Parser {
     Reporter* reporter;
     ArrayBuf(Expression) expressions;
     ArrayBuf(usize) functions;
-    AstStorage storage;
+    Arena* arena;
 } Parser;
 
 static bool parser_match(Parser* parser, TokenKind kind, Token* dst) {
-    ArrayBuf(Token) tokens = parser->tokens.tokens;
-    if (tokens.len == parser->pos) {
+    ArrayBuf(u8) kinds = parser->tokens.kinds;
+    if (kinds.len == parser->pos) {
         return false;
     }
-    if (tokens.data[parser->pos].kind != kind) {
+    if (kinds.data[parser->pos] != kind) {
         return false;
     }
     if (dst) {
-        *dst = tokens.data[parser->pos];
+        *dst = token_stream_get(parser->tokens, parser->pos);
     }
     parser->pos++;
     return true;
 }
 
 static void parser_skip_until(Parser* parser, TokenKind kind) {
-    TokenStream tokens = parser->tokens;
+    ArrayBuf(u8) kinds = parser->tokens.kinds;
     usize paren_depth = 0;
-    while (parser->pos != tokens.tokens.len) {
-        Token token = tokens.tokens.data[parser->pos];
-        if (paren_depth == 0 && token.kind == kind) {
+    while (parser->pos != kinds.len) {
+        TokenKind token_kind = kinds.data[parser->pos];
+        if (paren_depth == 0 && token_kind == kind) {
             return;
         }
-        if (token.kind == TOKEN_PAREN_LEFT) {
+        if (token_kind == TOKEN_PAREN_LEFT) {
             paren_depth++;
         }
-        if (token.kind == TOKEN_PAREN_RIGHT && paren_depth >= 0) {
+        if (token_kind == TOKEN_PAREN_RIGHT && paren_depth >= 0) {
             paren_depth--;
         }
         parser->pos++;
@@ -45,6 +46,10 @@ static void parser_skip_until(Parser* parser, TokenKind kind) {
 
 static ExpressionId box_expression(Parser* parser, Expression expression) {
     usize id = parser->expressions.len;
+    if (expression.kind == EXPRESSION_FUNCTION) {
+        expression.as.function.function_id = parser->functions.len;
+        array_buf_push(usize)(&parser->functions, id);
+    }
     array_buf_push(Expression)(&parser->expressions, expression);
     return id;
 }
@@ -55,8 +60,14 @@ static Result parse_constant(Parser* parser, ConstantDef* dst);
 static Result parse_expression(Parser* parser, ExpressionId* dst, Range* range);
 // parser must not be exhausted
 static Result parse_expression_head(Parser* parser, ExpressionId* dst, Range* dst_range);
-// head token must be `fn`
-static Result parse_function(Parser* parser, Function* dst, Range* range);
+// head token must be `fn`. Declarations have no body and are left before
+// the `;` that ends them.
+static Result parse_function(
+    Parser* parser,
+    bool declaration_allowed,
+    Function* dst,
+    Range* range
+);
 static Result parse_pattern(Parser* parser, Pattern* dst);
 static Result parse_type_name(Parser* parser, TypeName* dst);
 static Result parse_identifier(Parser* parser, Identifier* dst);
@@ -66,34 +77,36 @@ bool parse(
     Reporter* reporter,
     Ast* dst
 ) {
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_PARSER);
+    Arena* arena = arena_new(0);
     Parser parser = {
         .source = tokens.source,
         .tokens = tokens,
         .pos = 0,
         .reporter = reporter,
-        .expressions = array_buf_new(Expression)(),
-        .functions = array_buf_new(usize)(),
-        .storage = ast_storage_new(),
+        .expressions = array_buf_new_in(Expression)(&arena->base),
+        .functions = array_buf_new_in(usize)(&arena->base),
+        .arena = arena,
     };
     Module module;
     parse_module(&parser, &module);
-    ast_store(&parser.storage, parser.expressions.data);
-    ast_store(&parser.storage, parser.functions.data);
     *dst = (Ast){
-        .bindings = binding_registry_new(),
-        .types = type_registry_new(),
+        .bindings = binding_registry_new_in(&arena->base),
+        .types = type_registry_new_in(&arena->base),
         .expressions = parser.expressions,
         .functions = parser.functions,
         .root = module,
-        .storage = parser.storage,
+        .interner = tokens.interner,
+        .arena = arena,
     };
+    alloc_stage_leave(stage);
     return reporter_error_count(reporter) == 0;
 }
 
 static Result parse_module(Parser* parser, Module* dst) {
-    TokenStream tokens = parser->tokens;
-    ArrayBuf(ConstantDef) global_constants = array_buf_new(ConstantDef)();
-    while (parser->pos != tokens.tokens.len) {
+    ArrayBuf(ConstantDef) global_constants =
+        array_buf_new_in(ConstantDef)(&parser->arena->base);
+    while (parser->pos != parser->tokens.kinds.len) {
         ConstantDef constant;
         if (parse_constant(parser, &constant) != SUCCESS) {
             parser_skip_until(parser, TOKEN_SEMICOLON);
@@ -116,8 +129,23 @@ static Result parse_constant(Parser* parser, ConstantDef* dst) {
     if (!parser_match(parser, TOKEN_COLON_COLON, NULL)) {
         return ERROR;
     }
+    // global functions can be declared without a body, when another module
+    // defines them.
     ExpressionId value;
-    if (parse_expression(parser, &value, NULL) != SUCCESS) {
+    ArrayBuf(u8) kinds = parser->tokens.kinds;
+    if (parser->pos != kinds.len && kinds.data[parser->pos] == TOKEN_FN) {
+        Expression function = {
+            .kind = EXPRESSION_FUNCTION,
+            .type = TYPE_INVALID,
+        };
+        if (
+            parse_function(parser, true, &function.as.function, &function.range)
+            != SUCCESS
+        ) {
+            return ERROR;
+        }
+        value = box_expression(parser, function);
+    } else if (parse_expression(parser, &value, NULL) != SUCCESS) {
         return ERROR;
     }
     if (!parser_match(parser, TOKEN_SEMICOLON, NULL)) {
@@ -134,7 +162,7 @@ static Result parse_constant(Parser* parser, ConstantDef* dst) {
 }
 
 static Result parse_expression(Parser* parser, ExpressionId* dst, Range* range_dst) {
-    if (parser->pos == parser->tokens.tokens.len) {
+    if (parser->pos == parser->tokens.kinds.len) {
         return ERROR;
     }
 
@@ -144,10 +172,10 @@ static Result parse_expression(Parser* parser, ExpressionId* dst, Range* range_d
 
     // parse function calls
     while (true) {
-        if (parser->pos == parser->tokens.tokens.len) {
+        if (parser->pos == parser->tokens.kinds.len) {
             break;
         }
-        if (parser->tokens.tokens.data[parser->pos].kind != TOKEN_PAREN_LEFT) {
+        if (parser->tokens.kinds.data[parser->pos] != TOKEN_PAREN_LEFT) {
             break;
         }
         Range argument_range = range;
@@ -178,7 +206,7 @@ static Result parse_expression(Parser* parser, ExpressionId* dst, Range* range_d
 }
 
 static Result parse_expression_head(Parser* parser, ExpressionId* dst, Range* dst_range) {
-    Token head = parser->tokens.tokens.data[parser->pos];
+    Token head = token_stream_get(parser->tokens, parser->pos);
     Expression expr = { .type = TYPE_INVALID };
 
     switch (head.kind) {
@@ -194,7 +222,7 @@ static Result parse_expression_head(Parser* parser, ExpressionId* dst, Range* ds
     case TOKEN_FN:
         expr.kind = EXPRESSION_FUNCTION;
         if (
-            parse_function(parser, &expr.as.function, &expr.range)
+            parse_function(parser, false, &expr.as.function, &expr.range)
             != SUCCESS
         ) {
             return ERROR;
@@ -204,13 +232,13 @@ static Result parse_expression_head(Parser* parser, ExpressionId* dst, Range* ds
     case TOKEN_FALSE:
         expr.kind = EXPRESSION_LITERAL_BOOL;
         expr.as.literal_bool = false;
-        expr.range = token_range(parser->tokens, head);
+        expr.range = token_range(head);
         parser->pos++;
         break;
     case TOKEN_TRUE:
         expr.kind = EXPRESSION_LITERAL_BOOL;
         expr.as.literal_bool = true;
-        expr.range = token_range(parser->tokens, head);
+        expr.range = token_range(head);
         parser->pos++;
         break;
 
@@ -231,20 +259,18 @@ static Result parse_expression_head(Parser* parser, ExpressionId* dst, Range* ds
         return ERROR;
     }
 
-    ExpressionId id = parser->expressions.len;
-    if (expr.kind == EXPRESSION_FUNCTION) {
-        expr.as.function.function_id = parser->functions.len;
-        array_buf_push(usize)(&parser->functions, id);
-    }
-    array_buf_push(Expression)(&parser->expressions, expr);
-
-    *dst = id;
+    *dst = box_expression(parser, expr);
     *dst_range = expr.range;
 
     return SUCCESS;
 }
 
-static Result parse_function(Parser* parser, Function* dst, Range* range) {
+static Result parse_function(
+    Parser* parser,
+    bool declaration_allowed,
+    Function* dst,
+    Range* range
+) {
     usize start = parser->pos++;
     Pattern input;
     if (parse_pattern(parser, &input) != SUCCESS) {
@@ -257,12 +283,18 @@ static Result parse_function(Parser* parser, Function* dst, Range* range) {
     if (parse_type_name(parser, &output_type) != SUCCESS) {
         return ERROR;
     }
-    if (!parser_match(parser, TOKEN_DOUBLE_ARROW, NULL)) {
-        return ERROR;
-    }
-    ExpressionId output;
-    if (parse_expression(parser, &output, NULL) != SUCCESS) {
-        return ERROR;
+    ArrayBuf(u8) kinds = parser->tokens.kinds;
+    bool external = declaration_allowed
+        && parser->pos != kinds.len
+        && kinds.data[parser->pos] == TOKEN_SEMICOLON;
+    ExpressionId output = 0;
+    if (!external) {
+        if (!parser_match(parser, TOKEN_DOUBLE_ARROW, NULL)) {
+            return ERROR;
+        }
+        if (parse_expression(parser, &output, NULL) != SUCCESS) {
+            return ERROR;
+        }
     }
     usize end = parser->pos;
     *dst = (Function){
@@ -270,6 +302,7 @@ static Result parse_function(Parser* parser, Function* dst, Range* range) {
         .explicit_output_type = true,
         .output_type_name = output_type,
         .output_type = TYPE_INVALID,
+        .external = external,
         .output = output,
     };
     *range = token_range_range(parser->tokens, (Range){ start, end });
@@ -325,9 +358,9 @@ static Result parse_identifier(Parser* parser, Identifier* dst) {
     if (!parser_match(parser, TOKEN_IDENTIFIER, &identifier)) {
         return ERROR;
     }
-    Range range = token_range(parser->tokens, identifier);
+    Range range = token_range(identifier);
     *dst = (Identifier){
-        .string = string_slice(parser->source, range),
+        .atom = identifier.atom,
         .range = range,
     };
     return SUCCESS;
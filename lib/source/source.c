@@ -1,60 +1,179 @@
+#include <string.h>
+
+#include "alloc/alloc.h"
 #include "source/source.h"
 
-SourceText source_text_new(char const* path, char const* text) {
-    ArrayBuf(usize) line_indices = array_buf_new(usize)();
-    array_buf_push(usize)(&line_indices, 0);
-    usize i;
-    for (i = 0; text[i] != '\0'; i++) {
-        if (text[i] == '\n') {
-            array_buf_push(usize)(&line_indices, i + 1);
-        }
+#ifdef SOURCE_TEXT_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+Errno source_read(SourceReader* reader, char* buffer, usize capacity, usize* len) {
+    return reader->vtable->read(reader, buffer, capacity, len);
+}
+
+static Errno file_source_read(
+    SourceReader* raw,
+    char* buffer,
+    usize capacity,
+    usize* len
+) {
+    FileSourceReader* self = (FileSourceReader*)raw;
+    *len = fread(buffer, 1, capacity, self->file);
+    if (*len == 0 && ferror(self->file)) {
+        return errno ? errno : EIO;
     }
-    array_buf_push(usize)(&line_indices, i);
+    return 0;
+}
+
+static SourceReaderVTable const file_source_reader_vtable = {
+    .read = file_source_read,
+};
+
+FileSourceReader file_source_reader_new(FILE* file) {
+    return (FileSourceReader){
+        .base.vtable = &file_source_reader_vtable,
+        .file = file,
+    };
+}
+
+SourceText source_text_new(char const* path, char const* text) {
     return (SourceText){
         .path = path,
         .text = text,
-        .line_indices = line_indices
+        .len = strlen(text),
+        .line_indices = array_buf_new(usize)(),
+        ._mapping = NULL,
     };
 }
 
+#ifdef SOURCE_TEXT_MMAP
+
+static Errno map_file(char const* path, void** mapping, usize* size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return errno;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        Errno err = errno;
+        close(fd);
+        return err;
+    }
+    *size = status.st_size;
+    if (*size == 0) {
+        // empty mappings are not allowed
+        close(fd);
+        *mapping = NULL;
+        return 0;
+    }
+    *mapping = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    Errno err = (*mapping == MAP_FAILED) ? errno : 0;
+    close(fd);
+    return err;
+}
+
+static void unmap_file(void* mapping, usize size) {
+    munmap(mapping, size);
+}
+
+#else
+
+static Errno map_file(char const* path, void** mapping, usize* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return errno;
+    }
+    StringBuf contents = string_buf_new();
+    Errno err = read_file(file, &contents);
+    fclose(file);
+    if (err) {
+        string_buf_free(&contents);
+        return err;
+    }
+    *mapping = contents.data;
+    *size = contents.len;
+    return 0;
+}
+
+static void unmap_file(void* mapping, usize size) {
+    free_allocation(mapping);
+}
+
+#endif
+
+Errno source_text_open(char const* path, SourceText* dst) {
+    void* mapping;
+    usize size;
+    Errno err = map_file(path, &mapping, &size);
+    if (err) {
+        return err;
+    }
+    *dst = (SourceText){
+        .path = path,
+        .text = mapping ? mapping : "",
+        .len = size,
+        .line_indices = array_buf_new(usize)(),
+        ._mapping = mapping,
+        ._mapping_size = size,
+    };
+    return 0;
+}
+
 void source_text_free(SourceText* source) {
     array_buf_free(usize)(&source->line_indices);
+    if (source->_mapping) {
+        unmap_file(source->_mapping, source->_mapping_size);
+        source->_mapping = NULL;
+    }
 }
 
-LineColumn source_text_position(SourceText text, usize index) {
-    // invariants during the loop:
-    // index at `start` <= `index` < index at `end`
+String source_text_string(SourceText const* source) {
+    return (String){ .data = source->text, .len = source->len };
+}
+
+// the start of every line, then the end of the text.
+static void index_lines(SourceText* source) {
+    ArrayBuf(usize)* line_indices = &source->line_indices;
+    array_buf_push(usize)(line_indices, 0);
+    // `memchr` is vectorized by the C library
+    char const* end = source->text + source->len;
+    char const* newline = source->text;
+    while ((newline = memchr(newline, '\n', end - newline))) {
+        newline++;
+        array_buf_push(usize)(line_indices, newline - source->text);
+    }
+    array_buf_push(usize)(line_indices, source->len);
+}
+
+LineColumn source_text_position(SourceText* source, usize index) {
+    if (source->line_indices.len == 0) {
+        index_lines(source);
+    }
+    ArrayBuf(usize) line_indices = source->line_indices;
+    // the last index is the end of the text, where no line starts.
+    usize lines = line_indices.len - 1;
 
+    // invariants during the loop:
+    // index at `start` <= `index`, and `end` is `lines` or `index` < index at
+    // `end`. the middle is strictly between them, so the loop ends.
     usize start = 0;
-    usize end = text.line_indices.len;
-    usize line;
-    usize line_start;
-    while (true) {
-        usize i = (start + end) / 2;
-        if (index < text.line_indices.data[i]) {                // (1)
-            end = i;
-            // we still have: `index` < index at `end`.
-        } else if (text.line_indices.data[i + 1] <= index) {    // (2)
-            start = i + 1;
-            // we still have: index at `start` <= index.
+    usize end = lines;
+    while (end - start > 1) {
+        usize i = start + (end - start) / 2;
+        if (line_indices.data[i] <= index) {
+            start = i;
         } else {
-            // we have: index at `i` <= `index` < index at `i + 1`.
-            // hence the index at `i` is the index of the start of the searched
-            // line.
-            line = i;
-            line_start = text.line_indices.data[i];
-            break;
+            end = i;
         }
-
-        // Let s and e be respectively `start` and `end` before one iteration.
-        // Let s' and e' be respectively `start` and `end` after the iteration.
-        // If we didn't break, we have either:
-        // (1) e' - s'  == floor((s + e) / 2) - s <= (e - s) / 2 < e - s
-        // (2) e' - s'  == e - floor((s + e) / 2) - 1 <= (e - s) / 2 < e - s
-        // Note: the last inequality of each case is strict because start < end
-        // by the invariants.
-        // Hence, by infinite descent, we are guaranteed to break.
     }
 
-    return (LineColumn){ .line = line, .column = index - line_start };
+    // the line of `start` is the last one that starts at or before `index`,
+    // which puts the end of the text on the last line.
+    return (LineColumn){
+        .line = start,
+        .column = index - line_indices.data[start],
+    };
 }
@@ -13,15 +13,59 @@ typedef struct LineColumn {
     usize column;
 } LineColumn;
 
+// Sources are memory-mapped, which needs `mmap`. Elsewhere they are read.
+#if defined(__unix__) || defined(__APPLE__)
+#define SOURCE_TEXT_MMAP
+#endif
+
+/// @brief The text of a source, with the index of its lines that diagnostics
+/// need to print positions.
+///
+/// The index is only built by the first `source_text_position`, so that
+/// sources that compile without diagnostics are never scanned for lines.
 typedef struct SourceText {
     char const* path;   // NULL if stdin
-    char const* text;
-    ArrayBuf(usize) line_indices;
+    char const* text;   // only NUL-terminated if given to `source_text_new`
+    usize len;
+    ArrayBuf(usize) line_indices;   // empty until the first position
+    /// @brief The mapping of a file opened with `source_text_open`, or `NULL`.
+    void* _mapping;
+    usize _mapping_size;
 } SourceText;
 
 Errno read_file(FILE* file, StringBuf* dst);
 
+/// @brief Where sources are read from piece by piece, by the streaming
+/// tokenizer.
+typedef struct SourceReader {
+    struct SourceReaderVTable const* vtable;
+} SourceReader;
+
+typedef struct SourceReaderVTable {
+    /// @brief Reads up to `capacity` bytes into `buffer`. `*len` is set to the
+    /// number of bytes read, which is only 0 at the end of the source.
+    Errno (*read)(SourceReader* self, char* buffer, usize capacity, usize* len);
+} SourceReaderVTable;
+
+Errno source_read(SourceReader* reader, char* buffer, usize capacity, usize* len);
+
+/// @brief Reads a file with `fread`. The file is not closed.
+typedef struct FileSourceReader {
+    SourceReader base;
+    FILE* file;
+} FileSourceReader;
+
+FileSourceReader file_source_reader_new(FILE* file);
+
+/// @brief A source whose NUL-terminated text is owned by the caller.
 SourceText source_text_new(char const* path, char const* text);
+
+/// @brief Opens the file at `path`, whose text is a read-only mapping of the
+/// file rather than a copy of it. It is freed with the source.
+Errno source_text_open(char const* path, SourceText* dst);
+
 void source_text_free(SourceText* source);
 
-LineColumn source_text_position(SourceText text, usize index);
+String source_text_string(SourceText const* source);
+
+LineColumn source_text_position(SourceText* source, usize index);
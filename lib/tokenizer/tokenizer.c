@@ -1,155 +1,357 @@
-#include <ctype.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "tokenizer/tokenizer.h"
+#include "alloc/alloc.h"
+#include "alloc/tracking.h"
 
 typedef struct Tokenizer {
-    String source;
-    usize pos;
+    String source;      // the whole source, or the window of a stream
+    usize offset;       // of the window in the source
+    usize pos;          // in the window
+    bool partial;       // whether the source goes on after the window
+    bool copy;          // whether identifiers go away with the window
     Reporter* reporter;
     TokenStream* dst;
     bool error;
 } Tokenizer;
 
-static void invalid_token(Tokenizer* tokenizer, usize start) {
+static void token_error(Tokenizer* tokenizer, usize start, char const* message) {
     Reporter* reporter = tokenizer->reporter;
     // FIXME: error code
     report_start(reporter, SEVERITY_ERROR, 0);
-    report_message(reporter, format("invalid token"));
-    report_source_code(reporter, (Range){ start, tokenizer->pos });
+    report_format(reporter, "%s", message);
+    Range range = { tokenizer->offset + start, tokenizer->offset + tokenizer->pos };
+    report_source_code(reporter, range);
     report_end(reporter);
     tokenizer->error = true;
 }
 
-typedef struct ExactToken {
-    char pattern[8];
-    TokenKind kind;
-} ExactToken;
+static void invalid_token(Tokenizer* tokenizer, usize start) {
+    token_error(tokenizer, start, "invalid token");
+}
+
+// the token is at a position of the window.
+static void push_token(Tokenizer* tokenizer, Token token) {
+    if (tokenizer->offset + token.pos > TOKEN_MAX_POS) {
+        token_error(tokenizer, token.pos, "source is too long");
+        return;
+    }
+    if (token.len > TOKEN_MAX_LEN) {
+        token_error(tokenizer, token.pos, "token is too long");
+        return;
+    }
+    token.pos += tokenizer->offset;
+    token_stream_push(tokenizer->dst, token);
+}
 
-static ExactToken punctuation[] = {
-    { "(", TOKEN_PAREN_LEFT },
-    { ")", TOKEN_PAREN_RIGHT },
-    { ":", TOKEN_COLON },
-    { "::", TOKEN_COLON_COLON },
-    { "=", TOKEN_EQUAL },
-    { ":=", TOKEN_COLON_EQUAL },
-    { "->", TOKEN_ARROW },
-    { "=>", TOKEN_DOUBLE_ARROW },
-    { ";", TOKEN_SEMICOLON },
-
-    { "&", TOKEN_AMPERSAND },
+// classes of the bytes of sources, like the "C" locale classifies ASCII.
+// bytes without a class are tokenized as punctuation.
+enum {
+    CHAR_SPACE = 1 << 0,
+    CHAR_IDENTIFIER_START = 1 << 1,
+    CHAR_IDENTIFIER = 1 << 2,
 };
 
-static void tokenize_punctuation(Tokenizer* tokenizer) {
-    usize max_len = 0;
+#define S CHAR_SPACE
+#define L (CHAR_IDENTIFIER_START | CHAR_IDENTIFIER)
+#define D CHAR_IDENTIFIER
+static u8 const char_classes[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, S, S, S, S, S, 0, 0,   // \t \n \v \f \r
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // space
+    D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0,   // 0-9
+    0, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L,   // A-O
+    L, L, L, L, L, L, L, L, L, L, L, 0, 0, 0, 0, L,   // P-Z _
+    0, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L,   // a-o
+    L, L, L, L, L, L, L, L, L, L, L, 0, 0, 0, 0, 0,   // p-z
+};
+#undef S
+#undef L
+#undef D
+
+static inline bool char_is(char c, u8 class) {
+    return char_classes[(u8)c] & class;
+}
+
+#ifdef __SSE2__
+
+#define CHUNK_SIZE 16
+
+// the bytes of `chunk` in [low, low + span], compared as unsigned.
+static inline __m128i chunk_in_range(__m128i chunk, char low, char span) {
+    __m128i offset = _mm_sub_epi8(chunk, _mm_set1_epi8(low));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(span)), offset);
+}
+
+static inline u32 chunk_spaces(__m128i chunk) {
+    __m128i spaces = _mm_or_si128(
+        _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+        chunk_in_range(chunk, '\t', '\r' - '\t')
+    );
+    return (u32)_mm_movemask_epi8(spaces);
+}
+
+static inline u32 chunk_identifier(__m128i chunk) {
+    // setting 0x20 lowers letters, and moves no other byte into a-z
+    __m128i lowered = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    __m128i identifier = _mm_or_si128(
+        _mm_or_si128(
+            chunk_in_range(lowered, 'a', 'z' - 'a'),
+            chunk_in_range(chunk, '0', '9' - '0')
+        ),
+        _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'))
+    );
+    return (u32)_mm_movemask_epi8(identifier);
+}
+
+// skips the bytes that `chunk_class` matches, 16 at a time, until less than
+// 16 are left.
+#define SKIP_CHUNKS(source, pos, chunk_class)                                   \
+    while ((pos) + CHUNK_SIZE <= (source).len) {                                \
+        __m128i chunk = _mm_loadu_si128(                                        \
+            (__m128i const*)((source).data + (pos))                             \
+        );                                                                      \
+        u32 others = ~chunk_class(chunk) & 0xffff;                              \
+        if (others) {                                                           \
+            return (pos) + (usize)__builtin_ctz(others);                        \
+        }                                                                       \
+        (pos) += CHUNK_SIZE;                                                    \
+    }
+
+#else
+
+#define SKIP_CHUNKS(source, pos, chunk_class)
+
+#endif
+
+// returns the position of the first byte from `pos` that is not of `class`.
+#define SKIP_CLASS(source, pos, class, chunk_class)                             \
+    SKIP_CHUNKS(source, pos, chunk_class)                                       \
+    while ((pos) < (source).len && char_is((source).data[(pos)], (class))) {    \
+        (pos)++;                                                                \
+    }                                                                           \
+    return (pos);
+
+static usize skip_spaces(String source, usize pos) {
+    SKIP_CLASS(source, pos, CHAR_SPACE, chunk_spaces)
+}
+
+static usize skip_identifier(String source, usize pos) {
+    SKIP_CLASS(source, pos, CHAR_IDENTIFIER, chunk_identifier)
+}
+
+// returns false if the token may go on after the window.
+static bool tokenize_punctuation(Tokenizer* tokenizer) {
+    usize start = tokenizer->pos;
+    if (tokenizer->partial && start + 1 == tokenizer->source.len) {
+        return false;
+    }
+    char c = tokenizer->source.data[start];
+    char next = start + 1 < tokenizer->source.len
+        ? tokenizer->source.data[start + 1]
+        : '\0';
     TokenKind kind;
-    for (usize i = 0; i < sizeof(punctuation) / sizeof(ExactToken); i++) {
-        ExactToken pattern = punctuation[i];
-        if (!strncmp(
-            pattern.pattern,
-            tokenizer->source.data + tokenizer->pos,
-            strlen(pattern.pattern)
-        )) {
-            usize len = strlen(pattern.pattern);
-            if (len > max_len) {
-                max_len = len;
-                kind = pattern.kind;
-            }
+    usize len = 1;
+    switch (c) {
+    case '(': kind = TOKEN_PAREN_LEFT; break;
+    case ')': kind = TOKEN_PAREN_RIGHT; break;
+    case ';': kind = TOKEN_SEMICOLON; break;
+    case '&': kind = TOKEN_AMPERSAND; break;
+    case ':':
+        switch (next) {
+        case ':': kind = TOKEN_COLON_COLON; len = 2; break;
+        case '=': kind = TOKEN_COLON_EQUAL; len = 2; break;
+        default: kind = TOKEN_COLON; break;
         }
-    }
-    if (max_len == 0) {
-        usize start = tokenizer->pos++;
+        break;
+    case '=':
+        if (next == '>') {
+            kind = TOKEN_DOUBLE_ARROW;
+            len = 2;
+        } else {
+            kind = TOKEN_EQUAL;
+        }
+        break;
+    case '-':
+        if (next == '>') {
+            kind = TOKEN_ARROW;
+            len = 2;
+            break;
+        }
+        // fallthrough
+    default:
+        tokenizer->pos++;
         invalid_token(tokenizer, start);
-        return;
-    } else {
-        Token token = { .pos = tokenizer->pos, .kind = kind };
-        array_buf_push(Token)(&tokenizer->dst->tokens, token);
+        return true;
     }
-    tokenizer->pos += max_len;
-};
+    Token token = { .kind = kind, .pos = start, .len = len };
+    push_token(tokenizer, token);
+    tokenizer->pos += len;
+    return true;
+}
+
+typedef struct ExactToken {
+    char pattern[8];
+    TokenKind kind;
+} ExactToken;
+
+// a perfect hash of the keywords, which each have their own slot.
+#define KEYWORD_SLOT(first, len) ((((usize)(u8)(first)) ^ (usize)(len)) & 7)
 
-static ExactToken keywords[] = {
-    { .pattern = "let", .kind = TOKEN_LET },
-    { .pattern = "fn", .kind = TOKEN_FN },
-    { .pattern = "true", .kind = TOKEN_TRUE },
-    { .pattern = "false", .kind = TOKEN_FALSE },
+static ExactToken const keywords[8] = {
+    [KEYWORD_SLOT('l', 3)] = { .pattern = "let", .kind = TOKEN_LET },
+    [KEYWORD_SLOT('f', 2)] = { .pattern = "fn", .kind = TOKEN_FN },
+    [KEYWORD_SLOT('t', 4)] = { .pattern = "true", .kind = TOKEN_TRUE },
+    [KEYWORD_SLOT('f', 5)] = { .pattern = "false", .kind = TOKEN_FALSE },
 };
 
 // first character must be alphabetic or `_`
-// return whether an identifier as been tokenized
-static void tokenize_identifier_or_keyword(Tokenizer* tokenizer) {
+// returns false if the token may go on after the window.
+static bool tokenize_identifier_or_keyword(Tokenizer* tokenizer) {
     usize start = tokenizer->pos;
     // skip first character
-    while (++tokenizer->pos < tokenizer->source.len) {
-        char c = tokenizer->source.data[tokenizer->pos];
-        if (!isalnum(c) && c != '_') {
-            break;
-        }
+    usize end = skip_identifier(tokenizer->source, start + 1);
+    if (tokenizer->partial && end == tokenizer->source.len) {
+        return false;
     }
+    tokenizer->pos = end;
     char const* p_start = tokenizer->source.data + start;
     usize len = tokenizer->pos - start;
     TokenKind kind = TOKEN_IDENTIFIER;
-    for (usize i = 0; i < sizeof(keywords) / sizeof(ExactToken); i++) {
-        ExactToken pattern = keywords[i];
-        if (!strncmp(p_start, pattern.pattern, len)) {
-            kind = pattern.kind;
-            break;
-        }
+    ExactToken const* keyword = &keywords[KEYWORD_SLOT(p_start[0], len)];
+    if (
+        len < sizeof(keyword->pattern)
+        && keyword->pattern[len] == '\0'
+        && memcmp(p_start, keyword->pattern, len) == 0
+    ) {
+        kind = keyword->kind;
     }
+    Atom atom = 0;
     if (kind == TOKEN_IDENTIFIER) {
-        hash_map_insert(usize, usize)(
-            &tokenizer->dst->_end_pos,
-            start,
-            tokenizer->pos
-        );
+        String name = { .data = p_start, .len = len };
+        atom = tokenizer->copy
+            ? intern_copy(tokenizer->dst->interner, name)
+            : intern(tokenizer->dst->interner, name);
     }
-    Token token = { .kind = kind, .pos = start };
-    array_buf_push(Token)(&tokenizer->dst->tokens, token);
-}
-
-static void skip_whitespace(Tokenizer* p_tokenizer) {
-    Tokenizer tokenizer = *p_tokenizer;
-    while (tokenizer.pos < tokenizer.source.len) {
-        if (isspace(tokenizer.source.data[tokenizer.pos])) {
-            tokenizer.pos++;
-            continue;
-        }
-        break;
-    }
-    *p_tokenizer = tokenizer;
+    Token token = { .kind = kind, .atom = atom, .pos = start, .len = len };
+    push_token(tokenizer, token);
+    return true;
 }
 
-bool tokenize_one(Tokenizer* tokenizer) {
-    skip_whitespace(tokenizer);
+// returns false at the end of the window, where `pos` is left at the start of
+// the token that may go on after it, if any.
+static bool tokenize_one(Tokenizer* tokenizer) {
+    tokenizer->pos = skip_spaces(tokenizer->source, tokenizer->pos);
     if (tokenizer->pos == tokenizer->source.len) {
         return false;
     }
     char c = tokenizer->source.data[tokenizer->pos];
-    if (ispunct(c) && c != '_') {
-        tokenize_punctuation(tokenizer);
-    } else if (isalpha(c) || c == '_') {
-        tokenize_identifier_or_keyword(tokenizer);
+    if (char_is(c, CHAR_IDENTIFIER_START)) {
+        return tokenize_identifier_or_keyword(tokenizer);
+    } else {
+        return tokenize_punctuation(tokenizer);
     }
-    return true;
 }
 
-bool tokenize(String source, Reporter* reporter, TokenStream* dst) {
-    TokenStream stream = {
-        .source = source,
-        .tokens = array_buf_new(Token)(),
-        ._end_pos = hash_map_new(usize, usize)(),
-    };
+bool tokenize(
+    String source,
+    Interner* interner,
+    Reporter* reporter,
+    TokenStream* dst
+) {
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_TOKENIZER);
+    TokenStream stream = token_stream_new(source, interner);
     Tokenizer tokenizer = {
         .source = source,
+        .offset = 0,
         .pos = 0,
+        .partial = false,
+        .copy = false,
         .reporter = reporter,
         .dst = &stream,
         .error = false,
     };
     while (tokenize_one(&tokenizer));
+    alloc_stage_leave(stage);
     if (tokenizer.error) {
+        token_stream_free(&stream);
         return false;
     }
     *dst = stream;
     return true;
 }
+
+bool tokenize_stream(
+    SourceReader* reader,
+    usize chunk_size,
+    Interner* interner,
+    Reporter* reporter,
+    TokenSink* sink
+) {
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_TOKENIZER);
+    if (chunk_size == 0) {
+        chunk_size = TOKENIZER_DEFAULT_CHUNK_SIZE;
+    }
+    usize capacity = chunk_size;
+    char* buffer = malloc_or_exit(capacity);
+    usize len = 0;
+    TokenStream batch = token_stream_new((String){ .data = NULL, .len = 0 }, interner);
+    Tokenizer tokenizer = {
+        .offset = 0,
+        .copy = true,
+        .reporter = reporter,
+        .dst = &batch,
+        .error = false,
+    };
+    bool end = false;
+    while (!end) {
+        // the token left at the start fills the buffer
+        if (len == capacity) {
+            buffer = realloc_or_exit(buffer, capacity * 2);
+            capacity *= 2;
+        }
+        usize read;
+        Errno err = source_read(reader, buffer + len, capacity - len, &read);
+        if (err) {
+            // FIXME: error code
+            report_start(reporter, SEVERITY_ERROR, 0);
+            report_format(reporter, "cannot read the source: %s", strerror(err));
+            report_end(reporter);
+            tokenizer.error = true;
+            break;
+        }
+        end = read == 0;
+        len += read;
+
+        tokenizer.source = (String){ .data = buffer, .len = len };
+        tokenizer.pos = 0;
+        tokenizer.partial = !end;
+        while (tokenize_one(&tokenizer));
+        if (tokenizer.pos == 0 && len == capacity && capacity > TOKEN_MAX_LEN) {
+            // no token is that long, so the buffer is not grown any further
+            tokenizer.partial = false;
+            while (tokenize_one(&tokenizer));
+        }
+        if (batch.kinds.len > 0) {
+            sink->vtable->push(sink, &batch);
+            batch.kinds.len = 0;
+            batch.starts.len = 0;
+            batch.lens.len = 0;
+            batch.atoms.len = 0;
+        }
+
+        // the bytes of the token that may go on are read again with the next
+        // ones
+        len -= tokenizer.pos;
+        memmove(buffer, buffer + tokenizer.pos, len);
+        tokenizer.offset += tokenizer.pos;
+    }
+    token_stream_free(&batch);
+    free_allocation(buffer);
+    alloc_stage_leave(stage);
+    return !tokenizer.error;
+}
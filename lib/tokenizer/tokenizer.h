@@ -6,4 +6,30 @@
 
 // *dst will be replaced without being freed
 // *dst may be uninitialized
-bool tokenize(String source, Reporter* reporter, TokenStream* dst);
+// identifiers are interned in `interner`, which must outlive the stream
+bool tokenize(
+    String source,
+    Interner* interner,
+    Reporter* reporter,
+    TokenStream* dst
+);
+
+#define TOKENIZER_DEFAULT_CHUNK_SIZE ((usize)64 << 10)
+
+/// @brief Tokenizes the source that `reader` reads, `chunk_size` bytes at a
+/// time or a default size if it is 0, and pushes the tokens of each chunk to
+/// `sink`.
+///
+/// Only a chunk of the source is in memory at once, with the start of the
+/// token it ends in, if any. Identifiers are copied into `interner`. Errors
+/// are reported as they are found, and the tokens around them are still
+/// pushed.
+///
+/// @return Whether the whole source was read and tokenized without errors.
+bool tokenize_stream(
+    SourceReader* reader,
+    usize chunk_size,
+    Interner* interner,
+    Reporter* reporter,
+    TokenSink* sink
+);
@@ -1,51 +1,69 @@
 #include "tokens/token.h"
 
-IMPL_ARRAY_BUF(Token)
+TokenStream token_stream_new(String source, Interner* interner) {
+    return (TokenStream){
+        .source = source,
+        .kinds = array_buf_new(u8)(),
+        .starts = array_buf_new(u32)(),
+        .lens = array_buf_new(u16)(),
+        .atoms = array_buf_new(Atom)(),
+        .interner = interner,
+    };
+}
 
 void token_stream_free(TokenStream* token_stream) {
-    array_buf_free(Token)(&token_stream->tokens);
-    hash_map_free(usize, usize)(&token_stream->_end_pos);
+    array_buf_free(u8)(&token_stream->kinds);
+    array_buf_free(u32)(&token_stream->starts);
+    array_buf_free(u16)(&token_stream->lens);
+    array_buf_free(Atom)(&token_stream->atoms);
 }
 
-static usize token_len[] = {
-    [TOKEN_PAREN_LEFT] = 1,
-    [TOKEN_PAREN_RIGHT] = 1,
-    [TOKEN_COLON] = 1,
-    [TOKEN_COLON_COLON] = 2,
-    [TOKEN_EQUAL] = 1,
-    [TOKEN_COLON_EQUAL] = 2,
-    [TOKEN_ARROW] = 2,
-    [TOKEN_DOUBLE_ARROW] = 2,
-    [TOKEN_SEMICOLON] = 1,
+void token_stream_push(TokenStream* stream, Token token) {
+    array_buf_push(u8)(&stream->kinds, token.kind);
+    array_buf_push(u32)(&stream->starts, token.pos);
+    array_buf_push(u16)(&stream->lens, token.len);
+    array_buf_push(Atom)(&stream->atoms, token.atom);
+}
 
-    [TOKEN_AMPERSAND] = 1,
+Token token_stream_get(TokenStream stream, usize index) {
+    return (Token){
+        .kind = stream.kinds.data[index],
+        .atom = stream.atoms.data[index],
+        .pos = stream.starts.data[index],
+        .len = stream.lens.data[index],
+    };
+}
 
-    [TOKEN_IDENTIFIER] = -1,
+static void token_stream_sink_push(TokenSink* raw, TokenStream const* batch) {
+    TokenStreamSink* self = (TokenStreamSink*)raw;
+    usize len = batch->kinds.len;
+    array_buf_extend(u8)(&self->dst->kinds, batch->kinds.data, len);
+    array_buf_extend(u32)(&self->dst->starts, batch->starts.data, len);
+    array_buf_extend(u16)(&self->dst->lens, batch->lens.data, len);
+    array_buf_extend(Atom)(&self->dst->atoms, batch->atoms.data, len);
+}
 
-    [TOKEN_FN] = 2,
-    [TOKEN_FALSE] = 5,
-    [TOKEN_TRUE] = 4,
+static TokenSinkVTable const token_stream_sink_vtable = {
+    .push = token_stream_sink_push,
 };
 
-Range token_range(TokenStream stream, Token token) {
-    usize end_pos;
-    switch (token.kind) {
-    case TOKEN_IDENTIFIER:;
-        end_pos = *hash_map_get(usize, usize)(stream._end_pos, token.pos);
-        break;
+TokenStreamSink token_stream_sink_new(TokenStream* dst) {
+    return (TokenStreamSink){
+        .base.vtable = &token_stream_sink_vtable,
+        .dst = dst,
+    };
+}
 
-    default:
-        end_pos = token.pos + token_len[token.kind];
-        break;
-    }
-    return (Range){ token.pos, end_pos };
+Range token_range(Token token) {
+    return (Range){ token.pos, token.pos + token.len };
 }
 
 Range token_range_range(TokenStream stream, Range range) {
-    usize start = stream.tokens.data[range.start].pos;
+    usize start = stream.starts.data[range.start];
     if (range.end <= range.start) {
         return (Range){ start, start };
     }
-    usize end = token_range(stream, stream.tokens.data[range.end - 1]).end;
+    usize last = range.end - 1;
+    usize end = stream.starts.data[last] + stream.lens.data[last];
     return (Range){ start, end };
 }
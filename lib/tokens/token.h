@@ -2,7 +2,7 @@
 
 #include "primitives/primitives.h"
 #include "collections/array.h"
-#include "collections/hash_map.h"
+#include "collections/interner.h"
 
 typedef enum TokenKind {
     TOKEN_PAREN_LEFT,
@@ -25,20 +25,55 @@ typedef enum TokenKind {
     TOKEN_TRUE,
 } TokenKind;
 
+/// @brief Tokens start in the first 4 GiB of the source and are shorter than
+/// 64 KiB, so that streams can store them in fewer bytes.
+#define TOKEN_MAX_POS ((usize)UINT32_MAX)
+#define TOKEN_MAX_LEN ((usize)UINT16_MAX)
+
 typedef struct Token {
     TokenKind kind;
+    Atom atom;      // of identifiers
     usize pos;
+    usize len;
 } Token;
 
-DECL_ARRAY_BUF(Token)
-
+/// @brief The tokens of a source, in parallel arrays indexed by token, so that
+/// matching kinds only reads a byte per token.
 typedef struct TokenStream {
     String source;
-    ArrayBuf(Token) tokens;
-    HashMap(usize, usize) _end_pos;
+    ArrayBuf(u8) kinds;     // TokenKind
+    ArrayBuf(u32) starts;
+    ArrayBuf(u16) lens;
+    ArrayBuf(Atom) atoms;   // of identifiers, 0 for the other tokens
+    Interner* interner;     // of the identifiers, not owned
 } TokenStream;
 
+TokenStream token_stream_new(String source, Interner* interner);
 void token_stream_free(TokenStream* token_stream);
 
-Range token_range(TokenStream stream, Token token);
+/// @brief The position and length of the token must fit, see `TOKEN_MAX_POS`
+/// and `TOKEN_MAX_LEN`.
+void token_stream_push(TokenStream* stream, Token token);
+Token token_stream_get(TokenStream stream, usize index);
+
+/// @brief Receives the tokens of a streamed source, batch by batch.
+typedef struct TokenSink {
+    struct TokenSinkVTable const* vtable;
+} TokenSink;
+
+typedef struct TokenSinkVTable {
+    /// @brief The batch is only valid during the call. Its positions are in
+    /// the whole source, which it has no `source` of.
+    void (*push)(TokenSink* self, TokenStream const* batch);
+} TokenSinkVTable;
+
+/// @brief A sink that appends the batches to a stream, for the parser.
+typedef struct TokenStreamSink {
+    TokenSink base;
+    TokenStream* dst;
+} TokenStreamSink;
+
+TokenStreamSink token_stream_sink_new(TokenStream* dst);
+
+Range token_range(Token token);
 Range token_range_range(TokenStream stream, Range range);
@@ -0,0 +1,801 @@
+#include <string.h>
+
+#include "alloc/alloc.h"
+#include "ops/ptr.h"
+#include "verifier/verifier.h"
+
+IMPL_ARRAY_BUF(BytecodeFunction)
+
+char const* const verify_error_messages[VERIFY_ERRORS_LEN] = {
+    [VERIFY_INVALID_OPCODE] = "invalid opcode",
+    [VERIFY_INVALID_SYSCALL] = "invalid syscall",
+    [VERIFY_TRUNCATED] = "truncated instruction",
+    [VERIFY_MISALIGNED_IMMEDIATE] = "word immediate is not aligned",
+    [VERIFY_INVALID_TARGET] = "location is not the start of an instruction",
+    [VERIFY_FALLS_OFF_END] = "runs past the end of the bytecode",
+    [VERIFY_STACK_UNDERFLOW] = "stack underflow",
+    [VERIFY_STACK_MISMATCH] = "stack depth depends on the path to the instruction",
+    [VERIFY_VARIABLE_OUT_OF_RANGE] = "variable is not reserved by the function",
+    [VERIFY_MISPLACED_RES] = "`res` is not at the entry of a function",
+    [VERIFY_UNKNOWN_CALLEE] = "indirect call to functions with different stack effects",
+    [VERIFY_ENTRY_RETURNS] = "the entry point returns",
+};
+
+void bytecode_metadata_free(BytecodeMetadata* metadata) {
+    array_buf_free(BytecodeFunction)(&metadata->functions);
+}
+
+void bytecode_stack_map_free(BytecodeStackMap* stack_map) {
+    free_allocation(stack_map->functions);
+    free_allocation(stack_map->depths);
+}
+
+#define NONE ((usize)-1)
+#define UNKNOWN_DEPTH INT64_MIN
+
+typedef struct VerifierInstruction {
+    usize offset;
+    Opcode opcode;
+    Syscall syscall;
+    Byteword imb;
+    Word imw;
+    usize vars[3];
+    u8 vars_len;
+    bool has_target;
+    usize target;   // location, then index of the instruction there
+} VerifierInstruction;
+
+DECL_ARRAY_BUF(VerifierInstruction)
+IMPL_ARRAY_BUF(VerifierInstruction)
+
+typedef enum BoundsState {
+    BOUNDS_UNKNOWN,
+    BOUNDS_VISITING,
+    BOUNDS_KNOWN,
+} BoundsState;
+
+typedef struct VerifierFunction {
+    usize entry;        // instruction index
+    bool known;         // whether `returns`, `args` and `results` are set
+    bool returns;
+    bool address_taken; // whether it may be called indirectly
+    i64 args;
+    i64 results;
+    i64 max_depth;
+    u16 locals;
+    usize calls_start;  // in `Verifier.calls`
+    usize calls_len;
+
+    BoundsState bounds;
+    usize max_stack;
+    usize max_locals;
+    usize max_calls;
+} VerifierFunction;
+
+DECL_ARRAY_BUF(VerifierFunction)
+IMPL_ARRAY_BUF(VerifierFunction)
+
+typedef struct VerifierCall {
+    i64 depth;      // of the caller's stack once the callee is entered
+    usize callee;   // `NONE` for indirect calls
+} VerifierCall;
+
+DECL_ARRAY_BUF(VerifierCall)
+IMPL_ARRAY_BUF(VerifierCall)
+
+typedef struct Verifier {
+    usize len;      // of the bytecode
+    ArrayBuf(VerifierInstruction) in;
+    ArrayBuf(VerifierFunction) functions;
+    ArrayBuf(VerifierCall) calls;
+    usize* function_of_entry;   // for each instruction
+    bool* is_target;            // of a jump
+    VerifyError error;
+
+    // analysis of one function
+    i64* depths;
+    ArrayBuf(usize) work;
+    ArrayBuf(usize) visited;
+    usize function;
+    i64 min_depth;
+    i64 max_depth;
+    bool has_ret;
+    i64 ret_depth;
+    usize ret_index;
+    bool blocked;
+    bool record_calls;
+
+    BytecodeStackMap* stack_map;    // if it is mapped
+} Verifier;
+
+static bool fail_at(
+    Verifier* verifier,
+    VerifyErrorKind kind,
+    usize offset,
+    usize end
+) {
+    verifier->error = (VerifyError){ .kind = kind, .offset = offset, .end = end };
+    return false;
+}
+
+static bool fail(Verifier* verifier, VerifyErrorKind kind, usize index) {
+    usize end = (index + 1 < verifier->in.len)
+        ? verifier->in.data[index + 1].offset
+        : verifier->len;
+    return fail_at(verifier, kind, verifier->in.data[index].offset, end);
+}
+
+static VerifyErrorKind const decode_errors[] = {
+    [DECODE_INVALID_OPCODE] = VERIFY_INVALID_OPCODE,
+    [DECODE_INVALID_SYSCALL] = VERIFY_INVALID_SYSCALL,
+    [DECODE_TRUNCATED] = VERIFY_TRUNCATED,
+    [DECODE_MISALIGNED_IMMEDIATE] = VERIFY_MISALIGNED_IMMEDIATE,
+};
+
+static bool decode(Verifier* verifier, Bytecode bytecode) {
+    Byteword const* const start = bytecode.instructions.data;
+    Byteword const* const end = start + bytecode.instructions.len;
+    Byteword const* ip = start;
+    // offsets are only aligned like the words they lead to if the bytecode is.
+    if ((uptr)start % alignof(Word) != 0) {
+        return fail_at(verifier, VERIFY_MISALIGNED_IMMEDIATE, 0, 0);
+    }
+    usize offset;
+    while ((offset = ip - start) < verifier->len) {
+        BytecodeInstruction decoded;
+        DecodeError error = bytecode_decode(&ip, end, &decoded);
+        if (error != DECODE_OK) {
+            return fail_at(verifier, decode_errors[error], offset, ip - start);
+        }
+        VerifierInstruction instruction = {
+            .offset = offset,
+            .opcode = decoded.opcode,
+            .syscall = decoded.syscall,
+        };
+        for (usize i = 0; i < decoded.operands_len; i++) {
+            BytecodeOperand operand = decoded.operands[i];
+            switch (decoded.kinds[i]) {
+            case OPERAND_IMB:
+                instruction.imb = operand.imb;
+                break;
+            case OPERAND_IMW:
+                instruction.imw = operand.imw;
+                break;
+            case OPERAND_LOC:
+                instruction.has_target = true;
+                instruction.target = operand.loc;
+                break;
+            case OPERAND_VAR:
+                instruction.vars[instruction.vars_len++] = operand.var;
+                break;
+            }
+        }
+        array_buf_push(VerifierInstruction)(&verifier->in, instruction);
+    }
+    return true;
+}
+
+static bool is_jump(Opcode opcode) {
+    switch (opcode) {
+    case OP_JMP:
+    case OP_JNZ:
+    case OP_JEQ:
+    case OP_JNE:
+    case OP_JGE:
+    case OP_JGT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// decodes the bytecode, and resolves its locations to instruction indices.
+static bool check_encoding(Verifier* verifier, Bytecode bytecode) {
+    if (!decode(verifier, bytecode)) {
+        return false;
+    }
+    usize len = verifier->in.len;
+    verifier->function_of_entry = malloc_or_exit((len + 1) * sizeof(usize));
+    verifier->is_target = malloc_or_exit((len + 1) * sizeof(bool));
+    verifier->depths = malloc_or_exit((len + 1) * sizeof(i64));
+    for (usize i = 0; i < len; i++) {
+        verifier->function_of_entry[i] = NONE;
+        verifier->is_target[i] = false;
+        verifier->depths[i] = UNKNOWN_DEPTH;
+    }
+
+    usize* indices = malloc_or_exit((verifier->len + 1) * sizeof(usize));
+    for (usize i = 0; i < verifier->len; i++) {
+        indices[i] = NONE;
+    }
+    for (usize i = 0; i < len; i++) {
+        indices[verifier->in.data[i].offset] = i;
+    }
+    for (usize i = 0; i < len; i++) {
+        VerifierInstruction* instruction = &verifier->in.data[i];
+        if (!instruction->has_target) {
+            continue;
+        }
+        usize target = instruction->target;
+        if (target >= verifier->len || indices[target] == NONE) {
+            free_allocation(indices);
+            return fail(verifier, VERIFY_INVALID_TARGET, i);
+        }
+        instruction->target = indices[target];
+        if (is_jump(instruction->opcode)) {
+            verifier->is_target[instruction->target] = true;
+        }
+    }
+    free_allocation(indices);
+    return true;
+}
+
+static bool find_functions(Verifier* verifier) {
+    usize len = verifier->in.len;
+    if (len == 0) {
+        return fail_at(verifier, VERIFY_FALLS_OFF_END, 0, 0);
+    }
+
+    verifier->function_of_entry[0] = 0;
+    array_buf_push(VerifierFunction)(
+        &verifier->functions,
+        (VerifierFunction){ .entry = 0 }
+    );
+    for (usize i = 0; i < len; i++) {
+        VerifierInstruction instruction = verifier->in.data[i];
+        if (instruction.opcode != OP_LOC) {
+            continue;
+        }
+        usize entry = instruction.target;
+        if (verifier->function_of_entry[entry] == NONE) {
+            verifier->function_of_entry[entry] = verifier->functions.len;
+            array_buf_push(VerifierFunction)(
+                &verifier->functions,
+                (VerifierFunction){ .entry = entry }
+            );
+        }
+        bool called_directly =
+            i + 1 < len
+            && verifier->in.data[i + 1].opcode == OP_CAL
+            && !verifier->is_target[i + 1];
+        if (!called_directly) {
+            verifier->functions.data[verifier->function_of_entry[entry]].address_taken = true;
+        }
+    }
+    return true;
+}
+
+static bool touch(Verifier* verifier, usize index, i64 depth) {
+    // the entry point has no caller to pop values from.
+    if (depth < 0 && verifier->function == 0) {
+        return fail(verifier, VERIFY_STACK_UNDERFLOW, index);
+    }
+    if (depth < verifier->min_depth) {
+        verifier->min_depth = depth;
+    }
+    if (depth > verifier->max_depth) {
+        verifier->max_depth = depth;
+    }
+    return true;
+}
+
+static bool visit(Verifier* verifier, usize from, usize index, i64 depth) {
+    if (index >= verifier->in.len) {
+        return fail(verifier, VERIFY_FALLS_OFF_END, from);
+    }
+    if (!touch(verifier, from, depth)) {
+        return false;
+    }
+    if (verifier->depths[index] == UNKNOWN_DEPTH) {
+        verifier->depths[index] = depth;
+        array_buf_push(usize)(&verifier->work, index);
+        array_buf_push(usize)(&verifier->visited, index);
+        return true;
+    }
+    if (verifier->depths[index] != depth) {
+        return fail(verifier, VERIFY_STACK_MISMATCH, index);
+    }
+    return true;
+}
+
+// the effect on the stack shared by all the functions that may be called
+// indirectly, `NULL` if some of them are not known yet.
+static bool indirect_callee(
+    Verifier* verifier,
+    usize index,
+    VerifierFunction const** dst
+) {
+    VerifierFunction const* effect = NULL;
+    for (usize f = 0; f < verifier->functions.len; f++) {
+        VerifierFunction const* function = &verifier->functions.data[f];
+        if (!function->address_taken) {
+            continue;
+        }
+        if (!function->known) {
+            *dst = NULL;
+            return true;
+        }
+        if (
+            effect
+            && (
+                effect->returns != function->returns
+                || effect->args != function->args
+                || effect->results != function->results
+            )
+        ) {
+            return fail(verifier, VERIFY_UNKNOWN_CALLEE, index);
+        }
+        effect = function;
+    }
+    if (!effect) {
+        return fail(verifier, VERIFY_UNKNOWN_CALLEE, index);
+    }
+    *dst = effect;
+    return true;
+}
+
+static bool check_var(Verifier* verifier, usize index, usize var) {
+    if (var >= verifier->functions.data[verifier->function].locals) {
+        return fail(verifier, VERIFY_VARIABLE_OUT_OF_RANGE, index);
+    }
+    return true;
+}
+
+static bool check_vars(Verifier* verifier, usize index) {
+    VerifierInstruction const* instruction = &verifier->in.data[index];
+    for (usize i = 0; i < instruction->vars_len; i++) {
+        if (!check_var(verifier, index, instruction->vars[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// follows all the paths of a function to find its stack depths. Calls to
+// functions whose effect on the stack is not known yet are not followed, and
+// set `verifier->blocked`.
+static bool analyze(Verifier* verifier, usize function_index) {
+    for (usize i = 0; i < verifier->visited.len; i++) {
+        verifier->depths[verifier->visited.data[i]] = UNKNOWN_DEPTH;
+    }
+    verifier->visited.len = 0;
+    verifier->work.len = 0;
+    verifier->function = function_index;
+    verifier->min_depth = 0;
+    verifier->max_depth = 0;
+    verifier->has_ret = false;
+    verifier->ret_depth = 0;
+    verifier->blocked = false;
+
+    VerifierInstruction const* in = verifier->in.data;
+    VerifierFunction* function = &verifier->functions.data[function_index];
+    usize entry = function->entry;
+    function->locals = (in[entry].opcode == OP_RES) ? in[entry].imb : 0;
+    if (!visit(verifier, entry, entry, 0)) {
+        return false;
+    }
+
+    #define VISIT(index, depth)                                                 \
+        if (!visit(verifier, i, (index), (depth))) {                            \
+            return false;                                                       \
+        }
+    #define TOUCH(depth)                                                        \
+        if (!touch(verifier, i, (depth))) {                                     \
+            return false;                                                       \
+        }
+
+    while (verifier->work.len > 0) {
+        usize i = array_buf_pop(usize)(&verifier->work);
+        i64 d = verifier->depths[i];
+        VerifierInstruction const* instruction = &in[i];
+        if (!check_vars(verifier, i)) {
+            return false;
+        }
+
+        switch (instruction->opcode) {
+        case OP_NOP:
+            VISIT(i + 1, d);
+            break;
+
+        case OP_RES:
+            if (i != entry) {
+                return fail(verifier, VERIFY_MISPLACED_RES, i);
+            }
+            VISIT(i + 1, d);
+            break;
+
+        case OP_RET:
+            if (verifier->has_ret && verifier->ret_depth != d) {
+                return fail(verifier, VERIFY_STACK_MISMATCH, i);
+            }
+            verifier->has_ret = true;
+            verifier->ret_depth = d;
+            verifier->ret_index = i;
+            break;
+
+        case OP_CAL: {
+            TOUCH(d - 1);
+            usize callee_index = NONE;
+            VerifierFunction const* callee;
+            if (i > 0 && in[i - 1].opcode == OP_LOC && !verifier->is_target[i]) {
+                callee_index = verifier->function_of_entry[in[i - 1].target];
+                callee = &verifier->functions.data[callee_index];
+                if (!callee->known) {
+                    callee = NULL;
+                }
+            } else if (!indirect_callee(verifier, i, &callee)) {
+                return false;
+            }
+            if (!callee) {
+                verifier->blocked = true;
+                break;
+            }
+            if (verifier->record_calls) {
+                array_buf_push(VerifierCall)(
+                    &verifier->calls,
+                    (VerifierCall){ .depth = d - 1, .callee = callee_index }
+                );
+            }
+            TOUCH(d - 1 - callee->args);
+            if (callee->returns) {
+                VISIT(i + 1, d - 1 - callee->args + callee->results);
+            }
+            break;
+        }
+
+        case OP_SCA:
+        case OP_LOC:
+        case OP_VAR:
+            VISIT(i + 1, d + 1);
+            break;
+
+        case OP_SET:
+        case OP_POP:
+            VISIT(i + 1, d - 1);
+            break;
+
+        case OP_JMP:
+            VISIT(instruction->target, d);
+            break;
+
+        case OP_JNZ:
+            // `sca n; jnz` only ever takes one branch, so the other one need
+            // not agree on the depth.
+            if (
+                i > 0
+                && in[i - 1].opcode == OP_SCA
+                && !verifier->is_target[i]
+                && verifier->function_of_entry[i] == NONE
+            ) {
+                usize next = in[i - 1].imw.as_uint ? instruction->target : i + 1;
+                VISIT(next, d - 1);
+                break;
+            }
+            VISIT(instruction->target, d - 1);
+            VISIT(i + 1, d - 1);
+            break;
+
+        case OP_EQU:
+        case OP_NEU:
+        case OP_GEU:
+        case OP_GTU:
+        case OP_ADU:
+            TOUCH(d - 2);
+            VISIT(i + 1, d - 1);
+            break;
+
+        case OP_ADI:
+            TOUCH(d - 1);
+            VISIT(i + 1, d);
+            break;
+
+        case OP_ADL:
+        case OP_INC:
+            VISIT(i + 1, d);
+            break;
+
+        case OP_JEQ:
+        case OP_JNE:
+        case OP_JGE:
+        case OP_JGT:
+            VISIT(instruction->target, d);
+            VISIT(i + 1, d);
+            break;
+
+        case OP_SYS:
+            switch (instruction->syscall) {
+            case SYS_EXIT:
+                TOUCH(d - 1);
+                break;
+            default:
+                VISIT(i + 1, d);
+                break;
+            }
+            break;
+
+        default:
+            return fail(verifier, VERIFY_INVALID_OPCODE, i);
+        }
+    }
+    #undef VISIT
+    #undef TOUCH
+
+    return true;
+}
+
+static void map_stack(Verifier* verifier, usize function_index) {
+    BytecodeStackMap* stack_map = verifier->stack_map;
+    for (usize i = 0; i < verifier->visited.len; i++) {
+        usize index = verifier->visited.data[i];
+        usize offset = verifier->in.data[index].offset;
+        stack_map->functions[offset] =
+            (stack_map->functions[offset] == BYTECODE_UNREACHABLE)
+                ? function_index
+                : BYTECODE_SHARED;
+        stack_map->depths[offset] = verifier->depths[index];
+    }
+}
+
+static void set_effect(Verifier* verifier, usize function_index) {
+    VerifierFunction* function = &verifier->functions.data[function_index];
+    function->known = true;
+    function->returns = verifier->has_ret;
+    function->args = -verifier->min_depth;
+    function->results = verifier->has_ret ? verifier->ret_depth + function->args : 0;
+}
+
+// computes how each function changes the stack of its caller. The effect of
+// recursive functions is first guessed from the paths that do not recurse,
+// then checked once all effects are known.
+static bool analyze_functions(Verifier* verifier) {
+    while (true) {
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (usize f = 0; f < verifier->functions.len; f++) {
+                if (verifier->functions.data[f].known) {
+                    continue;
+                }
+                if (!analyze(verifier, f)) {
+                    return false;
+                }
+                if (verifier->blocked && !verifier->has_ret) {
+                    continue;
+                }
+                set_effect(verifier, f);
+                progress = true;
+            }
+        }
+
+        // the functions left only call each other before they could return,
+        // so one of them never does.
+        usize unknown = NONE;
+        for (usize f = 0; f < verifier->functions.len && unknown == NONE; f++) {
+            if (!verifier->functions.data[f].known) {
+                unknown = f;
+            }
+        }
+        if (unknown == NONE) {
+            break;
+        }
+        if (!analyze(verifier, unknown)) {
+            return false;
+        }
+        set_effect(verifier, unknown);
+    }
+
+    verifier->record_calls = true;
+    for (usize f = 0; f < verifier->functions.len; f++) {
+        VerifierFunction* function = &verifier->functions.data[f];
+        function->calls_start = verifier->calls.len;
+        if (!analyze(verifier, f)) {
+            return false;
+        }
+        function = &verifier->functions.data[f];
+        if (f == 0 && verifier->has_ret) {
+            return fail(verifier, VERIFY_ENTRY_RETURNS, verifier->ret_index);
+        }
+        i64 results = verifier->ret_depth - verifier->min_depth;
+        if (
+            function->returns != verifier->has_ret
+            || function->args != -verifier->min_depth
+            || (function->returns && function->results != results)
+        ) {
+            return fail(verifier, VERIFY_STACK_MISMATCH, function->entry);
+        }
+        function->max_depth = verifier->max_depth;
+        function->calls_len = verifier->calls.len - function->calls_start;
+        if (verifier->stack_map) {
+            map_stack(verifier, f);
+        }
+    }
+    return true;
+}
+
+static bool compute_bounds(Verifier* verifier, usize function_index);
+
+static bool bound_call(
+    Verifier* verifier,
+    VerifierCall call,
+    usize callee_index,
+    i64* max_stack,
+    usize* max_locals,
+    usize* max_calls
+) {
+    if (!compute_bounds(verifier, callee_index)) {
+        return false;
+    }
+    VerifierFunction const* callee = &verifier->functions.data[callee_index];
+    i64 stack = call.depth + (i64)callee->max_stack;
+    if (stack > *max_stack) {
+        *max_stack = stack;
+    }
+    if (callee->max_locals > *max_locals) {
+        *max_locals = callee->max_locals;
+    }
+    if (callee->max_calls + 1 > *max_calls) {
+        *max_calls = callee->max_calls + 1;
+    }
+    return true;
+}
+
+// the bounds of the stacks while the function runs, including its callees.
+// Functions that may call themselves have none.
+static bool compute_bounds(Verifier* verifier, usize function_index) {
+    VerifierFunction* function = &verifier->functions.data[function_index];
+    switch (function->bounds) {
+    case BOUNDS_KNOWN:
+        return function->max_stack != BYTECODE_UNBOUNDED;
+    case BOUNDS_VISITING:
+        return false;
+    default:
+        break;
+    }
+    function->bounds = BOUNDS_VISITING;
+
+    bool bounded = true;
+    i64 max_stack = function->max_depth;
+    usize max_locals = 0;
+    usize max_calls = 0;
+    usize calls_end = function->calls_start + function->calls_len;
+    for (usize c = function->calls_start; c < calls_end; c++) {
+        VerifierCall call = verifier->calls.data[c];
+        if (call.callee != NONE) {
+            bounded &= bound_call(verifier, call, call.callee, &max_stack, &max_locals, &max_calls);
+            continue;
+        }
+        for (usize f = 0; f < verifier->functions.len; f++) {
+            if (verifier->functions.data[f].address_taken) {
+                bounded &= bound_call(verifier, call, f, &max_stack, &max_locals, &max_calls);
+            }
+        }
+    }
+
+    function = &verifier->functions.data[function_index];
+    function->bounds = BOUNDS_KNOWN;
+    if (!bounded) {
+        function->max_stack = BYTECODE_UNBOUNDED;
+        function->max_locals = BYTECODE_UNBOUNDED;
+        function->max_calls = BYTECODE_UNBOUNDED;
+        return false;
+    }
+    function->max_stack = max_stack;
+    function->max_locals = function->locals + max_locals;
+    function->max_calls = max_calls;
+    return true;
+}
+
+static Verifier verifier_new(Bytecode bytecode) {
+    return (Verifier){
+        .len = bytecode.instructions.len,
+        .in = array_buf_new(VerifierInstruction)(),
+        .functions = array_buf_new(VerifierFunction)(),
+        .calls = array_buf_new(VerifierCall)(),
+        .work = array_buf_new(usize)(),
+        .visited = array_buf_new(usize)(),
+    };
+}
+
+static void verifier_free(Verifier* verifier) {
+    array_buf_free(VerifierInstruction)(&verifier->in);
+    array_buf_free(VerifierFunction)(&verifier->functions);
+    array_buf_free(VerifierCall)(&verifier->calls);
+    array_buf_free(usize)(&verifier->work);
+    array_buf_free(usize)(&verifier->visited);
+    free_allocation(verifier->function_of_entry);
+    free_allocation(verifier->is_target);
+    free_allocation(verifier->depths);
+}
+
+static BytecodeMetadata metadata_new(Verifier* verifier) {
+    compute_bounds(verifier, 0);
+    VerifierFunction entry = verifier->functions.data[0];
+    BytecodeMetadata metadata = {
+        .functions = array_buf_new(BytecodeFunction)(),
+        .max_stack = entry.max_stack,
+        .max_locals = entry.max_locals,
+        .max_calls = entry.max_calls,
+    };
+    for (usize f = 0; f < verifier->functions.len; f++) {
+        VerifierFunction function = verifier->functions.data[f];
+        array_buf_push(BytecodeFunction)(
+            &metadata.functions,
+            (BytecodeFunction){
+                .offset = verifier->in.data[function.entry].offset,
+                .locals = function.locals,
+                .args = function.args,
+                .results = function.results,
+                .returns = function.returns,
+                .max_depth = function.max_depth,
+            }
+        );
+    }
+    return metadata;
+}
+
+bool bytecode_analyze_stack(
+    Bytecode bytecode,
+    BytecodeMetadata* dst,
+    BytecodeStackMap* stack_map,
+    VerifyError* error
+) {
+    Verifier verifier = verifier_new(bytecode);
+    BytecodeStackMap map = { 0 };
+    if (stack_map) {
+        usize len = bytecode.instructions.len;
+        map = (BytecodeStackMap){
+            .functions = malloc_or_exit((len + 1) * sizeof(usize)),
+            .depths = malloc_or_exit((len + 1) * sizeof(i64)),
+        };
+        for (usize i = 0; i <= len; i++) {
+            map.functions[i] = BYTECODE_UNREACHABLE;
+            map.depths[i] = 0;
+        }
+        verifier.stack_map = &map;
+    }
+    bool ok =
+        check_encoding(&verifier, bytecode)
+        && find_functions(&verifier)
+        && analyze_functions(&verifier);
+    if (ok) {
+        *dst = metadata_new(&verifier);
+        if (stack_map) {
+            *stack_map = map;
+        }
+    } else {
+        *error = verifier.error;
+        bytecode_stack_map_free(&map);
+    }
+    verifier_free(&verifier);
+    return ok;
+}
+
+bool bytecode_analyze(Bytecode bytecode, BytecodeMetadata* dst, VerifyError* error) {
+    return bytecode_analyze_stack(bytecode, dst, NULL, error);
+}
+
+static void report_verify_error(Reporter* reporter, VerifyError error) {
+    report_start(reporter, SEVERITY_ERROR, error.kind);
+    report_format(reporter, "%s", verify_error_messages[error.kind]);
+    report_source_code(reporter, (Range){ error.offset, error.end });
+    report_end(reporter);
+}
+
+bool bytecode_verify_encoding(Bytecode bytecode, Reporter* reporter) {
+    Verifier verifier = verifier_new(bytecode);
+    bool ok = check_encoding(&verifier, bytecode);
+    if (!ok) {
+        report_verify_error(reporter, verifier.error);
+    }
+    verifier_free(&verifier);
+    return ok;
+}
+
+bool bytecode_verify(Bytecode bytecode, Reporter* reporter, BytecodeMetadata* dst) {
+    VerifyError error;
+    if (!bytecode_analyze(bytecode, dst, &error)) {
+        report_verify_error(reporter, error);
+        return false;
+    }
+    return true;
+}
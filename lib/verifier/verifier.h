@@ -0,0 +1,124 @@
+#pragma once
+
+#include "bytecode/bytecode.h"
+#include "collections/array.h"
+#include "diagnostics/report.h"
+
+/// @brief Stands for the bounds of programs that recurse.
+#define BYTECODE_UNBOUNDED ((usize)-1)
+
+/// @brief What the verifier learned about a function of the bytecode.
+///
+/// Functions are the entry point at offset 0 and the targets of `loc`.
+/// Depths are counted in values, relative to the depth of the value stack
+/// when the function is entered.
+typedef struct BytecodeFunction {
+    usize offset;       // of the entry, in bytewords
+    u16 locals;         // reserved by the `res` at the entry, if any
+    u32 args;           // values popped from the caller's stack
+    u32 results;        // values pushed back to the caller's stack
+    bool returns;       // whether any path reaches a `ret`
+    u32 max_depth;      // of the function itself, without its callees
+} BytecodeFunction;
+
+DECL_ARRAY_BUF(BytecodeFunction)
+
+/// @brief The per-function metadata of verified bytecode, and the bounds of
+/// the stacks of the whole program when it does not recurse.
+typedef struct BytecodeMetadata {
+    ArrayBuf(BytecodeFunction) functions;   // the entry point first
+    usize max_stack;        // values on the value stack at once
+    usize max_locals;       // local variables of all the frames at once
+    usize max_calls;        // frames on top of the entry frame at once
+} BytecodeMetadata;
+
+void bytecode_metadata_free(BytecodeMetadata* metadata);
+
+typedef enum VerifyErrorKind {
+    VERIFY_INVALID_OPCODE,
+    VERIFY_INVALID_SYSCALL,
+    VERIFY_TRUNCATED,           // an immediate runs past the end
+    VERIFY_MISALIGNED_IMMEDIATE,
+    VERIFY_INVALID_TARGET,      // a location is not the start of an instruction
+    VERIFY_FALLS_OFF_END,
+    VERIFY_STACK_UNDERFLOW,
+    VERIFY_STACK_MISMATCH,      // paths reach an instruction with different depths
+    VERIFY_VARIABLE_OUT_OF_RANGE,
+    VERIFY_MISPLACED_RES,       // `res` is only allowed at the entry of a function
+    VERIFY_UNKNOWN_CALLEE,      // the effect of an indirect call is not known
+    VERIFY_ENTRY_RETURNS,
+
+    VERIFY_ERRORS_LEN,
+} VerifyErrorKind;
+
+extern char const* const verify_error_messages[VERIFY_ERRORS_LEN];
+
+typedef struct VerifyError {
+    VerifyErrorKind kind;
+    usize offset;   // of the culprit instruction, in bytewords
+    usize end;      // of the culprit instruction, as far as it was decoded
+} VerifyError;
+
+/// @brief Checks that the bytecode is well formed, and computes the stack
+/// usage of each function.
+///
+/// All paths of all functions reachable from the entry point are followed,
+/// so that every instruction runs with a single, statically known stack depth
+/// that never drops below what the function may pop from its caller. A `jnz`
+/// right after a `sca` only follows the branch the constant takes. Indirect
+/// calls are allowed when all the functions whose location is taken have the
+/// same effect on the stack.
+///
+/// @param dst where the metadata is written, only if the bytecode is valid.
+/// @param error where the first problem found is written otherwise.
+bool bytecode_analyze(Bytecode bytecode, BytecodeMetadata* dst, VerifyError* error);
+
+/// @brief Marks offsets of a `BytecodeStackMap` where no reachable
+/// instruction starts.
+#define BYTECODE_UNREACHABLE ((usize)-1)
+
+/// @brief Marks offsets of a `BytecodeStackMap` whose instruction is reached
+/// from several functions.
+#define BYTECODE_SHARED ((usize)-2)
+
+/// @brief Where each instruction of verified bytecode runs, for the passes
+/// that lower it further.
+///
+/// Both arrays are indexed by offset in bytewords, up to the length of the
+/// bytecode included.
+typedef struct BytecodeStackMap {
+    usize* functions;   // indices in `BytecodeMetadata.functions`
+    i64* depths;        // relative to the entry of the function
+} BytecodeStackMap;
+
+void bytecode_stack_map_free(BytecodeStackMap* stack_map);
+
+/// @brief Like `bytecode_analyze`, and also maps the stack depth at each
+/// instruction.
+///
+/// @param stack_map is only written if the bytecode is valid.
+bool bytecode_analyze_stack(
+    Bytecode bytecode,
+    BytecodeMetadata* dst,
+    BytecodeStackMap* stack_map,
+    VerifyError* error
+);
+
+/// @brief Checks that the bytecode decodes: every opcode and syscall exists,
+/// immediates are complete and aligned with zeroed padding, and locations
+/// point to the start of instructions.
+///
+/// Code that passes can be decoded, disassembled or fused safely, but may
+/// still misuse the stack when run.
+///
+/// @param reporter gets the first problem found, with the code of its
+/// `VerifyErrorKind` and the range of the culprit instruction in bytewords.
+bool bytecode_verify_encoding(Bytecode bytecode, Reporter* reporter);
+
+/// @brief Checks everything that `bytecode_analyze` checks, so that the
+/// bytecode can run without runtime checks.
+///
+/// @param reporter gets the first problem found, like with
+/// `bytecode_verify_encoding`.
+/// @param dst where the metadata is written if the bytecode is valid.
+bool bytecode_verify(Bytecode bytecode, Reporter* reporter, BytecodeMetadata* dst);
@@ -6,6 +6,9 @@ typedef enum RuntimeErrorKind {
     RE_INVALID_INSTRUCTION,
     RE_INVALID_SYSCALL,
     RE_INTEGER_OVERFLOW,
+    RE_STACK_OVERFLOW,
+    RE_STACK_UNDERFLOW,
+    RE_MALFORMED_BYTECODE,
 } RuntimeErrorKind;
 
 typedef struct RuntimeReporter {
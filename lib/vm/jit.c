@@ -0,0 +1,386 @@
+#include <string.h>
+
+#include "alloc/alloc.h"
+#include "alloc/buf.h"
+#include "vm/jit.h"
+#include "vm/vm.h"
+
+#ifdef VM_JIT_SUPPORTED
+#include <sys/mman.h>
+#endif
+
+VmJit vm_jit_new(VmProgram program, u32 threshold) {
+    usize len = program.instructions.len;
+    VmJitFunction* functions = malloc_or_exit(len * sizeof(VmJitFunction));
+    memset(functions, 0, len * sizeof(VmJitFunction));
+    return (VmJit){
+        .instructions = program.instructions.data,
+        .len = len,
+        .threshold = threshold,
+        .functions = functions,
+    };
+}
+
+void vm_jit_free(VmJit* jit) {
+#ifdef VM_JIT_SUPPORTED
+    for (usize i = 0; i < jit->len; i++) {
+        VmJitFunction function = jit->functions[i];
+        if (function.code) {
+            munmap((void*)function.code, function.code_size);
+        }
+    }
+#endif
+    free_allocation(jit->functions);
+}
+
+#ifdef VM_JIT_SUPPORTED
+
+// Compiled code keeps the top of the value stack in rsi, the local variables
+// in rdx and the context in rdi, and uses rax and rcx as scratch registers.
+// It calls nothing, so it only needs caller-saved registers.
+
+#define CONTEXT_DISP(field) ((u8)offsetof(VmJitContext, field))
+#define FRAME_DISP(field) ((u8)(offsetof(VmFrame, field) - sizeof(VmFrame)))
+
+#define NO_DEPTH INT64_MIN
+
+typedef struct JitCompiler {
+    VmJit* jit;
+    Buf code;
+    i64* depths;            // relative to the entry, for each instruction
+    u32* native_offsets;    // of each instruction in `code`
+    ArrayBuf(usize) work;
+    ArrayBuf(usize) jump_patches;   // pairs of a rel32 offset and its target
+    usize first;            // visited range
+    usize last;
+    i64 max_depth;
+} JitCompiler;
+
+static void emit_bytes(JitCompiler* compiler, u8 const* bytes, usize len) {
+    buf_extend_or_grow(&compiler->code, bytes, len, 1);
+}
+
+#define EMIT(...)                                                               \
+    emit_bytes(                                                                 \
+        compiler,                                                               \
+        (u8 const[]){ __VA_ARGS__ },                                            \
+        sizeof((u8 const[]){ __VA_ARGS__ })                                     \
+    )
+
+static void emit_u32(JitCompiler* compiler, u32 value) {
+    emit_bytes(compiler, (u8 const*)&value, sizeof(value));
+}
+
+static void emit_u64(JitCompiler* compiler, u64 value) {
+    emit_bytes(compiler, (u8 const*)&value, sizeof(value));
+}
+
+static void emit_jump_target(JitCompiler* compiler, VmInstruction const* target) {
+    array_buf_push(usize)(&compiler->jump_patches, compiler->code.size);
+    array_buf_push(usize)(
+        &compiler->jump_patches,
+        target - compiler->jit->instructions
+    );
+    emit_u32(compiler, 0);
+}
+
+// mov [rsi], rax; add rsi, 8
+static void emit_push_rax(JitCompiler* compiler) {
+    EMIT(0x48, 0x89, 0x06);
+    EMIT(0x48, 0x83, 0xC6, 0x08);
+}
+
+// sub rsi, 8; mov rax, [rsi]
+static void emit_pop_rax(JitCompiler* compiler) {
+    EMIT(0x48, 0x83, 0xEE, 0x08);
+    EMIT(0x48, 0x8B, 0x06);
+}
+
+// writes the top of the stack back and returns `instruction` to the
+// interpreter.
+static void emit_exit(JitCompiler* compiler, VmInstruction const* instruction) {
+    EMIT(0x48, 0x89, 0x77, CONTEXT_DISP(sp));           // mov [rdi + sp], rsi
+    EMIT(0x48, 0xB8);                                   // movabs rax, instruction
+    emit_u64(compiler, (u64)(uptr)instruction);
+    EMIT(0xC3);                                         // ret
+}
+
+// cmp [rsi - 8], rax, with the lower value in memory and the upper one in rax.
+static void emit_compare(JitCompiler* compiler, u8 setcc) {
+    emit_pop_rax(compiler);
+    EMIT(0x48, 0x39, 0x46, 0xF8);                       // cmp [rsi - 8], rax
+    EMIT(0x0F, setcc, 0xC0);                            // setcc al
+    EMIT(0x0F, 0xB6, 0xC0);                             // movzx eax, al
+    EMIT(0x48, 0x89, 0x46, 0xF8);                       // mov [rsi - 8], rax
+}
+
+static bool is_supported(u16 handler_index) {
+    switch (handler_index) {
+    case OP_NOP:
+    case OP_SCA:
+    case OP_VAR:
+    case OP_SET:
+    case OP_POP:
+    case OP_ADU:
+    case OP_EQU:
+    case OP_NEU:
+    case OP_GEU:
+    case OP_GTU:
+    case OP_JNZ:
+    case OP_JMP:
+    case OP_RET:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool visit(JitCompiler* compiler, usize index, i64 depth) {
+    if (index >= compiler->jit->len) {
+        return false;
+    }
+    if (compiler->depths[index] == NO_DEPTH) {
+        compiler->depths[index] = depth;
+        array_buf_push(usize)(&compiler->work, index);
+        if (index < compiler->first) {
+            compiler->first = index;
+        }
+        if (index > compiler->last) {
+            compiler->last = index;
+        }
+        if (depth > compiler->max_depth) {
+            compiler->max_depth = depth;
+        }
+        return true;
+    }
+    return compiler->depths[index] == depth;
+}
+
+// finds the stack depth of each instruction the compiled code runs, which
+// bounds how much it pushes. Unsupported instructions end the paths.
+static bool analyze(JitCompiler* compiler, usize start) {
+    VmInstruction const* instructions = compiler->jit->instructions;
+    if (!visit(compiler, start, 0)) {
+        return false;
+    }
+    while (compiler->work.len > 0) {
+        usize i = array_buf_pop(usize)(&compiler->work);
+        i64 d = compiler->depths[i];
+        VmInstruction const* instruction = &instructions[i];
+        bool ok = true;
+        switch (instruction->handler_index) {
+        case OP_NOP:
+            ok = visit(compiler, i + 1, d);
+            break;
+        case OP_SCA:
+        case OP_VAR:
+            ok = visit(compiler, i + 1, d + 1);
+            break;
+        case OP_SET:
+        case OP_POP:
+        case OP_ADU:
+        case OP_EQU:
+        case OP_NEU:
+        case OP_GEU:
+        case OP_GTU:
+            ok = visit(compiler, i + 1, d - 1);
+            break;
+        case OP_JNZ:
+            ok = visit(compiler, instruction->operands[0].loc - instructions, d - 1)
+                && visit(compiler, i + 1, d - 1);
+            break;
+        case OP_JMP:
+            ok = visit(compiler, instruction->operands[0].loc - instructions, d);
+            break;
+        default:
+            // `ret` and the exits to the interpreter.
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void emit_one(JitCompiler* compiler, VmInstruction const* instruction) {
+    VmOperand const* operands = instruction->operands;
+    switch (instruction->handler_index) {
+    case OP_NOP:
+        break;
+
+    case OP_SCA:
+        EMIT(0x48, 0xB8);                               // movabs rax, imm
+        emit_u64(compiler, operands[0].imw.as_uint);
+        emit_push_rax(compiler);
+        break;
+
+    case OP_VAR:
+        EMIT(0x48, 0x8B, 0x82);                         // mov rax, [rdx + var]
+        emit_u32(compiler, operands[0].var * sizeof(Word));
+        emit_push_rax(compiler);
+        break;
+
+    case OP_SET:
+        emit_pop_rax(compiler);
+        EMIT(0x48, 0x89, 0x82);                         // mov [rdx + var], rax
+        emit_u32(compiler, operands[0].var * sizeof(Word));
+        break;
+
+    case OP_POP:
+        EMIT(0x48, 0x83, 0xEE, 0x08);                   // sub rsi, 8
+        break;
+
+    case OP_ADU:
+        emit_pop_rax(compiler);
+        EMIT(0x48, 0x01, 0x46, 0xF8);                   // add [rsi - 8], rax
+        break;
+
+    // upper <= lower and upper < lower
+    case OP_EQU: emit_compare(compiler, 0x94); break;  // sete
+    case OP_NEU: emit_compare(compiler, 0x95); break;  // setne
+    case OP_GEU: emit_compare(compiler, 0x93); break;  // setae
+    case OP_GTU: emit_compare(compiler, 0x97); break;  // seta
+
+    case OP_JNZ:
+        emit_pop_rax(compiler);
+        EMIT(0x48, 0x85, 0xC0);                         // test rax, rax
+        EMIT(0x0F, 0x85);                               // jnz rel32
+        emit_jump_target(compiler, operands[0].loc);
+        break;
+
+    case OP_JMP:
+        EMIT(0xE9);                                     // jmp rel32
+        emit_jump_target(compiler, operands[0].loc);
+        break;
+
+    case OP_RET:
+        // pops the frame like the interpreter, and returns its return_ip.
+        EMIT(0x48, 0x8B, 0x42, FRAME_DISP(return_ip));  // mov rax, [rdx + return_ip]
+        EMIT(0x48, 0x8D, 0x4A, (u8)-sizeof(VmFrame));   // lea rcx, [rdx - frame]
+        EMIT(0x48, 0x89, 0x4F, CONTEXT_DISP(frames_top));
+        EMIT(0x48, 0x8B, 0x4A, FRAME_DISP(return_local_variables));
+        EMIT(0x48, 0x03, 0x4F, CONTEXT_DISP(frames_data));
+        EMIT(0x48, 0x89, 0x4F, CONTEXT_DISP(locals));
+        EMIT(0x48, 0x89, 0x77, CONTEXT_DISP(sp));       // mov [rdi + sp], rsi
+        EMIT(0xC3);                                     // ret
+        break;
+
+    default:
+        emit_exit(compiler, instruction);
+        break;
+    }
+}
+
+static VmJitCode install(JitCompiler* compiler, usize* size) {
+    // mappings are never both writable and executable.
+    *size = compiler->code.size;
+    void* code = mmap(
+        NULL,
+        *size,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0
+    );
+    if (code == MAP_FAILED) {
+        return NULL;
+    }
+    memcpy(code, compiler->code.data, *size);
+    if (mprotect(code, *size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(code, *size);
+        return NULL;
+    }
+    return (VmJitCode)code;
+}
+
+static bool compile(VmJit* jit, VmJitFunction* function, usize entry) {
+    usize start = entry;
+    if (jit->instructions[entry].handler_index == OP_RES) {
+        function->reserve = jit->instructions[entry].operands[0].imb;
+        start++;
+    }
+    if (!is_supported(jit->instructions[start].handler_index)) {
+        // the compiled code would exit right away.
+        return false;
+    }
+
+    JitCompiler compiler = {
+        .jit = jit,
+        .code = buf_new(256),
+        .depths = malloc_or_exit(jit->len * sizeof(i64)),
+        .native_offsets = malloc_or_exit(jit->len * sizeof(u32)),
+        .work = array_buf_new(usize)(),
+        .jump_patches = array_buf_new(usize)(),
+        .first = jit->len,
+        .last = 0,
+        .max_depth = 0,
+    };
+    for (usize i = 0; i < jit->len; i++) {
+        compiler.depths[i] = NO_DEPTH;
+    }
+
+    bool ok = analyze(&compiler, start);
+    if (ok) {
+        // mov rsi, [rdi + sp]; mov rdx, [rdi + locals]
+        emit_bytes(&compiler, (u8 const[]){ 0x48, 0x8B, 0x77, CONTEXT_DISP(sp) }, 4);
+        emit_bytes(&compiler, (u8 const[]){ 0x48, 0x8B, 0x57, CONTEXT_DISP(locals) }, 4);
+        if (start != compiler.first) {
+            emit_bytes(&compiler, (u8 const[]){ 0xE9 }, 1);
+            array_buf_push(usize)(&compiler.jump_patches, compiler.code.size);
+            array_buf_push(usize)(&compiler.jump_patches, start);
+            emit_u32(&compiler, 0);
+        }
+        // instructions are emitted in order, so fallthroughs need no jumps.
+        for (usize i = compiler.first; i <= compiler.last; i++) {
+            if (compiler.depths[i] == NO_DEPTH) {
+                continue;
+            }
+            compiler.native_offsets[i] = compiler.code.size;
+            emit_one(&compiler, &jit->instructions[i]);
+        }
+        for (usize i = 0; i < compiler.jump_patches.len; i += 2) {
+            usize at = compiler.jump_patches.data[i];
+            usize target = compiler.jump_patches.data[i + 1];
+            i32 rel = (i32)compiler.native_offsets[target] - (i32)(at + 4);
+            memcpy((u8*)compiler.code.data + at, &rel, sizeof(rel));
+        }
+
+        function->max_push = compiler.max_depth;
+        function->code = install(&compiler, &function->code_size);
+        ok = function->code != NULL;
+    }
+
+    buf_free(&compiler.code);
+    free_allocation(compiler.depths);
+    free_allocation(compiler.native_offsets);
+    array_buf_free(usize)(&compiler.work);
+    array_buf_free(usize)(&compiler.jump_patches);
+    return ok;
+}
+
+#undef EMIT
+
+VmJitFunction const* vm_jit_call(VmJit* jit, VmInstruction const* entry) {
+    usize index = entry - jit->instructions;
+    VmJitFunction* function = &jit->functions[index];
+    if (function->code) {
+        return function;
+    }
+    if (function->failed || ++function->calls < jit->threshold) {
+        return NULL;
+    }
+    if (!compile(jit, function, index)) {
+        function->failed = true;
+        return NULL;
+    }
+    return function;
+}
+
+#else
+
+VmJitFunction const* vm_jit_call(VmJit* jit, VmInstruction const* entry) {
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "bytecode/bytecode.h"
+#include "vm/program.h"
+
+// The JIT only emits x86-64 code, and needs `mmap` for executable memory.
+#if defined(__x86_64__) && defined(__GNUC__) && (defined(__linux__) || defined(__APPLE__))
+#define VM_JIT_SUPPORTED
+#endif
+
+/// @brief The machine state shared with compiled code.
+typedef struct VmJitContext {
+    Word* sp;
+    Word* locals;
+    void* frames_data;
+    void* frames_top;
+} VmJitContext;
+
+/// @brief Compiled code of a function.
+///
+/// It runs until it returns from the function, or until it reaches an
+/// instruction it does not support. Either way, it returns the instruction
+/// the interpreter continues with, and leaves the machine state in `context`.
+typedef VmInstruction const* (*VmJitCode)(VmJitContext* context);
+
+typedef struct VmJitFunction {
+    VmJitCode code;     // `NULL` until the function is compiled
+    usize code_size;    // of the executable mapping at `code`, in bytes
+    u32 calls;
+    bool failed;        // whether the function cannot be compiled
+    /// @brief The size of the leading `res`, that the interpreter runs before
+    /// entering the compiled code.
+    u16 reserve;
+    /// @brief How many values the compiled code may push on the value stack.
+    u32 max_push;
+} VmJitFunction;
+
+typedef struct VmJit {
+    VmInstruction const* instructions;
+    usize len;
+    u32 threshold;
+    VmJitFunction* functions;   // indexed by the instruction at their entry
+} VmJit;
+
+/// @brief A JIT for the functions of `program`, compiled once they have been
+/// called `threshold` times.
+VmJit vm_jit_new(VmProgram program, u32 threshold);
+void vm_jit_free(VmJit* jit);
+
+/// @brief Counts a call to the function at `entry`, and compiles it if it is
+/// hot enough.
+///
+/// @return the function if it has compiled code, `NULL` otherwise.
+VmJitFunction const* vm_jit_call(VmJit* jit, VmInstruction const* entry);
@@ -0,0 +1,129 @@
+#include <string.h>
+
+#include "alloc/alloc.h"
+#include "vm/program.h"
+
+IMPL_ARRAY_BUF(VmInstruction)
+
+#define NO_INSTRUCTION ((usize)-1)
+
+static void set_handler(
+    VmInstruction* instruction,
+    u16 handler_index,
+    void const* const* handlers
+) {
+    instruction->handler_index = handler_index;
+    instruction->handler = handlers ? handlers[handler_index] : NULL;
+}
+
+// returns whether the instruction decodes, without reading past `end`.
+static bool decode_one(
+    Byteword const** ip,
+    Byteword const* end,
+    VmInstruction* instruction,
+    void const* const* handlers
+) {
+    BytecodeInstruction decoded;
+    if (bytecode_decode(ip, end, &decoded) != DECODE_OK) {
+        return false;
+    }
+    u16 handler_index = (decoded.opcode == OP_SYS)
+        ? VM_HANDLER_SYS(decoded.syscall)
+        : decoded.opcode;
+    set_handler(instruction, handler_index, handlers);
+    for (usize i = 0; i < decoded.operands_len; i++) {
+        BytecodeOperand operand = decoded.operands[i];
+        switch (decoded.kinds[i]) {
+        case OPERAND_IMB:
+            instruction->operands[i].imb = operand.imb;
+            break;
+        case OPERAND_IMW:
+            instruction->operands[i].imw = operand.imw;
+            break;
+        case OPERAND_LOC:
+            // stored as a raw offset until all instructions are decoded.
+            instruction->operands[i].var = operand.loc;
+            break;
+        case OPERAND_VAR:
+            instruction->operands[i].var = operand.var;
+            break;
+        }
+    }
+    return true;
+}
+
+VmInstruction const* vm_program_at(VmProgram const* program, usize offset) {
+    // the trailing invalid instruction ends the decoded instructions.
+    usize last = program->instructions.len - 1;
+    usize end = program->instructions.data[last].offset;
+    usize index = (offset < end) ? program->_indices[offset] : NO_INSTRUCTION;
+    if (index == NO_INSTRUCTION) {
+        index = last;
+    }
+    return program->instructions.data + index;
+}
+
+#define RESOLVE_ARG_imb(idx)
+#define RESOLVE_ARG_imw(idx)
+#define RESOLVE_ARG_var(idx)
+#define RESOLVE_ARG_loc(idx)                                                    \
+    instruction->operands[idx].loc =                                            \
+        vm_program_at(&program, instruction->operands[idx].var);
+#define RESOLVE_ARG(idx, kind, ...) RESOLVE_ARG_##kind(idx)
+
+VmProgram vm_program_new(Bytecode bytecode, void const* const* handlers) {
+    usize len = bytecode.instructions.len;
+    Byteword const* start = bytecode.instructions.data;
+    Byteword const* end = start + len;
+
+    // maps the offset of each byteword to the index of the instruction that
+    // starts there, if any. It is kept to call the values of `loc`.
+    usize* indices = malloc_or_exit((len + 1) * sizeof(usize));
+    for (usize i = 0; i <= len; i++) {
+        indices[i] = NO_INSTRUCTION;
+    }
+
+    VmProgram program = {
+        .instructions = array_buf_new(VmInstruction)(),
+        ._indices = indices,
+    };
+    Byteword const* ip = start;
+    usize offset = 0;
+    while ((offset = ip - start) < len) {
+        VmInstruction instruction = { .offset = offset };
+        if (!decode_one(&ip, end, &instruction, handlers)) {
+            break;
+        }
+        indices[offset] = program.instructions.len;
+        array_buf_push(VmInstruction)(&program.instructions, instruction);
+    }
+
+    VmInstruction invalid = { .offset = offset };
+    set_handler(&invalid, VM_HANDLER_INVALID, handlers);
+    array_buf_push(VmInstruction)(&program.instructions, invalid);
+
+    for (usize i = 0; i + 1 < program.instructions.len; i++) {
+        VmInstruction* instruction = &program.instructions.data[i];
+        switch (instruction->handler_index) {
+        #define RESOLVE_CASE(code, mnemo, ...)                                  \
+            case code:                                                          \
+                FOR_ALL(RESOLVE_ARG __VA_OPT__(, __VA_ARGS__))                  \
+                break;
+        FOR_OPERATIONS(RESOLVE_CASE)
+
+        #define RESOLVE_SYS_CASE(code, mnemo, ...)                              \
+            case VM_HANDLER_SYS(code):                                          \
+                FOR_ALL(RESOLVE_ARG __VA_OPT__(, __VA_ARGS__))                  \
+                break;
+        FOR_SYSCALLS(RESOLVE_SYS_CASE)
+        }
+    }
+
+    return program;
+}
+
+void vm_program_free(VmProgram* program) {
+    array_buf_free(VmInstruction)(&program->instructions);
+    free_allocation(program->_indices);
+    program->_indices = NULL;
+}
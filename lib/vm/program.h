@@ -0,0 +1,60 @@
+#pragma once
+
+#include "bytecode/bytecode.h"
+#include "collections/array.h"
+
+// Every instruction of a `VmProgram` runs one handler. Handlers are numbered
+// like opcodes, except that each syscall gets its own handler after them, that
+// a handler reports invalid instructions, and that the JIT engine replaces the
+// handler of `cal`.
+#define VM_HANDLER_SYS(syscall) (OPCODES_LEN + (syscall))
+#define VM_HANDLER_INVALID (OPCODES_LEN + SYSCALLS_LEN)
+#define VM_HANDLER_JIT_CAL (VM_HANDLER_INVALID + 1)
+#define VM_HANDLERS_LEN (VM_HANDLER_JIT_CAL + 1)
+
+#define VM_MAX_OPERANDS BYTECODE_MAX_OPERANDS
+
+typedef struct VmInstruction VmInstruction;
+
+typedef union VmOperand {
+    Byteword imb;
+    Word imw;
+    VmInstruction const* loc;
+    usize var;
+} VmOperand;
+
+/// @brief A decoded instruction.
+///
+/// Unlike `Bytecode`, instructions have a fixed width, their immediates are
+/// already widened and their locations point directly to their target.
+struct VmInstruction {
+    /// @brief The address of the handler in the threaded engine, or `NULL`
+    /// when it dispatches with a `switch` on `handler_index`.
+    void const* handler;
+    u16 handler_index;
+    u32 offset; // of the original instruction, in bytewords
+    VmOperand operands[VM_MAX_OPERANDS];
+};
+
+DECL_ARRAY_BUF(VmInstruction)
+
+/// @brief `Bytecode` decoded once at load time.
+///
+/// The last instruction is always invalid, so that running off the end of the
+/// bytecode, jumping to the middle of an instruction or running an unknown
+/// opcode are all reported by the same handler. Decoding stops at the first
+/// instruction that does not decode, which becomes that invalid instruction.
+typedef struct VmProgram {
+    ArrayBuf(VmInstruction) instructions;
+    /// @brief The index of the instruction that starts at each byteword
+    /// offset, up to the end of the decoded instructions included.
+    usize* _indices;
+} VmProgram;
+
+// `handlers` maps handler indices to handler addresses, it may be `NULL`.
+VmProgram vm_program_new(Bytecode bytecode, void const* const* handlers);
+void vm_program_free(VmProgram* program);
+
+/// @brief The instruction that starts at a byteword offset, like the values
+/// that `loc` pushes, or the trailing invalid one if there is none.
+VmInstruction const* vm_program_at(VmProgram const* program, usize offset);
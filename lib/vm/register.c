@@ -0,0 +1,687 @@
+#include <string.h>
+
+#include "alloc/alloc.h"
+#include "vm/register.h"
+
+IMPL_ARRAY_BUF(VmRegInstruction)
+IMPL_ARRAY_BUF(VmRegFunction)
+
+#define NONE ((usize)-1)
+
+// how a value of the stack is currently known during lowering.
+typedef enum StackEntryKind {
+    STACK_ENTRY_SLOT,       // in the register of its stack slot
+    STACK_ENTRY_LOCAL,      // still in a local variable
+    STACK_ENTRY_CONSTANT,   // not computed yet
+} StackEntryKind;
+
+typedef struct StackEntry {
+    StackEntryKind kind;
+    u32 local;
+    Word constant;
+} StackEntry;
+
+typedef struct Lowerer {
+    VmInstruction const* in;
+    usize len;                  // without the trailing invalid instruction
+    void const* const* handlers;
+    BytecodeMetadata const* metadata;
+    BytecodeStackMap const* stack_map;
+
+    usize* function_entries;    // instruction index of each function
+    usize indirect_callee;      // a function called through a value, if any
+    bool* is_target;            // of a jump
+    usize failed_at;            // instruction index
+
+    // emission
+    usize* new_indices;
+    ArrayBuf(VmRegInstruction) out;
+    StackEntry* entries;        // indexed by depth + args
+    BytecodeFunction const* function;
+    i64 depth;
+} Lowerer;
+
+static bool fail(Lowerer* lowerer, usize index) {
+    lowerer->failed_at = index;
+    return false;
+}
+
+static usize target_of(Lowerer* lowerer, VmOperand operand) {
+    return operand.loc - lowerer->in;
+}
+
+// the function of the metadata that runs the instruction at `index`.
+static usize owner_of(Lowerer* lowerer, usize index) {
+    return lowerer->stack_map->functions[lowerer->in[index].offset];
+}
+
+static i64 depth_of(Lowerer* lowerer, usize index) {
+    return lowerer->stack_map->depths[lowerer->in[index].offset];
+}
+
+static usize jump_operand(u16 handler_index) {
+    switch (handler_index) {
+    case OP_JMP:
+    case OP_JNZ:
+        return 0;
+    case OP_JEQ:
+    case OP_JNE:
+    case OP_JGE:
+    case OP_JGT:
+        return 2;
+    default:
+        return NONE;
+    }
+}
+
+// whether the `cal` at `index` calls the function of the `loc` before it, like
+// in `bytecode_analyze`.
+static bool is_direct_call(Lowerer* lowerer, usize index) {
+    return index < lowerer->len
+        && lowerer->in[index].handler_index == OP_CAL
+        && index > 0
+        && lowerer->in[index - 1].handler_index == OP_LOC
+        && !lowerer->is_target[index];
+}
+
+// finds the jump targets and the entry of each function. Every function gets
+// its own frame layout, so code reached from several of them cannot be
+// lowered.
+static bool find_blocks(Lowerer* lowerer) {
+    VmInstruction const* in = lowerer->in;
+    BytecodeMetadata const* metadata = lowerer->metadata;
+    for (usize f = 0; f < metadata->functions.len; f++) {
+        lowerer->function_entries[f] = NONE;
+    }
+
+    for (usize i = 0; i < lowerer->len; i++) {
+        usize owner = owner_of(lowerer, i);
+        if (owner == BYTECODE_SHARED) {
+            return fail(lowerer, i);
+        }
+        if (
+            owner != BYTECODE_UNREACHABLE
+            && in[i].offset == metadata->functions.data[owner].offset
+        ) {
+            lowerer->function_entries[owner] = i;
+        }
+
+        usize operand = jump_operand(in[i].handler_index);
+        if (operand != NONE) {
+            lowerer->is_target[target_of(lowerer, in[i].operands[operand])] = true;
+        }
+    }
+
+    // the verifier checked that all the functions called through a value
+    // have the same effect on the stack.
+    for (usize i = 0; i < lowerer->len; i++) {
+        if (in[i].handler_index == OP_LOC && !is_direct_call(lowerer, i + 1)) {
+            usize entry = target_of(lowerer, in[i].operands[0]);
+            lowerer->indirect_callee = owner_of(lowerer, entry);
+        }
+    }
+    return true;
+}
+
+static VmRegOperand reg(u32 reg) {
+    return (VmRegOperand){ .reg = reg };
+}
+
+static VmRegOperand imw(Word imw) {
+    return (VmRegOperand){ .imw = imw };
+}
+
+static VmRegOperand cnt(u32 cnt) {
+    return (VmRegOperand){ .cnt = cnt };
+}
+
+static VmRegInstruction* emit(
+    Lowerer* lowerer,
+    VmRegOpcode opcode,
+    usize index,
+    VmRegOperand a,
+    VmRegOperand b,
+    VmRegOperand c
+) {
+    VmRegInstruction instruction = {
+        .handler = lowerer->handlers ? lowerer->handlers[opcode] : NULL,
+        .handler_index = opcode,
+        .offset = lowerer->in[index].offset,
+        .operands = { a, b, c },
+    };
+    array_buf_push(VmRegInstruction)(&lowerer->out, instruction);
+    return &lowerer->out.data[lowerer->out.len - 1];
+}
+
+#define NO_OPERAND ((VmRegOperand){ .cnt = 0 })
+#define EMIT(opcode, ...) EMIT_(opcode, __VA_ARGS__, NO_OPERAND, NO_OPERAND, NO_OPERAND)
+#define EMIT_(opcode, a, b, c, ...) emit(lowerer, opcode, i, a, b, c)
+
+static u32 slot(Lowerer* lowerer, i64 depth) {
+    return lowerer->function->locals + lowerer->function->args + depth;
+}
+
+static StackEntry* entry_at(Lowerer* lowerer, i64 depth) {
+    return &lowerer->entries[depth + lowerer->function->args];
+}
+
+static void materialize(Lowerer* lowerer, usize i, i64 depth) {
+    StackEntry* entry = entry_at(lowerer, depth);
+    switch (entry->kind) {
+    case STACK_ENTRY_SLOT:
+        return;
+    case STACK_ENTRY_LOCAL:
+        EMIT(REG_OP_MOV, reg(slot(lowerer, depth)), reg(entry->local));
+        break;
+    case STACK_ENTRY_CONSTANT:
+        EMIT(REG_OP_LDI, reg(slot(lowerer, depth)), imw(entry->constant));
+        break;
+    }
+    entry->kind = STACK_ENTRY_SLOT;
+}
+
+// moves every value of the stack to its slot, as control flow merges assume.
+static void flush(Lowerer* lowerer, usize i) {
+    for (i64 d = -(i64)lowerer->function->args; d < lowerer->depth; d++) {
+        materialize(lowerer, i, d);
+    }
+}
+
+// returns the register holding the value at `depth`.
+static u32 read(Lowerer* lowerer, usize i, i64 depth) {
+    StackEntry* entry = entry_at(lowerer, depth);
+    if (entry->kind == STACK_ENTRY_LOCAL) {
+        return entry->local;
+    }
+    materialize(lowerer, i, depth);
+    return slot(lowerer, depth);
+}
+
+// copies the values of the stack that still refer to a local variable before
+// it is overwritten, returns whether anything was emitted.
+static bool spill_local(Lowerer* lowerer, usize i, u32 local) {
+    bool spilled = false;
+    for (i64 d = -(i64)lowerer->function->args; d < lowerer->depth; d++) {
+        StackEntry* entry = entry_at(lowerer, d);
+        if (entry->kind == STACK_ENTRY_LOCAL && entry->local == local) {
+            materialize(lowerer, i, d);
+            spilled = true;
+        }
+    }
+    return spilled;
+}
+
+static void push_entry(Lowerer* lowerer, StackEntry entry) {
+    *entry_at(lowerer, lowerer->depth++) = entry;
+}
+
+static void reset_entries(Lowerer* lowerer) {
+    for (i64 d = -(i64)lowerer->function->args; d < lowerer->depth; d++) {
+        entry_at(lowerer, d)->kind = STACK_ENTRY_SLOT;
+    }
+}
+
+static VmRegOpcode compare_opcode(u16 handler_index) {
+    switch (handler_index) {
+    case OP_EQU: return REG_OP_EQU;
+    case OP_NEU: return REG_OP_NEU;
+    case OP_GEU: return REG_OP_GEU;
+    default: return REG_OP_GTU;
+    }
+}
+
+static VmRegOpcode jump_opcode(u16 handler_index) {
+    switch (handler_index) {
+    case OP_EQU: case OP_JEQ: return REG_OP_JEQ;
+    case OP_NEU: case OP_JNE: return REG_OP_JNE;
+    case OP_GEU: case OP_JGE: return REG_OP_JGE;
+    default: return REG_OP_JGT;
+    }
+}
+
+static bool writes_first_operand(u16 handler_index) {
+    switch (handler_index) {
+    case REG_OP_MOV:
+    case REG_OP_LDI:
+    case REG_OP_LDF:
+    case REG_OP_ADD:
+    case REG_OP_ADI:
+    case REG_OP_EQU:
+    case REG_OP_NEU:
+    case REG_OP_GEU:
+    case REG_OP_GTU:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// lowers the instruction at `i`, returns whether it falls through to the next
+// one and sets `skip` if the next one was lowered with it.
+static bool lower_one(Lowerer* lowerer, usize i, usize block_start, bool* skip) {
+    VmInstruction const* instruction = &lowerer->in[i];
+    VmOperand const* operands = instruction->operands;
+    i64 d = lowerer->depth;
+    *skip = false;
+
+    switch (instruction->handler_index) {
+    case OP_NOP:
+    case OP_RES:
+        return true;
+
+    case OP_LOC:
+        // the callee of a direct call is not pushed.
+        if (is_direct_call(lowerer, i + 1)) {
+            return true;
+        }
+        EMIT(
+            REG_OP_LDF,
+            reg(slot(lowerer, d)),
+            cnt(owner_of(lowerer, target_of(lowerer, operands[0])))
+        );
+        push_entry(lowerer, (StackEntry){ .kind = STACK_ENTRY_SLOT });
+        return true;
+
+    case OP_SCA:
+        push_entry(lowerer, (StackEntry){
+            .kind = STACK_ENTRY_CONSTANT,
+            .constant = operands[0].imw,
+        });
+        return true;
+
+    case OP_VAR:
+        push_entry(lowerer, (StackEntry){
+            .kind = STACK_ENTRY_LOCAL,
+            .local = operands[0].var,
+        });
+        return true;
+
+    case OP_POP:
+        lowerer->depth--;
+        return true;
+
+    case OP_SET: {
+        u32 local = operands[0].var;
+        lowerer->depth--;
+        StackEntry top = *entry_at(lowerer, d - 1);
+        bool spilled = spill_local(lowerer, i, local);
+        switch (top.kind) {
+        case STACK_ENTRY_CONSTANT:
+            EMIT(REG_OP_LDI, reg(local), imw(top.constant));
+            break;
+        case STACK_ENTRY_LOCAL:
+            if (top.local != local) {
+                EMIT(REG_OP_MOV, reg(local), reg(top.local));
+            }
+            break;
+        case STACK_ENTRY_SLOT:;
+            // the last instruction computed the value: store it directly.
+            VmRegInstruction* last = lowerer->out.len > block_start
+                ? &lowerer->out.data[lowerer->out.len - 1]
+                : NULL;
+            if (
+                !spilled
+                && last
+                && writes_first_operand(last->handler_index)
+                && last->operands[0].reg == slot(lowerer, d - 1)
+            ) {
+                last->operands[0].reg = local;
+            } else {
+                EMIT(REG_OP_MOV, reg(local), reg(slot(lowerer, d - 1)));
+            }
+            break;
+        }
+        return true;
+    }
+
+    case OP_ADU:
+    case OP_ADI: {
+        bool immediate = instruction->handler_index == OP_ADI;
+        i64 lower_depth = immediate ? d - 1 : d - 2;
+        StackEntry lower = *entry_at(lowerer, lower_depth);
+        StackEntry upper = immediate
+            ? (StackEntry){ .kind = STACK_ENTRY_CONSTANT, .constant = operands[0].imw }
+            : *entry_at(lowerer, d - 1);
+        u32 dst = slot(lowerer, lower_depth);
+
+        if (lower.kind == STACK_ENTRY_CONSTANT && upper.kind == STACK_ENTRY_CONSTANT) {
+            lowerer->depth = lower_depth;
+            push_entry(lowerer, (StackEntry){
+                .kind = STACK_ENTRY_CONSTANT,
+                .constant.as_uint = lower.constant.as_uint + upper.constant.as_uint,
+            });
+            return true;
+        }
+        if (upper.kind == STACK_ENTRY_CONSTANT) {
+            u32 src = read(lowerer, i, lower_depth);
+            EMIT(REG_OP_ADI, reg(dst), reg(src), imw(upper.constant));
+        } else if (lower.kind == STACK_ENTRY_CONSTANT) {
+            u32 src = read(lowerer, i, d - 1);
+            EMIT(REG_OP_ADI, reg(dst), reg(src), imw(lower.constant));
+        } else {
+            u32 a = read(lowerer, i, lower_depth);
+            u32 b = read(lowerer, i, d - 1);
+            EMIT(REG_OP_ADD, reg(dst), reg(a), reg(b));
+        }
+        lowerer->depth = lower_depth;
+        push_entry(lowerer, (StackEntry){ .kind = STACK_ENTRY_SLOT });
+        return true;
+    }
+
+    case OP_EQU:
+    case OP_NEU:
+    case OP_GEU:
+    case OP_GTU: {
+        StackEntry lower = *entry_at(lowerer, d - 2);
+        StackEntry upper = *entry_at(lowerer, d - 1);
+        usize next = i + 1;
+        if (
+            upper.kind == STACK_ENTRY_CONSTANT
+            && lower.kind != STACK_ENTRY_CONSTANT
+            && next < lowerer->len
+            && lowerer->in[next].handler_index == OP_JNZ
+            && !lowerer->is_target[next]
+        ) {
+            // `var %a; sca n; geu; jnz :L` is `jge %a n :L`.
+            u32 src = read(lowerer, i, d - 2);
+            lowerer->depth = d - 2;
+            flush(lowerer, i);
+            EMIT(
+                jump_opcode(instruction->handler_index),
+                reg(src),
+                imw(upper.constant),
+                cnt(target_of(lowerer, lowerer->in[next].operands[0]))
+            );
+            reset_entries(lowerer);
+            *skip = true;
+            return true;
+        }
+        u32 a = read(lowerer, i, d - 2);
+        u32 b = read(lowerer, i, d - 1);
+        EMIT(
+            compare_opcode(instruction->handler_index),
+            reg(slot(lowerer, d - 2)),
+            reg(a),
+            reg(b)
+        );
+        lowerer->depth = d - 2;
+        push_entry(lowerer, (StackEntry){ .kind = STACK_ENTRY_SLOT });
+        return true;
+    }
+
+    case OP_ADL: {
+        u32 dst = operands[2].var;
+        spill_local(lowerer, i, dst);
+        EMIT(REG_OP_ADD, reg(dst), reg(operands[0].var), reg(operands[1].var));
+        return true;
+    }
+
+    case OP_INC: {
+        u32 local = operands[0].var;
+        spill_local(lowerer, i, local);
+        EMIT(REG_OP_ADI, reg(local), reg(local), imw(operands[1].imw));
+        return true;
+    }
+
+    case OP_JMP:
+        flush(lowerer, i);
+        EMIT(REG_OP_JMP, cnt(target_of(lowerer, operands[0])));
+        return false;
+
+    case OP_JNZ: {
+        StackEntry top = *entry_at(lowerer, d - 1);
+        u32 src = 0;
+        if (top.kind != STACK_ENTRY_CONSTANT) {
+            src = read(lowerer, i, d - 1);
+        }
+        lowerer->depth = d - 1;
+        flush(lowerer, i);
+        if (top.kind != STACK_ENTRY_CONSTANT) {
+            EMIT(REG_OP_JNZ, reg(src), cnt(target_of(lowerer, operands[0])));
+        } else if (top.constant.as_uint != 0) {
+            EMIT(REG_OP_JMP, cnt(target_of(lowerer, operands[0])));
+            return false;
+        }
+        return true;
+    }
+
+    case OP_JEQ:
+    case OP_JNE:
+    case OP_JGE:
+    case OP_JGT:
+        flush(lowerer, i);
+        EMIT(
+            jump_opcode(instruction->handler_index),
+            reg(operands[0].var),
+            imw(operands[1].imw),
+            cnt(target_of(lowerer, operands[2]))
+        );
+        return true;
+
+    case OP_CAL: {
+        bool direct = is_direct_call(lowerer, i);
+        usize callee_index = lowerer->indirect_callee;
+        if (direct) {
+            usize entry = target_of(lowerer, lowerer->in[i - 1].operands[0]);
+            callee_index = owner_of(lowerer, entry);
+        }
+        BytecodeFunction callee = lowerer->metadata->functions.data[callee_index];
+        // the arguments are below the callee of an indirect call.
+        i64 args_end = direct ? d : d - 1;
+        i64 args_depth = args_end - callee.args;
+        for (i64 depth = args_depth; depth < args_end; depth++) {
+            materialize(lowerer, i, depth);
+        }
+        if (direct) {
+            EMIT(REG_OP_CAL, cnt(callee_index), reg(slot(lowerer, args_depth)));
+        } else {
+            u32 src = read(lowerer, i, d - 1);
+            EMIT(REG_OP_CAI, reg(src), reg(slot(lowerer, args_depth)));
+        }
+        lowerer->depth = args_depth;
+        for (u32 r = 0; r < callee.results; r++) {
+            push_entry(lowerer, (StackEntry){ .kind = STACK_ENTRY_SLOT });
+        }
+        return callee.returns;
+    }
+
+    case OP_RET:
+        flush(lowerer, i);
+        EMIT(
+            REG_OP_RET,
+            reg(slot(lowerer, -(i64)lowerer->function->args)),
+            cnt(d + lowerer->function->args)
+        );
+        return false;
+
+    case VM_HANDLER_SYS(SYS_NOP):
+        EMIT(REG_OP_SYS_NOP, NO_OPERAND);
+        return true;
+
+    case VM_HANDLER_SYS(SYS_HI):
+        EMIT(REG_OP_SYS_HI, NO_OPERAND);
+        return true;
+
+    case VM_HANDLER_SYS(SYS_BYE):
+        EMIT(REG_OP_SYS_BYE, NO_OPERAND);
+        return true;
+
+    case VM_HANDLER_SYS(SYS_DBG):
+        EMIT(REG_OP_SYS_DBG, reg(operands[0].var));
+        return true;
+
+    case VM_HANDLER_SYS(SYS_EXIT): {
+        u32 src = read(lowerer, i, d - 1);
+        lowerer->depth = d - 1;
+        EMIT(REG_OP_SYS_EXIT, reg(src));
+        return false;
+    }
+
+    default:
+        // rejected by the verifier
+        return false;
+    }
+}
+
+static void lower(Lowerer* lowerer) {
+    BytecodeMetadata const* metadata = lowerer->metadata;
+    i64 max_entries = 0;
+    for (usize f = 0; f < metadata->functions.len; f++) {
+        BytecodeFunction function = metadata->functions.data[f];
+        if ((i64)function.args + function.max_depth > max_entries) {
+            max_entries = (i64)function.args + function.max_depth;
+        }
+    }
+    lowerer->entries = malloc_or_exit((max_entries + 1) * sizeof(StackEntry));
+
+    bool falls_through = false;
+    usize block_start = 0;
+    for (usize i = 0; i < lowerer->len; i++) {
+        usize owner = owner_of(lowerer, i);
+        if (owner == BYTECODE_UNREACHABLE) {
+            falls_through = false;
+            continue;
+        }
+        bool starts_block = !falls_through
+            || lowerer->is_target[i]
+            || lowerer->function_entries[owner] == i;
+        if (starts_block) {
+            if (falls_through) {
+                flush(lowerer, i);
+            }
+            lowerer->function = &metadata->functions.data[owner];
+            lowerer->depth = depth_of(lowerer, i);
+            reset_entries(lowerer);
+            block_start = lowerer->out.len;
+        }
+        lowerer->new_indices[i] = lowerer->out.len;
+
+        bool skip;
+        falls_through = lower_one(lowerer, i, block_start, &skip);
+        if (skip) {
+            // the next instruction is never jumped to.
+            i++;
+        }
+    }
+
+    free_allocation(lowerer->entries);
+}
+
+static void resolve(Lowerer* lowerer, VmRegProgram* program) {
+    BytecodeMetadata const* metadata = lowerer->metadata;
+    for (usize f = 0; f < metadata->functions.len; f++) {
+        BytecodeFunction function = metadata->functions.data[f];
+        usize entry = lowerer->function_entries[f];
+        array_buf_push(VmRegFunction)(&program->functions, (VmRegFunction){
+            .entry = lowerer->out.data + lowerer->new_indices[entry],
+            .offset = function.offset,
+            .locals = function.locals,
+            .args = function.args,
+            .frame_size = function.locals + function.args + function.max_depth,
+        });
+    }
+
+    for (usize i = 0; i < lowerer->out.len; i++) {
+        VmRegInstruction* instruction = &lowerer->out.data[i];
+        VmRegOperand* operands = instruction->operands;
+        switch (instruction->handler_index) {
+        case REG_OP_JMP:
+            operands[0].loc = lowerer->out.data + lowerer->new_indices[operands[0].cnt];
+            break;
+        case REG_OP_JNZ:
+            operands[1].loc = lowerer->out.data + lowerer->new_indices[operands[1].cnt];
+            break;
+        case REG_OP_JEQ:
+        case REG_OP_JNE:
+        case REG_OP_JGE:
+        case REG_OP_JGT:
+            operands[2].loc = lowerer->out.data + lowerer->new_indices[operands[2].cnt];
+            break;
+        case REG_OP_CAL:
+            operands[0].fun = program->functions.data + operands[0].cnt;
+            break;
+        case REG_OP_LDF:
+            operands[1].fun = program->functions.data + operands[1].cnt;
+            break;
+        }
+    }
+    program->instructions = lowerer->out;
+}
+
+VmRegProgram vm_reg_program_new(
+    VmProgram program,
+    BytecodeMetadata const* metadata,
+    BytecodeStackMap const* stack_map,
+    void const* const* handlers
+) {
+    // the decoded program always ends with an invalid instruction.
+    usize len = program.instructions.len - 1;
+    Lowerer lowerer = {
+        .in = program.instructions.data,
+        .len = len,
+        .handlers = handlers,
+        .metadata = metadata,
+        .stack_map = stack_map,
+        .function_entries = malloc_or_exit(metadata->functions.len * sizeof(usize)),
+        .is_target = malloc_or_exit((len + 1) * sizeof(bool)),
+        .indirect_callee = NONE,
+        .failed_at = len,
+        .new_indices = malloc_or_exit((len + 1) * sizeof(usize)),
+        .out = array_buf_new(VmRegInstruction)(),
+    };
+    for (usize i = 0; i <= len; i++) {
+        lowerer.is_target[i] = false;
+        lowerer.new_indices[i] = NONE;
+    }
+
+    VmRegProgram lowered = {
+        .instructions = array_buf_new(VmRegInstruction)(),
+        .functions = array_buf_new(VmRegFunction)(),
+    };
+    if (find_blocks(&lowerer)) {
+        lower(&lowerer);
+        resolve(&lowerer, &lowered);
+    } else {
+        usize i = lowerer.failed_at;
+        VmRegInstruction* invalid = emit(
+            &lowerer, REG_OP_INVALID, i, NO_OPERAND, NO_OPERAND, NO_OPERAND
+        );
+        array_buf_push(VmRegFunction)(&lowered.functions, (VmRegFunction){
+            .entry = invalid,
+        });
+        lowered.instructions = lowerer.out;
+    }
+
+    // the trailing invalid instruction is at the end of the bytecode.
+    lowered._len = program.instructions.data[len].offset;
+    lowered._function_indices =
+        malloc_or_exit((lowered._len + 1) * sizeof(usize));
+    for (usize i = 0; i <= lowered._len; i++) {
+        lowered._function_indices[i] = NONE;
+    }
+    for (usize f = 0; f < lowered.functions.len; f++) {
+        lowered._function_indices[lowered.functions.data[f].offset] = f;
+    }
+
+    free_allocation(lowerer.function_entries);
+    free_allocation(lowerer.is_target);
+    free_allocation(lowerer.new_indices);
+    return lowered;
+}
+
+void vm_reg_program_free(VmRegProgram* program) {
+    array_buf_free(VmRegInstruction)(&program->instructions);
+    array_buf_free(VmRegFunction)(&program->functions);
+    free_allocation(program->_function_indices);
+    program->_function_indices = NULL;
+}
+
+VmRegFunction const* vm_reg_program_function_at(
+    VmRegProgram const* program,
+    usize offset
+) {
+    usize index = offset <= program->_len
+        ? program->_function_indices[offset]
+        : NONE;
+    return index == NONE ? NULL : program->functions.data + index;
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "bytecode/bytecode.h"
+#include "collections/array.h"
+#include "verifier/verifier.h"
+#include "vm/program.h"
+
+// Operand kinds of register instructions:
+// - reg: a register of the current frame, as a `u32` index. Registers start
+//   with the local variables, so `%n` is register `n`.
+// - imw: a word immediate.
+// - loc: the instruction to jump to.
+// - fun: the function to call.
+// - cnt: a `u32` count.
+#define FOR_REGISTER_OPERATIONS(proc)               \
+    proc(REG_OP_MOV, mov, reg, reg)                 \
+    proc(REG_OP_LDI, ldi, reg, imw)                 \
+    proc(REG_OP_LDF, ldf, reg, fun)                 \
+    proc(REG_OP_ADD, add, reg, reg, reg)            \
+    proc(REG_OP_ADI, adi, reg, reg, imw)            \
+    proc(REG_OP_EQU, equ, reg, reg, reg)            \
+    proc(REG_OP_NEU, neu, reg, reg, reg)            \
+    proc(REG_OP_GEU, geu, reg, reg, reg)            \
+    proc(REG_OP_GTU, gtu, reg, reg, reg)            \
+    proc(REG_OP_JMP, jmp, loc)                      \
+    proc(REG_OP_JNZ, jnz, reg, loc)                 \
+    proc(REG_OP_JEQ, jeq, reg, imw, loc)            \
+    proc(REG_OP_JNE, jne, reg, imw, loc)            \
+    proc(REG_OP_JGE, jge, reg, imw, loc)            \
+    proc(REG_OP_JGT, jgt, reg, imw, loc)            \
+    proc(REG_OP_CAL, cal, fun, reg)                 \
+    proc(REG_OP_CAI, cai, reg, reg)                 \
+    proc(REG_OP_RET, ret, reg, cnt)                 \
+    proc(REG_OP_SYS_NOP, sys_nop)                   \
+    proc(REG_OP_SYS_EXIT, sys_exit, reg)            \
+    proc(REG_OP_SYS_HI, sys_hi)                     \
+    proc(REG_OP_SYS_BYE, sys_bye)                   \
+    proc(REG_OP_SYS_DBG, sys_dbg, reg)              \
+    proc(REG_OP_INVALID, invalid)                   \
+
+typedef enum VmRegOpcode {
+    /// @brief `mov %dst %src`
+    ///
+    /// Copies the register %src to %dst.
+    REG_OP_MOV,
+
+    /// @brief `ldi %dst n`
+    ///
+    /// Loads the immediate n into %dst.
+    REG_OP_LDI,
+
+    /// @brief `ldf %dst fun`
+    ///
+    /// Loads the offset of the function in the bytecode into %dst, like `loc`
+    /// pushes it, to call it with `cai`.
+    REG_OP_LDF,
+
+    /// @brief `add %dst %a %b`
+    ///
+    /// Stores %a + %b in %dst.
+    REG_OP_ADD,
+
+    /// @brief `adi %dst %a n`
+    ///
+    /// Stores %a + n in %dst.
+    REG_OP_ADI,
+
+    /// @brief `equ %dst %a %b`
+    ///
+    /// Stores 1 in %dst if %a == %b, 0 otherwise.
+    REG_OP_EQU,
+
+    /// @brief `neu %dst %a %b`
+    ///
+    /// Stores 1 in %dst if %a != %b, 0 otherwise.
+    REG_OP_NEU,
+
+    /// @brief `geu %dst %a %b`
+    ///
+    /// Stores 1 in %dst if %a >= %b, 0 otherwise.
+    REG_OP_GEU,
+
+    /// @brief `gtu %dst %a %b`
+    ///
+    /// Stores 1 in %dst if %a > %b, 0 otherwise.
+    REG_OP_GTU,
+
+    /// @brief `jmp :loc`
+    REG_OP_JMP,
+
+    /// @brief `jnz %a :loc`
+    ///
+    /// Jumps if %a is not zero.
+    REG_OP_JNZ,
+
+    /// @brief `jeq %a n :loc`
+    REG_OP_JEQ,
+
+    /// @brief `jne %a n :loc`
+    REG_OP_JNE,
+
+    /// @brief `jge %a n :loc`
+    REG_OP_JGE,
+
+    /// @brief `jgt %a n :loc`
+    REG_OP_JGT,
+
+    /// @brief `cal fun %args`
+    ///
+    /// Pushes a frame for the function, zeroes its local variables and copies
+    /// its arguments from the registers starting at %args. When the function
+    /// returns, its results are copied back to the registers starting at
+    /// %args.
+    REG_OP_CAL,
+
+    /// @brief `cai %fun %args`
+    ///
+    /// Like `cal`, with the function loaded in %fun by `ldf`.
+    REG_OP_CAI,
+
+    /// @brief `ret %results count`
+    ///
+    /// Pops the frame and returns the count registers starting at %results.
+    REG_OP_RET,
+
+    /// @brief `sys_nop`
+    REG_OP_SYS_NOP,
+
+    /// @brief `sys_exit %code`
+    REG_OP_SYS_EXIT,
+
+    /// @brief `sys_hi`
+    REG_OP_SYS_HI,
+
+    /// @brief `sys_bye`
+    REG_OP_SYS_BYE,
+
+    /// @brief `sys_dbg %var`
+    REG_OP_SYS_DBG,
+
+    /// @brief Reports that the bytecode could not be lowered.
+    REG_OP_INVALID,
+
+    REG_OPCODES_LEN,
+} VmRegOpcode;
+
+typedef struct VmRegInstruction VmRegInstruction;
+typedef struct VmRegFunction VmRegFunction;
+
+typedef union VmRegOperand {
+    u32 reg;
+    u32 cnt;
+    Word imw;
+    VmRegInstruction const* loc;
+    VmRegFunction const* fun;
+} VmRegOperand;
+
+/// @brief A three-address instruction of the register engine.
+///
+/// Like `VmInstruction`, it has a fixed width and holds the handler it runs.
+struct VmRegInstruction {
+    void const* handler;
+    u16 handler_index;
+    u32 offset; // of the first lowered bytecode instruction, in bytewords
+    VmRegOperand operands[VM_MAX_OPERANDS];
+};
+
+/// @brief The frame layout of a lowered function.
+///
+/// Registers are the local variables, then the arguments, then the value
+/// stack slots of the function.
+struct VmRegFunction {
+    VmRegInstruction const* entry;
+    u32 offset; // of the entry in the bytecode, in bytewords
+    u32 locals;
+    u32 args;
+    u32 frame_size; // in registers
+};
+
+DECL_ARRAY_BUF(VmRegInstruction)
+DECL_ARRAY_BUF(VmRegFunction)
+
+/// @brief Bytecode lowered to register instructions.
+///
+/// The first function is the entry point at offset 0. If the bytecode cannot
+/// be lowered, the program is a single invalid instruction at the offset of
+/// the culprit, run in a frame without registers.
+typedef struct VmRegProgram {
+    ArrayBuf(VmRegInstruction) instructions;
+    ArrayBuf(VmRegFunction) functions;
+    /// @brief The index of the function that starts at each byteword offset,
+    /// up to the end of the bytecode included.
+    usize* _function_indices;
+    usize _len;     // of the bytecode, in bytewords
+} VmRegProgram;
+
+/// @brief Lowers a decoded stack program to register instructions.
+///
+/// Every stack slot gets a register, at the depth the verifier found for each
+/// instruction. Functions get their own frame layout, so the bytecode can only
+/// be lowered if no instruction is reached from several functions.
+///
+/// @param metadata and @param stack_map come from `bytecode_analyze_stack` on
+/// the bytecode the program was decoded from.
+/// @param handlers maps opcodes to handler addresses, it may be `NULL`.
+VmRegProgram vm_reg_program_new(
+    VmProgram program,
+    BytecodeMetadata const* metadata,
+    BytecodeStackMap const* stack_map,
+    void const* const* handlers
+);
+void vm_reg_program_free(VmRegProgram* program);
+
+/// @brief The function whose entry is at a byteword offset, like the values
+/// that `ldf` loads, or `NULL` if there is none.
+VmRegFunction const* vm_reg_program_function_at(
+    VmRegProgram const* program,
+    usize offset
+);
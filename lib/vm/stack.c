@@ -0,0 +1,122 @@
+#include "vm/stack.h"
+
+#ifdef COUGH_VM_GUARDED_STACKS
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "diagnostics/errno.h"
+
+static usize round_to_pages(usize size) {
+    usize page = (usize)sysconf(_SC_PAGESIZE);
+    usize pages = (size + page - 1) / page;
+    return (pages ? pages : 1) * page;
+}
+
+void* vm_stack_map(
+    usize size,
+    usize guard_below,
+    usize guard_above,
+    VmStackMapping* mapping
+) {
+    size = round_to_pages(size);
+    guard_below = round_to_pages(guard_below);
+    guard_above = round_to_pages(guard_above);
+    usize total = guard_below + size + guard_above;
+
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    // only the usable memory is ever touched, so the whole reservation costs
+    // address space but no memory.
+    errno = 0;
+    void* base = mmap(NULL, total, PROT_NONE, flags, -1, 0);
+    if (base == MAP_FAILED) {
+        exit_on_errno_or(errno, "stack reservation failed");
+    }
+    void* data = (char*)base + guard_below;
+    if (mprotect(data, size, PROT_READ | PROT_WRITE) != 0) {
+        exit_on_errno_or(errno, "stack reservation failed");
+    }
+    *mapping = (VmStackMapping){
+        .base = base,
+        .size = total,
+        .guard_below = guard_below,
+        .guard_above = guard_above,
+    };
+    return data;
+}
+
+void vm_stack_unmap(VmStackMapping mapping) {
+    if (mapping.base) {
+        munmap(mapping.base, mapping.size);
+    }
+}
+
+VmStackFault vm_stack_fault(VmStackMapping mapping, void const* address) {
+    char const* base = mapping.base;
+    char const* at = address;
+    if (at < base || at >= base + mapping.size) {
+        return VM_STACK_NO_FAULT;
+    }
+    if (at < base + mapping.guard_below) {
+        return VM_STACK_UNDERFLOW;
+    }
+    if (at >= base + mapping.size - mapping.guard_above) {
+        return VM_STACK_OVERFLOW;
+    }
+    return VM_STACK_NO_FAULT;
+}
+
+static _Thread_local VmStackGuard* current_guard;
+
+// the handlers that were installed before ours, which get the faults that do
+// not hit a guard region.
+static struct sigaction previous_segv_action;
+static struct sigaction previous_bus_action;
+static volatile sig_atomic_t handler_installed;
+
+static void handle_fault(int signal, siginfo_t* info, void* context) {
+    VmStackGuard* guard = current_guard;
+    for (usize i = 0; guard && i < guard->len; i++) {
+        if (vm_stack_fault(guard->mappings[i], info->si_addr) != VM_STACK_NO_FAULT) {
+            guard->fault_address = info->si_addr;
+            siglongjmp(guard->resume, 1);
+        }
+    }
+    // restores the previous handler, that runs when the faulting instruction
+    // is retried.
+    handler_installed = 0;
+    sigaction(SIGSEGV, &previous_segv_action, NULL);
+    sigaction(SIGBUS, &previous_bus_action, NULL);
+}
+
+static void install_handler(void) {
+    if (handler_installed) {
+        return;
+    }
+    struct sigaction action = {
+        .sa_sigaction = handle_fault,
+        .sa_flags = SA_SIGINFO,
+    };
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &previous_segv_action);
+    // some systems report accesses to `PROT_NONE` pages as bus errors.
+    sigaction(SIGBUS, &action, &previous_bus_action);
+    handler_installed = 1;
+}
+
+void vm_stack_guard_enter(VmStackGuard* guard) {
+    install_handler();
+    guard->fault_address = NULL;
+    guard->previous = current_guard;
+    current_guard = guard;
+}
+
+void vm_stack_guard_leave(VmStackGuard* guard) {
+    current_guard = guard->previous;
+}
+
+#endif
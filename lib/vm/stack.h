@@ -0,0 +1,64 @@
+#pragma once
+
+#include <setjmp.h>
+
+#include "primitives/primitives.h"
+
+// Guarded stacks need `mmap` and signals, the build only enables them where
+// both exist.
+#ifdef COUGH_VM_GUARDED_STACKS
+
+/// @brief A stack reserved up front, between two inaccessible guard regions.
+///
+/// The VM does not check the bounds of guarded stacks: running past either end
+/// touches a guard region, which faults, and `vm_stack_guard_enter` turns the
+/// fault into a jump back to the VM.
+typedef struct VmStackMapping {
+    void* base;         // of the mapping, that starts with the lower guard
+    usize size;         // of the mapping, in bytes
+    usize guard_below;  // in bytes
+    usize guard_above;  // in bytes
+} VmStackMapping;
+
+/// @brief Maps a stack of at least `size` usable bytes.
+///
+/// The guards are rounded up to whole pages, so that `guard_above` must be at
+/// least the largest distance the VM can move past the top of the stack
+/// without touching the memory in between.
+///
+/// @return the start of the usable memory, which is zeroed.
+void* vm_stack_map(
+    usize size,
+    usize guard_below,
+    usize guard_above,
+    VmStackMapping* mapping
+);
+void vm_stack_unmap(VmStackMapping mapping);
+
+typedef enum VmStackFault {
+    VM_STACK_NO_FAULT,
+    VM_STACK_UNDERFLOW,
+    VM_STACK_OVERFLOW,
+} VmStackFault;
+
+/// @brief Where `address` falls relative to the usable memory of `mapping`.
+VmStackFault vm_stack_fault(VmStackMapping mapping, void const* address);
+
+/// @brief The stacks of a running VM, and where to resume if they fault.
+typedef struct VmStackGuard {
+    sigjmp_buf resume;
+    VmStackMapping const* mappings;
+    usize len;
+    void const* fault_address;  // set before jumping to `resume`
+    struct VmStackGuard* previous;
+} VmStackGuard;
+
+/// @brief Makes faults in the guard regions of `guard->mappings` jump to
+/// `guard->resume` on this thread, until `vm_stack_guard_leave`.
+///
+/// Guards nest, so that a VM may run from a syscall of another VM. Faults
+/// anywhere else are left to the handler that was installed before.
+void vm_stack_guard_enter(VmStackGuard* guard);
+void vm_stack_guard_leave(VmStackGuard* guard);
+
+#endif
@@ -4,49 +4,195 @@
 #include <string.h>
 
 #include "alloc/alloc.h"
+#include "alloc/tracking.h"
 #include "vm/vm.h"
 #include "vm/diagnostics.h"
 
+static void run_threaded(Vm* vm, void const* const** handlers);
+static void run_register(Vm* vm, void const* const** handlers);
+static void* frames_alloc(Vm* vm, usize size);
+
+char const* const vm_engine_names[VM_ENGINES_LEN] = {
+    [VM_ENGINE_REFERENCE] = "reference",
+    [VM_ENGINE_THREADED] = "threaded",
+    [VM_ENGINE_REGISTER] = "register",
+    [VM_ENGINE_JIT] = "jit",
+};
+
+VmOptions vm_default_options(void) {
+    return (VmOptions){
+        .engine = VM_ENGINE_REFERENCE,
+        .jit_threshold = 100,
+        .value_stack_size = 1 << 20,
+        .frame_stack_size = 16 << 20,
+    };
+}
+
 Vm vm_new(VmSystem* system, Bytecode bytecode, Reporter* reporter) {
-    Word* value_stack_data = malloc_or_exit(8 * sizeof(Word));
-    VmValueStack value_stack = {
+    return vm_new_with_options(system, bytecode, reporter, vm_default_options());
+}
+
+// `max_frame_size` is the largest frame of the register engine, in registers.
+static void stacks_new(Vm* vm, usize max_frame_size) {
+#ifdef COUGH_VM_GUARDED_STACKS
+    usize value_stack_capacity = vm->options.value_stack_size;
+    usize frame_capacity = vm->options.frame_stack_size;
+#else
+    usize value_stack_capacity = 8;
+    usize frame_capacity = 64;
+#endif
+    // bytecode that does not recurse gets stacks of exactly the size it needs,
+    // which never grow. The register engine lays its frames out differently.
+    BytecodeMetadata metadata = vm->metadata;
+    if (vm->verified && metadata.max_stack != BYTECODE_UNBOUNDED) {
+        value_stack_capacity = metadata.max_stack ? metadata.max_stack : 1;
+        if (vm->options.engine != VM_ENGINE_REGISTER) {
+            frame_capacity =
+                metadata.max_locals * sizeof(Word)
+                + metadata.max_calls * sizeof(VmFrame);
+            frame_capacity = frame_capacity ? frame_capacity : sizeof(Word);
+        }
+    }
+
+#ifdef COUGH_VM_GUARDED_STACKS
+    // values are pushed and popped one at a time, but frames may be allocated
+    // by a whole `res` or register frame before they are touched, so the guard
+    // above them must be larger than any frame.
+    usize max_locals = max_frame_size > UINT16_MAX ? max_frame_size : UINT16_MAX;
+    Word* value_stack_data = vm_stack_map(
+        value_stack_capacity * sizeof(Word),
+        sizeof(Word),
+        sizeof(Word),
+        &vm->stack_mappings[0]
+    );
+    void* frame_data = vm_stack_map(
+        frame_capacity,
+        sizeof(VmFrame),
+        sizeof(VmFrame) + max_locals * sizeof(Word),
+        &vm->stack_mappings[1]
+    );
+#else
+    Word* value_stack_data = malloc_or_exit(value_stack_capacity * sizeof(Word));
+    void* frame_data = malloc_or_exit(frame_capacity);
+#endif
+    vm->value_stack = (VmValueStack){
         .data = value_stack_data,
         .top = value_stack_data,
-        .capacity = 8,
+        .capacity = value_stack_capacity,
     };
-
-    void* frame_data = malloc_or_exit(64);
-    VmFrameStack frames = {
+    vm->frames = (VmFrameStack){
         .data = frame_data,
         .top = frame_data,
         .local_variables = frame_data,
-        .capacity = 64,
+        .capacity = frame_capacity,
     };
+}
 
-    return (Vm){
+Vm vm_new_with_options(
+    VmSystem* system,
+    Bytecode bytecode,
+    Reporter* reporter,
+    VmOptions options
+) {
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_VM);
+    Vm vm = {
+        .options = options,
         .system = system,
         .reporter = reporter,
         .bytecode = bytecode,
         .ip = bytecode.instructions.data,
-        .value_stack = value_stack,
-        .frames = frames,
     };
+    // decoding, lowering and compiling all assume well-formed bytecode, so
+    // bytecode that does not verify is left as is, and never runs. The
+    // register engine lowers from the depths the verifier found.
+    BytecodeStackMap stack_map;
+    vm.verified = options.engine == VM_ENGINE_REGISTER
+        ? bytecode_analyze_stack(bytecode, &vm.metadata, &stack_map, &vm.verify_error)
+        : bytecode_analyze(bytecode, &vm.metadata, &vm.verify_error);
+
+    usize max_frame_size = 0;
+    if (vm.verified) {
+        void const* const* handlers;
+        run_threaded(NULL, &handlers);
+        VmProgram program = vm_program_new(bytecode, handlers);
+        vm.program = program;
+        vm.pc = program.instructions.data;
+
+        if (options.engine == VM_ENGINE_JIT) {
+            for (usize i = 0; i < program.instructions.len; i++) {
+                VmInstruction* instruction = &program.instructions.data[i];
+                if (instruction->handler_index == OP_CAL) {
+                    instruction->handler_index = VM_HANDLER_JIT_CAL;
+                    instruction->handler =
+                        handlers ? handlers[VM_HANDLER_JIT_CAL] : NULL;
+                }
+            }
+            vm.jit = vm_jit_new(program, options.jit_threshold);
+        }
+
+        if (options.engine == VM_ENGINE_REGISTER) {
+            run_register(NULL, &handlers);
+            vm.register_program =
+                vm_reg_program_new(program, &vm.metadata, &stack_map, handlers);
+            bytecode_stack_map_free(&stack_map);
+            for (usize i = 0; i < vm.register_program.functions.len; i++) {
+                usize size = vm.register_program.functions.data[i].frame_size;
+                if (size > max_frame_size) {
+                    max_frame_size = size;
+                }
+            }
+        }
+    }
+    stacks_new(&vm, max_frame_size);
+
+    if (options.engine == VM_ENGINE_REGISTER && vm.verified) {
+        // the entry point runs in a frame without metadata, like in the
+        // other engines.
+        VmRegFunction entry = vm.register_program.functions.data[0];
+        usize size = entry.frame_size * sizeof(Word);
+        memset(frames_alloc(&vm, size), 0, size);
+        vm.register_pc = entry.entry;
+    }
+    alloc_stage_leave(stage);
+    return vm;
 }
 
 void vm_free(Vm* vm) {
-    free(vm->value_stack.data);
-    free(vm->frames.data);
+    if (vm->verified) {
+        bytecode_metadata_free(&vm->metadata);
+    }
+    vm_program_free(&vm->program);
+    vm_reg_program_free(&vm->register_program);
+    if (vm->options.engine == VM_ENGINE_JIT) {
+        vm_jit_free(&vm->jit);
+    }
+#ifdef COUGH_VM_GUARDED_STACKS
+    vm_stack_unmap(vm->stack_mappings[0]);
+    vm_stack_unmap(vm->stack_mappings[1]);
+#else
+    free_allocation(vm->value_stack.data);
+    free_allocation(vm->frames.data);
+#endif
 }
 
-static void push(Vm* vm, Word value) {
+#ifndef COUGH_VM_GUARDED_STACKS
+static void grow_value_stack(Vm* vm) {
     VmValueStack stack = vm->value_stack;
     usize len = stack.top - stack.data;
-    if (len == stack.capacity) {
-        stack.capacity *= 2;
-        stack.data = realloc_or_exit(stack.data, stack.capacity * sizeof(Word));
-        stack.top = stack.data + len;
-        vm->value_stack = stack;
+    stack.capacity *= 2;
+    stack.data = realloc_or_exit(stack.data, stack.capacity * sizeof(Word));
+    stack.top = stack.data + len;
+    vm->value_stack = stack;
+}
+#endif
+
+static void push(Vm* vm, Word value) {
+#ifndef COUGH_VM_GUARDED_STACKS
+    VmValueStack stack = vm->value_stack;
+    if (stack.top == stack.data + stack.capacity) {
+        grow_value_stack(vm);
     }
+#endif
     *(vm->value_stack.top++) = value;
 }
 
@@ -56,6 +202,11 @@ static Word pop(Vm* vm) {
 
 // reserves `size` bytes after `vm->stack.local_variables`.
 static void* frames_alloc(Vm* vm, usize size) {
+#ifdef COUGH_VM_GUARDED_STACKS
+    void* ptr = vm->frames.top;
+    vm->frames.top += size;
+    return ptr;
+#else
     VmFrameStack frames = vm->frames;
     usize len = frames.top - frames.data;
     usize min_capacity = len + size;
@@ -65,12 +216,13 @@ static void* frames_alloc(Vm* vm, usize size) {
     }
     usize new_capacity = (2 * frames.capacity >= min_capacity) ? 2 * frames.capacity : min_capacity;
     usize var_offset = (void*)frames.local_variables - frames.data;
-    frames.data = realloc_or_exit(frames.data, frames.capacity);
+    frames.data = realloc_or_exit(frames.data, new_capacity);
     frames.top = frames.data + len + size;
     frames.local_variables = frames.data + var_offset;
     frames.capacity = new_capacity;
     vm->frames = frames;
     return frames.data + len;
+#endif
 }
 
 typedef enum ControlFlow {
@@ -79,6 +231,7 @@ typedef enum ControlFlow {
 } ControlFlow;
 
 static ControlFlow run_one(Vm* vm);
+static ControlFlow run_sys(Vm* vm);
 
 #define Arg(mnemo) Arg_##mnemo
 #define Arg_imb Byteword
@@ -102,14 +255,99 @@ FOR_OPERATIONS(DECL_OP_FN)
     );
 FOR_SYSCALLS(DECL_SYS_FN)
 
-void vm_run(Vm* vm) {
+#ifdef COUGH_VM_COUNT_INSTRUCTIONS
+#define COUNT_INSTRUCTION(vm) ((vm)->instruction_count++)
+#else
+#define COUNT_INSTRUCTION(vm) ((void)0)
+#endif
+
+static void run_reference(Vm* vm) {
     while (true){
+        COUNT_INSTRUCTION(vm);
         if (run_one(vm) == FLOW_EXIT) {
             return;
         }
     }
 }
 
+static void run_engine(Vm* vm) {
+    switch (vm->options.engine) {
+    case VM_ENGINE_REFERENCE:
+        run_reference(vm);
+        return;
+    case VM_ENGINE_THREADED:
+    case VM_ENGINE_JIT:
+        run_threaded(vm, NULL);
+        return;
+    case VM_ENGINE_REGISTER:
+        run_register(vm, NULL);
+        return;
+    default:
+        return;
+    }
+}
+
+#ifdef COUGH_VM_GUARDED_STACKS
+static void report_stack_fault(Vm* vm, void const* address) {
+    static char const* const stack_names[] = { "value stack", "frame stack" };
+    for (usize i = 0; i < 2; i++) {
+        switch (vm_stack_fault(vm->stack_mappings[i], address)) {
+        case VM_STACK_OVERFLOW:
+            report_simple_runtime_error(
+                vm->reporter,
+                RE_STACK_OVERFLOW,
+                format("%s overflow", stack_names[i])
+            );
+            return;
+        case VM_STACK_UNDERFLOW:
+            report_simple_runtime_error(
+                vm->reporter,
+                RE_STACK_UNDERFLOW,
+                format("%s underflow", stack_names[i])
+            );
+            return;
+        default:
+            break;
+        }
+    }
+}
+#endif
+
+void vm_run(Vm* vm) {
+    if (!vm->verified) {
+        report_simple_runtime_error(
+            vm->reporter,
+            RE_MALFORMED_BYTECODE,
+            format(
+                "malformed bytecode at offset %zu: %s",
+                vm->verify_error.offset,
+                verify_error_messages[vm->verify_error.kind]
+            )
+        );
+        return;
+    }
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_VM);
+#ifdef COUGH_VM_GUARDED_STACKS
+    // the engines do not check the bounds of the stacks, running past them
+    // faults in a guard page and lands back here.
+    VmStackGuard* guard = &vm->stack_guard;
+    guard->mappings = vm->stack_mappings;
+    guard->len = 2;
+    if (sigsetjmp(guard->resume, 1) != 0) {
+        vm_stack_guard_leave(guard);
+        report_stack_fault(vm, guard->fault_address);
+        alloc_stage_leave(stage);
+        return;
+    }
+    vm_stack_guard_enter(guard);
+    run_engine(vm);
+    vm_stack_guard_leave(guard);
+#else
+    run_engine(vm);
+#endif
+    alloc_stage_leave(stage);
+}
+
 static Opcode fetch_op(Vm* vm) {
     return bytecode_read_opcode(&vm->ip);
 }
@@ -136,35 +374,60 @@ static usize fetch_var(Vm* vm) {
 
 static ControlFlow run_one(Vm* vm) {
     Opcode opcode = fetch_op(vm);
-    #define FETCH(idx, kind, ...) , fetch_##kind(vm)
+    // operands are fetched in order before the call, as the evaluation
+    // order of arguments is unspecified.
+    #define FETCH(idx, kind, ...) Arg(kind) x##idx = fetch_##kind(vm);
+    #define PASS(idx, kind, ...) , x##idx
     switch (opcode) {
     #define RUN_ONE_CASE(code, mnemo, ...)                  \
-        case code:                                          \
+        case code: {                                        \
+            FOR_ALL(FETCH __VA_OPT__(, __VA_ARGS__))        \
             return op_##mnemo(                              \
                 vm                                          \
-                FOR_ALL(FETCH __VA_OPT__(, __VA_ARGS__))    \
-            );
+                FOR_ALL(PASS __VA_OPT__(, __VA_ARGS__))     \
+            );                                              \
+        }
     FOR_OPERATIONS(RUN_ONE_CASE)
 
-    case OP_SYS:;
-        Syscall syscall = fetch_sys(vm);
-        switch (syscall) {
-        #define RUN_ONE_SYS_CASE(code, mnemo, ...)              \
-            case code:                                          \
-                return sys_##mnemo(                             \
-                    vm                                          \
-                    FOR_ALL(FETCH __VA_OPT__(, __VA_ARGS__))    \
-                );
-        FOR_SYSCALLS(RUN_ONE_SYS_CASE)
-        default:
-            // FIXME: invalid opcode
-            exit(-1);
-            return FLOW_EXIT;
-        }
+    case OP_SYS:
+        return run_sys(vm);
+
+    default:
+        // only reachable with bytecode that `vm_run` did not verify.
+        report_simple_runtime_error(
+            vm->reporter,
+            RE_INVALID_INSTRUCTION,
+            format(
+                "invalid instruction at offset %td",
+                vm->ip - 1 - vm->bytecode.instructions.data
+            )
+        );
+        return FLOW_EXIT;
+    }
+}
 
+static ControlFlow run_sys(Vm* vm) {
+    Syscall syscall = fetch_sys(vm);
+    switch (syscall) {
+    #define RUN_SYS_CASE(code, mnemo, ...)                      \
+        case code: {                                            \
+            FOR_ALL(FETCH __VA_OPT__(, __VA_ARGS__))            \
+            return sys_##mnemo(                                 \
+                vm                                              \
+                FOR_ALL(PASS __VA_OPT__(, __VA_ARGS__))         \
+            );                                                  \
+        }
+    FOR_SYSCALLS(RUN_SYS_CASE)
     default:
-        // FIXME: invalid opcode
-        exit(-1);
+        // only reachable with bytecode that `vm_run` did not verify.
+        report_simple_runtime_error(
+            vm->reporter,
+            RE_INVALID_SYSCALL,
+            format(
+                "invalid syscall at offset %td",
+                vm->ip - 2 - vm->bytecode.instructions.data
+            )
+        );
         return FLOW_EXIT;
     }
 }
@@ -239,8 +502,10 @@ static ControlFlow op_jnz(Vm* vm, usize dst) {
 // LHS is upper value, RHS is lower value
 #define IMPL_OP_COMPARE(mnemo, type, op)                        \
     static ControlFlow op_##mnemo(Vm* vm) {                     \
+        Word upper = pop(vm);                                   \
+        Word lower = pop(vm);                                   \
         push(vm, (Word){                                        \
-            .as_uint = pop(vm).as_##type op pop(vm).as_##type   \
+            .as_uint = upper.as_##type op lower.as_##type       \
         });                                                     \
         return FLOW_CONTINUE;                                   \
     }
@@ -256,6 +521,43 @@ static ControlFlow op_adu(Vm* vm) {
     });
     return FLOW_CONTINUE;
 }
+
+static ControlFlow op_adl(Vm* vm, usize a, usize b, usize c) {
+    Word* local_variables = vm->frames.local_variables;
+    local_variables[c].as_uint =
+        local_variables[a].as_uint + local_variables[b].as_uint;
+    return FLOW_CONTINUE;
+}
+
+static ControlFlow op_adi(Vm* vm, Word val) {
+    vm->value_stack.top[-1].as_uint += val.as_uint;
+    return FLOW_CONTINUE;
+}
+
+static ControlFlow op_inc(Vm* vm, usize var_index, Word val) {
+    vm->frames.local_variables[var_index].as_uint += val.as_uint;
+    return FLOW_CONTINUE;
+}
+
+#define IMPL_OP_JUMP_COMPARE(mnemo, type, op)                   \
+    static ControlFlow op_##mnemo(                              \
+        Vm* vm,                                                 \
+        usize var_index,                                        \
+        Word val,                                               \
+        usize dst                                               \
+    ) {                                                         \
+        Word var = vm->frames.local_variables[var_index];       \
+        if (var.as_##type op val.as_##type) {                   \
+            vm->ip = vm->bytecode.instructions.data + dst;      \
+        }                                                       \
+        return FLOW_CONTINUE;                                   \
+    }
+
+IMPL_OP_JUMP_COMPARE(jeq, uint, ==);
+IMPL_OP_JUMP_COMPARE(jne, uint, !=);
+IMPL_OP_JUMP_COMPARE(jge, uint, >=);
+IMPL_OP_JUMP_COMPARE(jgt, uint, >);
+
 static ControlFlow sys_nop(Vm* vm) {
     (vm->system)->vtable->nop(vm->system);
     return FLOW_CONTINUE;
@@ -281,3 +583,519 @@ static ControlFlow sys_dbg(Vm* vm, usize var_index) {
     (vm->system)->vtable->dbg(vm->system, var_index, val);
     return FLOW_CONTINUE;
 }
+
+// The threaded engine runs the `VmProgram` decoded by `vm_new`. It keeps the
+// current instruction, the top of the value stack and the local variables in C
+// locals, and only writes them back to `vm` when calling into code that needs
+// the full machine state.
+//
+// With GCC-compatible compilers, each handler jumps straight to the next one
+// through the handler address stored in the instruction. Otherwise, the
+// handlers are the cases of a plain `switch`.
+//
+// When `handlers` is not `NULL`, the table of handler addresses (or `NULL`
+// without computed gotos) is written to it instead of running anything.
+#if defined(__GNUC__) && !defined(COUGH_VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO
+#endif
+
+static void run_threaded(Vm* vm, void const* const** handlers) {
+#ifdef VM_COMPUTED_GOTO
+    static void const* const handler_table[VM_HANDLERS_LEN] = {
+        #define HANDLER_TABLE_ENTRY(code, mnemo, ...) [code] = &&do_##mnemo,
+        FOR_OPERATIONS(HANDLER_TABLE_ENTRY)
+        #define HANDLER_TABLE_SYS_ENTRY(code, mnemo, ...)                   \
+            [VM_HANDLER_SYS(code)] = &&do_sys_##mnemo,
+        FOR_SYSCALLS(HANDLER_TABLE_SYS_ENTRY)
+        [VM_HANDLER_INVALID] = &&do_invalid,
+        [VM_HANDLER_JIT_CAL] = &&do_jit_cal,
+    };
+    #define TARGET(code, mnemo) do_##mnemo
+    #define DISPATCH()                                                      \
+        do {                                                                \
+            COUNT_INSTRUCTION(vm);                                          \
+            goto *ip->handler;                                              \
+        } while (0)
+#else
+    static void const* const* const handler_table = NULL;
+    #define TARGET(code, mnemo) case code
+    #define DISPATCH() goto dispatch
+#endif
+
+    if (handlers) {
+        *handlers = handler_table;
+        return;
+    }
+
+    VmSystem* const system = vm->system;
+    VmInstruction const* ip = vm->pc;
+    Word* sp = vm->value_stack.top;
+    Word* locals = vm->frames.local_variables;
+#ifndef COUGH_VM_GUARDED_STACKS
+    Word* stack_end = vm->value_stack.data + vm->value_stack.capacity;
+#endif
+
+    #define SAVE_STATE()                                                    \
+        (vm->pc = ip, vm->value_stack.top = sp)
+#ifdef COUGH_VM_GUARDED_STACKS
+    #define PUSH(val)                                                       \
+        do {                                                                \
+            Word pushed = (val);                                            \
+            *(sp++) = pushed;                                               \
+        } while (0)
+#else
+    #define PUSH(val)                                                       \
+        do {                                                                \
+            Word pushed = (val);                                            \
+            if (sp == stack_end) {                                          \
+                vm->value_stack.top = sp;                                   \
+                grow_value_stack(vm);                                       \
+                sp = vm->value_stack.top;                                   \
+                stack_end = vm->value_stack.data + vm->value_stack.capacity;\
+            }                                                               \
+            *(sp++) = pushed;                                               \
+        } while (0)
+#endif
+    #define POP() (*(--sp))
+    #define OPERAND(idx, kind) (ip->operands[idx].kind)
+    #define NEXT() (ip++)
+
+#ifdef VM_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    COUNT_INSTRUCTION(vm);
+    switch (ip->handler_index) {
+#endif
+
+    TARGET(OP_NOP, nop):
+        NEXT();
+        DISPATCH();
+
+    // locations are pushed as byteword offsets, like in the reference engine.
+    TARGET(OP_CAL, cal): {
+        VmInstruction const* dst = vm_program_at(&vm->program, POP().as_uint);
+        VmFrame frame = {
+            .return_ip = ip + 1,
+            .return_local_variables = (void*)locals - vm->frames.data,
+        };
+        *(VmFrame*)frames_alloc(vm, sizeof(frame)) = frame;
+        locals = vm->frames.local_variables = vm->frames.top;
+        ip = dst;
+        DISPATCH();
+    }
+
+    // like `cal`, then runs the compiled code of the function if it has some.
+    TARGET(VM_HANDLER_JIT_CAL, jit_cal): {
+        VmInstruction const* dst = vm_program_at(&vm->program, POP().as_uint);
+        VmFrame frame = {
+            .return_ip = ip + 1,
+            .return_local_variables = (void*)locals - vm->frames.data,
+        };
+        *(VmFrame*)frames_alloc(vm, sizeof(frame)) = frame;
+        locals = vm->frames.local_variables = vm->frames.top;
+        ip = dst;
+
+        VmJitFunction const* function = vm_jit_call(&vm->jit, dst);
+        if (function) {
+            usize size = function->reserve * sizeof(Word);
+            memset(frames_alloc(vm, size), 0, size);
+            locals = vm->frames.local_variables;
+#ifndef COUGH_VM_GUARDED_STACKS
+            while ((usize)(stack_end - sp) < function->max_push) {
+                vm->value_stack.top = sp;
+                grow_value_stack(vm);
+                sp = vm->value_stack.top;
+                stack_end = vm->value_stack.data + vm->value_stack.capacity;
+            }
+#endif
+            VmJitContext context = {
+                .sp = sp,
+                .locals = locals,
+                .frames_data = vm->frames.data,
+                .frames_top = vm->frames.top,
+            };
+            ip = function->code(&context);
+            sp = context.sp;
+            locals = vm->frames.local_variables = context.locals;
+            vm->frames.top = context.frames_top;
+        }
+        DISPATCH();
+    }
+
+    TARGET(OP_RES, res): {
+        usize size = OPERAND(0, imb) * sizeof(Word);
+        memset(frames_alloc(vm, size), 0, size);
+        locals = vm->frames.local_variables;
+        NEXT();
+        DISPATCH();
+    }
+
+    TARGET(OP_RET, ret): {
+        VmFrame* frame = (VmFrame*)locals - 1;
+        vm->frames.top = (void*)frame;
+        locals = vm->frames.local_variables =
+            (Word*)(vm->frames.data + frame->return_local_variables);
+        ip = frame->return_ip;
+        DISPATCH();
+    }
+
+    TARGET(OP_SCA, sca):
+        PUSH(OPERAND(0, imw));
+        NEXT();
+        DISPATCH();
+
+    TARGET(OP_LOC, loc):
+        PUSH(((Word){ .as_uint = OPERAND(0, loc)->offset }));
+        NEXT();
+        DISPATCH();
+
+    TARGET(OP_VAR, var):
+        PUSH(locals[OPERAND(0, var)]);
+        NEXT();
+        DISPATCH();
+
+    TARGET(OP_SET, set):
+        locals[OPERAND(0, var)] = POP();
+        NEXT();
+        DISPATCH();
+
+    TARGET(OP_POP, pop):
+        sp--;
+        NEXT();
+        DISPATCH();
+
+    TARGET(OP_JMP, jmp):
+        ip = OPERAND(0, loc);
+        DISPATCH();
+
+    TARGET(OP_JNZ, jnz):
+        if (POP().as_uint != 0) {
+            ip = OPERAND(0, loc);
+        } else {
+            NEXT();
+        }
+        DISPATCH();
+
+    // LHS is upper value, RHS is lower value
+    #define THREADED_COMPARE(code, mnemo, type, op)                         \
+        TARGET(code, mnemo): {                                              \
+            Word upper = POP();                                             \
+            sp[-1].as_uint = upper.as_##type op sp[-1].as_##type;           \
+            NEXT();                                                         \
+            DISPATCH();                                                     \
+        }
+
+    THREADED_COMPARE(OP_EQU, equ, uint, ==)
+    THREADED_COMPARE(OP_NEU, neu, uint, !=)
+    THREADED_COMPARE(OP_GEU, geu, uint, <=)
+    THREADED_COMPARE(OP_GTU, gtu, uint, <)
+
+    TARGET(OP_ADU, adu): {
+        Word upper = POP();
+        sp[-1].as_uint += upper.as_uint;
+        NEXT();
+        DISPATCH();
+    }
+
+    TARGET(OP_ADL, adl):
+        locals[OPERAND(2, var)].as_uint =
+            locals[OPERAND(0, var)].as_uint + locals[OPERAND(1, var)].as_uint;
+        NEXT();
+        DISPATCH();
+
+    TARGET(OP_ADI, adi):
+        sp[-1].as_uint += OPERAND(0, imw).as_uint;
+        NEXT();
+        DISPATCH();
+
+    TARGET(OP_INC, inc):
+        locals[OPERAND(0, var)].as_uint += OPERAND(1, imw).as_uint;
+        NEXT();
+        DISPATCH();
+
+    #define THREADED_JUMP_COMPARE(code, mnemo, type, op)                    \
+        TARGET(code, mnemo):                                                \
+            if (locals[OPERAND(0, var)].as_##type                           \
+                    op OPERAND(1, imw).as_##type) {                         \
+                ip = OPERAND(2, loc);                                       \
+            } else {                                                        \
+                NEXT();                                                     \
+            }                                                               \
+            DISPATCH();
+
+    THREADED_JUMP_COMPARE(OP_JEQ, jeq, uint, ==)
+    THREADED_JUMP_COMPARE(OP_JNE, jne, uint, !=)
+    THREADED_JUMP_COMPARE(OP_JGE, jge, uint, >=)
+    THREADED_JUMP_COMPARE(OP_JGT, jgt, uint, >)
+
+    TARGET(VM_HANDLER_SYS(SYS_NOP), sys_nop):
+        system->vtable->nop(system);
+        NEXT();
+        DISPATCH();
+
+    TARGET(VM_HANDLER_SYS(SYS_EXIT), sys_exit):
+        system->vtable->exit(system, POP().as_int);
+        NEXT();
+        SAVE_STATE();
+        return;
+
+    TARGET(VM_HANDLER_SYS(SYS_HI), sys_hi):
+        system->vtable->hi(system);
+        NEXT();
+        DISPATCH();
+
+    TARGET(VM_HANDLER_SYS(SYS_BYE), sys_bye):
+        system->vtable->bye(system);
+        NEXT();
+        DISPATCH();
+
+    TARGET(VM_HANDLER_SYS(SYS_DBG), sys_dbg):
+        system->vtable->dbg(system, OPERAND(0, var), locals[OPERAND(0, var)]);
+        NEXT();
+        DISPATCH();
+
+#ifndef VM_COMPUTED_GOTO
+    default:
+#endif
+    TARGET(VM_HANDLER_INVALID, invalid):
+        SAVE_STATE();
+        report_simple_runtime_error(
+            vm->reporter,
+            RE_INVALID_INSTRUCTION,
+            format("invalid instruction at offset %" PRIu32, ip->offset)
+        );
+        return;
+
+#ifndef VM_COMPUTED_GOTO
+    }
+#endif
+
+    #undef SAVE_STATE
+    #undef PUSH
+    #undef POP
+    #undef OPERAND
+    #undef NEXT
+    #undef TARGET
+    #undef DISPATCH
+    #undef HANDLER_TABLE_ENTRY
+    #undef HANDLER_TABLE_SYS_ENTRY
+    #undef THREADED_COMPARE
+    #undef THREADED_JUMP_COMPARE
+}
+
+// The register engine runs the `VmRegProgram` lowered by `vm_new`, with the same
+// dispatch as the threaded engine. Its instructions read and write the
+// registers of the current frame, so it never touches the value stack.
+static void run_register(Vm* vm, void const* const** handlers) {
+#ifdef VM_COMPUTED_GOTO
+    static void const* const handler_table[REG_OPCODES_LEN] = {
+        #define HANDLER_TABLE_ENTRY(code, mnemo, ...) [code] = &&do_##mnemo,
+        FOR_REGISTER_OPERATIONS(HANDLER_TABLE_ENTRY)
+    };
+    #define TARGET(code, mnemo) do_##mnemo
+    #define DISPATCH()                                                      \
+        do {                                                                \
+            COUNT_INSTRUCTION(vm);                                          \
+            goto *ip->handler;                                              \
+        } while (0)
+#else
+    static void const* const* const handler_table = NULL;
+    #define TARGET(code, mnemo) case code
+    #define DISPATCH() goto dispatch
+#endif
+
+    if (handlers) {
+        *handlers = handler_table;
+        return;
+    }
+
+    VmSystem* const system = vm->system;
+    VmRegInstruction const* ip = vm->register_pc;
+    Word* regs = vm->frames.local_variables;
+    VmRegFunction const* callee;
+
+    #define SAVE_STATE() (vm->register_pc = ip)
+    #define OPERAND(idx, kind) (ip->operands[idx].kind)
+    #define REG(idx) (regs[OPERAND(idx, reg)])
+    #define NEXT() (ip++)
+
+#ifdef VM_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    COUNT_INSTRUCTION(vm);
+    switch (ip->handler_index) {
+#endif
+
+    TARGET(REG_OP_MOV, mov):
+        REG(0) = REG(1);
+        NEXT();
+        DISPATCH();
+
+    TARGET(REG_OP_LDI, ldi):
+        REG(0) = OPERAND(1, imw);
+        NEXT();
+        DISPATCH();
+
+    TARGET(REG_OP_LDF, ldf):
+        REG(0).as_uint = OPERAND(1, fun)->offset;
+        NEXT();
+        DISPATCH();
+
+    TARGET(REG_OP_ADD, add):
+        REG(0).as_uint = REG(1).as_uint + REG(2).as_uint;
+        NEXT();
+        DISPATCH();
+
+    TARGET(REG_OP_ADI, adi):
+        REG(0).as_uint = REG(1).as_uint + OPERAND(2, imw).as_uint;
+        NEXT();
+        DISPATCH();
+
+    #define REGISTER_COMPARE(code, mnemo, type, op)                         \
+        TARGET(code, mnemo):                                                \
+            REG(0).as_uint = REG(1).as_##type op REG(2).as_##type;          \
+            NEXT();                                                         \
+            DISPATCH();
+
+    REGISTER_COMPARE(REG_OP_EQU, equ, uint, ==)
+    REGISTER_COMPARE(REG_OP_NEU, neu, uint, !=)
+    REGISTER_COMPARE(REG_OP_GEU, geu, uint, >=)
+    REGISTER_COMPARE(REG_OP_GTU, gtu, uint, >)
+
+    TARGET(REG_OP_JMP, jmp):
+        ip = OPERAND(0, loc);
+        DISPATCH();
+
+    TARGET(REG_OP_JNZ, jnz):
+        if (REG(0).as_uint != 0) {
+            ip = OPERAND(1, loc);
+        } else {
+            NEXT();
+        }
+        DISPATCH();
+
+    #define REGISTER_JUMP_COMPARE(code, mnemo, type, op)                    \
+        TARGET(code, mnemo):                                                \
+            if (REG(0).as_##type op OPERAND(1, imw).as_##type) {            \
+                ip = OPERAND(2, loc);                                       \
+            } else {                                                        \
+                NEXT();                                                     \
+            }                                                               \
+            DISPATCH();
+
+    REGISTER_JUMP_COMPARE(REG_OP_JEQ, jeq, uint, ==)
+    REGISTER_JUMP_COMPARE(REG_OP_JNE, jne, uint, !=)
+    REGISTER_JUMP_COMPARE(REG_OP_JGE, jge, uint, >=)
+    REGISTER_JUMP_COMPARE(REG_OP_JGT, jgt, uint, >)
+
+    TARGET(REG_OP_CAI, cai):
+        callee = vm_reg_program_function_at(&vm->register_program, REG(0).as_uint);
+        if (!callee) {
+            SAVE_STATE();
+            report_simple_runtime_error(
+                vm->reporter,
+                RE_INVALID_INSTRUCTION,
+                format("no function to call at offset %" PRIu64, REG(0).as_uint)
+            );
+            return;
+        }
+        goto call;
+
+    TARGET(REG_OP_CAL, cal):
+        callee = OPERAND(0, fun);
+    call: {
+        // the frames may move when the new one is allocated.
+        usize args = (void*)&REG(1) - vm->frames.data;
+        VmFrame frame = {
+            .return_ip = ip + 1,
+            .return_local_variables = (void*)regs - vm->frames.data,
+        };
+        VmFrame* new_frame = frames_alloc(
+            vm,
+            sizeof(frame) + callee->frame_size * sizeof(Word)
+        );
+        *new_frame = frame;
+        regs = vm->frames.local_variables = (Word*)(new_frame + 1);
+        memset(regs, 0, callee->locals * sizeof(Word));
+        memcpy(
+            regs + callee->locals,
+            vm->frames.data + args,
+            callee->args * sizeof(Word)
+        );
+        ip = callee->entry;
+        DISPATCH();
+    }
+
+    TARGET(REG_OP_RET, ret): {
+        VmFrame* frame = (VmFrame*)regs - 1;
+        VmRegInstruction const* return_ip = frame->return_ip;
+        Word* caller = (Word*)(vm->frames.data + frame->return_local_variables);
+        // the results go where the arguments of the call were.
+        memcpy(
+            caller + return_ip[-1].operands[1].reg,
+            &REG(0),
+            OPERAND(1, cnt) * sizeof(Word)
+        );
+        vm->frames.top = (void*)frame;
+        regs = vm->frames.local_variables = caller;
+        ip = return_ip;
+        DISPATCH();
+    }
+
+    TARGET(REG_OP_SYS_NOP, sys_nop):
+        SAVE_STATE();
+        system->vtable->nop(system);
+        NEXT();
+        DISPATCH();
+
+    TARGET(REG_OP_SYS_EXIT, sys_exit):
+        SAVE_STATE();
+        system->vtable->exit(system, REG(0).as_int);
+        return;
+
+    TARGET(REG_OP_SYS_HI, sys_hi):
+        SAVE_STATE();
+        system->vtable->hi(system);
+        NEXT();
+        DISPATCH();
+
+    TARGET(REG_OP_SYS_BYE, sys_bye):
+        SAVE_STATE();
+        system->vtable->bye(system);
+        NEXT();
+        DISPATCH();
+
+    TARGET(REG_OP_SYS_DBG, sys_dbg):
+        SAVE_STATE();
+        system->vtable->dbg(system, OPERAND(0, reg), REG(0));
+        NEXT();
+        DISPATCH();
+
+    TARGET(REG_OP_INVALID, invalid):
+        SAVE_STATE();
+        report_simple_runtime_error(
+            vm->reporter,
+            RE_INVALID_INSTRUCTION,
+            format(
+                "instruction at offset %" PRIu32 " cannot run on the register engine",
+                ip->offset
+            )
+        );
+        return;
+
+#ifndef VM_COMPUTED_GOTO
+    }
+#endif
+
+    #undef SAVE_STATE
+    #undef OPERAND
+    #undef REG
+    #undef NEXT
+    #undef TARGET
+    #undef DISPATCH
+    #undef HANDLER_TABLE_ENTRY
+    #undef REGISTER_COMPARE
+    #undef REGISTER_JUMP_COMPARE
+}
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "bytecode/bytecode.h"
+#include "vm/program.h"
+#include "vm/register.h"
+#include "vm/jit.h"
+#include "vm/stack.h"
 #include "vm/system.h"
+#include "verifier/verifier.h"
 #include "diagnostics/report.h"
 
 typedef struct VmValueStack {
@@ -11,7 +16,7 @@ typedef struct VmValueStack {
 } VmValueStack;
 
 typedef struct VmFrame {
-    Byteword const* return_ip;
+    void const* return_ip;  // a `Byteword`, `VmInstruction` or `VmRegInstruction`, depending on the engine
     usize return_local_variables; // offset in bytes
     // local variables go here
 } VmFrame;
@@ -23,17 +28,81 @@ typedef struct VmFrameStack {
     usize capacity;         // in bytes
 } VmFrameStack;
 
+typedef enum VmEngine {
+    /// @brief Decodes and runs one instruction at a time through `run_one`.
+    ///
+    /// This is the reference implementation that all other engines must agree
+    /// with, and the default one.
+    VM_ENGINE_REFERENCE,
+
+    /// @brief Threaded interpreter over the pre-decoded `VmProgram`, that
+    /// keeps the machine state in locals and dispatches with computed gotos
+    /// when the compiler supports them.
+    VM_ENGINE_THREADED,
+
+    /// @brief Threaded interpreter over the `VmRegProgram` lowered from the
+    /// `VmProgram`, whose three-address instructions work directly on the
+    /// registers of the frame instead of the value stack.
+    VM_ENGINE_REGISTER,
+
+    /// @brief The threaded engine, that compiles functions to machine code
+    /// once they have been called `VmOptions.jit_threshold` times.
+    ///
+    /// Compiled code hands back to the interpreter on instructions it does not
+    /// support. Without JIT support for the host, this is the threaded engine.
+    VM_ENGINE_JIT,
+
+    VM_ENGINES_LEN,
+} VmEngine;
+
+extern char const* const vm_engine_names[VM_ENGINES_LEN];
+
+typedef struct VmOptions {
+    VmEngine engine;
+    u32 jit_threshold;  // calls before a function is compiled
+    /// @brief The sizes the stacks are reserved with when they are guarded
+    /// (see `COUGH_VM_GUARDED_STACKS`), running past them is a runtime error.
+    ///
+    /// Without guards, the stacks start small and grow without limit.
+    usize value_stack_size; // in words
+    usize frame_stack_size; // in bytes
+} VmOptions;
+
+VmOptions vm_default_options(void);
+
 typedef struct Vm {
+    VmOptions options;
     VmSystem* system;
     Reporter* reporter;
     Bytecode bytecode;
-    Byteword const* ip;
+    bool verified;              // the bytecode does not run otherwise
+    BytecodeMetadata metadata;  // if it is verified
+    VerifyError verify_error;   // if it is not
+    Byteword const* ip;         // used by the reference engine
+    VmProgram program;          // empty if it is not verified
+    VmInstruction const* pc;    // used by the threaded engine
+    VmRegProgram register_program;
+    VmRegInstruction const* register_pc;  // used by the register engine
+    VmJit jit;
     VmValueStack value_stack;
     VmFrameStack frames;
+#ifdef COUGH_VM_GUARDED_STACKS
+    VmStackMapping stack_mappings[2];   // of the value stack, then the frames
+    VmStackGuard stack_guard;           // while running
+#endif
+#ifdef COUGH_VM_COUNT_INSTRUCTIONS
+    u64 instruction_count;      // run so far, by any engine
+#endif
 } Vm;
 
 // the VM is not responsible for destroying the bytecode
 Vm vm_new(VmSystem* system, Bytecode bytecode, Reporter* reporter);
+Vm vm_new_with_options(
+    VmSystem* system,
+    Bytecode bytecode,
+    Reporter* reporter,
+    VmOptions options
+);
 void vm_free(Vm* vm);
 
 void vm_run(Vm* vm);
@@ -0,0 +1,166 @@
+#include "alloc/alloc.h"
+#include "workers/workers.h"
+
+#ifdef COUGH_THREADS
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#endif
+
+#define CHUNKS_PER_THREAD 4
+
+usize worker_pool_chunks(WorkerPool const* pool, usize len) {
+    usize chunks = pool->threads > 1 ? pool->threads * CHUNKS_PER_THREAD : 1;
+    return chunks < len ? chunks : len;
+}
+
+usize worker_chunk_start(usize len, usize chunks, usize chunk) {
+    return (usize)((u64)len * chunk / chunks);
+}
+
+#ifdef COUGH_THREADS
+
+struct WorkerShared {
+    pthread_mutex_t lock;
+    pthread_cond_t start;   // a job was posted, or the pool stops
+    pthread_cond_t done;    // the last thread left the job
+    usize generation;       // of the last job posted
+    bool stop;
+    WorkerTask task;
+    void* context;
+    usize tasks;
+    atomic_size_t next_task;
+    usize busy;             // threads that did not leave the job yet
+    usize thread_count;
+    pthread_t thread_ids[];
+};
+
+static void run_tasks(WorkerShared* shared) {
+    for (;;) {
+        usize task = atomic_fetch_add_explicit(&shared->next_task, 1, memory_order_relaxed);
+        if (task >= shared->tasks) {
+            return;
+        }
+        shared->task(shared->context, task);
+    }
+}
+
+static void* worker_main(void* arg) {
+    WorkerShared* shared = arg;
+    usize seen = 0;
+    pthread_mutex_lock(&shared->lock);
+    for (;;) {
+        while (!shared->stop && shared->generation == seen) {
+            pthread_cond_wait(&shared->start, &shared->lock);
+        }
+        if (shared->stop) {
+            break;
+        }
+        seen = shared->generation;
+        pthread_mutex_unlock(&shared->lock);
+        run_tasks(shared);
+        pthread_mutex_lock(&shared->lock);
+        if (--shared->busy == 0) {
+            pthread_cond_signal(&shared->done);
+        }
+    }
+    pthread_mutex_unlock(&shared->lock);
+    return NULL;
+}
+
+WorkerPool worker_pool_new(usize threads) {
+    if (threads <= 1) {
+        return (WorkerPool){ .threads = 1, ._shared = NULL };
+    }
+    WorkerShared* shared =
+        malloc_or_exit(sizeof(WorkerShared) + (threads - 1) * sizeof(pthread_t));
+    pthread_mutex_init(&shared->lock, NULL);
+    pthread_cond_init(&shared->start, NULL);
+    pthread_cond_init(&shared->done, NULL);
+    shared->generation = 0;
+    shared->stop = false;
+    shared->tasks = 0;
+    atomic_init(&shared->next_task, 0);
+    shared->busy = 0;
+    shared->thread_count = 0;
+    for (usize i = 0; i < threads - 1; i++) {
+        if (pthread_create(&shared->thread_ids[i], NULL, worker_main, shared) != 0) {
+            break;
+        }
+        shared->thread_count++;
+    }
+    return (WorkerPool){ .threads = shared->thread_count + 1, ._shared = shared };
+}
+
+void worker_pool_free(WorkerPool* pool) {
+    WorkerShared* shared = pool->_shared;
+    if (!shared) {
+        return;
+    }
+    pthread_mutex_lock(&shared->lock);
+    shared->stop = true;
+    pthread_cond_broadcast(&shared->start);
+    pthread_mutex_unlock(&shared->lock);
+    for (usize i = 0; i < shared->thread_count; i++) {
+        pthread_join(shared->thread_ids[i], NULL);
+    }
+    pthread_cond_destroy(&shared->done);
+    pthread_cond_destroy(&shared->start);
+    pthread_mutex_destroy(&shared->lock);
+    free_allocation(shared);
+    pool->_shared = NULL;
+}
+
+usize worker_pool_default_threads(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 1 ? (usize)count : 1;
+}
+
+void worker_pool_run(WorkerPool* pool, usize tasks, WorkerTask task, void* context) {
+    WorkerShared* shared = pool->_shared;
+    if (!shared || shared->thread_count == 0 || tasks <= 1) {
+        for (usize i = 0; i < tasks; i++) {
+            task(context, i);
+        }
+        return;
+    }
+    pthread_mutex_lock(&shared->lock);
+    shared->task = task;
+    shared->context = context;
+    shared->tasks = tasks;
+    atomic_store_explicit(&shared->next_task, 0, memory_order_relaxed);
+    shared->busy = shared->thread_count;
+    shared->generation++;
+    pthread_cond_broadcast(&shared->start);
+    pthread_mutex_unlock(&shared->lock);
+
+    run_tasks(shared);
+
+    // the tasks are done once every thread left the job, and the lock makes
+    // what they wrote visible here.
+    pthread_mutex_lock(&shared->lock);
+    while (shared->busy > 0) {
+        pthread_cond_wait(&shared->done, &shared->lock);
+    }
+    pthread_mutex_unlock(&shared->lock);
+}
+
+#else
+
+WorkerPool worker_pool_new(usize threads) {
+    return (WorkerPool){ .threads = 1, ._shared = NULL };
+}
+
+void worker_pool_free(WorkerPool* pool) {}
+
+usize worker_pool_default_threads(void) {
+    return 1;
+}
+
+void worker_pool_run(WorkerPool* pool, usize tasks, WorkerTask task, void* context) {
+    for (usize i = 0; i < tasks; i++) {
+        task(context, i);
+    }
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "primitives/primitives.h"
+
+/// @brief Runs one task of a job, numbered from 0.
+typedef void (*WorkerTask)(void* context, usize task);
+
+typedef struct WorkerShared WorkerShared;
+
+/// @brief Threads that wait for jobs, to run their tasks in parallel.
+///
+/// A job is a number of independent tasks, handed out one at a time to the
+/// threads of the pool and to the thread that runs the job, so that tasks
+/// that take longer do not hold the others back. Pools of one thread, and
+/// builds without `COUGH_THREADS`, run every task on the calling thread.
+typedef struct WorkerPool {
+    usize threads;      // including the thread that runs jobs
+    WorkerShared* _shared;
+} WorkerPool;
+
+/// @brief Starts `threads - 1` threads, or fewer if they cannot be started.
+WorkerPool worker_pool_new(usize threads);
+/// @brief Stops the threads, that must not be running a job.
+void worker_pool_free(WorkerPool* pool);
+
+/// @brief The number of processors online, at least 1.
+usize worker_pool_default_threads(void);
+
+/// @brief Runs `task(context, i)` for every `i` below `tasks`, in no
+/// particular order, and returns when they are all done.
+///
+/// Tasks run concurrently, so they must only write what no other task of the
+/// job reads or writes. Jobs of a pool must not overlap.
+void worker_pool_run(WorkerPool* pool, usize tasks, WorkerTask task, void* context);
+
+/// @brief How many chunks to split `len` items into, so that the threads of
+/// the pool can balance their work: a few per thread, at most one per item.
+usize worker_pool_chunks(WorkerPool const* pool, usize len);
+
+/// @brief The first of the items of `chunk`, when `len` items are split into
+/// `chunks` contiguous chunks of nearly equal sizes.
+usize worker_chunk_start(usize len, usize chunks, usize chunk);
@@ -0,0 +1,47 @@
+#include <stdio.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+#include "collections/string.h"
+
+// Times the analysis of a generated module of constants named like `c123`,
+// each calling the one before it, so that every name is looked up once from
+// a function scope and once when it is defined.
+//
+// usage: bench_analyzer [constants]
+
+int main(int argc, char const* argv[]) {
+    usize n = bench_arg(argc, argv, 10000);
+    StringBuf text = string_buf_new();
+    string_buf_extend(&text, "c0 :: fn x: Bool -> Bool => x;\n");
+    for (usize i = 1; i < n; i++) {
+        format_into(&text, "c%zu :: fn x: Bool -> Bool => c%zu(x);\n", i, i - 1);
+    }
+    String source = { .data = text.data, .len = text.len };
+
+    SourceText source_text = source_text_new(NULL, text.data);
+    // benches are built without assertions, and errors crash the reporter
+    CrashingReporter reporter = crashing_reporter_new(source_text);
+    Interner interner = interner_new();
+    TokenStream tokens;
+    tokenize(source, &interner, &reporter.base, &tokens);
+    Ast ast;
+    parse(tokens, &reporter.base, &ast);
+
+    f64 start = bench_now();
+    analyze(&ast, &reporter.base);
+    f64 end = bench_now();
+    printf(
+        "%zu constants: analyzed in %.3f ms, %.1f ns/constant\n",
+        n,
+        (end - start) * 1e3,
+        (end - start) * 1e9 / (f64)n
+    );
+
+    ast_free(&ast);
+    token_stream_free(&tokens);
+    interner_free(&interner);
+    source_text_free(&source_text);
+    string_buf_free(&text);
+    return 0;
+}
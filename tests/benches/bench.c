@@ -0,0 +1,48 @@
+#include <stdlib.h>
+#include <time.h>
+
+#include "benches/bench.h"
+
+f64 bench_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+}
+
+u64 bench_arg(int argc, char const* argv[], u64 default_value) {
+    if (argc < 2) {
+        return default_value;
+    }
+    u64 value = strtoull(argv[1], NULL, 10);
+    return value ? value : default_value;
+}
+
+static void bench_vm_system_nop(VmSystem* raw) {
+    ((BenchVmSystem*)raw)->syscall_count++;
+}
+
+static void bench_vm_system_exit(VmSystem* raw, i64 exit_code) {
+    BenchVmSystem* self = (BenchVmSystem*)raw;
+    self->syscall_count++;
+    self->exit_code = exit_code;
+}
+
+static void bench_vm_system_dbg(VmSystem* raw, usize var_idx, Word var_val) {
+    ((BenchVmSystem*)raw)->syscall_count++;
+}
+
+static const VmSystemVTable bench_vm_system_vtable = {
+    .nop = bench_vm_system_nop,
+    .exit = bench_vm_system_exit,
+    .hi = bench_vm_system_nop,
+    .bye = bench_vm_system_nop,
+    .dbg = bench_vm_system_dbg,
+};
+
+BenchVmSystem bench_vm_system_new(void) {
+    return (BenchVmSystem){
+        .base.vtable = &bench_vm_system_vtable,
+        .syscall_count = 0,
+        .exit_code = 0,
+    };
+}
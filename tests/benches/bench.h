@@ -0,0 +1,21 @@
+#pragma once
+
+#include "primitives/primitives.h"
+#include "vm/system.h"
+
+/// @brief A monotonic clock, in seconds.
+f64 bench_now(void);
+
+/// @brief Parses the first command-line argument as a positive integer, or
+/// returns `default_value` if there is none.
+u64 bench_arg(int argc, char const* argv[], u64 default_value);
+
+/// @brief A `VmSystem` whose syscalls do nothing but count, so that programs
+/// can call them in a loop.
+typedef struct BenchVmSystem {
+    VmSystem base;
+    u64 syscall_count;
+    i64 exit_code;
+} BenchVmSystem;
+
+BenchVmSystem bench_vm_system_new(void);
@@ -0,0 +1,122 @@
+#include <stdio.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+#include "benches/collections/old_array_buf.h"
+#include "collections/array.h"
+
+// Compares the inlined pushes of `ArrayBuf` with the ones that went through
+// `Buf`, on bytes, words and token-sized structures. Each array is filled
+// from empty by single pushes, by batches of a few elements like the
+// instructions of the emitter, and by pushes into an exactly reserved array.
+//
+// usage: bench_array_buf [elements]
+
+typedef struct Triple {
+    usize kind;
+    usize start;
+    usize len;
+} Triple;
+
+DECL_ARRAY_BUF(Triple)
+IMPL_ARRAY_BUF(Triple)
+DECL_OLD_ARRAY_BUF(u8)
+IMPL_OLD_ARRAY_BUF(u8)
+DECL_OLD_ARRAY_BUF(usize)
+IMPL_OLD_ARRAY_BUF(usize)
+DECL_OLD_ARRAY_BUF(Triple)
+IMPL_OLD_ARRAY_BUF(Triple)
+
+#define BATCH 4
+
+typedef struct Timings {
+    f64 push;
+    f64 batch;
+    f64 reserved;
+} Timings;
+
+// `MAKE(i)` builds the i-th element, and `READ` turns one into a number for a
+// checksum that keeps the stores alive.
+#define BENCH_ARRAY(ARRAY, T, MAKE, READ, N, DST)                               \
+    do {                                                                        \
+        usize checksum = 0;                                                     \
+        f64 start = bench_now();                                                \
+        ARRAY(T) pushed = ARRAY##_NEW(T)();                                     \
+        for (usize i = 0; i < (N); i++) {                                       \
+            ARRAY##_PUSH(T)(&pushed, MAKE(i));                                  \
+        }                                                                       \
+        checksum += pushed.len + READ(pushed.data[(N) / 2]);                    \
+        ARRAY##_FREE(T)(&pushed);                                               \
+        f64 after_push = bench_now();                                           \
+        ARRAY(T) batched = ARRAY##_NEW(T)();                                    \
+        for (usize i = 0; i + BATCH <= (N); i += BATCH) {                       \
+            T values[BATCH];                                                    \
+            for (usize j = 0; j < BATCH; j++) {                                 \
+                values[j] = MAKE(i + j);                                        \
+            }                                                                   \
+            ARRAY##_EXTEND(T)(&batched, values, BATCH);                         \
+        }                                                                       \
+        checksum += batched.len + READ(batched.data[(N) / 2]);                  \
+        ARRAY##_FREE(T)(&batched);                                              \
+        f64 after_batch = bench_now();                                          \
+        ARRAY(T) reserved = ARRAY##_NEW(T)();                                   \
+        ARRAY##_RESERVE(T)(&reserved, (N));                                     \
+        for (usize i = 0; i < (N); i++) {                                       \
+            ARRAY##_PUSH(T)(&reserved, MAKE(i));                                \
+        }                                                                       \
+        checksum += reserved.len + READ(reserved.data[(N) / 2]);                \
+        ARRAY##_FREE(T)(&reserved);                                             \
+        f64 end = bench_now();                                                  \
+        assert(checksum != 0);                                                  \
+        (DST) = (Timings){                                                      \
+            .push = (after_push - start) * 1e9 / (f64)(N),                      \
+            .batch = (after_batch - after_push) * 1e9 / (f64)(N),               \
+            .reserved = (end - after_batch) * 1e9 / (f64)(N),                   \
+        };                                                                      \
+    } while (0)
+
+#define OldArrayBuf_NEW old_array_buf_new
+#define OldArrayBuf_PUSH old_array_buf_push
+#define OldArrayBuf_EXTEND old_array_buf_extend
+#define OldArrayBuf_RESERVE old_array_buf_reserve
+#define OldArrayBuf_FREE old_array_buf_free
+#define ArrayBuf_NEW array_buf_new
+#define ArrayBuf_PUSH array_buf_push
+#define ArrayBuf_EXTEND array_buf_extend
+#define ArrayBuf_RESERVE array_buf_reserve_exact
+#define ArrayBuf_FREE array_buf_free
+
+#define MAKE_BYTE(i) ((u8)(i))
+#define MAKE_WORD(i) ((usize)(i))
+#define MAKE_TRIPLE(i) ((Triple){ .kind = (i) & 7, .start = (i), .len = 1 })
+#define READ_SCALAR(value) ((usize)(value))
+#define READ_TRIPLE(value) ((value).start)
+
+static void print_timings(char const* name, Timings timings) {
+    printf(
+        "%-14s %7.2f ns/push %7.2f ns/batched %7.2f ns/reserved\n",
+        name,
+        timings.push,
+        timings.batch,
+        timings.reserved
+    );
+}
+
+int main(int argc, char const* argv[]) {
+    usize n = bench_arg(argc, argv, 10000000);
+    printf("%zu elements\n", n);
+    Timings timings;
+    BENCH_ARRAY(OldArrayBuf, u8, MAKE_BYTE, READ_SCALAR, n, timings);
+    print_timings("old u8", timings);
+    BENCH_ARRAY(ArrayBuf, u8, MAKE_BYTE, READ_SCALAR, n, timings);
+    print_timings("new u8", timings);
+    BENCH_ARRAY(OldArrayBuf, usize, MAKE_WORD, READ_SCALAR, n, timings);
+    print_timings("old usize", timings);
+    BENCH_ARRAY(ArrayBuf, usize, MAKE_WORD, READ_SCALAR, n, timings);
+    print_timings("new usize", timings);
+    BENCH_ARRAY(OldArrayBuf, Triple, MAKE_TRIPLE, READ_TRIPLE, n, timings);
+    print_timings("old triple", timings);
+    BENCH_ARRAY(ArrayBuf, Triple, MAKE_TRIPLE, READ_TRIPLE, n, timings);
+    print_timings("new triple", timings);
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+#include "benches/collections/old_hash_map.h"
+#include "collections/hash_map.h"
+
+// Compares the Swiss table `HashMap` with the linear-probing one it replaced,
+// on integer keys and on short string keys like the names of the assembler.
+// Each map gets the same inserts, then looks up every key, then as many keys
+// that are absent, both in another order than they were inserted in.
+//
+// usage: bench_hash_map [keys]
+
+// strings get their own key type, since the library already has maps from
+// `String`.
+typedef String Name;
+
+void hash_Name(Hasher* hasher, Name name) {
+    hash(String)(hasher, name);
+}
+
+bool eq_Name(Name a, Name b) {
+    return a.len == b.len && memcmp(a.data, b.data, a.len) == 0;
+}
+
+DECL_OLD_HASH_MAP(usize, usize)
+IMPL_OLD_HASH_MAP(usize, usize)
+DECL_OLD_HASH_MAP(Name, usize)
+IMPL_OLD_HASH_MAP(Name, usize)
+DECL_HASH_MAP(Name, usize)
+IMPL_HASH_MAP(Name, usize)
+
+typedef struct Timings {
+    f64 insert;
+    f64 hit;
+    f64 miss;
+} Timings;
+
+// runs the inserts and lookups with the functions of one kind of map.
+#define BENCH_MAP(MAP, KEY, KEYS, LOOKUPS, MISSES, N, DST)                      \
+    do {                                                                        \
+        MAP(KEY, usize) map = MAP##_NEW(KEY, usize)();                          \
+        f64 start = bench_now();                                                \
+        for (usize i = 0; i < (N); i++) {                                       \
+            MAP##_INSERT(KEY, usize)(&map, (KEYS)[i], i);                       \
+        }                                                                       \
+        f64 inserted = bench_now();                                             \
+        usize found = 0;                                                        \
+        for (usize i = 0; i < (N); i++) {                                       \
+            found += *MAP##_GET(KEY, usize)(map, (LOOKUPS)[i]);                 \
+        }                                                                       \
+        f64 hits = bench_now();                                                 \
+        for (usize i = 0; i < (N); i++) {                                       \
+            found += MAP##_GET(KEY, usize)(map, (MISSES)[i]) != NULL;           \
+        }                                                                       \
+        f64 misses = bench_now();                                               \
+        assert(found == (N) * ((N) - 1) / 2);                                   \
+        MAP##_FREE(KEY, usize)(&map);                                           \
+        (DST) = (Timings){                                                      \
+            .insert = (inserted - start) * 1e9 / (f64)(N),                      \
+            .hit = (hits - inserted) * 1e9 / (f64)(N),                          \
+            .miss = (misses - hits) * 1e9 / (f64)(N),                           \
+        };                                                                      \
+    } while (0)
+
+#define OldHashMap_NEW old_hash_map_new
+#define OldHashMap_INSERT old_hash_map_insert
+#define OldHashMap_GET old_hash_map_get
+#define OldHashMap_FREE old_hash_map_free
+#define HashMap_NEW hash_map_new
+#define HashMap_INSERT hash_map_insert
+#define HashMap_GET hash_map_get
+#define HashMap_FREE hash_map_free
+
+// splitmix64, so that keys are distinct but have no pattern the hash could
+// happen to spread perfectly.
+static usize random_key(usize i) {
+    u64 z = (i + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (usize)(z ^ (z >> 31));
+}
+
+static void print_timings(char const* name, Timings timings) {
+    printf(
+        "%-16s %8.2f ns/insert %8.2f ns/hit %8.2f ns/miss\n",
+        name,
+        timings.insert,
+        timings.hit,
+        timings.miss
+    );
+}
+
+int main(int argc, char const* argv[]) {
+    usize n = bench_arg(argc, argv, 1000000);
+
+    usize* keys = malloc_or_exit(n * sizeof(usize));
+    usize* absent = malloc_or_exit(n * sizeof(usize));
+    for (usize i = 0; i < n; i++) {
+        keys[i] = random_key(i);
+        absent[i] = random_key(n + i);
+    }
+    // a fixed shuffle of the keys, so that lookups do not benefit from the
+    // order of the inserts.
+    usize* order = malloc_or_exit(n * sizeof(usize));
+    for (usize i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    u64 state = 0x853c49e6748fea9bULL;
+    for (usize i = n - 1; i > 0; i--) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        usize j = (usize)((state >> 33) % (i + 1));
+        usize t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    usize* lookups = malloc_or_exit(n * sizeof(usize));
+    usize* absent_lookups = malloc_or_exit(n * sizeof(usize));
+    for (usize i = 0; i < n; i++) {
+        lookups[i] = keys[order[i]];
+        absent_lookups[i] = absent[order[i]];
+    }
+
+    // like generated identifiers: a letter and a number.
+    char* storage = malloc_or_exit(2 * n * 24);
+    Name* names = malloc_or_exit(n * sizeof(Name));
+    Name* absent_names = malloc_or_exit(n * sizeof(Name));
+    for (usize i = 0; i < n; i++) {
+        char* name = storage + 2 * i * 24;
+        char* absent_name = name + 24;
+        names[i] = (Name){ name, (usize)snprintf(name, 24, "c%zu", i) };
+        absent_names[i] =
+            (Name){ absent_name, (usize)snprintf(absent_name, 24, "d%zu", i) };
+    }
+    Name* name_lookups = malloc_or_exit(n * sizeof(Name));
+    for (usize i = 0; i < n; i++) {
+        name_lookups[i] = names[order[i]];
+    }
+
+    printf("%zu keys\n", n);
+    Timings timings;
+    BENCH_MAP(OldHashMap, usize, keys, lookups, absent_lookups, n, timings);
+    print_timings("old usize", timings);
+    BENCH_MAP(HashMap, usize, keys, lookups, absent_lookups, n, timings);
+    print_timings("swiss usize", timings);
+    BENCH_MAP(OldHashMap, Name, names, name_lookups, absent_names, n, timings);
+    print_timings("old string", timings);
+    BENCH_MAP(HashMap, Name, names, name_lookups, absent_names, n, timings);
+    print_timings("swiss string", timings);
+
+    free(keys);
+    free(absent);
+    free(order);
+    free(lookups);
+    free(absent_lookups);
+    free(name_lookups);
+    free(storage);
+    free(names);
+    free(absent_names);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// The `ArrayBuf` that went through `Buf` for every push, renamed so that
+// benchmarks can compare both.
+
+#include <stdlib.h>
+
+#include "primitives/primitives.h"
+#include "alloc/alloc.h"
+#include "alloc/buf.h"
+
+#define OldArrayBuf(T) OldArrayBuf_##T
+
+#define old_array_buf_new(T)        old_array_buf_new_##T
+#define old_array_buf_free(T)       old_array_buf_free_##T
+#define old_array_buf_reserve(T)    old_array_buf_reserve_##T
+#define old_array_buf_push(T)       old_array_buf_push_##T
+#define old_array_buf_extend(T)     old_array_buf_extend_##T
+
+#define DECL_OLD_ARRAY_BUF(T)                                                   \
+    typedef struct OldArrayBuf(T) {                                             \
+        T* data;                                                                \
+        usize len;                                                              \
+        usize capacity;                                                         \
+    } OldArrayBuf(T);                                                           \
+
+#define IMPL_OLD_ARRAY_BUF(T)                                                   \
+    OldArrayBuf(T)                                                              \
+    old_array_buf_new(T)(void) {                                                \
+        return (OldArrayBuf(T)){                                                \
+            .data = NULL,                                                       \
+            .len = 0,                                                           \
+            .capacity = 0                                                       \
+        };                                                                      \
+    }                                                                           \
+                                                                                \
+    void                                                                        \
+    old_array_buf_free(T)(                                                      \
+        OldArrayBuf(T)* array                                                   \
+    ) {                                                                         \
+        free_allocation(array->data);                                           \
+    }                                                                           \
+                                                                                \
+    void                                                                        \
+    old_array_buf_reserve(T)(                                                   \
+        OldArrayBuf(T)* array,                                                  \
+        usize additional                                                        \
+    ) {                                                                         \
+        Buf buf = {                                                             \
+            .data = (void*)array->data,                                         \
+            .size = array->len * sizeof(T),                                     \
+            .capacity = array->capacity * sizeof(T),                            \
+        };                                                                      \
+        buf_reserve(&buf, additional * sizeof(T));                              \
+        array->data = (T*)buf.data;                                             \
+        array->len = buf.size / sizeof(T);                                      \
+        array->capacity = buf.capacity / sizeof(T);                             \
+    }                                                                           \
+                                                                                \
+    void                                                                        \
+    old_array_buf_extend(T)(                                                    \
+        OldArrayBuf(T)* array,                                                  \
+        T const* values,                                                        \
+        usize len                                                               \
+    ) {                                                                         \
+        Buf buf = {                                                             \
+            .data = (void*)array->data,                                         \
+            .size = array->len * sizeof(T),                                     \
+            .capacity = array->capacity * sizeof(T),                            \
+        };                                                                      \
+        buf_extend_or_grow(&buf, values, len * sizeof(T), 1);                   \
+        array->data = (T*)buf.data;                                             \
+        array->len = buf.size / sizeof(T);                                      \
+        array->capacity = buf.capacity / sizeof(T);                             \
+    }                                                                           \
+                                                                                \
+    void                                                                        \
+    old_array_buf_push(T)(                                                      \
+        OldArrayBuf(T)* array,                                                  \
+        T value                                                                 \
+    ) {                                                                         \
+        old_array_buf_extend(T)(array, &value, 1);                              \
+    }                                                                           \
+
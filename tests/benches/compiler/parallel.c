@@ -0,0 +1,84 @@
+#include <stdio.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+
+// Times the compilation of a generated module of functions named like `f123`,
+// each calling some others, on pools of 1 thread up to twice the number of
+// processors. Tokenizing and parsing stay on one thread, so they are timed
+// apart from the analysis and generation that run on the pool.
+//
+// usage: bench_compile [functions]
+
+#define RUNS 5
+
+int main(int argc, char const* argv[]) {
+    usize n = bench_arg(argc, argv, 20000);
+    StringBuf text = string_buf_new();
+    for (usize i = 0; i < n; i++) {
+        format_into(
+            &text,
+            "f%zu :: fn x: Bool -> Bool => f%zu(f%zu(f%zu(x)));\n",
+            i,
+            (i + 1) % n,
+            (i + n - 1) % n,
+            (i * 7) % n
+        );
+    }
+    String source = { .data = text.data, .len = text.len };
+    SourceText source_text = source_text_new(NULL, text.data);
+    // benches are built without assertions, and errors crash the reporter
+    CrashingReporter reporter = crashing_reporter_new(source_text);
+
+    usize max_threads = 2 * worker_pool_default_threads();
+    f64 sequential = 0;
+    for (usize threads = 1; threads <= max_threads; threads *= 2) {
+        WorkerPool workers = worker_pool_new(threads);
+        f64 best_front = 0;
+        f64 best_back = 0;
+        for (usize run = 0; run < RUNS; run++) {
+            Interner interner = interner_new();
+            TokenStream tokens;
+            Ast ast;
+            f64 start = bench_now();
+            tokenize(source, &interner, &reporter.base, &tokens);
+            parse(tokens, &reporter.base, &ast);
+            f64 parsed = bench_now();
+            analyze_parallel(&ast, &reporter.base, &workers);
+            Emitter emitter = emitter_new();
+            generate_parallel(&ast, &emitter, &workers);
+            Bytecode bytecode;
+            emitter_finish(&emitter, &bytecode);
+            f64 end = bench_now();
+
+            if (run == 0 || parsed - start < best_front) {
+                best_front = parsed - start;
+            }
+            if (run == 0 || end - parsed < best_back) {
+                best_back = end - parsed;
+            }
+            array_buf_free(Byteword)(&bytecode.instructions);
+            array_buf_free(Byteword)(&bytecode.rodata);
+            ast_free(&ast);
+            token_stream_free(&tokens);
+            interner_free(&interner);
+        }
+        if (threads == 1) {
+            sequential = best_back;
+        }
+        printf(
+            "%zu functions, %2zu threads: parsed in %.3f ms, "
+            "analyzed and generated in %.3f ms, %.2fx\n",
+            n,
+            workers.threads,
+            best_front * 1e3,
+            best_back * 1e3,
+            sequential / best_back
+        );
+        worker_pool_free(&workers);
+    }
+
+    source_text_free(&source_text);
+    string_buf_free(&text);
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+#include "bytecode/bytecode.h"
+#include "ops/hash.h"
+
+// Compares `hash(String)` with the byte-at-a-time hashing it replaced: first
+// the throughput on strings of several lengths, then how the hashes of the
+// kinds of keys the compiler puts in hash maps spread over a table of twice
+// their number of slots.
+//
+// usage: bench_hash [bytes per length]
+
+// the previous `Hasher`, that folds every value with a single multiplication
+// and has no finalizer.
+#define OLD_PI ((u64)0x517cc1b727220a95ULL)
+
+static u64 old_hash_step(u64 state, u64 value) {
+    state = (state << 5) | (state >> 59);
+    return (state ^ value) * OLD_PI;
+}
+
+static u64 old_hash_string(String string) {
+    u64 state = old_hash_step(0, string.len);
+    for (usize i = 0; i < string.len; i++) {
+        state = old_hash_step(state, (u64)string.data[i]);
+    }
+    return state;
+}
+
+static u64 new_hash_string(String string) {
+    Hasher hasher = new_hasher();
+    hash(String)(&hasher, string);
+    return finish_hash(hasher);
+}
+
+typedef struct Keys {
+    char const* name;
+    usize len;
+    u64* old_hashes;
+    u64* new_hashes;
+} Keys;
+
+static Keys keys_new(char const* name, usize len) {
+    return (Keys){
+        .name = name,
+        .len = 0,
+        .old_hashes = malloc_or_exit(len * sizeof(u64)),
+        .new_hashes = malloc_or_exit(len * sizeof(u64)),
+    };
+}
+
+static void keys_free(Keys* keys) {
+    free(keys->old_hashes);
+    free(keys->new_hashes);
+}
+
+static void push_string(Keys* keys, String key) {
+    keys->old_hashes[keys->len] = old_hash_string(key);
+    keys->new_hashes[keys->len] = new_hash_string(key);
+    keys->len++;
+}
+
+static int compare_u64(void const* a, void const* b) {
+    u64 x = *(u64 const*)a, y = *(u64 const*)b;
+    return (x > y) - (x < y);
+}
+
+// keys that share their whole hash, or the slot they start probing at.
+static void count_collisions(u64* hashes, usize len, usize* full, usize* slots) {
+    usize capacity = 1;
+    while (capacity < 2 * len) {
+        capacity *= 2;
+    }
+    u8* taken = calloc(capacity, 1);
+    *slots = 0;
+    for (usize i = 0; i < len; i++) {
+        usize slot = hashes[i] & (capacity - 1);
+        *slots += taken[slot];
+        taken[slot] = 1;
+    }
+    free(taken);
+    qsort(hashes, len, sizeof(u64), compare_u64);
+    *full = 0;
+    for (usize i = 1; i < len; i++) {
+        *full += hashes[i] == hashes[i - 1];
+    }
+}
+
+static f64 power(f64 base, usize exponent) {
+    f64 result = 1.0;
+    for (; exponent; exponent >>= 1, base *= base) {
+        if (exponent & 1) {
+            result *= base;
+        }
+    }
+    return result;
+}
+
+static void print_collisions(Keys keys) {
+    usize capacity = 1;
+    while (capacity < 2 * keys.len) {
+        capacity *= 2;
+    }
+    // the slot collisions of a random function.
+    f64 expected = (f64)keys.len - (f64)capacity
+        * (1.0 - power(1.0 - 1.0 / (f64)capacity, keys.len));
+    usize old_full, old_slots, new_full, new_slots;
+    count_collisions(keys.old_hashes, keys.len, &old_full, &old_slots);
+    count_collisions(keys.new_hashes, keys.len, &new_full, &new_slots);
+    printf(
+        "%-22s %6zu keys   old %4zu full %6zu slot   new %4zu full %6zu slot"
+        "   random %8.1f slot\n",
+        keys.name,
+        keys.len,
+        old_full,
+        old_slots,
+        new_full,
+        new_slots,
+        expected
+    );
+}
+
+static void bench_throughput(usize total) {
+    usize const lengths[] = { 4, 8, 16, 32, 64, 256, 4096, 65536 };
+    char* buffer = malloc_or_exit(65536);
+    for (usize i = 0; i < 65536; i++) {
+        buffer[i] = (char)('a' + i % 26);
+    }
+    for (usize i = 0; i < sizeof(lengths) / sizeof(usize); i++) {
+        usize len = lengths[i];
+        usize rounds = total / len;
+        u64 sink = 0;
+
+        f64 start = bench_now();
+        for (usize j = 0; j < rounds; j++) {
+            buffer[0] = (char)j;
+            sink += old_hash_string((String){ buffer, len });
+        }
+        f64 old_elapsed = bench_now() - start;
+
+        start = bench_now();
+        for (usize j = 0; j < rounds; j++) {
+            buffer[0] = (char)j;
+            sink += new_hash_string((String){ buffer, len });
+        }
+        f64 new_elapsed = bench_now() - start;
+
+        printf(
+            "%6zu bytes   old %7.3f GB/s %8.2f ns/hash"
+            "   new %7.3f GB/s %8.2f ns/hash   (%02" PRIx64 ")\n",
+            len,
+            (f64)(rounds * len) / old_elapsed * 1e-9,
+            old_elapsed * 1e9 / (f64)rounds,
+            (f64)(rounds * len) / new_elapsed * 1e-9,
+            new_elapsed * 1e9 / (f64)rounds,
+            sink & 0xff
+        );
+    }
+    free(buffer);
+}
+
+int main(int argc, char const* argv[]) {
+    usize total = bench_arg(argc, argv, 64 << 20);
+    bench_throughput(total);
+    printf("\n");
+
+    // the mnemonics of the assembler.
+    Keys mnemonics = keys_new("mnemonics", OPCODES_LEN + SYSCALLS_LEN);
+    Mnemonic const* tables[] = { instruction_mnemonics, syscall_mnemonics };
+    usize const table_lens[] = { OPCODES_LEN, SYSCALLS_LEN };
+    for (usize t = 0; t < 2; t++) {
+        for (usize i = 0; i < table_lens[t]; i++) {
+            Mnemonic mnemonic = tables[t][i];
+            u64 word;
+            memcpy(&word, mnemonic.chars, sizeof(word));
+            mnemonics.old_hashes[mnemonics.len] = old_hash_step(0, word);
+            Hasher hasher = new_hasher();
+            hash(Mnemonic)(&hasher, mnemonic);
+            mnemonics.new_hashes[mnemonics.len] = finish_hash(hasher);
+            mnemonics.len++;
+        }
+    }
+    print_collisions(mnemonics);
+    keys_free(&mnemonics);
+
+    // the start positions of tokens, a few bytes apart.
+    Keys positions = keys_new("token positions", 100000);
+    for (usize i = 0; i < 100000; i++) {
+        positions.old_hashes[i] = old_hash_step(0, i * 4);
+        Hasher hasher = new_hasher();
+        hash(usize)(&hasher, i * 4);
+        positions.new_hashes[i] = finish_hash(hasher);
+    }
+    positions.len = 100000;
+    print_collisions(positions);
+    keys_free(&positions);
+
+    // function types, as pairs of type ids.
+    Keys function_types = keys_new("function types", 256 * 256);
+    for (usize input = 0; input < 256; input++) {
+        for (usize output = 0; output < 256; output++) {
+            usize i = function_types.len++;
+            function_types.old_hashes[i] =
+                old_hash_step(old_hash_step(0, input), output);
+            Hasher hasher = new_hasher();
+            hash(usize)(&hasher, input);
+            hash(usize)(&hasher, output);
+            function_types.new_hashes[i] = finish_hash(hasher);
+        }
+    }
+    print_collisions(function_types);
+    keys_free(&function_types);
+
+    // generated names, and labels of the assembler.
+    Keys names = keys_new("names c<N>", 100000);
+    Keys labels = keys_new("labels loop_<N>_end", 100000);
+    for (usize i = 0; i < 100000; i++) {
+        char buffer[32];
+        int len = snprintf(buffer, sizeof(buffer), "c%zu", i);
+        push_string(&names, (String){ buffer, (usize)len });
+        len = snprintf(buffer, sizeof(buffer), "loop_%zu_end", i);
+        push_string(&labels, (String){ buffer, (usize)len });
+    }
+    print_collisions(names);
+    print_collisions(labels);
+    keys_free(&names);
+    keys_free(&labels);
+
+    return 0;
+}
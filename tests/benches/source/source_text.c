@@ -0,0 +1,66 @@
+#include <stdio.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+#include "source/source.h"
+
+// Loads a generated source file of a few megabytes like a clean compile
+// would, by reading it and indexing its lines, or by mapping it. The first
+// diagnostic of a mapped file pays for the index.
+//
+// usage: bench_source_text [megabytes]
+
+#define SOURCE_PATH "bench_source_text.cough"
+#define RUNS 5
+
+int main(int argc, char const* argv[]) {
+    usize size = bench_arg(argc, argv, 64) << 20;
+    FILE* file = fopen(SOURCE_PATH, "wb");
+    assert(file);
+    usize written = 0;
+    for (usize i = 0; written < size; i++) {
+        int len = fprintf(file, "constant_%zu :: fn x: Bool -> Bool => x;\n", i);
+        written += len;
+    }
+    fclose(file);
+
+    f64 read_time = 0;
+    f64 open_time = 0;
+    f64 index_time = 0;
+    usize checksum = 0;
+    for (usize run = 0; run < RUNS; run++) {
+        f64 start = bench_now();
+        file = fopen(SOURCE_PATH, "rb");
+        StringBuf text = string_buf_new();
+        read_file(file, &text);
+        fclose(file);
+        SourceText read = source_text_new(SOURCE_PATH, text.data);
+        checksum += source_text_position(&read, 0).line;
+        f64 time = bench_now() - start;
+        read_time = (run == 0 || time < read_time) ? time : read_time;
+        source_text_free(&read);
+        string_buf_free(&text);
+
+        start = bench_now();
+        SourceText mapped;
+        source_text_open(SOURCE_PATH, &mapped);
+        // touches every page, like tokenizing would
+        for (usize i = 0; i < mapped.len; i += 4096) {
+            checksum += mapped.text[i];
+        }
+        time = bench_now() - start;
+        open_time = (run == 0 || time < open_time) ? time : open_time;
+        start = bench_now();
+        checksum += source_text_position(&mapped, mapped.len / 2).line;
+        time = bench_now() - start;
+        index_time = (run == 0 || time < index_time) ? time : index_time;
+        source_text_free(&mapped);
+    }
+    remove(SOURCE_PATH);
+
+    printf("%.1f MB (checksum %zu)\n", (f64)written / 1e6, checksum);
+    printf("read and indexed  %8.3f ms\n", read_time * 1e3);
+    printf("mapped            %8.3f ms\n", open_time * 1e3);
+    printf("first position    %8.3f ms\n", index_time * 1e3);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+#include "collections/string.h"
+#include "alloc/tracking.h"
+
+// Tokenizes a generated source of constants, with identifiers of a few
+// lengths, every keyword and every punctuation, and reports the throughput of
+// the best of a few runs. The source is tokenized whole, then streamed in
+// chunks to a sink that only counts the tokens. Tracking builds also report
+// the peak memory of the tokenizer.
+//
+// usage: bench_tokenizer [megabytes]
+
+#define RUNS 5
+
+// copies the source, like reading a file would.
+typedef struct MemoryReader {
+    SourceReader base;
+    String source;
+    usize pos;
+} MemoryReader;
+
+static Errno memory_read(SourceReader* raw, char* buffer, usize capacity, usize* len) {
+    MemoryReader* self = (MemoryReader*)raw;
+    usize left = self->source.len - self->pos;
+    *len = left < capacity ? left : capacity;
+    memcpy(buffer, self->source.data + self->pos, *len);
+    self->pos += *len;
+    return 0;
+}
+
+static SourceReaderVTable const memory_reader_vtable = { .read = memory_read };
+
+typedef struct CountingSink {
+    TokenSink base;
+    usize count;
+} CountingSink;
+
+static void counting_push(TokenSink* raw, TokenStream const* batch) {
+    ((CountingSink*)raw)->count += batch->kinds.len;
+}
+
+static TokenSinkVTable const counting_sink_vtable = { .push = counting_push };
+
+static void print_throughput(char const* name, usize size, usize tokens, f64 time) {
+    printf(
+        "%-8s %.3f ms, %.1f Mtokens/s, %.1f MB/s, peak %zu KiB\n",
+        name,
+        time * 1e3,
+        (f64)tokens / time / 1e6,
+        (f64)size / time / 1e6,
+        alloc_stats(ALLOC_STAGE_TOKENIZER).peak >> 10
+    );
+}
+
+int main(int argc, char const* argv[]) {
+    usize size = bench_arg(argc, argv, 16) << 20;
+    StringBuf text = string_buf_new();
+    for (usize i = 0; text.len < size; i++) {
+        format_into(
+            &text,
+            "constant_%zu :: fn x: Bool -> Bool =>\n"
+            "    wrap_%zu(let_it_be(x)) & (true) & f(false);\n"
+            "\tvariable_name_%zu := (fn y: Bool => y)(x) = true;\n",
+            i, i % 97, i
+        );
+    }
+    String source = { .data = text.data, .len = text.len };
+
+    SourceText source_text = source_text_new(NULL, text.data);
+    // benches are built without assertions, and errors crash the reporter
+    CrashingReporter reporter = crashing_reporter_new(source_text);
+    f64 best = 0;
+    usize token_count = 0;
+    alloc_stats_reset();
+    for (usize run = 0; run < RUNS; run++) {
+        Interner interner = interner_new();
+        TokenStream tokens;
+        f64 start = bench_now();
+        tokenize(source, &interner, &reporter.base, &tokens);
+        f64 time = bench_now() - start;
+        if (run == 0 || time < best) {
+            best = time;
+        }
+        token_count = tokens.kinds.len;
+        token_stream_free(&tokens);
+        interner_free(&interner);
+    }
+    printf("%.1f MB, %zu tokens\n", (f64)text.len / 1e6, token_count);
+    print_throughput("whole", text.len, token_count, best);
+
+    alloc_stats_reset();
+    for (usize run = 0; run < RUNS; run++) {
+        Interner interner = interner_new();
+        MemoryReader reader = { .base.vtable = &memory_reader_vtable, .source = source };
+        CountingSink sink = { .base.vtable = &counting_sink_vtable };
+        f64 start = bench_now();
+        tokenize_stream(&reader.base, 0, &interner, &reporter.base, &sink.base);
+        f64 time = bench_now() - start;
+        if (run == 0 || time < best) {
+            best = time;
+        }
+        token_count = sink.count;
+        interner_free(&interner);
+    }
+    print_throughput("streamed", text.len, token_count, best);
+
+    source_text_free(&source_text);
+    string_buf_free(&text);
+    return 0;
+}
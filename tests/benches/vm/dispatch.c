@@ -0,0 +1,74 @@
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+
+// Measures the dispatch cost per instruction of each VM engine on a countdown
+// loop. The reference engine decodes the `Bytecode` at every step, while the
+// other engines run the `VmProgram` decoded by `vm_new`, lowered to registers
+// for the register engine. Times are per stack instruction for all engines.
+//
+// usage: bench_vm_dispatch [iterations]
+
+#define LOOP_INSTRUCTIONS 8
+#define OTHER_INSTRUCTIONS 5
+
+int main(int argc, char const* argv[]) {
+    u64 iterations = bench_arg(argc, argv, 10000000);
+
+    char init[64];
+    snprintf(init, sizeof(init), "   sca %" PRIu64, iterations);
+    char const* assembly[] = {
+        "   res 1",
+        init,
+        "   set %0",
+        ":loop",
+        "   var %0",
+        "   sca -1",
+        "   adu",
+        "   set %0",
+        "   var %0",
+        "   sca 0",
+        "   neu",
+        "   jnz :loop",
+        "   sca 0",
+        "   sys exit",
+    };
+    Bytecode bytecode =
+        assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char const*));
+    u64 instructions = LOOP_INSTRUCTIONS * iterations + OTHER_INSTRUCTIONS;
+
+    printf("%" PRIu64 " instructions per run\n", instructions);
+    for (usize engine = 0; engine < VM_ENGINES_LEN; engine++) {
+        TestVmSystem vm_system = test_vm_system_new();
+        TestReporter reporter = test_reporter_new();
+        VmOptions options = vm_default_options();
+        options.engine = engine;
+
+        Vm vm = vm_new_with_options(
+            (VmSystem*)&vm_system,
+            bytecode,
+            (Reporter*)&reporter,
+            options
+        );
+        f64 start = bench_now();
+        vm_run(&vm);
+        f64 elapsed = bench_now() - start;
+        vm_free(&vm);
+
+        assert(vm_system.syscalls.len == 1);
+        assert(vm_system.syscalls.data[0].kind == SYS_EXIT);
+        printf(
+            "%-10s %10.3f ms %8.3f ns/instruction\n",
+            vm_engine_names[engine],
+            elapsed * 1e3,
+            elapsed * 1e9 / (f64)instructions
+        );
+
+        test_vm_system_free(vm_system);
+        test_reporter_free(reporter);
+    }
+
+    return 0;
+}
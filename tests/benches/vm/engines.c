@@ -0,0 +1,184 @@
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "tests/common.h"
+#include "benches/bench.h"
+
+// Compares the stack engines with the register engine on the fibonacci and
+// function_call test programs, each called in a loop by the entry point.
+//
+// Prints the number of instructions of each program, as run by the engine,
+// and the wall time per call. Configure with -DCOUGH_VM_COUNT_INSTRUCTIONS=ON
+// to also count the instructions run per call.
+//
+// usage: bench_vm_engines [calls]
+
+// `NULL` stands for `sca <calls>`.
+static char const* fibonacci[] = {
+    "   res 2",
+    NULL,
+    "   set %1",
+    ":again",
+    "   sca 90",
+    "   loc :fibonacci",
+    "   cal",
+    "   set %0",
+    "   var %1",
+    "   sca -1",
+    "   adu",
+    "   set %1",
+    "   var %1",
+    "   sca 0",
+    "   neu",
+    "   jnz :again",
+    "   sys dbg %0",
+    "   sca 0",
+    "   sys exit",
+
+    ":fibonacci",
+    "   res 3",
+    "   set %0",
+    "   var %0",
+    "   sca 1",
+    "   gtu",
+    "   jnz :loop_start",
+    "   var %0",
+    "   ret",
+    ":loop_start",
+    "   sca 0",
+    "   set %1",
+    "   sca 1",
+    "   set %2",
+    ":loop_body",
+    "   var %1",
+    "   var %2",
+    "   adu",
+    "   var %2",
+    "   set %1",
+    "   set %2",
+    "   var %0",
+    "   sca -1",
+    "   adu",
+    "   set %0",
+    "   var %0",
+    "   sca 2",
+    "   geu",
+    "   jnz :loop_body",
+    "   var %2",
+    "   ret",
+};
+
+static char const* function_call[] = {
+    "   res 1",
+    NULL,
+    "   set %0",
+    ":again",
+    "   loc :foo",
+    "   cal",
+    "   pop",
+    "   var %0",
+    "   sca -1",
+    "   adu",
+    "   set %0",
+    "   var %0",
+    "   sca 0",
+    "   neu",
+    "   jnz :again",
+    "   sca 0",
+    "   sys exit",
+
+    ":foo",
+    "   res 1",
+    "   sys hi",
+    "   sca 21",
+    "   loc :bar",
+    "   cal",
+    "   set %0",
+    "   sys dbg %0",
+    "   sca -1",
+    "   ret",
+
+    ":bar",
+    "   res 1",
+    "   set %0",
+    "   var %0",
+    "   var %0",
+    "   adu",
+    "   ret",
+};
+
+static usize program_len(Vm const* vm) {
+    if (vm->options.engine == VM_ENGINE_REGISTER) {
+        return vm->register_program.instructions.len;
+    }
+    // without the trailing invalid instruction
+    return vm->program.instructions.len - 1;
+}
+
+static void bench_program(
+    char const* name,
+    char const** assembly,
+    usize assembly_len,
+    u64 calls
+) {
+    char init[64];
+    snprintf(init, sizeof(init), "   sca %" PRIu64, calls);
+    char const* parts[64];
+    assert(assembly_len <= 64);
+    for (usize i = 0; i < assembly_len; i++) {
+        parts[i] = assembly[i] ? assembly[i] : init;
+    }
+    Bytecode bytecode = assembly_to_bytecode(parts, assembly_len);
+    printf("%s, %" PRIu64 " calls\n", name, calls);
+
+    for (usize engine = 0; engine < VM_ENGINES_LEN; engine++) {
+        BenchVmSystem vm_system = bench_vm_system_new();
+        TestReporter reporter = test_reporter_new();
+        VmOptions options = vm_default_options();
+        options.engine = engine;
+
+        Vm vm = vm_new_with_options(
+            (VmSystem*)&vm_system,
+            bytecode,
+            (Reporter*)&reporter,
+            options
+        );
+        f64 start = bench_now();
+        vm_run(&vm);
+        f64 elapsed = bench_now() - start;
+
+        assert(reporter.error_codes.len == 0);
+        assert(vm_system.exit_code == 0);
+        printf(
+            "  %-10s %4zu instructions %10.3f ms %8.2f ns/call",
+            vm_engine_names[engine],
+            program_len(&vm),
+            elapsed * 1e3,
+            elapsed * 1e9 / (f64)calls
+        );
+#ifdef COUGH_VM_COUNT_INSTRUCTIONS
+        printf(" %8.2f instructions/call", (f64)vm.instruction_count / (f64)calls);
+#endif
+        printf("\n");
+
+        vm_free(&vm);
+        test_reporter_free(reporter);
+    }
+}
+
+int main(int argc, char const* argv[]) {
+    u64 calls = bench_arg(argc, argv, 1000000);
+    bench_program(
+        "fibonacci",
+        fibonacci,
+        sizeof(fibonacci) / sizeof(char const*),
+        calls
+    );
+    bench_program(
+        "function_call",
+        function_call,
+        sizeof(function_call) / sizeof(char const*),
+        calls
+    );
+    return 0;
+}
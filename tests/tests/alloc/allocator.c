@@ -0,0 +1,152 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc/allocator.h"
+#include "collections/array.h"
+#include "collections/hash_map.h"
+#include "collections/string.h"
+
+// counts the bytes that are live on the heap, and refuses to go past a limit.
+typedef struct CountingAllocator {
+    Allocator base;
+    usize live;
+    usize peak;
+    usize limit;
+    usize refused;
+} CountingAllocator;
+
+static bool counting_admit(CountingAllocator* self, usize old_size, usize new_size) {
+    usize live = self->live - old_size + new_size;
+    if (live > self->limit) {
+        self->refused++;
+        return false;
+    }
+    self->live = live;
+    if (live > self->peak) {
+        self->peak = live;
+    }
+    return true;
+}
+
+static void* counting_alloc(Allocator* self, usize size, usize alignment) {
+    CountingAllocator* allocator = (CountingAllocator*)self;
+    return counting_admit(allocator, 0, size) ? malloc(size) : NULL;
+}
+
+static void* counting_realloc(
+    Allocator* self,
+    void* ptr,
+    usize old_size,
+    usize new_size,
+    usize alignment
+) {
+    CountingAllocator* allocator = (CountingAllocator*)self;
+    return counting_admit(allocator, old_size, new_size)
+        ? realloc(ptr, new_size)
+        : NULL;
+}
+
+static void counting_free(Allocator* self, void* ptr, usize size) {
+    CountingAllocator* allocator = (CountingAllocator*)self;
+    if (ptr != NULL) {
+        allocator->live -= size;
+    }
+    free(ptr);
+}
+
+static const AllocatorVTable counting_allocator_vtable = {
+    .alloc = counting_alloc,
+    .realloc = counting_realloc,
+    .free = counting_free,
+};
+
+int main(int argc, char const* argv[]) {
+    CountingAllocator counting = {
+        .base.vtable = &counting_allocator_vtable,
+        .limit = 1 << 20,
+    };
+    Allocator* allocator = &counting.base;
+
+    // the collections go through the allocator, and give back what they got.
+    ArrayBuf(usize) numbers = array_buf_new_in(usize)(allocator);
+    HashMap(usize, usize) squares = hash_map_new_in(usize, usize)(allocator);
+    StringBuf text = string_buf_new_in(allocator);
+    for (usize i = 0; i < 1000; i++) {
+        array_buf_push(usize)(&numbers, i);
+        hash_map_insert(usize, usize)(&squares, i, i * i);
+        string_buf_push(&text, 'a' + i % 26);
+    }
+    assert(counting.live >= numbers.capacity * sizeof(usize) + text.capacity);
+    for (usize i = 0; i < 1000; i++) {
+        assert(numbers.data[i] == i);
+        assert(*hash_map_get(usize, usize)(squares, i) == i * i);
+        assert(text.data[i] == 'a' + (char)(i % 26));
+    }
+    usize peak = counting.peak;
+    assert(peak >= counting.live);
+
+    array_buf_free(usize)(&numbers);
+    hash_map_free(usize, usize)(&squares);
+    string_buf_free(&text);
+    assert(counting.live == 0);
+    assert(counting.peak == peak);
+
+    // past the limit, allocations fail instead of growing.
+    counting.limit = 64;
+    assert(allocator->vtable->alloc(allocator, 128, 1) == NULL);
+    assert(counting.refused == 1);
+
+    // collections see the refusal through their `try_` functions, and keep
+    // what they had.
+    counting.limit = 1 << 10;
+    ArrayBuf(usize) capped = array_buf_new_in(usize)(allocator);
+    usize pushed = 0;
+    while (array_buf_try_push(usize)(&capped, pushed)) {
+        pushed++;
+    }
+    assert(counting.refused == 2);
+    assert(pushed > 0 && pushed * sizeof(usize) <= counting.limit);
+    assert(capped.len == pushed);
+    for (usize i = 0; i < pushed; i++) {
+        assert(capped.data[i] == i);
+    }
+    StringBuf capped_text = string_buf_new_in(allocator);
+    assert(!string_buf_try_reserve(&capped_text, counting.limit));
+    assert(counting.refused == 3);
+    assert(capped_text.len == 0 && capped_text.data == NULL);
+    array_buf_free(usize)(&capped);
+    string_buf_free(&capped_text);
+    assert(counting.live == 0);
+
+    HashMap(usize, usize) capped_squares =
+        hash_map_new_in(usize, usize)(allocator);
+    usize inserted = 0;
+    while (
+        hash_map_try_insert(usize, usize)(
+            &capped_squares,
+            inserted,
+            inserted * inserted
+        )
+    ) {
+        inserted++;
+    }
+    assert(counting.refused == 4);
+    assert(inserted > 0 && capped_squares.len == inserted);
+    for (usize i = 0; i < inserted; i++) {
+        assert(*hash_map_get(usize, usize)(capped_squares, i) == i * i);
+    }
+    assert(hash_map_get(usize, usize)(capped_squares, inserted) == NULL);
+    // keys already in the map are replaced without growing it.
+    assert(hash_map_try_insert(usize, usize)(&capped_squares, 0, 1));
+    assert(*hash_map_get(usize, usize)(capped_squares, 0) == 1);
+    hash_map_free(usize, usize)(&capped_squares);
+    assert(counting.live == 0);
+
+    // the heap is the default.
+    void* ptr = allocator_alloc(&heap_allocator, 16, 8);
+    ptr = allocator_realloc(&heap_allocator, ptr, 16, 32, 8);
+    memset(ptr, 0, 32);
+    allocator_free(&heap_allocator, ptr, 32);
+    return 0;
+}
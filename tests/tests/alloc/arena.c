@@ -0,0 +1,57 @@
+#include <assert.h>
+#include <string.h>
+
+#include "alloc/arena.h"
+#include "collections/array.h"
+#include "collections/hash_map.h"
+
+int main(int argc, char const* argv[]) {
+    Arena* arena = arena_new(256);
+
+    // allocations are aligned and do not overlap.
+    char* a = arena_alloc(arena, 3, 1);
+    u64* b = arena_alloc(arena, sizeof(u64), alignof(u64));
+    assert((uptr)b % alignof(u64) == 0);
+    assert((char*)b >= a + 3);
+    memset(a, 0xaa, 3);
+    *b = 42;
+
+    // the last allocation grows in place while its chunk has room.
+    char* c = arena_alloc(arena, 16, 1);
+    assert(arena_realloc(arena, c, 16, 64, 1) == c);
+    // other ones are copied.
+    u64* d = arena_realloc(arena, b, sizeof(u64), 2 * sizeof(u64), alignof(u64));
+    assert(d != b && *d == 42);
+
+    // allocations larger than chunks get their own.
+    char* big = arena_alloc(arena, 4096, 16);
+    memset(big, 0, 4096);
+    assert(arena->allocated >= 3 + 4096);
+
+    // collections can live in the arena, and are freed with it.
+    ArrayBuf(usize) numbers = array_buf_new_in(usize)(&arena->base);
+    HashMap(usize, usize) squares = hash_map_new_in(usize, usize)(&arena->base);
+    for (usize i = 0; i < 1000; i++) {
+        array_buf_push(usize)(&numbers, i);
+        hash_map_insert(usize, usize)(&squares, i, i * i);
+    }
+    for (usize i = 0; i < 1000; i++) {
+        assert(numbers.data[i] == i);
+        assert(*hash_map_get(usize, usize)(squares, i) == i * i);
+    }
+    // freeing them is a no-op.
+    array_buf_free(usize)(&numbers);
+    hash_map_free(usize, usize)(&squares);
+
+    arena_free(arena);
+
+    // chunks smaller than the arena itself still leave room for it.
+    Arena* tiny = arena_new(16);
+    for (usize i = 0; i < 64; i++) {
+        u64* value = arena_alloc(tiny, sizeof(u64), alignof(u64));
+        *value = i;
+    }
+    assert(tiny->allocated == 64 * sizeof(u64));
+    arena_free(tiny);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "alloc/tracking.h"
+#include "compiler/compiler.h"
+
+int main(void) {
+    String source = STRING_LITERAL(
+        "wrap :: fn x: Bool -> Bool => identity(x);\n"
+        "identity :: fn y: Bool -> Bool => y;\n"
+    );
+    alloc_stats_reset();
+
+    // growing an array reallocates, and charges the stage it runs in.
+    AllocStage stage = alloc_stage_enter(ALLOC_STAGE_EMITTER);
+    ArrayBuf(usize) numbers = array_buf_new(usize)();
+    for (usize i = 0; i < 1000; i++) {
+        array_buf_push(usize)(&numbers, i);
+    }
+    alloc_stage_leave(stage);
+    AllocStats grown = alloc_stats(ALLOC_STAGE_EMITTER);
+    array_buf_free(usize)(&numbers);
+    AllocStats freed = alloc_stats(ALLOC_STAGE_EMITTER);
+
+    TestReporter reporter = test_reporter_new();
+    Bytecode bytecode;
+    assert(compile(source, &reporter.base, &bytecode));
+
+#ifdef COUGH_ALLOC_TRACKING
+    assert(grown.allocations == 1);
+    assert(grown.reallocations > 1);
+    assert(grown.bytes >= 1000 * sizeof(usize));
+    assert(grown.live >= 1000 * sizeof(usize));
+    assert(grown.peak == grown.live);
+    assert(freed.frees == 1);
+    assert(freed.live == 0);
+    assert(freed.peak == grown.peak);
+
+    // each stage of the compilation allocated something, but the analyzer
+    // that bumps its bindings from the arena of the parser.
+    AllocStage compiled[] = {
+        ALLOC_STAGE_TOKENIZER,
+        ALLOC_STAGE_PARSER,
+        ALLOC_STAGE_EMITTER,
+    };
+    for (usize i = 0; i < sizeof(compiled) / sizeof(*compiled); i++) {
+        AllocStats stats = alloc_stats(compiled[i]);
+        assert(stats.allocations + stats.reallocations > 0);
+        assert(stats.peak > 0);
+    }
+    AllocStats total = alloc_stats(ALLOC_STAGES_LEN);
+    assert(total.allocations >= grown.allocations);
+    assert(total.peak >= grown.peak);
+#else
+    assert(grown.allocations == 0 && freed.peak == 0);
+    assert(alloc_stats(ALLOC_STAGES_LEN).allocations == 0);
+#endif
+
+    // the report has a line per stage and one for the total.
+    FILE* file = tmpfile();
+    alloc_report(file);
+    rewind(file);
+    char line[256];
+    usize lines = 0;
+    bool has_tokenizer = false;
+    while (fgets(line, sizeof(line), file)) {
+        lines++;
+        has_tokenizer |= strncmp(line, "tokenizer ", 10) == 0;
+    }
+    fclose(file);
+    assert(lines == 1 + ALLOC_STAGES_LEN + 1);
+    assert(has_tokenizer);
+    return 0;
+}
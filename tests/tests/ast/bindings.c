@@ -0,0 +1,58 @@
+#include "tests/common.h"
+
+#include "ast/binding.h"
+
+static ValueBinding variable(Atom name, usize index) {
+    return (ValueBinding){
+        .name = name,
+        .type = TYPE_BOOL,
+        .store = {
+            .kind = VALUE_STORE_VARIABLE,
+            .as.variable = { .index = index, .function_id = 0 },
+        },
+    };
+}
+
+int main(int argc, char const** argv) {
+    enum { A, B, C, MISSING };
+    BindingRegistry registry = binding_registry_new();
+
+    ScopeLocation root = scope_end_location(registry, ROOT_SCOPE_ID);
+    BindingMut a;
+    assert(insert_value_binding(&registry, ROOT_SCOPE_ID, variable(A, 0), &a));
+    assert(!insert_value_binding(&registry, ROOT_SCOPE_ID, variable(A, 1), NULL));
+
+    // sequential bindings are only visible after their position
+    ScopeLocation inner = scope_new(&registry, root);
+    ScopeLocation before_b = inner;
+    BindingMut b;
+    assert(push_value_binding(&registry, &inner, variable(B, 2), &b));
+    ScopeLocation before_c = inner;
+    BindingMut c;
+    assert(push_value_binding(&registry, &inner, variable(C, 3), &c));
+    assert(!push_value_binding(&registry, &inner, variable(B, 4), NULL));
+    assert(c.location._pos == 1);
+
+    BindingId found;
+    assert(!find_binding(registry, before_b, B, &found));
+    assert(find_binding(registry, before_c, B, &found) && found == b.id);
+    assert(!find_binding(registry, before_c, C, &found));
+    assert(find_binding(registry, inner, C, &found) && found == c.id);
+    assert(find_binding(registry, inner, A, &found) && found == a.id);
+    assert(!find_binding(registry, inner, MISSING, &found));
+
+    // a nested scope shadows the names of its parents
+    ScopeLocation nested = scope_new(&registry, inner);
+    BindingMut shadow;
+    assert(push_value_binding(&registry, &nested, variable(A, 5), &shadow));
+    assert(find_binding(registry, nested, A, &found) && found == shadow.id);
+
+    Binding view = get_binding(registry, found);
+    assert(view.kind == BINDING_VALUE);
+    assert(view.as.value->name == A);
+    assert(view.as.value->store.as.variable.index == 5);
+    assert(view.location.scope_id == nested.scope_id);
+
+    binding_registry_free(&registry);
+    return 0;
+}
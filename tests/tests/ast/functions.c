@@ -11,7 +11,10 @@ int main(int argc, char const** argv) {
     // we don't repeat tests conducted in ast/identity_fn
 
     ConstantDef wrap_def = ast.root.global_constants.data[0];
-    assert(eq(String)(wrap_def.name.string, STRING_LITERAL("wrap")));
+    assert(eq(String)(
+        atom_string(*ast.interner, wrap_def.name.atom),
+        STRING_LITERAL("wrap")
+    ));
     Expression wrap_value = ast.expressions.data[wrap_def.value];
     assert(wrap_value.kind == EXPRESSION_FUNCTION);
     Function wrap_fn = wrap_value.as.function;
@@ -25,11 +28,17 @@ int main(int argc, char const** argv) {
     assert(lhs.kind == EXPRESSION_VARIABLE);
     Binding lhs_binding = get_binding(ast.bindings, lhs.as.variable.binding);
     assert(lhs_binding.kind == BINDING_VALUE);
-    assert(eq(String)(lhs_binding.as.value.name, STRING_LITERAL("identity")));
+    assert(eq(String)(
+        atom_string(*ast.interner, lhs_binding.as.value->name),
+        STRING_LITERAL("identity")
+    ));
     Expression rhs = ast.expressions.data[call.operand_right];
     assert(rhs.kind == EXPRESSION_VARIABLE);
     Binding rhs_binding = get_binding(ast.bindings, rhs.as.variable.binding);
-    assert(eq(String)(rhs_binding.as.value.name, STRING_LITERAL("x")));
+    assert(eq(String)(
+        atom_string(*ast.interner, rhs_binding.as.value->name),
+        STRING_LITERAL("x")
+    ));
 
     return 0;
 }
@@ -26,13 +26,16 @@ int main(int argc, char const *argv[]) {
     BindingId x_binding_id = identity.input.as.variable.binding;
     Binding x_binding = get_binding(ast.bindings, x_binding_id);
     assert(x_binding.kind == BINDING_VALUE);
-    assert(eq(String)(x_binding.as.value.name, STRING_LITERAL("x")));
-    assert(x_binding.as.value.type == TYPE_BOOL);
-    assert(x_binding.as.value.store.kind == VALUE_STORE_VARIABLE);
+    assert(eq(String)(
+        atom_string(*ast.interner, x_binding.as.value->name),
+        STRING_LITERAL("x")
+    ));
+    assert(x_binding.as.value->type == TYPE_BOOL);
+    assert(x_binding.as.value->store.kind == VALUE_STORE_VARIABLE);
 
     Expression output = ast.expressions.data[identity.output];
     assert(output.kind == EXPRESSION_VARIABLE);
-    assert(eq(String)(output.as.variable.name.string, STRING_LITERAL("x")));
+    assert(output.as.variable.name.atom == x_binding.as.value->name);
     assert(output.as.variable.binding == x_binding_id);
 
     return 0;
@@ -29,5 +29,32 @@ int main(int argc, char const* argv[]) {
         assert(foo.id == i);
     }
 
+    // elements appended in a batch are filled in by the caller.
+    Foo* batch = array_buf_extend_n(Foo)(&foos, 3);
+    for (usize i = 0; i < 3; i++) {
+        batch[i] = (Foo){ 10 + i };
+    }
+    assert(foos.len == 13);
+    assert(array_buf_pop(Foo)(&foos).id == 12);
+    assert(foos.len == 12);
+
+    // exact reservations do not round up, and shrinking gives back the rest.
+    array_buf_reserve_exact(Foo)(&foos, 100);
+    assert(foos.capacity == foos.len + 100);
+    array_buf_reserve(Foo)(&foos, 100);
+    assert(foos.capacity == foos.len + 100);
+    array_buf_shrink_to_fit(Foo)(&foos);
+    assert(foos.capacity == foos.len);
+    for (usize i = 0; i < foos.len; i++) {
+        assert(foos.data[i].id == i);
+    }
+    array_buf_push(Foo)(&foos, (Foo){ 12 });
+    assert(foos.capacity > foos.len);
+
+    foos.len = 0;
+    array_buf_shrink_to_fit(Foo)(&foos);
+    assert(foos.data == NULL && foos.capacity == 0);
+    array_buf_free(Foo)(&foos);
+
     return 0;
 }
@@ -60,6 +60,34 @@ int main(int argc, char const* argv[]) {
 
     hash_map_free(Person, i32)(&ages);
 
+    // enough keys to grow across many groups, and to reuse deleted slots.
+    HashMap(usize, usize) squares = hash_map_new(usize, usize)();
+    for (usize i = 0; i < 10000; i++) {
+        hash_map_insert(usize, usize)(&squares, i * 64, i * i);
+    }
+    assert(squares.len == 10000);
+    hash_map_insert(usize, usize)(&squares, 64, 2);
+    assert(squares.len == 10000);
+    assert(*hash_map_get(usize, usize)(squares, 64) == 2);
+    for (usize i = 0; i < 10000; i += 2) {
+        hash_map_remove(usize, usize)(&squares, i * 64);
+    }
+    assert(squares.len == 5000);
+    for (usize round = 0; round < 4; round++) {
+        for (usize i = 0; i < 10000; i += 2) {
+            hash_map_insert(usize, usize)(&squares, i * 64 + 1, i);
+        }
+        for (usize i = 0; i < 10000; i += 2) {
+            hash_map_remove(usize, usize)(&squares, i * 64 + 1);
+        }
+    }
+    assert(squares.len == 5000);
+    for (usize i = 3; i < 10000; i += 2) {
+        assert(*hash_map_get(usize, usize)(squares, i * 64) == i * i);
+        assert(hash_map_get(usize, usize)(squares, (i - 1) * 64) == NULL);
+    }
+    hash_map_free(usize, usize)(&squares);
+
     return 0;
 }
 
@@ -0,0 +1,32 @@
+#include <assert.h>
+
+#include "collections/interner.h"
+
+int main(int argc, char const* argv[]) {
+    Interner interner = interner_new();
+
+    Atom x = intern(&interner, STRING_LITERAL("x"));
+    Atom identity = intern(&interner, STRING_LITERAL("identity"));
+    assert(x == 0);
+    assert(identity == 1);
+
+    // equal strings from other places still have the same atom
+    char const source[] = "identity x";
+    assert(intern(&interner, (String){ .data = source, .len = 8 }) == identity);
+    assert(intern(&interner, (String){ .data = source + 9, .len = 1 }) == x);
+    assert(intern(&interner, (String){ .data = source, .len = 1 }) == 2);
+
+    assert(eq(String)(atom_string(interner, x), STRING_LITERAL("x")));
+    assert(eq(String)(atom_string(interner, identity), STRING_LITERAL("identity")));
+    assert(eq(String)(atom_string(interner, 2), STRING_LITERAL("i")));
+
+    // every prefix of "identity", of which "i" and "identity" are known
+    for (usize i = 0; i < 1000; i++) {
+        String prefix = { .data = "identity", .len = i % 9 };
+        assert(eq(String)(atom_string(interner, intern(&interner, prefix)), prefix));
+    }
+    assert(interner._strings.len == 10);
+
+    interner_free(&interner);
+    return 0;
+}
@@ -32,5 +32,45 @@ int main(int argc, char const* argv[]) {
     eprintf("formatted: %s\n", formatted.data);
     assert(!strcmp(formatted.data, "My favorite number is 42!"));
 
+    // empty results are still strings.
+    StringBuf empty = format("%s", "");
+    assert(empty.data && empty.len == 0 && !strcmp(empty.data, ""));
+    string_buf_free(&empty);
+    StringBuf fresh = string_buf_new();
+    format_into(&fresh, "%s", "");
+    assert(fresh.data && fresh.len == 0 && !strcmp(fresh.data, ""));
+    string_buf_free(&fresh);
+
+    // formatting appends, and grows the buffer when it does not fit.
+    format_into(&formatted, " And %s", "yours?");
+    assert(!strcmp(formatted.data, "My favorite number is 42! And yours?"));
+    assert(formatted.len == strlen(formatted.data));
+    string_buf_reserve(&formatted, 64);
+    char* data = formatted.data;
+    format_into(&formatted, " %d", 7);
+    assert(formatted.data == data);
+    assert(!strcmp(formatted.data, "My favorite number is 42! And yours? 7"));
+    string_buf_free(&formatted);
+
+    // short strings stay in the storage of small buffers.
+    SmallStringBuf small;
+    small_string_buf_init(&small);
+    assert(small.buf.len == 0 && !strcmp(small.buf.data, ""));
+    format_into(&small.buf, "invalid %s", "token");
+    string_buf_push(&small.buf, '!');
+    assert(!strcmp(small.buf.data, "invalid token!"));
+    assert(small.buf.data == small._storage);
+
+    // and move out of it when they outgrow it.
+    for (usize i = 0; i < SMALL_STRING_BUF_CAPACITY; i++) {
+        format_into(&small.buf, "%zu", i % 10);
+    }
+    assert(small.buf.data != small._storage);
+    assert(small.buf.len == 14 + SMALL_STRING_BUF_CAPACITY);
+    assert(!strncmp(small.buf.data, "invalid token!0123456789", 24));
+    assert(small.buf.data[small.buf.len] == '\0');
+    string_buf_free(&small.buf);
+    string_buf_free(&string);
+
     return 0;
 }
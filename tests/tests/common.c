@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "tests/common.h"
 
 #include "source/source.h"
@@ -55,8 +57,8 @@ static void crashing_report_message(Reporter* raw, StringBuf message) {
 
 static void crashing_report_souce_code(Reporter* raw, Range source) {
     CrashingReporter* self = (CrashingReporter*)raw;
-    LineColumn start = source_text_position(self->source, source.start);
-    LineColumn end = source_text_position(self->source, source.end);
+    LineColumn start = source_text_position(&self->source, source.start);
+    LineColumn end = source_text_position(&self->source, source.end);
     char const* path = self->source.path ? self->source.path : "<stdin>";
     eprintf(
         "at %s:%zu:%zu-%zu:%zu: %.*s\n",
@@ -146,11 +148,31 @@ void test_vm_system_free(TestVmSystem system) {
     array_buf_free(SyscallRecord)(&system.syscalls);
 }
 
+VmOptions test_vm_options(int argc, char const* argv[]) {
+    VmOptions options = vm_default_options();
+    // test programs are short, compile every function on its first call.
+    options.jit_threshold = 0;
+    if (argc < 2) {
+        return options;
+    }
+    for (usize i = 0; i < VM_ENGINES_LEN; i++) {
+        if (!strcmp(argv[1], vm_engine_names[i])) {
+            options.engine = i;
+            return options;
+        }
+    }
+    eprintf("unknown VM engine `%s`\n", argv[1]);
+    exit(-1);
+}
+
 Ast source_to_ast(String text) {
     SourceText source = source_text_new(NULL, text.data);
     TokenStream tokens;
     CrashingReporter reporter = crashing_reporter_new(source);
-    assert(tokenize(text, &reporter.base, &tokens));
+    // like the rest of the pipeline, the interner lives as long as the test
+    Interner* interner = malloc_or_exit(sizeof(Interner));
+    *interner = interner_new();
+    assert(tokenize(text, interner, &reporter.base, &tokens));
     Ast ast;
     assert(parse(tokens, &reporter.base, &ast));
     assert(analyze(&ast, &reporter.base));
@@ -161,12 +183,15 @@ Bytecode source_to_bytecode(String text) {
     SourceText source = source_text_new(NULL, text.data);
     TokenStream tokens;
     CrashingReporter reporter = crashing_reporter_new(source);
-    assert(tokenize(text, &reporter.base, &tokens));
+    // like the rest of the pipeline, the interner lives as long as the test
+    Interner* interner = malloc_or_exit(sizeof(Interner));
+    *interner = interner_new();
+    assert(tokenize(text, interner, &reporter.base, &tokens));
     Ast ast;
     assert(parse(tokens, &reporter.base, &ast));
     assert(analyze(&ast, &reporter.base));
     Emitter emitter = emitter_new();
-    generate(&ast, &emitter);
+    assert(generate(&ast, &emitter));
     Bytecode bytecode;
     assert(emitter_finish(&emitter, &bytecode));
     return bytecode;
@@ -57,6 +57,9 @@ typedef struct TestVmSystem {
 TestVmSystem test_vm_system_new(void);
 void test_vm_system_free(TestVmSystem system);
 
+// the VM options selected by the test's command line (the engine name, if any).
+VmOptions test_vm_options(int argc, char const* argv[]);
+
 Ast source_to_ast(String source);
 Bytecode source_to_bytecode(String source);
 Bytecode assembly_to_bytecode(char const** parts, usize count);
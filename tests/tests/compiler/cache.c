@@ -0,0 +1,154 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "compiler/cache.h"
+
+#define CACHE_DIRECTORY "test_compile_cache.d"
+
+static bool same_bytecode(Bytecode a, Bytecode b) {
+    return a.instructions.len == b.instructions.len
+        && !memcmp(
+            a.instructions.data,
+            b.instructions.data,
+            a.instructions.len * sizeof(Byteword)
+        );
+}
+
+int main(void) {
+    String source = STRING_LITERAL(
+        "wrap :: fn x: Bool -> Bool => identity(x);\n"
+        "identity :: fn y: Bool -> Bool => y;\n"
+    );
+    String changed = STRING_LITERAL(
+        "wrap :: fn x: Bool -> Bool => x;\n"
+    );
+    Bytecode expected = source_to_bytecode(source);
+    TestReporter reporter = test_reporter_new();
+
+    CompileCache cache = compile_cache_new(CACHE_DIRECTORY);
+    // entries left by earlier runs would turn the first misses into hits.
+    String sources[] = { source, changed };
+    for (usize i = 0; i < 2; i++) {
+        StringBuf path = compile_cache_path(&cache, sources[i]);
+        remove(path.data);
+        string_buf_free(&path);
+    }
+
+    // the first compilation goes through the pipeline and stores its result.
+    CachedBytecode first;
+    assert(compile_cached(&cache, source, &reporter.base, &first));
+    assert(!first.hit);
+    assert(same_bytecode(first.image.bytecode, expected));
+    assert(cache.stats.misses == 1 && cache.stats.stores == 1);
+
+    // the same source is then loaded.
+    CachedBytecode second;
+    assert(compile_cached(&cache, source, &reporter.base, &second));
+    assert(second.hit);
+    assert(same_bytecode(second.image.bytecode, expected));
+    assert(cache.stats.hits == 1 && cache.stats.misses == 1);
+
+    // another source has another entry.
+    CachedBytecode other;
+    assert(compile_cached(&cache, changed, &reporter.base, &other));
+    assert(!other.hit);
+    assert(!same_bytecode(other.image.bytecode, expected));
+    assert(cache.stats.misses == 2);
+    cached_bytecode_free(&other);
+
+    // so does another version of the compiler.
+    CompileCache upgraded = compile_cache_new(CACHE_DIRECTORY);
+    upgraded.version = STRING_LITERAL("a future version");
+    StringBuf old_path = compile_cache_path(&cache, source);
+    StringBuf new_path = compile_cache_path(&upgraded, source);
+    assert(strcmp(old_path.data, new_path.data) != 0);
+    remove(new_path.data);
+    CachedBytecode upgraded_first;
+    assert(compile_cached(&upgraded, source, &reporter.base, &upgraded_first));
+    assert(!upgraded_first.hit);
+    assert(upgraded.stats.misses == 1 && upgraded.stats.hits == 0);
+    cached_bytecode_free(&upgraded_first);
+    remove(new_path.data);
+    string_buf_free(&old_path);
+    string_buf_free(&new_path);
+    compile_cache_free(&upgraded);
+
+    // an entry that is not an image is compiled and stored again.
+    StringBuf path = compile_cache_path(&cache, source);
+    FILE* file = fopen(path.data, "wb");
+    assert(file);
+    fputs("not an image", file);
+    fclose(file);
+    CachedBytecode rewritten;
+    assert(compile_cached(&cache, source, &reporter.base, &rewritten));
+    assert(!rewritten.hit);
+    assert(cache.stats.misses == 3 && cache.stats.stores == 3);
+    cached_bytecode_free(&rewritten);
+    assert(compile_cached(&cache, source, &reporter.base, &rewritten));
+    assert(rewritten.hit);
+    cached_bytecode_free(&rewritten);
+
+    // so is an image whose bytecode does not verify.
+    Bytecode corrupt = first.image.bytecode;
+    corrupt.instructions = array_buf_new(Byteword)();
+    array_buf_extend(Byteword)(
+        &corrupt.instructions,
+        first.image.bytecode.instructions.data,
+        first.image.bytecode.instructions.len
+    );
+    corrupt.instructions.data[0] = OPCODES_LEN;
+    BytecodeImage corrupt_image = first.image;
+    corrupt_image.bytecode = corrupt;
+    file = fopen(path.data, "wb");
+    assert(file);
+    assert(bytecode_image_write(&corrupt_image, file) == IMAGE_OK);
+    fclose(file);
+    array_buf_free(Byteword)(&corrupt.instructions);
+    assert(compile_cached(&cache, source, &reporter.base, &rewritten));
+    assert(!rewritten.hit);
+    assert(cache.stats.rejected == 1 && cache.stats.misses == 4);
+    assert(same_bytecode(rewritten.image.bytecode, expected));
+    cached_bytecode_free(&rewritten);
+    assert(compile_cached(&cache, source, &reporter.base, &rewritten));
+    assert(rewritten.hit);
+    cached_bytecode_free(&rewritten);
+
+    // so is an object, whose locations are not resolved yet.
+    BytecodeImage object = first.image;
+    object.references = array_buf_new(usize)();
+    array_buf_push(usize)(&object.references, 0);
+    file = fopen(path.data, "wb");
+    assert(file);
+    assert(bytecode_image_write(&object, file) == IMAGE_OK);
+    fclose(file);
+    array_buf_free(usize)(&object.references);
+    assert(compile_cached(&cache, source, &reporter.base, &rewritten));
+    assert(!rewritten.hit);
+    assert(cache.stats.rejected == 2 && cache.stats.misses == 5);
+    cached_bytecode_free(&rewritten);
+
+    // even one without references, that only imports symbols.
+    object = first.image;
+    object.symbols = array_buf_new(BytecodeSymbol)();
+    array_buf_push(BytecodeSymbol)(&object.symbols, (BytecodeSymbol){
+        .name = STRING_LITERAL("imported"),
+        .signature = STRING_LITERAL("fn Bool -> Bool"),
+        .offset = BYTECODE_SYMBOL_UNDEFINED,
+    });
+    file = fopen(path.data, "wb");
+    assert(file);
+    assert(bytecode_image_write(&object, file) == IMAGE_OK);
+    fclose(file);
+    array_buf_free(BytecodeSymbol)(&object.symbols);
+    assert(compile_cached(&cache, source, &reporter.base, &rewritten));
+    assert(!rewritten.hit);
+    assert(cache.stats.rejected == 3 && cache.stats.misses == 6);
+    cached_bytecode_free(&rewritten);
+    string_buf_free(&path);
+
+    assert(reporter.error_codes.len == 0);
+    cached_bytecode_free(&first);
+    cached_bytecode_free(&second);
+    compile_cache_free(&cache);
+    return 0;
+}
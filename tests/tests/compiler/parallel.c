@@ -0,0 +1,56 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "compiler/compiler.h"
+
+#define FUNCTIONS 500
+
+static bool same_bytecode(Bytecode a, Bytecode b) {
+    return a.instructions.len == b.instructions.len
+        && !memcmp(
+            a.instructions.data,
+            b.instructions.data,
+            a.instructions.len * sizeof(Byteword)
+        );
+}
+
+int main(void) {
+    // functions calling each other in both directions, with some that define
+    // functions in their bodies and are left to the calling thread.
+    StringBuf text = string_buf_new();
+    for (usize i = 0; i < FUNCTIONS; i++) {
+        if (i % 7 == 3) {
+            format_into(
+                &text,
+                "f%zu :: fn x: Bool -> Bool => (fn y: Bool -> Bool => f%zu(y))(x);\n",
+                i,
+                (i + 1) % FUNCTIONS
+            );
+        } else {
+            format_into(
+                &text,
+                "f%zu :: fn x: Bool -> Bool => f%zu(f%zu(x));\n",
+                i,
+                (i + 1) % FUNCTIONS,
+                (i + FUNCTIONS - 1) % FUNCTIONS
+            );
+        }
+    }
+    String source = { .data = text.data, .len = text.len };
+    Bytecode expected = source_to_bytecode(source);
+
+    usize const threads[] = { 1, 2, 3, 8 };
+    for (usize i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        TestReporter reporter = test_reporter_new();
+        WorkerPool workers = worker_pool_new(threads[i]);
+        Bytecode bytecode;
+        assert(compile_parallel(source, &workers, &reporter.base, &bytecode));
+        assert(same_bytecode(bytecode, expected));
+        array_buf_free(Byteword)(&bytecode.instructions);
+        array_buf_free(Byteword)(&bytecode.rodata);
+        worker_pool_free(&workers);
+        test_reporter_free(reporter);
+    }
+    string_buf_free(&text);
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "disassembler/disassembler.h"
+#include "fuser/fuser.h"
+
+#define MAX_INSTRUCTIONS 32
+
+// decodes every instruction of `bytecode`, with its offset, returns how many.
+static usize decode_all(
+    Bytecode bytecode,
+    BytecodeInstruction* instructions,
+    usize* offsets
+) {
+    Byteword const* const start = bytecode.instructions.data;
+    Byteword const* const end = start + bytecode.instructions.len;
+    Byteword const* ip = start;
+    usize len = 0;
+    while (ip < end) {
+        assert(len < MAX_INSTRUCTIONS);
+        offsets[len] = ip - start;
+        assert(bytecode_decode(&ip, end, &instructions[len]) == DECODE_OK);
+        len++;
+    }
+    return len;
+}
+
+int main(int argc, char const* argv[]) {
+    TestVmSystem vm_system = test_vm_system_new();
+    TestReporter reporter = test_reporter_new();
+
+    char const* assembly[] = {
+        "   res 3",
+        "   sca 7",
+        "   set %0",
+        "   sca 0",
+        "   set %1",
+        "   sca 1",
+        "   set %2",
+        ":loop_body",
+        // fused into `adl %1 %2 %1`, then swapped.
+        "   var %1",
+        "   var %2",
+        "   adu",
+        "   set %1",
+        "   var %1",
+        "   var %2",
+        "   set %1",
+        "   set %2",
+        // fused into `inc %0 -1`.
+        "   var %0",
+        "   sca -1",
+        "   adu",
+        "   set %0",
+        // fused into `jge %0 2 :loop_body`.
+        "   var %0",
+        "   sca 2",
+        "   geu",
+        "   jnz :loop_body",
+        // fused into `adi 0`.
+        "   var %2",
+        "   sca 0",
+        "   adu",
+        // `:not_fused` is jumped to, so this is not fused.
+        "   sca 1",
+        ":not_fused",
+        "   adu",
+        "   set %2",
+        "   sys dbg %2",
+        "   sca 0",
+        "   jnz :not_fused",
+        "   sca 0",
+        "   sys exit",
+    };
+    Bytecode bytecode =
+        assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char*));
+
+    Bytecode fused;
+    bool ok = fuse(bytecode, &fused);
+    assert(ok);
+    assert(fused.instructions.len < bytecode.instructions.len);
+
+    // each sequence is fused in place, and the one jumped into is left as is.
+    {
+        BytecodeInstruction in[MAX_INSTRUCTIONS];
+        usize offsets[MAX_INSTRUCTIONS];
+        usize len = decode_all(fused, in, offsets);
+        Opcode const expected[] = {
+            OP_RES, OP_SCA, OP_SET, OP_SCA, OP_SET, OP_SCA, OP_SET,
+            OP_ADL, OP_VAR, OP_VAR, OP_SET, OP_SET,
+            OP_INC,
+            OP_JGE,
+            OP_VAR, OP_ADI,
+            OP_SCA, OP_ADU, OP_SET, OP_SYS, OP_SCA, OP_JNZ, OP_SCA, OP_SYS,
+        };
+        assert(len == sizeof(expected) / sizeof(Opcode));
+        for (usize i = 0; i < len; i++) {
+            assert(in[i].opcode == expected[i]);
+        }
+
+        assert(in[7].operands[0].var == 1);
+        assert(in[7].operands[1].var == 2);
+        assert(in[7].operands[2].var == 1);
+
+        assert(in[12].operands[0].var == 0);
+        assert(in[12].operands[1].imw.as_int == -1);
+
+        assert(in[13].operands[0].var == 0);
+        assert(in[13].operands[1].imw.as_uint == 2);
+        assert(in[13].operands[2].loc == offsets[7]);
+
+        assert(in[15].operands[0].imw.as_uint == 0);
+
+        assert(in[21].operands[0].loc == offsets[17]);
+    }
+
+    // the fused bytecode round-trips through the disassembler and assembler.
+    StringBuf text;
+    ok = disassemble(fused, &reporter.base, &text);
+    assert(ok);
+    char const* text_parts[] = { text.data };
+    Bytecode reassembled = assembly_to_bytecode(text_parts, 1);
+    assert(reassembled.instructions.len == fused.instructions.len);
+    assert(!memcmp(
+        reassembled.instructions.data,
+        fused.instructions.data,
+        fused.instructions.len * sizeof(Byteword)
+    ));
+
+    Vm vm = vm_new_with_options(
+        (VmSystem*)&vm_system,
+        fused,
+        (Reporter*)&reporter,
+        test_vm_options(argc, argv)
+    );
+    vm_run(&vm);
+
+    assert(vm_system.syscalls.len == 2);
+
+    assert(vm_system.syscalls.data[0].kind == SYS_DBG);
+    assert(vm_system.syscalls.data[0].as.dbg.var_val.as_uint == 14);
+
+    assert(vm_system.syscalls.data[1].kind == SYS_EXIT);
+    assert(vm_system.syscalls.data[1].as.exit.exit_code == 0);
+    vm_free(&vm);
+    test_vm_system_free(vm_system);
+
+    // a jump into the middle of a sequence keeps all of it, so that the
+    // target still has an instruction of its own.
+    char const* jumped_into[] = {
+        "   res 2",
+        "   sca 40",
+        "   set %0",
+        "   sca 1",
+        "   set %1",
+        "   var %0",
+        ":middle",
+        "   var %1",
+        "   adu",
+        "   set %0",
+        "   var %0",
+        "   sca 42",
+        "   geu",
+        "   jnz :done",
+        "   var %0",
+        "   jmp :middle",
+        ":done",
+        "   sys dbg %0",
+        "   sca 0",
+        "   sys exit",
+    };
+    bytecode = assembly_to_bytecode(jumped_into, sizeof(jumped_into) / sizeof(char*));
+    ok = fuse(bytecode, &fused);
+    assert(ok);
+    {
+        BytecodeInstruction in[MAX_INSTRUCTIONS];
+        usize offsets[MAX_INSTRUCTIONS];
+        usize len = decode_all(fused, in, offsets);
+        Opcode const expected[] = {
+            OP_RES, OP_SCA, OP_SET, OP_SCA, OP_SET,
+            OP_VAR, OP_VAR, OP_ADU, OP_SET,
+            OP_JGE,
+            OP_VAR, OP_JMP,
+            OP_SYS, OP_SCA, OP_SYS,
+        };
+        assert(len == sizeof(expected) / sizeof(Opcode));
+        for (usize i = 0; i < len; i++) {
+            assert(in[i].opcode == expected[i]);
+        }
+        assert(in[9].operands[2].loc == offsets[12]);
+        assert(in[11].operands[0].loc == offsets[6]);
+    }
+
+    vm_system = test_vm_system_new();
+    vm = vm_new_with_options(
+        (VmSystem*)&vm_system,
+        fused,
+        (Reporter*)&reporter,
+        test_vm_options(argc, argv)
+    );
+    vm_run(&vm);
+
+    assert(reporter.error_codes.len == 0);
+    assert(vm_system.syscalls.len == 2);
+    assert(vm_system.syscalls.data[0].as.dbg.var_val.as_uint == 42);
+    assert(vm_system.syscalls.data[1].as.exit.exit_code == 0);
+
+    return 0;
+}
@@ -24,8 +24,12 @@ int main(int argc, char const** argv) {
     Bytecode generated = source_to_bytecode(STRING_LITERAL(source));
     Bytecode expected = assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char const*));
     
+    TestReporter reporter = test_reporter_new();
+    StringBuf disassembly;
+    bool ok = disassemble(generated, &reporter.base, &disassembly);
+    assert(ok);
     eprintf("DISASSEMBLY\n");
-    eprintf("%s\n", disassemble(generated).data);
+    eprintf("%s\n", disassembly.data);
     assert(generated.instructions.len == expected.instructions.len);
     assert(memcmp(generated.instructions.data, expected.instructions.data, expected.instructions.len) == 0);
     return 0;
@@ -0,0 +1,158 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "image/image.h"
+
+#define IMAGE_PATH "test_image.cbc"
+
+// writes the image, and loads it back only to tell how that goes.
+static ImageError write_and_load(BytecodeImage const* image) {
+    FILE* file = fopen(IMAGE_PATH, "wb");
+    assert(file);
+    assert(bytecode_image_write(image, file) == IMAGE_OK);
+    fclose(file);
+    BytecodeImage loaded;
+    ImageError error = bytecode_image_load(IMAGE_PATH, &loaded);
+    if (error == IMAGE_OK) {
+        bytecode_image_free(&loaded);
+    }
+    return error;
+}
+
+int main(void) {
+    char const* assembly[] = {
+        "   loc :foo",
+        "   cal",
+        "   sys exit",
+        ":foo",
+        "   res 1",
+        "   sca 21",
+        "   set %0",
+        "   var %0",
+        "   var %0",
+        "   adu",
+        "   set %0",
+        "   sys dbg %0",
+        "   sca 0",
+        "   ret",
+    };
+    Bytecode bytecode = assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char const*));
+    TestReporter reporter = test_reporter_new();
+
+    BytecodeImage image = {
+        .bytecode = bytecode,
+        .symbols = array_buf_new(BytecodeSymbol)(),
+        .references = array_buf_new(usize)(),
+    };
+    assert(bytecode_verify(bytecode, &reporter.base, &image.metadata));
+    usize foo_offset = image.metadata.functions.data[1].offset;
+    array_buf_push(BytecodeSymbol)(
+        &image.symbols,
+        (BytecodeSymbol){ .name = STRING_LITERAL("main"), .offset = 0 }
+    );
+    array_buf_push(BytecodeSymbol)(
+        &image.symbols,
+        (BytecodeSymbol){
+            .name = STRING_LITERAL("foo"),
+            .signature = STRING_LITERAL("fn Bool -> Bool"),
+            .offset = foo_offset,
+        }
+    );
+
+    FILE* file = fopen(IMAGE_PATH, "wb");
+    assert(file);
+    assert(bytecode_image_write(&image, file) == IMAGE_OK);
+    fclose(file);
+
+    // the loaded image has the same contents, and runs like the original.
+    {
+        BytecodeImage loaded;
+        assert(bytecode_image_load(IMAGE_PATH, &loaded) == IMAGE_OK);
+        Bytecode code = loaded.bytecode;
+        assert(code.instructions.len == bytecode.instructions.len);
+        assert(!memcmp(
+            code.instructions.data,
+            bytecode.instructions.data,
+            bytecode.instructions.len * sizeof(Byteword)
+        ));
+        assert(code.rodata.len == 0);
+
+        assert(loaded.symbols.len == 2);
+        BytecodeSymbol foo = loaded.symbols.data[1];
+        assert(foo.name.len == 3 && !memcmp(foo.name.data, "foo", 3));
+        assert(eq(String)(foo.signature, STRING_LITERAL("fn Bool -> Bool")));
+        assert(foo.offset == foo_offset);
+        assert(loaded.references.len == 0);
+
+        assert(loaded.metadata.functions.len == 2);
+        BytecodeFunction function = loaded.metadata.functions.data[1];
+        assert(function.offset == foo_offset);
+        assert(function.locals == 1 && function.results == 1 && function.returns);
+        assert(loaded.metadata.max_stack == image.metadata.max_stack);
+
+        TestVmSystem vm_system = test_vm_system_new();
+        Vm vm = vm_new((VmSystem*)&vm_system, code, &reporter.base);
+        vm_run(&vm);
+        assert(reporter.error_codes.len == 0);
+        assert(vm_system.syscalls.len == 2);
+        assert(vm_system.syscalls.data[0].as.dbg.var_val.as_uint == 42);
+        vm_free(&vm);
+        test_vm_system_free(vm_system);
+        bytecode_image_free(&loaded);
+    }
+
+    // images of another version are refused.
+    {
+        file = fopen(IMAGE_PATH, "r+b");
+        assert(file);
+        fseek(file, 8, SEEK_SET);
+        u32 version = BYTECODE_IMAGE_VERSION + 1;
+        fwrite(&version, sizeof(version), 1, file);
+        fclose(file);
+        BytecodeImage loaded;
+        assert(bytecode_image_load(IMAGE_PATH, &loaded) == IMAGE_INCOMPATIBLE);
+    }
+
+    // as are files that are not images at all.
+    {
+        file = fopen(IMAGE_PATH, "wb");
+        assert(file);
+        for (usize i = 0; i < 256; i++) {
+            fputc('x', file);
+        }
+        fclose(file);
+        BytecodeImage loaded;
+        assert(bytecode_image_load(IMAGE_PATH, &loaded) == IMAGE_NOT_AN_IMAGE);
+        assert(bytecode_image_load("missing.cbc", &loaded) == IMAGE_IO);
+    }
+
+    // symbols and functions must be at the start of an instruction.
+    {
+        image.symbols.data[1].offset = foo_offset + 1;
+        assert(write_and_load(&image) == IMAGE_CORRUPT);
+        image.symbols.data[1].offset = foo_offset;
+
+        image.metadata.functions.data[1].offset = bytecode.instructions.len;
+        assert(write_and_load(&image) == IMAGE_CORRUPT);
+        image.metadata.functions.data[1].offset = foo_offset;
+        assert(write_and_load(&image) == IMAGE_OK);
+    }
+
+    // only objects have undefined symbols.
+    {
+        image.symbols.data[1].offset = BYTECODE_SYMBOL_UNDEFINED;
+        assert(write_and_load(&image) == IMAGE_OK);
+        file = fopen(IMAGE_PATH, "r+b");
+        assert(file);
+        fseek(file, 20, SEEK_SET);
+        u32 flags = 0;
+        fwrite(&flags, sizeof(flags), 1, file);
+        fclose(file);
+        BytecodeImage loaded;
+        assert(bytecode_image_load(IMAGE_PATH, &loaded) == IMAGE_CORRUPT);
+        image.symbols.data[1].offset = foo_offset;
+    }
+
+    remove(IMAGE_PATH);
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "compiler/compiler.h"
+#include "linker/linker.h"
+
+#define OBJECT_PATH "test_linker.cbc"
+
+static bool same_words(ArrayBuf(Byteword) a, ArrayBuf(Byteword) b) {
+    return a.len == b.len
+        && (a.len == 0 || !memcmp(a.data, b.data, a.len * sizeof(Byteword)));
+}
+
+static bool same_bytecode(Bytecode a, Bytecode b) {
+    return same_words(a.instructions, b.instructions)
+        && same_words(a.rodata, b.rodata);
+}
+
+static CompiledObject compile_module(String source) {
+    TestReporter reporter = test_reporter_new();
+    WorkerPool workers = worker_pool_new(1);
+    CompiledObject object;
+    assert(compile_object(source, &workers, &reporter.base, &object));
+    worker_pool_free(&workers);
+    test_reporter_free(reporter);
+    return object;
+}
+
+static bool has_error(TestReporter reporter, i32 code) {
+    for (usize i = 0; i < reporter.error_codes.len; i++) {
+        if (reporter.error_codes.data[i] == code) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(void) {
+    // `main` calls `identity` through a function of its own, that stays
+    // local, and `identity` calls `main` back.
+    String main_source = STRING_LITERAL(
+        "main :: fn x: Bool -> Bool => (fn y: Bool -> Bool => identity(y))(x);\n"
+        "identity :: fn y: Bool -> Bool;\n"
+    );
+    String identity_source = STRING_LITERAL(
+        "identity :: fn y: Bool -> Bool => wrap(y);\n"
+        "wrap :: fn z: Bool -> Bool => z;\n"
+        "main :: fn x: Bool -> Bool;\n"
+    );
+    // the same functions in a single module.
+    Bytecode expected = source_to_bytecode(STRING_LITERAL(
+        "main :: fn x: Bool -> Bool => (fn y: Bool -> Bool => identity(y))(x);\n"
+        "identity :: fn y: Bool -> Bool => wrap(y);\n"
+        "wrap :: fn z: Bool -> Bool => z;\n"
+    ));
+
+    CompiledObject main_object = compile_module(main_source);
+    CompiledObject identity_object = compile_module(identity_source);
+
+    // functions are exported or imported by the name of their constant, with
+    // their type.
+    BytecodeImage image = main_object.image;
+    assert(image.symbols.len == 3);
+    assert(image.references.len == 2);
+    usize named = 0;
+    usize identity_symbol = 0;
+    for (usize i = 0; i < image.symbols.len; i++) {
+        BytecodeSymbol symbol = image.symbols.data[i];
+        if (symbol.name.len != 0) {
+            assert(eq(String)(symbol.signature, STRING_LITERAL("fn Bool -> Bool")));
+        } else {
+            assert(symbol.signature.len == 0);
+        }
+        if (eq(String)(symbol.name, STRING_LITERAL("identity"))) {
+            assert(symbol.offset == BYTECODE_SYMBOL_UNDEFINED);
+            identity_symbol = i;
+            named++;
+        } else if (eq(String)(symbol.name, STRING_LITERAL("main"))) {
+            assert(symbol.offset != BYTECODE_SYMBOL_UNDEFINED);
+            named++;
+        } else {
+            assert(symbol.name.len == 0);
+        }
+    }
+    assert(named == 2);
+
+    // a module that imports functions cannot be compiled alone.
+    {
+        TestReporter reporter = test_reporter_new();
+        Bytecode bytecode;
+        assert(!compile(main_source, &reporter.base, &bytecode));
+        assert(reporter.error_codes.len == 1);
+        assert(has_error(reporter, 0));
+        test_reporter_free(reporter);
+    }
+
+    // the linked objects are laid out like the module they were split from.
+    {
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = { main_object.image, identity_object.image };
+        Bytecode linked;
+        assert(link(objects, 2, &reporter.base, &linked));
+        assert(reporter.error_codes.len == 0);
+        assert(same_bytecode(linked, expected));
+        array_buf_free(Byteword)(&linked.instructions);
+        array_buf_free(Byteword)(&linked.rodata);
+        test_reporter_free(reporter);
+    }
+
+    // objects link the same once written and loaded again.
+    {
+        FILE* file = fopen(OBJECT_PATH, "wb");
+        assert(file);
+        assert(bytecode_image_write(&identity_object.image, file) == IMAGE_OK);
+        fclose(file);
+        BytecodeImage loaded;
+        assert(bytecode_image_load(OBJECT_PATH, &loaded) == IMAGE_OK);
+        assert(loaded.references.len == identity_object.image.references.len);
+
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = { main_object.image, loaded };
+        Bytecode linked;
+        assert(link(objects, 2, &reporter.base, &linked));
+        assert(same_bytecode(linked, expected));
+        array_buf_free(Byteword)(&linked.instructions);
+        array_buf_free(Byteword)(&linked.rodata);
+        test_reporter_free(reporter);
+        bytecode_image_free(&loaded);
+        remove(OBJECT_PATH);
+    }
+
+    // imports are resolved whatever the order of the objects.
+    {
+        Bytecode reversed = source_to_bytecode(STRING_LITERAL(
+            "identity :: fn y: Bool -> Bool => wrap(y);\n"
+            "wrap :: fn z: Bool -> Bool => z;\n"
+            "main :: fn x: Bool -> Bool => (fn y: Bool -> Bool => identity(y))(x);\n"
+        ));
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = { identity_object.image, main_object.image };
+        Bytecode linked;
+        assert(link(objects, 2, &reporter.base, &linked));
+        assert(same_bytecode(linked, reversed));
+        array_buf_free(Byteword)(&linked.instructions);
+        array_buf_free(Byteword)(&linked.rodata);
+        test_reporter_free(reporter);
+    }
+
+    // symbols must be exported exactly once.
+    {
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = { main_object.image };
+        Bytecode linked;
+        assert(!link(objects, 1, &reporter.base, &linked));
+        assert(has_error(reporter, 1));
+        test_reporter_free(reporter);
+    }
+    {
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = {
+            main_object.image,
+            identity_object.image,
+            identity_object.image,
+        };
+        Bytecode linked;
+        assert(!link(objects, 3, &reporter.base, &linked));
+        assert(has_error(reporter, 0));
+        test_reporter_free(reporter);
+    }
+
+    // imports have the signature of their export.
+    {
+        image.symbols.data[identity_symbol].signature =
+            STRING_LITERAL("fn (fn Bool -> Bool) -> Bool");
+
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = { image, identity_object.image };
+        Bytecode linked;
+        assert(!link(objects, 2, &reporter.base, &linked));
+        assert(has_error(reporter, 4));
+        test_reporter_free(reporter);
+        image.symbols.data[identity_symbol].signature = STRING_LITERAL("fn Bool -> Bool");
+    }
+
+    // symbols are at the start of instructions, and references at their
+    // location operands.
+    {
+        usize main_symbol = 0;
+        String main_name = STRING_LITERAL("main");
+        while (!eq(String)(image.symbols.data[main_symbol].name, main_name)) {
+            main_symbol++;
+        }
+        usize offset = image.symbols.data[main_symbol].offset;
+        image.symbols.data[main_symbol].offset = image.references.data[0];
+
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = { image, identity_object.image };
+        Bytecode linked;
+        assert(!link(objects, 2, &reporter.base, &linked));
+        assert(has_error(reporter, 2));
+        test_reporter_free(reporter);
+        image.symbols.data[main_symbol].offset = offset;
+    }
+    {
+        image.references.data[0]++;
+
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = { image, identity_object.image };
+        Bytecode linked;
+        assert(!link(objects, 2, &reporter.base, &linked));
+        assert(has_error(reporter, 2));
+        test_reporter_free(reporter);
+        image.references.data[0]--;
+    }
+
+    // rodata cannot be relocated with the instructions.
+    {
+        BytecodeImage with_rodata = image;
+        with_rodata.bytecode.rodata = array_buf_new(Byteword)();
+        array_buf_push(Byteword)(&with_rodata.bytecode.rodata, 0);
+
+        TestReporter reporter = test_reporter_new();
+        BytecodeImage objects[] = { with_rodata, identity_object.image };
+        Bytecode linked;
+        assert(!link(objects, 2, &reporter.base, &linked));
+        assert(has_error(reporter, 3));
+        test_reporter_free(reporter);
+        array_buf_free(Byteword)(&with_rodata.bytecode.rodata);
+    }
+
+    compiled_object_free(&main_object);
+    compiled_object_free(&identity_object);
+    return 0;
+}
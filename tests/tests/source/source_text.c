@@ -0,0 +1,66 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "source/source.h"
+
+#define SOURCE_PATH "test_source_text.cough"
+
+static void write_file(char const* text) {
+    FILE* file = fopen(SOURCE_PATH, "wb");
+    assert(file);
+    fputs(text, file);
+    fclose(file);
+}
+
+int main(void) {
+    char const* text = "identity :: fn x: Bool -> Bool => x;\n\nwrap :: identity;\n";
+    write_file(text);
+
+    // opened files are mapped, and their lines are only indexed when needed
+    SourceText source;
+    assert(source_text_open(SOURCE_PATH, &source) == 0);
+    assert(source.len == strlen(text));
+    assert(!memcmp(source.text, text, source.len));
+    assert(source.line_indices.len == 0);
+
+    LineColumn position = source_text_position(&source, 0);
+    assert(position.line == 0 && position.column == 0);
+    assert(source.line_indices.len > 0);
+    position = source_text_position(&source, 33);
+    assert(position.line == 0 && position.column == 33);
+    position = source_text_position(&source, 37);
+    assert(position.line == 1 && position.column == 0);
+    position = source_text_position(&source, 42);
+    assert(position.line == 2 && position.column == 4);
+    position = source_text_position(&source, source.len);
+    assert(position.line == 3 && position.column == 0);
+
+    // they tokenize like the text they were written from
+    Interner interner = interner_new();
+    TestReporter reporter = test_reporter_new();
+    TokenStream tokens;
+    assert(tokenize(source_text_string(&source), &interner, &reporter.base, &tokens));
+    assert(tokens.kinds.len == 15);
+    token_stream_free(&tokens);
+    interner_free(&interner);
+    test_reporter_free(reporter);
+    source_text_free(&source);
+
+    // sources given as strings index the same lines
+    SourceText from_string = source_text_new(NULL, text);
+    position = source_text_position(&from_string, 42);
+    assert(position.line == 2 && position.column == 4);
+    source_text_free(&from_string);
+
+    // empty files cannot be mapped, but still open
+    write_file("");
+    assert(source_text_open(SOURCE_PATH, &source) == 0);
+    assert(source.len == 0);
+    position = source_text_position(&source, 0);
+    assert(position.line == 0 && position.column == 0);
+    source_text_free(&source);
+
+    remove(SOURCE_PATH);
+    assert(source_text_open(SOURCE_PATH, &source) != 0);
+    return 0;
+}
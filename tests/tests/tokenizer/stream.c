@@ -0,0 +1,106 @@
+#include <string.h>
+
+#include "tokenizer/tokenizer.h"
+
+#include "tests/common.h"
+
+// reads at most `step` bytes at a time, so that tokens straddle the reads.
+typedef struct StepReader {
+    SourceReader base;
+    String source;
+    usize pos;
+    usize step;
+} StepReader;
+
+static Errno step_read(SourceReader* raw, char* buffer, usize capacity, usize* len) {
+    StepReader* self = (StepReader*)raw;
+    usize left = self->source.len - self->pos;
+    *len = left < self->step ? left : self->step;
+    *len = *len < capacity ? *len : capacity;
+    memcpy(buffer, self->source.data + self->pos, *len);
+    self->pos += *len;
+    return 0;
+}
+
+static SourceReaderVTable const step_reader_vtable = { .read = step_read };
+
+static void assert_same_tokens(
+    TokenStream expected,
+    Interner expected_interner,
+    TokenStream actual,
+    Interner actual_interner
+) {
+    assert(actual.kinds.len == expected.kinds.len);
+    for (usize i = 0; i < expected.kinds.len; i++) {
+        Token a = token_stream_get(actual, i);
+        Token b = token_stream_get(expected, i);
+        assert(a.kind == b.kind && a.pos == b.pos && a.len == b.len);
+        if (a.kind == TOKEN_IDENTIFIER) {
+            assert(eq(String)(
+                atom_string(actual_interner, a.atom),
+                atom_string(expected_interner, b.atom)
+            ));
+        }
+    }
+}
+
+int main(int argc, char const* argv[]) {
+    String source = STRING_LITERAL(
+        "identity :: fn x: Bool -> Bool => x;\n"
+        "wrap :: fn   y: Bool -> Bool => identity(y) & (true);\n"
+        "a_much_longer_name_than_the_chunks := f::false=>g->h;"
+    );
+    TestReporter reporter = test_reporter_new();
+    Interner interner = interner_new();
+    TokenStream expected;
+    assert(tokenize(source, &interner, &reporter.base, &expected));
+
+    for (usize chunk_size = 1; chunk_size <= 20; chunk_size++) {
+        for (usize step = 1; step <= 24; step += 7) {
+            StepReader reader = {
+                .base.vtable = &step_reader_vtable,
+                .source = source,
+                .step = step,
+            };
+            Interner stream_interner = interner_new();
+            TokenStream tokens = token_stream_new(source, &stream_interner);
+            TokenStreamSink sink = token_stream_sink_new(&tokens);
+            assert(tokenize_stream(
+                &reader.base,
+                chunk_size,
+                &stream_interner,
+                &reporter.base,
+                &sink.base
+            ));
+            assert_same_tokens(expected, interner, tokens, stream_interner);
+            token_stream_free(&tokens);
+            interner_free(&stream_interner);
+        }
+    }
+    assert(reporter.error_codes.len == 0);
+
+    // files are read with their own reader, and errors are reported at their
+    // position in the whole source
+    FILE* file = tmpfile();
+    assert(file);
+    fputs("first second\n  third $ fourth", file);
+    rewind(file);
+    FileSourceReader file_reader = file_source_reader_new(file);
+    Interner file_interner = interner_new();
+    TokenStream tokens = token_stream_new(source, &file_interner);
+    TokenStreamSink sink = token_stream_sink_new(&tokens);
+    assert(!tokenize_stream(&file_reader.base, 4, &file_interner, &reporter.base, &sink.base));
+    fclose(file);
+    assert(reporter.error_codes.len == 1);
+    assert(tokens.kinds.len == 4);
+    Token fourth = token_stream_get(tokens, 3);
+    assert(fourth.pos == 23 && fourth.len == 6);
+    assert(eq(String)(atom_string(file_interner, fourth.atom), STRING_LITERAL("fourth")));
+    token_stream_free(&tokens);
+    interner_free(&file_interner);
+
+    token_stream_free(&expected);
+    interner_free(&interner);
+    test_reporter_free(reporter);
+    return 0;
+}
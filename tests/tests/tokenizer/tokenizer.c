@@ -4,23 +4,76 @@
 
 #include "tests/common.h"
 
+static bool tokenize_text(
+    char const* text,
+    Interner* interner,
+    TestReporter* reporter,
+    TokenStream* dst
+) {
+    String source = { .data = text, .len = strlen(text) };
+    return tokenize(source, interner, &reporter->base, dst);
+}
+
 int main(int argc, char const* argv[]) {
     char const* source = "() : :: = := -> => ; & hello let fn \n false true";
     TestReporter reporter = test_reporter_new();
 
+    Interner interner = interner_new();
     TokenStream tokens;
     tokenize(
         (String){ .data = source, .len = strlen(source) },
+        &interner,
         &reporter.base,
         &tokens
     );
 
     assert(reporter.error_codes.len == 0);
 
-    assert(tokens.tokens.len == 15);
+    assert(tokens.kinds.len == 15);
     for (usize i = 0; i < 15; i++) {
-        assert(tokens.tokens.data[i].kind == i);
+        assert(tokens.kinds.data[i] == i);
+        Token token = token_stream_get(tokens, i);
+        assert(token.kind == i);
+        assert(token_range_range(tokens, (Range){ i, i + 1 }).end == token.pos + token.len);
     }
 
+    Token hello = token_stream_get(tokens, TOKEN_IDENTIFIER);
+    assert(hello.pos == 23 && hello.len == 5);
+    assert(eq(String)(atom_string(interner, hello.atom), STRING_LITERAL("hello")));
+    Token arrow = token_stream_get(tokens, TOKEN_DOUBLE_ARROW);
+    assert(arrow.pos == 16 && arrow.len == 2);
+    Range all = token_range_range(tokens, (Range){ 0, 15 });
+    assert(all.start == 0 && all.end == strlen(source));
+    assert(intern(&interner, STRING_LITERAL("hello")) == hello.atom);
+
+    token_stream_free(&tokens);
+
+    // only whole keywords are keywords, and runs of spaces and identifiers
+    // are longer than the chunks that are scanned at once
+    char const* words =
+        "f l t fa le tru fnx lets _fn                 \n\t\r\v\f  "
+        "a_rather_long_identifier_0123456789 fn";
+    assert(tokenize_text(words, &interner, &reporter, &tokens));
+    assert(tokens.kinds.len == 11);
+    for (usize i = 0; i < 10; i++) {
+        assert(tokens.kinds.data[i] == TOKEN_IDENTIFIER);
+    }
+    assert(tokens.kinds.data[10] == TOKEN_FN);
+    Token long_identifier = token_stream_get(tokens, 9);
+    assert(long_identifier.len == 35);
+    assert(long_identifier.pos + long_identifier.len + 1 == strlen(words) - 2);
+    token_stream_free(&tokens);
+
+    // the tokenizer goes on after invalid bytes, then fails
+    char const* invalid[] = { "1", "-", "x - y", "a\x80" "b", "a $ b", "=<" };
+    for (usize i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        usize errors = reporter.error_codes.len;
+        assert(!tokenize_text(invalid[i], &interner, &reporter, &tokens));
+        assert(reporter.error_codes.len == errors + 1);
+    }
+
+    interner_free(&interner);
+    test_reporter_free(reporter);
+
     return 0;
 }
@@ -0,0 +1,182 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "disassembler/disassembler.h"
+#include "verifier/verifier.h"
+#include "vm/diagnostics.h"
+
+#define ASSEMBLE(assembly) \
+    assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char const*))
+
+static VerifyError analyze_error(Bytecode bytecode) {
+    BytecodeMetadata metadata;
+    VerifyError error;
+    assert(!bytecode_analyze(bytecode, &metadata, &error));
+    return error;
+}
+
+int main(void) {
+    char const* calls[] = {
+        "   loc :foo",
+        "   cal",
+        "   sys exit",
+        ":foo",
+        "   res 1",
+        "   sca 21",
+        "   loc :bar",
+        "   cal",
+        "   set %0",
+        "   sys dbg %0",
+        "   sca -1",
+        "   ret",
+        ":bar",
+        "   res 1",
+        "   set %0",
+        "   var %0",
+        "   var %0",
+        "   adu",
+        "   ret",
+    };
+    {
+        BytecodeMetadata metadata;
+        VerifyError error;
+        assert(bytecode_analyze(ASSEMBLE(calls), &metadata, &error));
+
+        assert(metadata.functions.len == 3);
+        BytecodeFunction foo = metadata.functions.data[1];
+        assert(foo.locals == 1 && foo.args == 0 && foo.results == 1);
+        assert(foo.returns && foo.max_depth == 2);
+        BytecodeFunction bar = metadata.functions.data[2];
+        assert(bar.locals == 1 && bar.args == 1 && bar.results == 1);
+        assert(bar.max_depth == 1);
+
+        // `bar` runs with 21 and its own values on top of the stack of `foo`.
+        assert(metadata.max_stack == 2);
+        assert(metadata.max_locals == 2);
+        assert(metadata.max_calls == 2);
+        bytecode_metadata_free(&metadata);
+    }
+
+    char const* recursive[] = {
+        "   sca 10",
+        "   loc :down",
+        "   cal",
+        "   sys exit",
+        ":down",
+        "   res 1",
+        "   set %0",
+        "   var %0",
+        "   jnz :recurse",
+        "   sca 0",
+        "   ret",
+        ":recurse",
+        "   var %0",
+        "   sca -1",
+        "   adu",
+        "   loc :down",
+        "   cal",
+        "   ret",
+    };
+    {
+        BytecodeMetadata metadata;
+        VerifyError error;
+        assert(bytecode_analyze(ASSEMBLE(recursive), &metadata, &error));
+        BytecodeFunction down = metadata.functions.data[1];
+        assert(down.args == 1 && down.results == 1);
+        assert(metadata.max_stack == BYTECODE_UNBOUNDED);
+        bytecode_metadata_free(&metadata);
+    }
+
+    char const* underflow[] = {
+        "   sca 1",
+        "   adu",
+        "   sys exit",
+    };
+    VerifyError error = analyze_error(ASSEMBLE(underflow));
+    assert(error.kind == VERIFY_STACK_UNDERFLOW);
+    assert(error.offset == 8);
+
+    char const* out_of_range[] = {
+        "   res 1",
+        "   var %1",
+        "   sys exit",
+    };
+    error = analyze_error(ASSEMBLE(out_of_range));
+    assert(error.kind == VERIFY_VARIABLE_OUT_OF_RANGE);
+    assert(error.offset == 2);
+
+    char const* mismatch[] = {
+        ":loop",
+        "   sca 1",
+        "   jmp :loop",
+    };
+    error = analyze_error(ASSEMBLE(mismatch));
+    assert(error.kind == VERIFY_STACK_MISMATCH);
+    assert(error.offset == 0);
+
+    char const* jump[] = {
+        "   sca 0",
+        "   jmp :exit",
+        ":exit",
+        "   sys exit",
+    };
+    {
+        Bytecode bytecode = ASSEMBLE(jump);
+        // `sca` is at 0 with its immediate at 4, `jmp` at 8 with its location
+        // at 12.
+        Word into_immediate = { .as_uint = 4 };
+        memcpy(&bytecode.instructions.data[12], &into_immediate, sizeof(Word));
+        error = analyze_error(bytecode);
+        assert(error.kind == VERIFY_INVALID_TARGET);
+        assert(error.offset == 8);
+
+        // no engine decodes it, and the VM refuses to run it.
+        for (usize engine = 0; engine < VM_ENGINES_LEN; engine++) {
+            VmOptions options = vm_default_options();
+            options.engine = engine;
+            TestVmSystem vm_system = test_vm_system_new();
+            TestReporter reporter = test_reporter_new();
+            Vm vm = vm_new_with_options(
+                (VmSystem*)&vm_system,
+                bytecode,
+                (Reporter*)&reporter,
+                options
+            );
+            assert(vm.program.instructions.len == 0);
+            vm_run(&vm);
+            assert(reporter.error_codes.len == 1);
+            assert(reporter.error_codes.data[0] == RE_MALFORMED_BYTECODE);
+            assert(vm_system.syscalls.len == 0);
+            vm_free(&vm);
+        }
+    }
+
+    // problems are reported with the range of the culprit instruction.
+    char const* syscall[] = {
+        "   sca 0",
+        "   sys exit",
+    };
+    {
+        Bytecode bytecode = ASSEMBLE(syscall);
+        bytecode.instructions.data[9] = SYSCALLS_LEN;
+        TestReporter reporter = test_reporter_new();
+        BytecodeMetadata metadata;
+        assert(!bytecode_verify(bytecode, &reporter.base, &metadata));
+        assert(reporter.error_codes.len == 1);
+        assert(reporter.error_codes.data[0] == VERIFY_INVALID_SYSCALL);
+
+        // the disassembler only prints bytecode that decodes.
+        StringBuf text;
+        assert(!disassemble(bytecode, &reporter.base, &text));
+        assert(reporter.error_codes.len == 2);
+
+        bytecode.instructions.data[9] = SYS_EXIT;
+        bytecode.instructions.data[1] = 1;
+        error = analyze_error(bytecode);
+        assert(error.kind == VERIFY_MISALIGNED_IMMEDIATE);
+        assert(error.offset == 0);
+        test_reporter_free(reporter);
+    }
+
+    return 0;
+}
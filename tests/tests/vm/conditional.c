@@ -29,7 +29,12 @@ int main(int argc, const char* argv[]) {
     };
     Bytecode bytecode = assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char*));
 
-    Vm vm = vm_new((VmSystem*)&vm_system, bytecode, (Reporter*)&reporter);
+    Vm vm = vm_new_with_options(
+        (VmSystem*)&vm_system,
+        bytecode,
+        (Reporter*)&reporter,
+        test_vm_options(argc, argv)
+    );
     vm_run(&vm);
 
     assert(vm_system.syscalls.len == 3);
@@ -30,7 +30,12 @@ int main(int argc, const char* argv[]) {
     TestVmSystem vm_system = test_vm_system_new();
     TestReporter reporter = test_reporter_new();
 
-    Vm vm = vm_new((VmSystem*)&vm_system, bytecode, (Reporter*)&reporter);
+    Vm vm = vm_new_with_options(
+        (VmSystem*)&vm_system,
+        bytecode,
+        (Reporter*)&reporter,
+        test_vm_options(argc, argv)
+    );
     vm_run(&vm);
 
     assert(vm_system.syscalls.len == 3);
@@ -43,6 +48,60 @@ int main(int argc, const char* argv[]) {
 
     assert(vm_system.syscalls.data[2].kind == SYS_EXIT);
     assert(vm_system.syscalls.data[2].as.exit.exit_code == -1);
+    vm_free(&vm);
+    test_reporter_free(reporter);
+    test_vm_system_free(vm_system);
+
+    // locations are the same values in every engine, the offset of their
+    // target in the bytecode, whether they are called or not.
+    char const* indirect_assembly[] = {
+        "   res 1",
+        "   loc :double",
+        "   set %0",
+        "   sys dbg %0",
+        "   sca 21",
+        "   var %0",
+        "   cal",
+        "   set %0",
+        "   sys dbg %0",
+        "   sca 0",
+        "   sys exit",
+        "",
+        ":double",
+        "   res 1",
+        "   set %0",
+        "   var %0",
+        "   var %0",
+        "   adu",
+        "   ret",
+    };
+    Bytecode indirect = assembly_to_bytecode(
+        indirect_assembly,
+        sizeof(indirect_assembly) / sizeof(char*)
+    );
+    Byteword const* ip = indirect.instructions.data;
+    Byteword const* end = ip + indirect.instructions.len;
+    BytecodeInstruction instruction;
+    do {
+        assert(bytecode_decode(&ip, end, &instruction) == DECODE_OK);
+    } while (instruction.opcode != OP_LOC);
+    usize double_offset = instruction.operands[0].loc;
+
+    vm_system = test_vm_system_new();
+    reporter = test_reporter_new();
+    vm = vm_new_with_options(
+        (VmSystem*)&vm_system,
+        indirect,
+        (Reporter*)&reporter,
+        test_vm_options(argc, argv)
+    );
+    vm_run(&vm);
+
+    assert(reporter.error_codes.len == 0);
+    assert(vm_system.syscalls.len == 3);
+    assert(vm_system.syscalls.data[0].as.dbg.var_val.as_uint == double_offset);
+    assert(vm_system.syscalls.data[1].as.dbg.var_val.as_uint == 42);
+    assert(vm_system.syscalls.data[2].as.exit.exit_code == 0);
 
     return 0;
 }
@@ -0,0 +1,84 @@
+#include "tests/common.h"
+
+int main(void) {
+    TestVmSystem vm_system = test_vm_system_new();
+    TestReporter reporter = test_reporter_new();
+
+    // calls :count 3 times, which loops until its argument is 0, then
+    // leaves the interpreter for the `sys dbg`.
+    char const* assembly[] = {
+        "   res 2",
+        "   sca 3",
+        "   set %1",
+        ":again",
+        "   sca 5",
+        "   loc :count",
+        "   cal",
+        "   set %0",
+        "   var %1",
+        "   sca -1",
+        "   adu",
+        "   set %1",
+        "   var %1",
+        "   jnz :again",
+        "   sys dbg %0",
+        "   sca 0",
+        "   sys exit",
+        ":count",
+        "   res 2",
+        "   set %0",
+        ":loop",
+        "   var %1",
+        "   var %0",
+        "   adu",
+        "   set %1",
+        "   var %0",
+        "   sca -1",
+        "   adu",
+        "   set %0",
+        "   var %0",
+        "   sca 0",
+        "   neu",
+        "   jnz :loop",
+        "   sys dbg %1",
+        "   var %1",
+        "   ret",
+    };
+    Bytecode bytecode = assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char*));
+
+    VmOptions options = vm_default_options();
+    options.engine = VM_ENGINE_JIT;
+    options.jit_threshold = 2;
+    Vm vm = vm_new_with_options(
+        (VmSystem*)&vm_system,
+        bytecode,
+        (Reporter*)&reporter,
+        options
+    );
+    vm_run(&vm);
+
+    assert(reporter.error_codes.len == 0);
+    assert(vm_system.syscalls.len == 5);
+    for (usize i = 0; i < 4; i++) {
+        assert(vm_system.syscalls.data[i].kind == SYS_DBG);
+        assert(vm_system.syscalls.data[i].as.dbg.var_val.as_uint == 15);
+    }
+    assert(vm_system.syscalls.data[4].kind == SYS_EXIT);
+
+#ifdef VM_JIT_SUPPORTED
+    // :count was compiled on its second call.
+    bool compiled = false;
+    for (usize i = 0; i < vm.jit.len; i++) {
+        VmJitFunction function = vm.jit.functions[i];
+        if (function.code) {
+            assert(function.calls == 2);
+            assert(function.reserve == 2);
+            compiled = true;
+        }
+    }
+    assert(compiled);
+#endif
+
+    vm_free(&vm);
+    return 0;
+}
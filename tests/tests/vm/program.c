@@ -0,0 +1,66 @@
+#include <string.h>
+
+#include "tests/common.h"
+#include "alloc/alloc.h"
+
+// a copy of the first `len` bytewords in a buffer of exactly that size, so
+// that reading past its end is caught by the sanitizers.
+static Bytecode truncated(Bytecode bytecode, usize len) {
+    Byteword* data = malloc_or_exit(len * sizeof(Byteword));
+    memcpy(data, bytecode.instructions.data, len * sizeof(Byteword));
+    return (Bytecode){
+        .rodata = array_buf_new(Byteword)(),
+        .instructions = { .data = data, .len = len, .capacity = len },
+    };
+}
+
+int main(void) {
+    char const* assembly[] = {
+        "   sys hi",
+        "   sca 7",
+        "   loc :exit",
+        ":exit",
+        "   sys exit",
+    };
+    Bytecode bytecode =
+        assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char const*));
+    // `sys hi` is at 0, `sca` at 2 with its immediate at 4, `loc` at 8 with
+    // its location at 12 and `sys exit` at 16.
+    assert(bytecode.instructions.len == 18);
+
+    {
+        VmProgram program = vm_program_new(bytecode, NULL);
+        assert(program.instructions.len == 5);
+        assert(program.instructions.data[1].operands[0].imw.as_uint == 7);
+        assert(program.instructions.data[2].operands[0].loc == &program.instructions.data[3]);
+        assert(program.instructions.data[4].handler_index == VM_HANDLER_INVALID);
+        vm_program_free(&program);
+    }
+
+    // truncated immediates end the program before the instruction they
+    // belong to.
+    usize const lens[] = { 1, 3, 6, 9, 14, 17 };
+    usize const decoded[] = { 0, 1, 1, 2, 2, 3 };
+    for (usize i = 0; i < sizeof(lens) / sizeof(usize); i++) {
+        Bytecode part = truncated(bytecode, lens[i]);
+
+        Byteword const* ip = part.instructions.data;
+        Byteword const* end = ip + part.instructions.len;
+        BytecodeInstruction instruction;
+        DecodeError error = DECODE_OK;
+        for (usize j = 0; j <= decoded[i]; j++) {
+            error = bytecode_decode(&ip, end, &instruction);
+        }
+        assert(error == DECODE_TRUNCATED);
+        assert(ip == end);
+
+        VmProgram program = vm_program_new(part, NULL);
+        assert(program.instructions.len == decoded[i] + 1);
+        VmInstruction invalid = program.instructions.data[decoded[i]];
+        assert(invalid.handler_index == VM_HANDLER_INVALID);
+        vm_program_free(&program);
+        free_allocation(part.instructions.data);
+    }
+
+    return 0;
+}
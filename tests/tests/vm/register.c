@@ -0,0 +1,105 @@
+#include "tests/common.h"
+#include "vm/diagnostics.h"
+
+static Vm register_vm(TestVmSystem* vm_system, TestReporter* reporter, Bytecode bytecode) {
+    VmOptions options = vm_default_options();
+    options.engine = VM_ENGINE_REGISTER;
+    return vm_new_with_options(
+        (VmSystem*)vm_system,
+        bytecode,
+        (Reporter*)reporter,
+        options
+    );
+}
+
+int main(void) {
+    // recursive functions are lowered once the effect of their base case on
+    // the stack is known.
+    char const* recursive[] = {
+        "   res 1",
+        "   sca 10",
+        "   loc :sum",
+        "   cal",
+        "   set %0",
+        "   sys dbg %0",
+        "   sca 0",
+        "   sys exit",
+        ":sum",
+        "   res 1",
+        "   set %0",
+        "   var %0",
+        "   jnz :recurse",
+        "   sca 0",
+        "   ret",
+        ":recurse",
+        "   var %0",
+        "   var %0",
+        "   sca -1",
+        "   adu",
+        "   loc :sum",
+        "   cal",
+        "   adu",
+        "   ret",
+    };
+    {
+        TestVmSystem vm_system = test_vm_system_new();
+        TestReporter reporter = test_reporter_new();
+        Bytecode bytecode = assembly_to_bytecode(
+            recursive,
+            sizeof(recursive) / sizeof(char const*)
+        );
+        Vm vm = register_vm(&vm_system, &reporter, bytecode);
+        assert(
+            vm.register_program.instructions.len
+            < vm.program.instructions.len
+        );
+        vm_run(&vm);
+
+        assert(reporter.error_codes.len == 0);
+        assert(vm_system.syscalls.len == 2);
+        assert(vm_system.syscalls.data[0].kind == SYS_DBG);
+        assert(vm_system.syscalls.data[0].as.dbg.var_val.as_uint == 55);
+        assert(vm_system.syscalls.data[1].kind == SYS_EXIT);
+        vm_free(&vm);
+    }
+
+    // calls through a variable run the function loaded by `ldf`.
+    char const* indirect[] = {
+        "   res 2",
+        "   loc :double",
+        "   set %0",
+        "   sca 21",
+        "   var %0",
+        "   cal",
+        "   set %1",
+        "   sys dbg %1",
+        "   sca 0",
+        "   sys exit",
+        ":double",
+        "   res 1",
+        "   set %0",
+        "   var %0",
+        "   var %0",
+        "   adu",
+        "   ret",
+    };
+    {
+        TestVmSystem vm_system = test_vm_system_new();
+        TestReporter reporter = test_reporter_new();
+        Bytecode bytecode = assembly_to_bytecode(
+            indirect,
+            sizeof(indirect) / sizeof(char const*)
+        );
+        Vm vm = register_vm(&vm_system, &reporter, bytecode);
+        vm_run(&vm);
+
+        assert(reporter.error_codes.len == 0);
+        assert(vm_system.syscalls.len == 2);
+        assert(vm_system.syscalls.data[0].kind == SYS_DBG);
+        assert(vm_system.syscalls.data[0].as.dbg.var_val.as_uint == 42);
+        assert(vm_system.syscalls.data[1].kind == SYS_EXIT);
+        vm_free(&vm);
+    }
+
+    return 0;
+}
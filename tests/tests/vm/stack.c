@@ -0,0 +1,55 @@
+#include "tests/common.h"
+#include "vm/diagnostics.h"
+
+int main(int argc, const char* argv[]) {
+#ifdef COUGH_VM_GUARDED_STACKS
+    // recurses a billion times, far more than the frames fit in.
+    char const* assembly[] = {
+        "   sca 1000000000",
+        "   loc :down",
+        "   cal",
+        "   sys exit",
+        ":down",
+        "   res 1",
+        "   set %0",
+        "   var %0",
+        "   jnz :recurse",
+        "   sca 0",
+        "   ret",
+        ":recurse",
+        "   var %0",
+        "   sca -1",
+        "   adu",
+        "   loc :down",
+        "   cal",
+        "   ret",
+    };
+    Bytecode bytecode = assembly_to_bytecode(assembly, sizeof(assembly) / sizeof(char*));
+
+    VmOptions options = test_vm_options(argc, argv);
+    options.value_stack_size = 256;
+    options.frame_stack_size = 1 << 16;
+
+    // overflows are reported, and do not stop other VMs from running.
+    for (usize i = 0; i < 2; i++) {
+        TestVmSystem vm_system = test_vm_system_new();
+        TestReporter reporter = test_reporter_new();
+        Vm vm = vm_new_with_options(
+            (VmSystem*)&vm_system,
+            bytecode,
+            (Reporter*)&reporter,
+            options
+        );
+        vm_run(&vm);
+
+        assert(reporter.error_codes.len == 1);
+        assert(reporter.error_codes.data[0] == RE_STACK_OVERFLOW);
+        assert(vm_system.syscalls.len == 0);
+
+        vm_free(&vm);
+        test_reporter_free(reporter);
+        test_vm_system_free(vm_system);
+    }
+#endif
+    return 0;
+}
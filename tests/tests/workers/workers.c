@@ -0,0 +1,62 @@
+#include <stdatomic.h>
+
+#include "tests/common.h"
+#include "workers/workers.h"
+
+#define TASKS 1000
+
+typedef struct Counts {
+    atomic_uint runs[TASKS];
+} Counts;
+
+static void count_task(void* context, usize task) {
+    Counts* counts = context;
+    atomic_fetch_add(&counts->runs[task], 1);
+}
+
+static void check_pool(usize threads) {
+    WorkerPool pool = worker_pool_new(threads);
+    assert(pool.threads >= 1 && pool.threads <= (threads ? threads : 1));
+
+    // every task runs exactly once per job, and jobs can follow each other.
+    static Counts counts;
+    for (usize job = 0; job < 3; job++) {
+        for (usize i = 0; i < TASKS; i++) {
+            atomic_init(&counts.runs[i], 0);
+        }
+        usize tasks = job == 0 ? TASKS : job;
+        worker_pool_run(&pool, tasks, count_task, &counts);
+        for (usize i = 0; i < TASKS; i++) {
+            assert(atomic_load(&counts.runs[i]) == (i < tasks ? 1u : 0u));
+        }
+    }
+    worker_pool_free(&pool);
+}
+
+int main(void) {
+    check_pool(0);
+    check_pool(1);
+    check_pool(2);
+    check_pool(8);
+
+    // chunks cover the items without gaps or overlaps.
+    WorkerPool pool = worker_pool_new(4);
+    usize const lens[] = { 0, 1, 5, 100, 1001 };
+    for (usize i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        usize chunks = worker_pool_chunks(&pool, lens[i]);
+        assert(chunks <= lens[i]);
+        if (chunks == 0) {
+            continue;
+        }
+        assert(worker_chunk_start(lens[i], chunks, 0) == 0);
+        assert(worker_chunk_start(lens[i], chunks, chunks) == lens[i]);
+        for (usize chunk = 0; chunk < chunks; chunk++) {
+            assert(
+                worker_chunk_start(lens[i], chunks, chunk)
+                < worker_chunk_start(lens[i], chunks, chunk + 1)
+            );
+        }
+    }
+    worker_pool_free(&pool);
+    return 0;
+}